@@ -0,0 +1,24 @@
+#-------------------------------------------------
+#
+# converts the flight recorder of TSC (.TSCFlightRecorder.tfr) to CSV
+# the recorder class is taken from the main project
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+TARGET = TSC_FlightDump
+TEMPLATE = app
+CONFIG += c++11
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += $$PWD/..
+
+SOURCES += \
+    flightdumpmain.cpp \
+    ../tsc_flightrecorder.cpp
+
+HEADERS += \
+    ../tsc_flightrecorder.h
@@ -0,0 +1,169 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+//---------------------------------------------------
+// converts a recording of the flight recorder to CSV. the file can be copied from the telescope or read while
+// TSC is running. usage: TSC_FlightDump [options] [file], the file defaults to .TSCFlightRecorder.tfr. options:
+// -o <CSV file> instead of the console, -n <number of records> only the last ones, -f <UTC> and -u <UTC> for the
+// first and last time as yyyy-MM-ddThh:mm:ss, -e only events, no periodic records
+// -i prints a summary instead of the records: time covered, records torn by a crash, the longest gap between two
+// records - the event queue of TSC was blocked then - and the largest latency of the USB connection.
+// the step of the meridian flip and of the sequencer are the numbers of mflipStep and sequencerStep in mainwindow.h
+
+#include <QDateTime>
+#include <QString>
+#include <stdio.h>
+#include <stdlib.h>
+#include "tsc_flightrecorder.h"
+
+static const char *eventNames[] = {"periodic", "session start", "guide pulse RA", "guide pulse decl", "GoTo", "sync", "emergency stop"};
+
+//---------------------------------------------------
+static QString getTimeString(int64_t timeInUS) {
+    return QDateTime::fromMSecsSinceEpoch(timeInUS/1000, Qt::UTC).toString("yyyy-MM-dd hh:mm:ss.zzz");
+}
+
+//---------------------------------------------------
+static int64_t getTimeFromString(const char *utc) {
+    QDateTime dt;
+
+    dt = QDateTime::fromString(QString(utc), Qt::ISODate);
+    if (dt.isValid() == false) {
+        printf("Cannot read the time %s - use yyyy-MM-ddThh:mm:ss\n", utc);
+        exit(1);
+    }
+    dt.setTimeSpec(Qt::UTC);
+    return dt.toMSecsSinceEpoch()*1000;
+}
+
+//---------------------------------------------------
+static void writeRecord(FILE *out, struct TSC_FlightRecorder::flightRecordStruct *rec) {
+    const char *eventName = "unknown";
+    short bit;
+
+    if (rec->event < sizeof(eventNames)/sizeof(eventNames[0])) {
+        eventName = eventNames[rec->event];
+    }
+    fprintf(out, "%u,%s,%s", rec->sequence, getTimeString(rec->timeInUS).toLatin1().constData(), eventName);
+    for (bit = 0; bit < 9; bit++) {
+        fprintf(out, ",%d", (rec->flags >> bit) & 1);
+    }
+    fprintf(out, ",%lld,%lld,%.3f,%.3f,%.1f,%.1f,%.3f,%.3f,%d,%d\n", (long long)rec->stepsRA, (long long)rec->stepsDecl,
+            rec->rateRA, rec->rateDecl, rec->guidePulseRA, rec->guidePulseDecl, rec->usbLatencyRA, rec->usbLatencyDecl,
+            rec->flipStep, rec->sequencerStep);
+}
+
+//---------------------------------------------------
+int main(int argc, char *argv[]) {
+    TSC_FlightRecorder recorder;
+    struct TSC_FlightRecorder::flightRecordStruct rec;
+    const char *fileName = ".TSCFlightRecorder.tfr";
+    const char *outName = NULL;
+    FILE *out = stdout;
+    uint64_t idx, first = 0, written = 0, torn = 0;
+    int64_t from = 0, until = INT64_MAX, firstTime = 0, lastTime = 0, gap, maxGap = 0, maxGapTime = 0;
+    long lastRecords = 0;
+    float maxLatency = 0;
+    bool eventsOnly = false, summary = false;
+    int ii;
+
+    for (ii = 1; ii < argc; ii++) {
+        if (argv[ii][0] != '-') {
+            fileName = argv[ii];
+            continue;
+        }
+        switch (argv[ii][1]) {
+        case 'e': eventsOnly = true; continue;
+        case 'i': summary = true; continue;
+        } // the options without a value
+        if (ii < argc - 1) {
+            switch (argv[ii][1]) {
+            case 'o': outName = argv[++ii]; break;
+            case 'n': lastRecords = atol(argv[++ii]); break;
+            case 'f': from = getTimeFromString(argv[++ii]); break;
+            case 'u': until = getTimeFromString(argv[++ii]); break;
+            }
+        }
+    }
+    if (recorder.openForReading(fileName) == false) {
+        printf("Cannot read a flight recording from %s\n", fileName);
+        return 1;
+    }
+    if ((lastRecords > 0) && ((uint64_t)lastRecords < recorder.getNumberOfRecords())) {
+        first = recorder.getNumberOfRecords() - lastRecords;
+    }
+    if ((summary == false) && (outName != NULL)) {
+        out = fopen(outName, "w");
+        if (out == NULL) {
+            printf("Cannot write %s\n", outName);
+            return 1;
+        }
+    }
+    if (summary == false) {
+        fprintf(out, "sequence,utc,event,tracking,goto_ra,goto_decl,ra_moving,decl_moving,guiding,east,parked,driver_error,"
+                "steps_ra,steps_decl,rate_ra_arcsec_s,rate_decl_arcsec_s,pulse_ra_ms,pulse_decl_ms,usb_ra_ms,usb_decl_ms,"
+                "flip_step,sequencer_step\n");
+    }
+    for (idx = first; idx < recorder.getNumberOfRecords(); idx++) {
+        if (recorder.getRecord(idx, &rec) == false) {
+            torn++;
+            continue;
+        }
+        if ((rec.timeInUS < from) || (rec.timeInUS > until)) {
+            continue;
+        }
+        if (summary == true) {
+            if (written == 0) {
+                firstTime = rec.timeInUS;
+            } else {
+                gap = rec.timeInUS - lastTime;
+                if ((rec.event != TSC_FlightRecorder::frSessionStart) && (gap > maxGap)) {
+                    maxGap = gap;
+                    maxGapTime = lastTime;
+                } // a restart of TSC is no gap in the event queue
+            }
+            lastTime = rec.timeInUS;
+            if (rec.usbLatencyRA > maxLatency) {
+                maxLatency = rec.usbLatencyRA;
+            }
+            if (rec.usbLatencyDecl > maxLatency) {
+                maxLatency = rec.usbLatencyDecl;
+            }
+            written++;
+            continue;
+        }
+        if ((eventsOnly == true) && (rec.event == TSC_FlightRecorder::frPeriodic)) {
+            continue;
+        }
+        writeRecord(out, &rec);
+        written++;
+    }
+    if (summary == true) {
+        printf("records in the file:      %llu of %llu written\n", (unsigned long long)recorder.getNumberOfRecords(),
+               (unsigned long long)recorder.getTotalRecords());
+        printf("records selected:         %llu\n", (unsigned long long)written);
+        printf("torn records:             %llu\n", (unsigned long long)torn);
+        if (written > 0) {
+            printf("first record:             %s\n", getTimeString(firstTime).toLatin1().constData());
+            printf("last record:              %s\n", getTimeString(lastTime).toLatin1().constData());
+            printf("longest gap:              %.3f s after %s\n", maxGap/1000000.0, getTimeString(maxGapTime).toLatin1().constData());
+            printf("largest USB latency:      %.3f ms\n", maxLatency);
+        }
+    }
+    if (out != stdout) {
+        fclose(out);
+    }
+    recorder.close();
+    return 0;
+}
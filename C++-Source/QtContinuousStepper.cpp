@@ -103,16 +103,14 @@ void QtContinuousStepper::setInitialParamsAndComputeBaseSpeed(double lacc, doubl
 //----------------------------------------------
 void QtContinuousStepper::startTracking(void) {
 
-    this->speedMax=g_AllData->getCelestialSpeed()*(this->gearRatio*this->microsteps);
-    this->sendCommandToAMIS("v",this->speedMax);
-    this->sendCommandToAMIS("z");
-    this->sendCommandToAMIS("s", this->RADirection*(60*60*24*this->stepsPerSecond));
-    this->sendCommandToAMIS("o");
+    this->speedMax=(g_AllData->getCelestialSpeed()+this->trackingRateOffset)*(this->gearRatio*this->microsteps);
+    this->takeUpBacklash(this->RADirection, this->speedMax, this->RADirection*(60*60*24*this->stepsPerSecond));
+        // after a GoTo in the opposite direction, tracking would stand still until the slack is gone
     this->stopped = false;
 }
 
 //-----------------------------------------------
-void QtContinuousStepper::travelForNSteps(long steps,short direction, int factor, bool isHBSlew) {
+void QtContinuousStepper::travelForNSteps(long steps,short direction, double factor, bool isHBSlew) {
 
     this->hBoxSlewEnded = false;
     this->isHBoxSlew = isHBSlew;
@@ -125,6 +123,10 @@ void QtContinuousStepper::travelForNSteps(long steps,short direction, int factor
     } else {
         direction = 1;
     }
+    this->backlashTakeUp.cancel(); // the new target replaces a motion that waits for a take-up
+    if (steps > 0) {
+        steps += this->getBacklashSteps(this->RADirection*direction);
+    }
     this->sendCommandToAMIS("v",this->speedMax);
     this->sendCommandToAMIS("z");
     this->sendCommandToAMIS("s",this->RADirection*direction*steps);
@@ -135,16 +137,13 @@ void QtContinuousStepper::travelForNSteps(long steps,short direction, int factor
 //-----------------------------------------------
 void QtContinuousStepper::travelForNSteps(short direction, float factor) {
 
-    this->speedMax=round(factor*g_AllData->getCelestialSpeed()*(this->gearRatio)*(this->microsteps));
     if (direction < 0) {
         direction = -1;
     } else {
         direction = 1;
     }
-    this->sendCommandToAMIS("v",this->speedMax);
-    this->sendCommandToAMIS("z");
-    this->sendCommandToAMIS("s",this->RADirection*direction*1000000000);
-    this->sendCommandToAMIS("o");
+    this->speedMax=round(factor*g_AllData->getCelestialSpeed()*(this->gearRatio)*(this->microsteps));
+    this->takeUpBacklash(this->RADirection*direction, this->speedMax, this->RADirection*direction*1000000000);
     this->stopped = false;
 }
 
@@ -162,10 +161,54 @@ void QtContinuousStepper::resetSteppersAfterStop(void) { // this function is cal
 //-----------------------------------------------
 void QtContinuousStepper::setRADirection(short dir) {
     if (abs(dir) == 1) {
+        this->countSteps(); // the steps so far were made in the old direction
         this->RADirection = dir;
     }
 }
 
+//-----------------------------------------------
+// the AMIS take integer speeds in microsteps/s; a new offset only matters if it changes that number
+bool QtContinuousStepper::setTrackingRateOffset(double offs) {
+    long oldSpeed, newSpeed;
+
+    oldSpeed = (long)((g_AllData->getCelestialSpeed()+this->trackingRateOffset)*(this->gearRatio*this->microsteps));
+    newSpeed = (long)((g_AllData->getCelestialSpeed()+offs)*(this->gearRatio*this->microsteps));
+    this->trackingRateOffset = offs;
+    return (oldSpeed != newSpeed);
+}
+
+//-----------------------------------------------
+// changes the speed of a running drive without stopping it; a tracking rate that lies between two integer
+// speeds is reached by switching between them. during a backlash take-up, the speed is kept for the motion
+// that follows
+bool QtContinuousStepper::adjustTrackingSpeed(long speed) {
+    if ((this->stopped == true) || (speed < 1)) {
+        return false;
+    }
+    if (this->backlashTakeUp.isRunning() == true) {
+        this->speedMax = speed;
+        this->backlashTakeUp.queueMotion(speed, this->backlashTakeUp.getQueuedSteps());
+        return false;
+    }
+    if (speed == this->commandedSpeed) {
+        return false;
+    }
+    this->speedMax = speed;
+    this->sendCommandToAMIS("v", speed);
+    return true;
+}
+
+//-----------------------------------------------
+long QtContinuousStepper::getTrackingSpeed(void) {
+    if (this->stopped == true) {
+        return 0;
+    }
+    if (this->backlashTakeUp.isRunning() == true) {
+        return this->backlashTakeUp.getQueuedSpeed();
+    }
+    return this->commandedSpeed;
+}
+
 //-----------------------------------------------------------------------------
 double QtContinuousStepper::getKineticsFromController(short whichOne) {
     double retval = 0;
@@ -230,6 +273,8 @@ void QtContinuousStepper::setStepperParams(double val, short whichOne) {
 //-----------------------------------------------------------------------------
 
 void QtContinuousStepper::shutDownDrive(void) {
+    this->backlashTakeUp.cancel();
+    this->countLastStepsOfMove();
     this->stopped=true;
     this->sendCommandToAMIS("x");
     this->sendCommandToAMIS("e",0);
@@ -240,9 +285,19 @@ bool QtContinuousStepper::getStopped(void) {
     return (this->stopped);
 }
 
+//------------------------------------------------------------------------------
+double QtContinuousStepper::getCommandedRate(void) {
+    if ((this->stopped == true) || (this->gearRatio*this->microsteps <= 0)) {
+        return 0;
+    }
+    return this->commandedDirection*this->commandedSpeed/(this->gearRatio*this->microsteps);
+}
+
 //------------------------------------------------------------------------------
 void QtContinuousStepper::stopDrive(void) {
 
+    this->backlashTakeUp.cancel();
+    this->countLastStepsOfMove();
     this->sendCommandToAMIS("x");
     this->sendCommandToAMIS("z");
     this->stopped=true;
@@ -272,12 +327,143 @@ bool QtContinuousStepper::hasHBoxSlewEnded(void) {
     return this->hBoxSlewEnded;
 }
 
+//--------------------------------------------------------------------------------
+void QtContinuousStepper::setBacklash(long steps) {
+    if (steps >= 0) {
+        this->backlash = steps;
+    }
+}
+
+//--------------------------------------------------------------------------------
+long QtContinuousStepper::getBacklash(void) {
+    return this->backlash;
+}
+
+//--------------------------------------------------------------------------------
+void QtContinuousStepper::setBacklashCompensation(bool isOn) {
+    this->backlashCompensationIsOn = isOn;
+}
+
+//--------------------------------------------------------------------------------
+// same as in QtKineticStepper; the backlash is scaled from the microstepping ratio for guiding to the current one
+long QtContinuousStepper::getBacklashSteps(short motorDirection) {
+    long steps = 0;
+
+    if (motorDirection == 0) {
+        return 0;
+    }
+    if ((this->backlashCompensationIsOn == true) && (this->lastMotorDirection != 0) && (this->lastMotorDirection != motorDirection)) {
+        steps = round(this->backlash*this->microsteps/((double)g_AllData->getMicroSteppingRatio(0)));
+    }
+    this->lastMotorDirection = motorDirection;
+    return steps;
+}
+
+//--------------------------------------------------------------------------------
+// the RA drive reverses mainly when tracking resumes after a GoTo or a handbox motion to the east; at sidereal speed,
+// the slack would take seconds to disappear while the stars drift. it is therefore travelled at eight times
+// the sidereal speed before the continuous motion starts. the drive does not wait for the take-up; the motion
+// is queued and started by finishBacklashTakeUp, which the event queue calls
+void QtContinuousStepper::takeUpBacklash(short motorDirection, long speed, long steps) {
+    long backlashSteps, takeUpSpeed;
+
+    backlashSteps = this->getBacklashSteps(motorDirection);
+    if ((backlashSteps == 0) && (this->backlashTakeUp.isRunning() == true)) {
+        this->backlashTakeUp.queueMotion(speed, steps);
+        return;
+    } // the motor keeps its direction; only the motion after the take-up changes
+    if (backlashSteps == 0) {
+        this->startContinuousMotion(speed, steps);
+        return;
+    }
+    takeUpSpeed = this->backlashTakeUp.getTakeUpSpeed(g_AllData->getCelestialSpeed()*(this->gearRatio)*(this->microsteps));
+    this->sendCommandToAMIS("v",takeUpSpeed);
+    this->sendCommandToAMIS("z");
+    this->sendCommandToAMIS("s",motorDirection*backlashSteps);
+    this->sendCommandToAMIS("o");
+    this->backlashTakeUp.start(backlashSteps, takeUpSpeed, speed, steps);
+}
+
+//--------------------------------------------------------------------------------
+void QtContinuousStepper::startContinuousMotion(long speed, long steps) {
+    this->sendCommandToAMIS("v",speed);
+    this->sendCommandToAMIS("z");
+    this->sendCommandToAMIS("s",steps);
+    this->sendCommandToAMIS("o");
+}
+
+//--------------------------------------------------------------------------------
+// the AMIS are asked whether the take-up has ended; a timeout keeps the motion from waiting forever if a reply is lost
+bool QtContinuousStepper::finishBacklashTakeUp(void) {
+    if (this->backlashTakeUp.isRunning() == false) {
+        return false;
+    }
+    if ((this->sendCommandToAMIS("f0").toLong() != 0) && (this->backlashTakeUp.hasTimedOut() == false)) {
+        return false;
+    }
+    this->backlashTakeUp.cancel();
+    this->startContinuousMotion(this->backlashTakeUp.getQueuedSpeed(), this->backlashTakeUp.getQueuedSteps());
+    return true;
+}
+
+//--------------------------------------------------------------------------------
+// the AMIS counts the steps of the running move only; "o" and "z" set its counter to zero. the steps are therefore
+// collected before the counter is reset, and scaled to the microstepping ratio for tracking. "RADirection" is
+// taken out, so that the counter runs with the hour angle on both hemispheres
+void QtContinuousStepper::countSteps(void) {
+    long stepsOfMove;
+    bool isValid = false;
+
+    if (this->moveWasStarted == false) {
+        return;
+    }
+    stepsOfMove = this->sendCommandToAMIS("f5").toLong(&isValid);
+    if ((isValid == false) || (this->microsteps <= 0)) {
+        return;
+    }
+    this->stepCounter += this->RADirection*(stepsOfMove - this->stepsOfMoveCounted)*g_AllData->getMicroSteppingRatio(0)/this->microsteps;
+    this->stepsOfMoveCounted = stepsOfMove;
+}
+
+//--------------------------------------------------------------------------------
+// the steps the drive makes on its ramp after "x" are not counted; "z" sets the counter of the AMIS to zero
+// right after it, and they are few
+void QtContinuousStepper::countLastStepsOfMove(void) {
+    this->countSteps();
+    this->moveWasStarted = false;
+}
+
+//--------------------------------------------------------------------------------
+long long QtContinuousStepper::getStepCounter(void) {
+    return llround(this->stepCounter);
+}
+
+//--------------------------------------------------------------------------------
+void QtContinuousStepper::refreshStepCounter(void) {
+    this->countSteps();
+}
+
+//--------------------------------------------------------------------------------
+void QtContinuousStepper::setStepCounter(long long steps) {
+    this->countSteps();
+    this->stepCounter = steps;
+}
+
 //--------------------------------------------------------------------------------
 // two private routines to simplify communications with the AMIS
 QString QtContinuousStepper::sendCommandToAMIS(QString cmd, long val) {
     QString theCommand;
     QString theReply;
 
+    if (cmd == "v") {
+        this->commandedSpeed = val;
+    }
+    if (cmd == "s") {
+        this->commandedDirection = (val < 0) ? -1 : 1;
+    }
+    if ((cmd == "m") || (cmd == "s")) {
+        this->countSteps();
+    } // the steps carried out so far were made at the old microstepping ratio or towards the old target
     theCommand.append(cmd);
     theCommand.append(QString::number(val, 10));
     amisInterface->sendCommand(theCommand,true);
@@ -287,7 +473,10 @@ QString QtContinuousStepper::sendCommandToAMIS(QString cmd, long val) {
         qDebug() << "Sent: " << theCommand.toLatin1();
         qDebug() << "Received: " << theReply.toLatin1();
     }
-*/    return theReply;
+*/    if ((cmd == "s") && (this->moveWasStarted == true)) {
+        this->stepsOfMoveCounted = this->sendCommandToAMIS("f5").toLong();
+    } // the AMIS reports the steps of a move relative to the number of steps set
+    return theReply;
 }
 
 //--------------------------------------------------------------------------------
@@ -295,6 +484,13 @@ QString QtContinuousStepper::sendCommandToAMIS(QString cmd) {
     QString theCommand;
     QString theReply;
 
+    if ((cmd == "x") || (cmd == "z") || (cmd == "o")) {
+        this->countSteps();
+    }
+    if ((cmd == "z") || (cmd == "o")) {
+        this->stepsOfMoveCounted = 0;
+        this->moveWasStarted = (cmd == "o");
+    } // the AMIS sets its counter to zero
     theCommand.append(cmd);
     amisInterface->sendCommand(theCommand,true);
     theReply.append(amisInterface->getReply(true));
@@ -303,6 +499,9 @@ QString QtContinuousStepper::sendCommandToAMIS(QString cmd) {
         qDebug() << "Sent: " << theCommand.toLatin1();
         qDebug() << "Received: " << theReply.toLatin1();
     } */
+    if ((cmd == "x") && (this->moveWasStarted == true)) {
+        this->stepsOfMoveCounted = this->sendCommandToAMIS("f5").toLong();
+    } // the ramp down gets a new target, which shifts the count of the move; the steps up to here are counted
     return theReply;
 }
 
@@ -18,6 +18,7 @@
 #define QTCONTINUOUSSTEPPER_H
 
 #include <QString>
+#include "tsc_backlashtakeup.h"
 
 class QtContinuousStepper {
 private:
@@ -36,6 +37,21 @@ private:
     bool hBoxSlewEnded; // a boolean that is set to true when a long slew has timed out; needed for the handbox-slew from TSC
     bool isHBoxSlew;
     short RADirection = 1; // a value that takes +/-1; it inverts continuous motion, for instance when moving to the southern hemisphere
+    double trackingRateOffset = 0; // an additional rate in degrees/s on top of the celestial speed, for instance from refraction
+    long backlash = 0; // backlash in microsteps at the microstepping ratio for guiding
+    bool backlashCompensationIsOn = false;
+    short lastMotorDirection = 0; // sign of the last motion sent to the AMIS, 0 if unknown
+    long commandedSpeed = 0; // the last speed in microsteps/s and the sign of the last travel sent to the AMIS, for the flight recorder
+    short commandedDirection = 0;
+    double stepCounter = 0; // position of the axis in microsteps at the ratio for tracking, from the moves the AMIS carried out
+    long stepsOfMoveCounted = 0; // the part of the running move that is already in stepCounter
+    bool moveWasStarted = false; // the AMIS reports the steps of a move only between "o" and the next "z"
+    void countSteps(void); // adds the steps carried out since the last call to stepCounter
+    void countLastStepsOfMove(void); // before a stop; the AMIS are not asked for the steps again until the next move
+    long getBacklashSteps(short); // microsteps to be added to a motion in the given direction - non-zero only if the motor reverses
+    TSC_BacklashTakeUp backlashTakeUp; // the motion that waits for the slack to be taken up
+    void takeUpBacklash(short, long, long); // motor direction, speed and signed steps of the continuous motion that follows the take-up
+    void startContinuousMotion(long, long); // speed and signed steps
     QString sendCommandToAMIS(QString, long);
     QString sendCommandToAMIS(QString);
 
@@ -43,9 +59,12 @@ public:
     QtContinuousStepper(void);
     ~QtContinuousStepper(void);
     void startTracking(void); // start continuous motion to compensate for earth's rotation
-    void travelForNSteps(long,short,int,bool);
+    void travelForNSteps(long,short,double,bool); // the multiple of sidereal speed need not be an integer; synchronised slews scale it down
     void travelForNSteps(short,float);
     void setRADirection(short); // switch "RADirection"
+    bool setTrackingRateOffset(double); // set an additional tracking rate in degrees/s; returns true if the drive speed changes
+    bool adjustTrackingSpeed(long); // new speed in microsteps/s for the running drive; returns false if nothing was sent
+    long getTrackingSpeed(void); // the speed in microsteps/s the drive runs at, or will run at after a backlash take-up; 0 if it is stopped
     void setGearRatioAndMicrosteps(double, double); // the product of the gears divided by the step size and the number of microsteps is stored here
     void changeMicroSteps(double); // switches the microstepping ratio for variable drivers
     void setInitialParamsAndComputeBaseSpeed(double,double); // after opening
@@ -56,12 +75,20 @@ public:
     void setStepperParams(double, short); // set acceleration, speed and current and convey it to the controller
     void shutDownDrive(void); // set motor to "unengaged state" - no more current is applied
     bool getStopped(void); // check whether the motor is active or not ...
+    bool finishBacklashTakeUp(void); // polled from the event queue; true if a take-up ended and the queued motion was started
+    double getCommandedRate(void); // motion of the axis in degrees/s as last commanded, signed; 0 if the drive was stopped
     void resetSteppersAfterStop(void);
     void setDriveToStopped(void); // necessary to convey the AMIS that they were stopped
     void stopDrive(void); // halt the motor
     //void engageDrive(void); // set motor to "engaged" stae without driving it
     void changeSpeedForGearChange(void); // a callback that changes speeds if the gear ratios change
     bool hasHBoxSlewEnded(void); // retrieve the state of the "hBoxSlewEnded" - flag ...
-
+    void setBacklash(long); // backlash in microsteps at the microstepping ratio for guiding
+    long getBacklash(void);
+    void setBacklashCompensation(bool); // if set, the backlash is taken up whenever the motor reverses
+    long long getStepCounter(void); // position of the axis in microsteps at the ratio for tracking, as counted by the AMIS; it counts up with the hour angle.
+        // the value is the one of the last count, which is taken whenever a move is stopped or replaced
+    void refreshStepCounter(void); // counts the steps of a running move now
+    void setStepCounter(long long); // for a position restored after a restart
 };
 #endif // QTCONTINUOUSSTEPPER_H
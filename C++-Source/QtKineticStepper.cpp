@@ -102,7 +102,7 @@ void QtKineticStepper::setInitialParamsAndComputeBaseSpeed(double lacc, double l
 }
 
 //-----------------------------------------------------------------------------
-void QtKineticStepper::travelForNSteps(long steps,short direction, int factor,bool isHBSlew) {
+void QtKineticStepper::travelForNSteps(long steps,short direction, double factor,bool isHBSlew) {
     const short directionfactor = -1; // change to switch directions of the drive
 
     this->hBoxSlewEnded = false;
@@ -113,10 +113,15 @@ void QtKineticStepper::travelForNSteps(long steps,short direction, int factor,bo
     } else {
         direction = 1;
     }
+    this->backlashTakeUp.cancel(); // the new target replaces a motion that waits for a take-up
+    if (steps > 0) {
+        steps += this->getBacklashSteps(g_AllData->getMFlipDecSign()*directionfactor*direction); // the slack is travelled at the same speed
+    }
     this->sendCommandToAMIS("v",(long)(this->speedMax));
     this->sendCommandToAMIS("z");
     this->sendCommandToAMIS("s", (long)g_AllData->getMFlipDecSign()*directionfactor*direction*steps);
     this->sendCommandToAMIS("o");
+    this->trackingSpeed = 0; // a continuous motion is replaced by the new one
     this->stopped = false;
 }
 
@@ -125,19 +130,46 @@ void QtKineticStepper::travelForNSteps(long steps,short direction, int factor,bo
 void QtKineticStepper::travelForNSteps(short direction, float factor) {
     const short directionfactor = -1; // change to switch directions of the drive
 
-    this->speedMax=round(factor*g_AllData->getCelestialSpeed()*(this->gearRatio)*(this->microsteps));
     if (direction < 0) {
         direction = -1;
     } else {
         direction = 1;
     }
-    this->sendCommandToAMIS("v",(long)(this->speedMax));
-    this->sendCommandToAMIS("z");
-    this->sendCommandToAMIS("s", (long)g_AllData->getMFlipDecSign()*directionfactor*direction*1000000000);
-    this->sendCommandToAMIS("o");
+    this->speedMax=round(factor*g_AllData->getCelestialSpeed()*(this->gearRatio)*(this->microsteps));
+    this->takeUpBacklash(g_AllData->getMFlipDecSign()*directionfactor*direction, (long)(this->speedMax),
+                         (long)g_AllData->getMFlipDecSign()*directionfactor*direction*1000000000); // a guide pulse has to move the axis from its first microstep
+    this->trackingSpeed = 0;
+    this->stopped = false;
+}
+
+//-----------------------------------------------------------------------------
+// the declination drive does not compensate earth motion, but moving objects require a slow motion that lasts
+// until the next rate update. the drive runs for one day at most, just like the RA drive
+void QtKineticStepper::startTracking(long speed) {
+    const short directionfactor = -1; // change to switch directions of the drive
+    short direction;
+
+    if (speed == 0) {
+        this->stopDrive();
+        return;
+    }
+    if (speed < 0) {
+        direction = -1;
+    } else {
+        direction = 1;
+    }
+    this->speedMax=labs(speed);
+    this->takeUpBacklash(g_AllData->getMFlipDecSign()*directionfactor*direction, (long)(this->speedMax),
+                         (long)g_AllData->getMFlipDecSign()*directionfactor*direction*(60*60*24*labs(speed)));
+    this->trackingSpeed = speed;
     this->stopped = false;
 }
 
+//-----------------------------------------------------------------------------
+long QtKineticStepper::getTrackingSpeed(void) {
+    return this->trackingSpeed;
+}
+
 //----------------------------------------------------------------------------------
 void QtKineticStepper::resetSteppersAfterStop(void) { // this function is called once it was detected that the steppers stopped moving
     this->stopped = true;
@@ -212,6 +244,8 @@ void QtKineticStepper::setStepperParams(double val, short whichOne) {
 //-----------------------------------------------------------------------------
 
 void QtKineticStepper::shutDownDrive(void) {
+    this->backlashTakeUp.cancel();
+    this->countLastStepsOfMove();
     this->stopped=true;
     this->sendCommandToAMIS("x");
     this->sendCommandToAMIS("e",0);
@@ -223,11 +257,22 @@ bool QtKineticStepper::getStopped(void) {
     return (this->stopped);
 }
 
+//------------------------------------------------------------------------------
+double QtKineticStepper::getCommandedRate(void) {
+    if ((this->stopped == true) || (this->gearRatio*this->microsteps <= 0)) {
+        return 0;
+    }
+    return this->commandedDirection*this->commandedSpeed/(this->gearRatio*this->microsteps);
+}
+
 //------------------------------------------------------------------------------
 void QtKineticStepper::stopDrive(void) {
+    this->backlashTakeUp.cancel();
+    this->countLastStepsOfMove();
     this->sendCommandToAMIS("s",0);
     this->sendCommandToAMIS("x");
     this->sendCommandToAMIS("z");
+    this->trackingSpeed = 0;
     this->stopped=true;
 }
 
@@ -254,12 +299,140 @@ bool QtKineticStepper::hasHBoxSlewEnded(void) {
     return this->hBoxSlewEnded;
 }
 
+//--------------------------------------------------------------------------------
+void QtKineticStepper::setBacklash(long steps) {
+    if (steps >= 0) {
+        this->backlash = steps;
+    }
+}
+
+//--------------------------------------------------------------------------------
+long QtKineticStepper::getBacklash(void) {
+    return this->backlash;
+}
+
+//--------------------------------------------------------------------------------
+void QtKineticStepper::setBacklashCompensation(bool isOn) {
+    this->backlashCompensationIsOn = isOn;
+}
+
+//--------------------------------------------------------------------------------
+// the backlash is given for the microstepping ratio used in guiding and has to be scaled to the current one.
+// the direction of every motion is remembered, even if compensation is off, so that switching it on
+// during a session does not cause a wrong correction
+long QtKineticStepper::getBacklashSteps(short motorDirection) {
+    long steps = 0;
+
+    if (motorDirection == 0) {
+        return 0;
+    }
+    if ((this->backlashCompensationIsOn == true) && (this->lastMotorDirection != 0) && (this->lastMotorDirection != motorDirection)) {
+        steps = round(this->backlash*this->microsteps/((double)g_AllData->getMicroSteppingRatio(0)));
+    }
+    this->lastMotorDirection = motorDirection;
+    return steps;
+}
+
+//--------------------------------------------------------------------------------
+// same as in QtContinuousStepper; the motion after the take-up is queued and started by finishBacklashTakeUp
+void QtKineticStepper::takeUpBacklash(short motorDirection, long speed, long steps) {
+    long backlashSteps, takeUpSpeed;
+
+    backlashSteps = this->getBacklashSteps(motorDirection);
+    if ((backlashSteps == 0) && (this->backlashTakeUp.isRunning() == true)) {
+        this->backlashTakeUp.queueMotion(speed, steps);
+        return;
+    } // the motor keeps its direction; only the motion after the take-up changes
+    if (backlashSteps == 0) {
+        this->startContinuousMotion(speed, steps);
+        return;
+    }
+    takeUpSpeed = this->backlashTakeUp.getTakeUpSpeed(g_AllData->getCelestialSpeed()*(this->gearRatio)*(this->microsteps));
+    this->sendCommandToAMIS("v",takeUpSpeed);
+    this->sendCommandToAMIS("z");
+    this->sendCommandToAMIS("s",motorDirection*backlashSteps);
+    this->sendCommandToAMIS("o");
+    this->backlashTakeUp.start(backlashSteps, takeUpSpeed, speed, steps);
+}
+
+//--------------------------------------------------------------------------------
+void QtKineticStepper::startContinuousMotion(long speed, long steps) {
+    this->sendCommandToAMIS("v",speed);
+    this->sendCommandToAMIS("z");
+    this->sendCommandToAMIS("s",steps);
+    this->sendCommandToAMIS("o");
+}
+
+//--------------------------------------------------------------------------------
+bool QtKineticStepper::finishBacklashTakeUp(void) {
+    if (this->backlashTakeUp.isRunning() == false) {
+        return false;
+    }
+    if ((this->sendCommandToAMIS("f0").toLong() != 0) && (this->backlashTakeUp.hasTimedOut() == false)) {
+        return false;
+    }
+    this->backlashTakeUp.cancel();
+    this->startContinuousMotion(this->backlashTakeUp.getQueuedSpeed(), this->backlashTakeUp.getQueuedSteps());
+    return true;
+}
+
+//--------------------------------------------------------------------------------
+// the AMIS counts the steps of the running move only; "o" and "z" set its counter to zero. the steps are therefore
+// collected before the counter is reset, and scaled to the microstepping ratio for tracking. the direction of the
+// motor is reversed as in "travelForNSteps", so that the counter runs with the declination
+void QtKineticStepper::countSteps(void) {
+    long stepsOfMove;
+    bool isValid = false;
+
+    if (this->moveWasStarted == false) {
+        return;
+    }
+    stepsOfMove = this->sendCommandToAMIS("f5").toLong(&isValid);
+    if ((isValid == false) || (this->microsteps <= 0)) {
+        return;
+    }
+    this->stepCounter -= g_AllData->getMFlipDecSign()*(stepsOfMove - this->stepsOfMoveCounted)*g_AllData->getMicroSteppingRatio(0)/this->microsteps;
+    this->stepsOfMoveCounted = stepsOfMove;
+}
+
+//--------------------------------------------------------------------------------
+// as in QtContinuousStepper
+void QtKineticStepper::countLastStepsOfMove(void) {
+    this->countSteps();
+    this->moveWasStarted = false;
+}
+
+//--------------------------------------------------------------------------------
+long long QtKineticStepper::getStepCounter(void) {
+    return llround(this->stepCounter);
+}
+
+//--------------------------------------------------------------------------------
+void QtKineticStepper::refreshStepCounter(void) {
+    this->countSteps();
+}
+
+//--------------------------------------------------------------------------------
+void QtKineticStepper::setStepCounter(long long steps) {
+    this->countSteps();
+    this->stepCounter = steps;
+}
+
 //--------------------------------------------------------------------------------
 // two private routines to simplify communications with the AMIS
 QString QtKineticStepper::sendCommandToAMIS(QString cmd, long val) {
     QString theCommand;
     QString theReply;
 
+    if (cmd == "v") {
+        this->commandedSpeed = val;
+    }
+    if (cmd == "s") {
+        this->commandedDirection = (val < 0) ? -1 : 1;
+    }
+    if ((cmd == "m") || (cmd == "s")) {
+        this->countSteps();
+    } // the steps carried out so far were made at the old microstepping ratio or towards the old target
     theCommand.append(cmd);
     theCommand.append(QString::number(val, 10));
     amisInterface->sendCommand(theCommand,false);
@@ -269,6 +442,9 @@ QString QtKineticStepper::sendCommandToAMIS(QString cmd, long val) {
         qDebug() << "Sent: " << theCommand.toLatin1();
         qDebug() << "Received: " << theReply.toLatin1();
     }*/
+    if ((cmd == "s") && (this->moveWasStarted == true)) {
+        this->stepsOfMoveCounted = this->sendCommandToAMIS("f5").toLong();
+    } // the AMIS reports the steps of a move relative to the number of steps set
     return theReply;
 }
 
@@ -277,6 +453,13 @@ QString QtKineticStepper::sendCommandToAMIS(QString cmd) {
     QString theCommand;
     QString theReply;
 
+    if ((cmd == "x") || (cmd == "z") || (cmd == "o")) {
+        this->countSteps();
+    }
+    if ((cmd == "z") || (cmd == "o")) {
+        this->stepsOfMoveCounted = 0;
+        this->moveWasStarted = (cmd == "o");
+    } // the AMIS sets its counter to zero
     theCommand.append(cmd);
     amisInterface->sendCommand(theCommand,false);
     theReply.append(amisInterface->getReply(false));
@@ -285,5 +468,8 @@ QString QtKineticStepper::sendCommandToAMIS(QString cmd) {
         qDebug() << "Sent: " << theCommand.toLatin1();
         qDebug() << "Received: " << theReply.toLatin1();
     }*/
+    if ((cmd == "x") && (this->moveWasStarted == true)) {
+        this->stepsOfMoveCounted = this->sendCommandToAMIS("f5").toLong();
+    } // the ramp down gets a new target, which shifts the count of the move; the steps up to here are counted
     return theReply;
 }
@@ -21,6 +21,7 @@
 #define QTKINETICSTEPPER_H
 
 #include <QString>
+#include "tsc_backlashtakeup.h"
 //#include "usb_communications.h"
 
 class QtKineticStepper {
@@ -40,6 +41,21 @@ private:
     double stepsPerSecond; // the current rate of microsteps per second
     bool hBoxSlewEnded; // a boolean that is set to true when a long slew has timed out; needed for the handbox-slew from TSC
     bool isHBoxSlew;
+    long trackingSpeed = 0; // speed in microsteps/s of the continuous motion started by startTracking; the sign gives the direction
+    long backlash = 0; // backlash in microsteps at the microstepping ratio for guiding
+    bool backlashCompensationIsOn = false;
+    short lastMotorDirection = 0; // sign of the last motion sent to the AMIS; 0 as long as it is not known which side of the gear is loaded
+    long commandedSpeed = 0; // the last speed in microsteps/s and the sign of the last travel sent to the AMIS, for the flight recorder
+    short commandedDirection = 0;
+    double stepCounter = 0; // position of the axis in microsteps at the ratio for tracking, from the moves the AMIS carried out
+    long stepsOfMoveCounted = 0; // the part of the running move that is already in stepCounter
+    bool moveWasStarted = false; // the AMIS reports the steps of a move only between "o" and the next "z"
+    void countSteps(void); // adds the steps carried out since the last call to stepCounter
+    void countLastStepsOfMove(void); // before a stop; the AMIS are not asked for the steps again until the next move
+    long getBacklashSteps(short); // microsteps to be added to a motion in the given direction - non-zero only if the motor reverses
+    TSC_BacklashTakeUp backlashTakeUp; // the motion that waits for the slack to be taken up
+    void takeUpBacklash(short, long, long); // motor direction, speed and signed steps of the continuous motion that follows the take-up
+    void startContinuousMotion(long, long); // speed and signed steps
     QString sendCommandToAMIS(QString, long);
     QString sendCommandToAMIS(QString);
 
@@ -49,20 +65,31 @@ public:
     void setGearRatioAndMicrosteps(double, double); // the product of the gears divided by the step size and the number of microsteps is stored here
     void changeMicroSteps(double); // switches the microstepping ratio for variable drivers
     void setInitialParamsAndComputeBaseSpeed(double,double); // after opening
-    void travelForNSteps(long,short,int,bool); // tell the drive to travel for steps, direction (+/-1),
+    void travelForNSteps(long,short,double,bool); // tell the drive to travel for steps, direction (+/-1),
         // a multiple of sidereal speed and a flag that indicates whether the slew was triggered by the handbox.
         // handbox slews terminate either after 180 or 360 degrees ...
     void travelForNSteps(short,float); // tell the drive to travel a constant number of steps in direction (+/-1) and a fraction of sidereal speed - used in ST4 guiding
+    void startTracking(long); // continuous motion at a given number of microsteps/s, the sign gives the direction - used for tracking moving objects
+    long getTrackingSpeed(void); // the speed of the continuous motion, 0 if the drive does not track
     double getKineticsFromController(short); //get parameters from controller such as maximum current, currently set acceleration, currently set velocity and so on ...
     bool getErrorFromDriver(void); // return the state of the error pin
     void setStepperParams(double, short); // set acceleration, speed and current and convey it to the controller
     void shutDownDrive(void); // set motor to "unengaged state" - no more current is applied
     bool getStopped(void); // check whether the motor is active or not ...
+    bool finishBacklashTakeUp(void); // polled from the event queue; true if a take-up ended and the queued motion was started
+    double getCommandedRate(void); // motion of the axis in degrees/s as last commanded, signed; 0 if the drive was stopped
     void stopDrive(void); // halt the motor
     void resetSteppersAfterStop(void);
     //void setDriveToStopped(void); // necessary to convey the AMIS that they were stopped
     //void engageDrive(void); // set motor to "engaged" stae without driving it
     void changeSpeedForGearChange(void); // a callback that changes speeds if the gear ratios change
     bool hasHBoxSlewEnded(void); // retrieve the state of the "hBoxSlewEnded" - flag ...
+    void setBacklash(long); // backlash in microsteps at the microstepping ratio for guiding
+    long getBacklash(void);
+    void setBacklashCompensation(bool); // if set, the backlash is taken up whenever the motor reverses
+    long long getStepCounter(void); // position of the axis in microsteps at the ratio for tracking, as counted by the AMIS; it counts up with the declination.
+        // the value is the one of the last count, which is taken whenever a move is stopped or replaced
+    void refreshStepCounter(void); // counts the steps of a running move now
+    void setStepCounter(long long); // for a position restored after a restart
 };
 #endif // QTKINETICSTEPPER_H
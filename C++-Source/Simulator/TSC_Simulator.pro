@@ -0,0 +1,87 @@
+#-------------------------------------------------
+#
+# headless simulator of TSC - runs an observing night on a virtual mount
+# the drive classes and the guiding code are taken from the main project
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+TARGET = TSC_Simulator
+TEMPLATE = app
+CONFIG += c++11
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += $$PWD/..
+
+SOURCES += \
+    simulatormain.cpp \
+    sim_usb_communications.cpp \
+    tsc_virtualamis.cpp \
+    tsc_virtualmount.cpp \
+    tsc_virtualsky.cpp \
+    tsc_nightbenchmark.cpp \
+    tsc_guidereplay.cpp \
+    ../tsc_globaldata.cpp \
+    ../QtContinuousStepper.cpp \
+    ../tsc_backlashtakeup.cpp \
+    ../QtKineticStepper.cpp \
+    ../ocv_guiding.cpp \
+    ../tsc_sequencer.cpp \
+    ../tsc_refraction.cpp \
+    ../tsc_slewtimemodel.cpp \
+    ../tsc_horizonmask.cpp \
+    ../currentObjectCatalog.cpp \
+    ../tsc_coordinatebatch.cpp \
+    ../tsc_drivetuner.cpp \
+    ../tsc_slewplanner.cpp \
+    ../tsc_mountcontrol.cpp \
+    ../tsc_driftcalibration.cpp \
+    ../tsc_centroid.cpp \
+    ../tsc_starensemble.cpp \
+    ../tsc_fitsdecoder.cpp \
+    ../tsc_guidealgorithm.cpp \
+    ../tsc_guidelog.cpp \
+    ../tsc_starfinder.cpp
+
+HEADERS += \
+    tsc_virtualamis.h \
+    tsc_virtualmount.h \
+    tsc_virtualsky.h \
+    tsc_nightbenchmark.h \
+    tsc_guidereplay.h \
+    ../tsc_globaldata.h \
+    ../usb_communications.h \
+    ../QtContinuousStepper.h \
+    ../tsc_backlashtakeup.h \
+    ../QtKineticStepper.h \
+    ../ocv_guiding.h \
+    ../tsc_sequencer.h \
+    ../tsc_refraction.h \
+    ../tsc_slewtimemodel.h \
+    ../tsc_horizonmask.h \
+    ../currentObjectCatalog.h \
+    ../tsc_coordinatebatch.h \
+    ../tsc_drivetuner.h \
+    ../tsc_slewplanner.h \
+    ../tsc_mountcontrol.h \
+    ../tsc_driftcalibration.h \
+    ../tsc_centroid.h \
+    ../tsc_starensemble.h \
+    ../tsc_fitsdecoder.h \
+    ../tsc_guidealgorithm.h \
+    ../tsc_guidelog.h \
+    ../tsc_starfinder.h
+
+INCLUDEPATH += /usr/local/include/opencv2
+
+unix:!macx: LIBS += -L$$PWD/../../../../usr/local/lib/ -lopencv_core
+
+INCLUDEPATH += $$PWD/../../../../usr/local/include
+DEPENDPATH += $$PWD/../../../../usr/local/include
+
+unix:!macx: LIBS += -L$$PWD/../../../../usr/local/lib/ -lopencv_imgproc
+
+INCLUDEPATH += $$PWD/../../../../usr/local/include
+DEPENDPATH += $$PWD/../../../../usr/local/include
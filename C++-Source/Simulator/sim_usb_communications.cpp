@@ -0,0 +1,127 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+// a replacement for usb_communications.cpp in the simulator; the class declaration is the same, but
+// the commands for the teensy boards are handed to the virtual mount instead of libusb. the drive
+// classes QtContinuousStepper and QtKineticStepper are therefore used without any change.
+
+#include "usb_communications.h"
+#include "tsc_globaldata.h"
+#include "tsc_virtualmount.h"
+#include <QDebug>
+
+extern TSC_GlobalData *g_AllData;
+extern TSC_VirtualMount *g_VirtualMount;
+
+usbCommunications::usbCommunications(int whichVID) {
+    this->theVID = whichVID;
+    this->deviceList = NULL;
+    this->deviceHandles[0] = NULL;
+    this->deviceHandles[1] = NULL;
+    this->devCnt = 2;
+    this->commandData[0] = NULL;
+    this->commandData[1] = NULL;
+    this->dataReceived[0] = new QString();
+    this->dataReceived[1] = new QString();
+    this->startupResponse = new QString();
+    this->indexForRA = 0;
+    this->indexForDecl = 1;
+    this->gotDeviceList = true;
+    this->usbDeviceIsOpen = true;
+    this->interfaceClaimed = true;
+    g_AllData->setDriverAvailability(true);
+}
+
+//---------------------------------------------------
+void usbCommunications::closeUSBConnection(void) {
+    if (this->usbConnAvailable == true) {
+        this->usbConnAvailable = false;
+        delete this->dataReceived[0];
+        delete this->dataReceived[1];
+        delete this->startupResponse;
+    }
+}
+
+//---------------------------------------------------
+bool usbCommunications::getUSBErrs(usbState errStat) {
+    switch (errStat) {
+        case open: return this->usbDeviceIsOpen; break;
+        case avail: return this->usbConnAvailable; break;
+        case init: return this->initErr; break;
+        case devListAvail: return this->gotDeviceList; break;
+        case kernelDrvr: return this->kernelDriverActive; break;
+        case claimed: return this->interfaceClaimed; break;
+        case writeErr: return this->writeError; break;
+        case released: return this->interfaceReleased; break;
+        case readErr: return this->readError; break;
+    }
+    return false;
+}
+
+//---------------------------------------------------
+// the virtual boards answer immediately; the reply is stored just like the one received via USB
+bool usbCommunications::sendCommand(QString theCmd, bool isRA) {
+    short idx;
+
+    this->deleteResponse(isRA);
+    if (isRA == true) {
+        idx = this->indexForRA;
+    } else {
+        idx = this->indexForDecl;
+    }
+    if (g_VirtualMount == NULL) {
+        this->writeError = true;
+        qDebug() << "No virtual mount available.";
+        return this->writeError;
+    }
+    this->dataReceived[idx]->append(g_VirtualMount->sendCommand(theCmd, isRA));
+    this->writeError = false;
+    return this->writeError;
+}
+
+//---------------------------------------------------
+bool usbCommunications::receiveReply(bool) {
+    this->readError = false;
+    return true;
+}
+
+//---------------------------------------------------
+QString usbCommunications::getReply(bool isRA) {
+    short idx;
+    QString reply;
+
+    if (isRA == true) {
+        idx = this->indexForRA;
+    } else {
+        idx = this->indexForDecl;
+    }
+    reply = *this->dataReceived[idx];
+    this->dataReceived[idx]->clear();
+    return reply;
+}
+
+//---------------------------------------------------
+void usbCommunications::deleteResponse(bool isRA) {
+    if (isRA == true) {
+        this->dataReceived[this->indexForRA]->clear();
+    } else {
+        this->dataReceived[this->indexForDecl]->clear();
+    }
+}
+
+//---------------------------------------------------
+// the virtual boards have no latency
+double usbCommunications::getRoundTripTime(bool) {
+    return 0;
+}
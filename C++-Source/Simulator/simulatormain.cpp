@@ -0,0 +1,594 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+// the headless simulator of TSC. it runs an observing night on a virtual mount and prints the accuracy
+// of GoTo, tracking and guiding together with the time needed. options:
+// -n <number of random targets>, -s <sequence file .tsq>, -t <length of the night in h>, -l <LST at start in h>,
+// -e <guide exposure in s>, -f <seeing FWHM in arcsec>, -j <image motion in arcsec>, -p <periodic error in arcsec>,
+// -d <declination drift in arcsec/min>, -r <random seed>
+// -c <directory with NGC.tsc and IC.tsc> does not run a night, but times the conversion of the catalogs to alt/az
+// -a runs the auto-tuning of acceleration, current and GoTo speed against motors that stall under a load
+// -i moves the axes of a GoTo independently at full speed instead of on a synchronised, straight path
+// -m <up>,<east> tilts the polar axis of the virtual mount by the given arcmin, -g <RA gear error in %>
+// -k plate solves while the mount tracks unguided and corrects the tracking rates from the drift
+// -x does not run a night, but measures the precision of the guide star centroids on synthetic stars
+// -z <number of guide stars>, -u <part of the image motion that differs between stars, 0..1>,
+// -o <part of the chip covered by a passing cloud, 0..1>
+// -w waits for the guide correction before the next guide exposure instead of starting it when the image arrives
+// -y does not run a night, but times the decoding of 16 bit guide camera images
+// -q reads out only a subframe around the guide stars while guiding
+// -b <RA>,<decl> guide algorithms: 0 hysteresis, 1 low pass, 2 resist switch, 3 PID, 4 predictive
+// -h <file> writes the guide frames of the night to a guiding log as TSC does
+// -v <guiding log> does not run a night, but replays a GuidingLog.csv through all guide algorithms; for the text
+//    logs of older versions, -e is taken as the time between the frames
+// -M <RA rate>,<decl rate>,<decl backlash in pixels> is the mount model of the replay; the rates are fractions of
+//    the motion expected from the calibration
+// -A selects the guide star by searching the rendered frame as the "Find Star" button does, instead of from the catalog
+
+#include <QGuiApplication>
+#include <QString>
+#include <QElapsedTimer>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include "tsc_globaldata.h"
+#include "usb_communications.h"
+#include "tsc_virtualmount.h"
+#include "tsc_nightbenchmark.h"
+#include "currentObjectCatalog.h"
+#include "tsc_fitsdecoder.h"
+#include "tsc_coordinatebatch.h"
+#include "tsc_horizonmask.h"
+#include "tsc_drivetuner.h"
+#include "tsc_centroid.h"
+#include "tsc_guidealgorithm.h"
+#include "tsc_guidereplay.h"
+
+TSC_GlobalData *g_AllData;
+usbCommunications *amisInterface;
+TSC_VirtualMount *g_VirtualMount;
+
+//---------------------------------------------------
+// the visibility check of the catalog list, once as a batch and once object by object as it was done before
+static int runCatalogBenchmark(QString catalogDir, double lst) {
+    const char *names[2] = {"NGC.tsc", "IC.tsc"};
+    currentObjectCatalog *catalog;
+    TSC_CoordinateBatch *batch;
+    TSC_HorizonMask *mask;
+    QElapsedTimer timer;
+    std::vector<float> ra, decl;
+    double alt, az, errAlt = 0, errAz = 0, batchUS, scalarUS;
+    long idx, run, runs = 200, visible = 0, visibleBatch = 0;
+    short cat;
+
+    for (cat = 0; cat < 2; cat++) {
+        catalog = new currentObjectCatalog(catalogDir + QString("/") + QString(names[cat]));
+        for (idx = 0; idx < catalog->getNumberOfObjects(); idx++) {
+            ra.push_back(catalog->getRADec(idx));
+            decl.push_back(catalog->getDeclDec(idx));
+        }
+        delete catalog;
+    }
+    if (ra.empty() == true) {
+        printf("No catalog objects found in %s\n", catalogDir.toLatin1().constData());
+        return 1;
+    }
+    batch = new TSC_CoordinateBatch();
+    mask = new TSC_HorizonMask();
+    batch->setLatitude(g_AllData->getSiteCoords(0));
+    mask->setLatitude(g_AllData->getSiteCoords(0));
+    for (idx = 0; idx < (long)ra.size(); idx++) {
+        batch->addObject(ra[idx], decl[idx]);
+    }
+    timer.start();
+    for (run = 0; run < runs; run++) {
+        batch->convert(lst + run*0.001);
+        visibleBatch = 0;
+        for (idx = 0; idx < (long)ra.size(); idx++) {
+            if (mask->isReachableAltAz(batch->getHourAngle(idx), decl[idx], batch->getAltitude(idx), batch->getAzimuth(idx)) == true) {
+                visibleBatch++;
+            }
+        }
+    }
+    batchUS = timer.nsecsElapsed()/1000.0/runs; // the same work as below: conversion and horizon check of every object
+    timer.start();
+    for (run = 0; run < runs; run++) {
+        visible = 0;
+        for (idx = 0; idx < (long)ra.size(); idx++) {
+            if (mask->isReachable((lst + run*0.001)*15.0 - ra[idx], decl[idx]) == true) {
+                visible++;
+            }
+        }
+    }
+    scalarUS = timer.nsecsElapsed()/1000.0/runs;
+    for (idx = 0; idx < (long)ra.size(); idx++) {
+        TSC_Refraction::convertHADeclToAltAz(batch->getHourAngle(idx), decl[idx], g_AllData->getSiteCoords(0), &alt, &az);
+        errAlt = fmax(errAlt, fabs(alt - batch->getAltitude(idx)));
+        if (alt < 89) { // the azimuth is undefined at the zenith
+            errAz = fmax(errAz, fabs(remainder(az - batch->getAzimuth(idx), 360.0))*cos(alt/180.0*M_PI));
+        }
+    }
+    printf("Catalog conversion: %ld objects, %ld reachable (%ld from the batch)\n", (long)ra.size(), visible, visibleBatch);
+    printf("  batch:      %8.1f us per conversion and horizon check\n", batchUS);
+    printf("  per object: %8.1f us per conversion and horizon check\n", scalarUS);
+    printf("  largest difference: altitude %.5f deg, azimuth %.5f deg on the sky\n", errAlt, errAz);
+    delete batch;
+    delete mask;
+    return 0;
+}
+
+//---------------------------------------------------
+static unsigned int benchmarkRandomState = 12345;
+
+static double getBenchmarkUniform(void) {
+    benchmarkRandomState = benchmarkRandomState*1664525u + 1013904223u;
+    return ((benchmarkRandomState >> 8) + 0.5)/16777216.0;
+}
+
+//---------------------------------------------------
+static double getBenchmarkGaussian(void) {
+    return sqrt(-2.0*log(getBenchmarkUniform()))*cos(2*M_PI*getBenchmarkUniform());
+}
+
+//---------------------------------------------------
+// synthetic stars at random sub-pixel positions near the centre of a region of interest of 180 x 180 pixels,
+// as the guiding cuts it out around the selected star. the pixels integrate a gaussian or moffat profile;
+// photon noise for a gain of 1 electron per ADU, read noise and the 8 bit quantisation are added. the
+// reference is the binary moments of the pixels above the guiding threshold, which TSC used before; the
+// threshold is set to half the peak of the star, but at least 5 sigma above the background. a centroid more
+// than 3 pixels off is counted as a false detection and not in the rms error.
+static void runCentroidBenchmark(void) {
+    const char *estimatorNames[6] = {"threshold", "moments", "windowed", "gaussian", "moffat", "quadratic"};
+    const double psfFWHM[3] = {2.5, 4.0, 3.0}, peaks[3] = {15, 40, 150}, background = 30, readNoise = 3, beta = 3;
+    const bool psfIsMoffat[3] = {false, false, true};
+    const int imgSize = 200, roiSize = 180, trials = 400;
+    int threshold[3];
+    std::vector<unsigned char> pixels(imgSize*imgSize);
+    TSC_Centroid *centroid;
+    QElapsedTimer timer;
+    double starX, starY, sigma, alpha, val, sx, sy, r2, cx, cy, m00, err2, sqErr[6], fwhmSum[6], snrSum[6], hfdSum[6], nsecs[6];
+    long hits[6], misses[6];
+    int psf, pk, trial, x, y, sub, est;
+
+    centroid = new TSC_Centroid();
+    printf("Centroid benchmark: %d stars per case, background %.0f ADU, read noise %.0f ADU\n", trials, background, readNoise);
+    printf("  %-10s %8s %8s %8s %8s %8s %8s %8s\n", "estimator", "rms[px]", "fwhm", "snr", "hfd", "us", "found", "false");
+    for (psf = 0; psf < 3; psf++) {
+        sigma = psfFWHM[psf]/2.35482;
+        alpha = psfFWHM[psf]/(2*sqrt(pow(2.0, 1.0/beta) - 1));
+        for (pk = 0; pk < 3; pk++) {
+            threshold[pk] = (int)(background + fmax(0.5*peaks[pk], 5*sqrt(background + readNoise*readNoise)));
+            for (est = 0; est < 6; est++) {
+                sqErr[est] = fwhmSum[est] = snrSum[est] = hfdSum[est] = nsecs[est] = 0;
+                hits[est] = misses[est] = 0;
+            }
+            for (trial = 0; trial < trials; trial++) {
+                starX = imgSize/2 + 6*(getBenchmarkUniform() - 0.5);
+                starY = imgSize/2 + 6*(getBenchmarkUniform() - 0.5);
+                for (y = 0; y < imgSize; y++) {
+                    for (x = 0; x < imgSize; x++) {
+                        val = 0;
+                        if ((fabs(x - starX) < 8*psfFWHM[psf]) && (fabs(y - starY) < 8*psfFWHM[psf])) {
+                            for (sub = 0; sub < 16; sub++) {
+                                sx = x - 0.375 + 0.25*(sub%4) - starX;
+                                sy = y - 0.375 + 0.25*(sub/4) - starY;
+                                r2 = sx*sx + sy*sy;
+                                if (psfIsMoffat[psf] == false) {
+                                    val += exp(-r2/(2*sigma*sigma))/16.0;
+                                } else {
+                                    val += pow(1 + r2/(alpha*alpha), -beta)/16.0;
+                                }
+                            }
+                        }
+                        val = background + peaks[pk]*val;
+                        val += sqrt(val)*getBenchmarkGaussian() + readNoise*getBenchmarkGaussian();
+                        pixels[y*imgSize + x] = (unsigned char)fmin(255, fmax(0, round(val)));
+                    }
+                }
+                for (est = 0; est < 6; est++) {
+                    timer.start();
+                    if (est == 0) {
+                        m00 = cx = cy = 0;
+                        for (y = (imgSize - roiSize)/2; y < (imgSize + roiSize)/2; y++) {
+                            for (x = (imgSize - roiSize)/2; x < (imgSize + roiSize)/2; x++) {
+                                if (pixels[y*imgSize + x] > threshold[pk]) {
+                                    m00++;
+                                    cx += x;
+                                    cy += y;
+                                }
+                            }
+                        }
+                        nsecs[est] += timer.nsecsElapsed();
+                        if (m00 > 0.01) {
+                            cx /= m00;
+                            cy /= m00;
+                            err2 = (cx - starX)*(cx - starX) + (cy - starY)*(cy - starY);
+                            if (err2 > 9) {
+                                misses[est]++;
+                            } else {
+                                sqErr[est] += err2;
+                                hits[est]++;
+                            }
+                        }
+                        continue;
+                    }
+                    centroid->setEstimator(est - 1);
+                    if (centroid->measure(pixels.data(), imgSize, (imgSize - roiSize)/2, (imgSize - roiSize)/2, roiSize, roiSize) == true) {
+                        nsecs[est] += timer.nsecsElapsed();
+                        cx = centroid->getCentroid(0);
+                        cy = centroid->getCentroid(1);
+                        err2 = (cx - starX)*(cx - starX) + (cy - starY)*(cy - starY);
+                        if (err2 > 9) {
+                            misses[est]++;
+                            continue;
+                        } // a spot of noise was taken for the star
+                        sqErr[est] += err2;
+                        fwhmSum[est] += centroid->getFWHM();
+                        snrSum[est] += centroid->getSNR();
+                        hfdSum[est] += centroid->getHFD();
+                        hits[est]++;
+                    } else {
+                        nsecs[est] += timer.nsecsElapsed();
+                    }
+                }
+            }
+            printf("%s profile, FWHM %.1f px, peak %.0f ADU:\n", (psfIsMoffat[psf] == true) ? "moffat" : "gaussian", psfFWHM[psf], peaks[pk]);
+            for (est = 0; est < 6; est++) {
+                if (hits[est] == 0) {
+                    printf("  %-10s %8s %8s %8s %8s %8.1f %8ld %8ld\n", estimatorNames[est], "-", "-", "-", "-", nsecs[est]/1000.0/trials,
+                           hits[est], misses[est]);
+                    continue;
+                }
+                printf("  %-10s %8.3f %8.2f %8.1f %8.2f %8.1f %8ld %8ld\n", estimatorNames[est], sqrt(sqErr[est]/hits[est]),
+                       fwhmSum[est]/hits[est], snrSum[est]/hits[est], hfdSum[est]/hits[est], nsecs[est]/1000.0/trials, hits[est], misses[est]);
+            }
+        }
+    }
+    delete centroid;
+}
+
+//---------------------------------------------------
+// the decoding of 16 bit guide camera images as it was done in ccd_client::newBLOB: swap the bytes and subtract
+// BZERO pixel by pixel, then the histogram, the clipping and the scaling to 8 bit in passes of their own. the
+// bytes are read unsigned and the histogram is cleared, otherwise it would not give a sensible image
+static void decodeFitsPerPixel(const unsigned char *data, long width, long height, unsigned char *image,
+                               std::vector<unsigned short> &pixels, std::vector<unsigned int> &histogram) {
+    long idx, n, lower, upper, imin, imax;
+    double toBeClipped;
+
+    n = width*height;
+    for (idx = 0; idx < n; idx++) {
+        pixels[idx] = (unsigned short)(data[2*idx]*256 + data[2*idx + 1]) - 32768;
+    }
+    histogram.assign(65536, 0);
+    for (idx = 0; idx < n; idx++) {
+        histogram[pixels[idx]] += 1;
+    }
+    toBeClipped = n/50.0;
+    lower = imin = 0;
+    do {
+        lower += histogram[imin];
+        imin++;
+    } while (lower < toBeClipped);
+    imin--;
+    upper = 0;
+    imax = 65535;
+    do {
+        upper += histogram[imax];
+        imax--;
+    } while (upper < toBeClipped);
+    imax++;
+    for (idx = 0; idx < n; idx++) {
+        if (pixels[idx] < imin) {
+            pixels[idx] = imin;
+        }
+        if (pixels[idx] > imax) {
+            pixels[idx] = imax;
+        }
+    }
+    for (idx = 0; idx < n; idx++) {
+        image[idx] = (unsigned char)floor((pixels[idx] - imin)/((float)(imax - imin))*250);
+    }
+}
+
+//---------------------------------------------------
+// times the decoding of synthetic 16 bit frames with a sky background, noise and stars, the way an INDI
+// server sends them: signed big endian words with BZERO 32768
+static void runFitsBenchmark(void) {
+    const long sizes[2][2] = {{1280, 1024}, {3840, 2160}};
+    const int repetitions = 20;
+    std::vector<unsigned char> data, refImage, newImage;
+    std::vector<unsigned short> pixels;
+    std::vector<unsigned int> histogram;
+    TSC_FitsDecoder *decoder;
+    QElapsedTimer timer;
+    double val, refMS, newMS;
+    long width, height, idx, star, x, y, differing, maxDiff;
+    int size, rep;
+    short word;
+
+    decoder = new TSC_FitsDecoder();
+    printf("FITS decoding benchmark: 16 bit to 8 bit with 2%% clipped at either end, %d frames per size\n", repetitions);
+    printf("  %-12s %12s %12s %12s %10s %10s\n", "frame", "per pixel ms", "table ms", "table Mpx/s", "differing", "max diff");
+    for (size = 0; size < 2; size++) {
+        width = sizes[size][0];
+        height = sizes[size][1];
+        data.resize(2*width*height);
+        refImage.resize(width*height);
+        newImage.resize(width*height);
+        pixels.resize(width*height);
+        for (idx = 0; idx < width*height; idx++) {
+            val = 1200 + 8*(idx%width)/(double)width + 25*getBenchmarkGaussian();
+            word = (short)(lround(fmin(65535, fmax(0, val))) - 32768);
+            data[2*idx] = (unsigned char)(((unsigned short)word) >> 8);
+            data[2*idx + 1] = (unsigned char)(((unsigned short)word) & 255);
+        }
+        for (star = 0; star < 200; star++) {
+            x = (long)(getBenchmarkUniform()*(width - 20)) + 10;
+            y = (long)(getBenchmarkUniform()*(height - 20)) + 10;
+            val = 60000*getBenchmarkUniform()*getBenchmarkUniform();
+            for (idx = 0; idx < 16*16; idx++) {
+                word = (short)(lround(fmin(65535, 1200 + val*exp(-((idx%16 - 8)*(idx%16 - 8) + (idx/16 - 8)*(idx/16 - 8))/4.5))) - 32768);
+                data[2*((y - 8 + idx/16)*width + x - 8 + idx%16)] = (unsigned char)(((unsigned short)word) >> 8);
+                data[2*((y - 8 + idx/16)*width + x - 8 + idx%16) + 1] = (unsigned char)(((unsigned short)word) & 255);
+            }
+        }
+        timer.start();
+        for (rep = 0; rep < repetitions; rep++) {
+            decodeFitsPerPixel(data.data(), width, height, refImage.data(), pixels, histogram);
+        }
+        refMS = timer.nsecsElapsed()/1.0e6/repetitions;
+        timer.start();
+        for (rep = 0; rep < repetitions; rep++) {
+            decoder->decode(data.data(), width, height, 32768, newImage.data(), width);
+        }
+        newMS = timer.nsecsElapsed()/1.0e6/repetitions;
+        differing = maxDiff = 0;
+        for (idx = 0; idx < width*height; idx++) {
+            if (refImage[idx] != newImage[idx]) {
+                differing++;
+                maxDiff = std::max(maxDiff, labs((long)refImage[idx] - (long)newImage[idx]));
+            }
+        }
+        printf("  %5ld x %-4ld %12.2f %12.2f %12.1f %10ld %10ld\n", width, height, refMS, newMS, width*height/newMS/1000.0,
+               differing, maxDiff);
+    }
+    delete decoder;
+}
+
+//---------------------------------------------------
+// the log is guided again by every algorithm on both axes, with the settings of the guiding tab at their defaults
+static int runGuideReplay(QString logFile, double interval, const double *mountModel) {
+    const char *names[5] = {"hysteresis", "low pass", "resist switch", "PID", "predictive"};
+    TSC_GuideReplay *replay;
+    short method;
+    bool inArcsec;
+
+    replay = new TSC_GuideReplay();
+    if (replay->loadLog(logFile, interval) == false) {
+        printf("No guide frames in %s\n", logFile.toLatin1().constData());
+        delete replay;
+        return 1;
+    }
+    replay->setMountModel(mountModel[0], mountModel[1], mountModel[2]);
+    inArcsec = replay->hasImageScale();
+    printf("Guide log replay, %ld frames in %ld segments, in %s\n", replay->getNumberOfFrames(), replay->getNumberOfSegments(),
+           inArcsec ? "arcsec" : "pixels");
+    printf("mount model: RA rate %.2f, decl rate %.2f, decl backlash %.1f pixels\n", mountModel[0], mountModel[1], mountModel[2]);
+    printf("  %-14s RMS RA/decl  peak RA/decl  pulses RA/decl [s]\n", "algorithm");
+    printf("  %-14s %5.2f %5.2f\n", "as recorded", replay->getRecordedRMS(0, inArcsec), replay->getRecordedRMS(1, inArcsec));
+    for (method = TSC_GuideAlgorithm::gaHysteresis; method <= TSC_GuideAlgorithm::gaPredictive; method++) {
+        replay->replay(method, method);
+        printf("  %-14s %5.2f %5.2f   %5.2f %5.2f   %7.1f %7.1f", names[method], replay->getRMS(0, inArcsec),
+               replay->getRMS(1, inArcsec), replay->getPeak(0, inArcsec), replay->getPeak(1, inArcsec),
+               replay->getPulseSeconds(0), replay->getPulseSeconds(1));
+        if (replay->getPeriod() > 0) {
+            printf("   period %.0f s", replay->getPeriod());
+        }
+        printf("\n");
+    }
+    delete replay;
+    return 0;
+}
+
+//---------------------------------------------------
+// the test slews of MainWindow::updateAutoTune, carried out on the virtual boards. the motors carry a load,
+// and a stall is detected from the position of the motor shaft like with an encoder
+static void runAutoTune(void) {
+    const char *axisNames[2] = {"RA", "Decl"};
+    TSC_DriveTuner *tuner;
+    double stepsPerDegree, speed, shaftAtStart;
+    long steps;
+    short axis, dir;
+    int microsteps;
+    bool isRA, hasStalled;
+
+    g_VirtualMount->setLoad(true, 900, 120, 300);
+    g_VirtualMount->setLoad(false, 600, 150, 250); // the declination axis carries the counterweights, too
+    tuner = new TSC_DriveTuner();
+    tuner->setLimits(10000, 2.5, 1000);
+    tuner->setMargins(0.7, 0.8);
+    for (axis = 0; axis < 2; axis++) {
+        isRA = (axis == 0);
+        microsteps = g_AllData->getMicroSteppingRatio(2);
+        stepsPerDegree = microsteps*g_AllData->getGearData(4*axis)*
+            g_AllData->getGearData(4*axis+1)*g_AllData->getGearData(4*axis+2)/g_AllData->getGearData(4*axis+3);
+        g_VirtualMount->sendCommand(QString("m") + QString::number(microsteps), isRA);
+        tuner->start(2000, 1.0, 50);
+        while (tuner->isFinished() == false) {
+            g_VirtualMount->sendCommand(QString("a") + QString::number(lround(tuner->getTrialAcceleration())), isRA);
+            g_VirtualMount->sendCommand(QString("c") + QString::number(lround(tuner->getTrialCurrent()*1000)), isRA);
+            speed = tuner->getTrialSpeed()*g_AllData->getCelestialSpeed()*stepsPerDegree;
+            g_VirtualMount->sendCommand(QString("v") + QString::number(lround(speed)), isRA);
+            steps = tuner->getTestTravel(stepsPerDegree, speed);
+            hasStalled = false;
+            for (dir = 1; dir >= -1; dir -= 2) {
+                shaftAtStart = g_VirtualMount->getMotorPosition(isRA);
+                g_VirtualMount->sendCommand(QString("z"), isRA);
+                g_VirtualMount->sendCommand(QString("s") + QString::number(dir*steps), isRA);
+                g_VirtualMount->sendCommand(QString("o"), isRA);
+                while (g_VirtualMount->drivesAreMoving() == true) {
+                    g_VirtualMount->advanceTime(0.05);
+                }
+                if (fabs(g_VirtualMount->getMotorPosition(isRA) - shaftAtStart - dir*steps/(double)microsteps) > 1.0) {
+                    hasStalled = true;
+                }
+            } // out and back; each leg is checked, as a motor that stalls in both directions ends where it started
+            tuner->reportTest(hasStalled);
+        }
+        printf("Auto-tune %s: %ld tests, %ld stalls%s\n", axisNames[axis], tuner->getNumberOfTests(), tuner->getNumberOfStalls(),
+               (tuner->hasFailed() == true) ? ", FAILED" : "");
+        printf("  acceleration %.0f microsteps/s^2, current %.2f A, GoTo speed %.0f x sidereal\n",
+               tuner->getResult(0), tuner->getResult(1), tuner->getResult(2));
+    }
+    delete tuner;
+}
+
+//---------------------------------------------------
+int main(int argc, char *argv[]) {
+    int ii;
+    long numberOfTargets = 8;
+    double hours = 8, lst = 18, expTime = 2, fwhm = 2.5, jitter = 0.5, pe = 5, drift = 0.5;
+    unsigned int seed = 1;
+    QString sequenceFile, catalogDir, guideLog, logOfNight;
+    double mountModel[3] = {1.0, 1.0, 0};
+    double poleUp = 0, poleEast = 0, gearError = 0, differentialMotion = 0, cloudCover = 0;
+    long guideStars = 1;
+    int raAlgorithm = 0, declAlgorithm = 0;
+    bool tuneDrives = false, synchronisedSlews = true, calibrateTracking = false, testCentroids = false, pipelinedGuiding = true;
+    bool testFitsDecoding = false, guideSubframe = false, automaticStarSelection = false;
+    TSC_NightBenchmark *benchmark;
+
+    qputenv("QT_QPA_PLATFORM", "offscreen"); // ocv_guiding creates pixmaps, but no display is needed
+    QGuiApplication a(argc, argv);
+    for (ii = 1; ii < argc; ii++) {
+        if ((argv[ii][0] == '-') && (argv[ii][1] == 'a')) {
+            tuneDrives = true;
+        } // the options without a value
+        if ((argv[ii][0] == '-') && (argv[ii][1] == 'i')) {
+            synchronisedSlews = false;
+        }
+        if ((argv[ii][0] == '-') && (argv[ii][1] == 'k')) {
+            calibrateTracking = true;
+        }
+        if ((argv[ii][0] == '-') && (argv[ii][1] == 'x')) {
+            testCentroids = true;
+        }
+        if ((argv[ii][0] == '-') && (argv[ii][1] == 'w')) {
+            pipelinedGuiding = false;
+        }
+        if ((argv[ii][0] == '-') && (argv[ii][1] == 'y')) {
+            testFitsDecoding = true;
+        }
+        if ((argv[ii][0] == '-') && (argv[ii][1] == 'q')) {
+            guideSubframe = true;
+        }
+        if ((argv[ii][0] == '-') && (argv[ii][1] == 'A')) {
+            automaticStarSelection = true;
+        }
+        if ((argv[ii][0] == '-') && (ii < argc - 1)) {
+            switch (argv[ii][1]) {
+            case 'n': numberOfTargets = atol(argv[++ii]); break;
+            case 's': sequenceFile = QString(argv[++ii]); break;
+            case 't': hours = atof(argv[++ii]); break;
+            case 'l': lst = atof(argv[++ii]); break;
+            case 'e': expTime = atof(argv[++ii]); break;
+            case 'f': fwhm = atof(argv[++ii]); break;
+            case 'j': jitter = atof(argv[++ii]); break;
+            case 'p': pe = atof(argv[++ii]); break;
+            case 'd': drift = atof(argv[++ii]); break;
+            case 'r': seed = (unsigned int)atol(argv[++ii]); break;
+            case 'c': catalogDir = QString(argv[++ii]); break;
+            case 'm': sscanf(argv[++ii], "%lf,%lf", &poleUp, &poleEast); break;
+            case 'g': gearError = atof(argv[++ii])/100.0; break;
+            case 'z': guideStars = atol(argv[++ii]); break;
+            case 'u': differentialMotion = atof(argv[++ii]); break;
+            case 'o': cloudCover = atof(argv[++ii]); break;
+            case 'v': guideLog = QString(argv[++ii]); break;
+            case 'b': sscanf(argv[++ii], "%d,%d", &raAlgorithm, &declAlgorithm); break;
+            case 'h': logOfNight = QString(argv[++ii]); break;
+            case 'M': sscanf(argv[++ii], "%lf,%lf,%lf", &mountModel[0], &mountModel[1], &mountModel[2]); break;
+            }
+        }
+    }
+
+    g_AllData = new TSC_GlobalData();
+    g_VirtualMount = new TSC_VirtualMount();
+    amisInterface = NULL;
+    if (catalogDir.isEmpty() == false) {
+        ii = runCatalogBenchmark(catalogDir, lst);
+        delete g_VirtualMount;
+        delete g_AllData;
+        return ii;
+    }
+    if (guideLog.isEmpty() == false) {
+        ii = runGuideReplay(guideLog, expTime, mountModel);
+        delete g_VirtualMount;
+        delete g_AllData;
+        return ii;
+    }
+    if (testCentroids == true) {
+        runCentroidBenchmark();
+        delete g_VirtualMount;
+        delete g_AllData;
+        return 0;
+    }
+    if (testFitsDecoding == true) {
+        runFitsBenchmark();
+        delete g_VirtualMount;
+        delete g_AllData;
+        return 0;
+    }
+    if (tuneDrives == true) {
+        runAutoTune();
+        delete g_VirtualMount;
+        delete g_AllData;
+        return 0;
+    }
+    benchmark = new TSC_NightBenchmark(seed);
+    benchmark->setSession(lst, hours);
+    benchmark->setGuiding(expTime, fwhm, jitter);
+    benchmark->setMountErrors(pe, drift);
+    benchmark->setSynchronisedSlews(synchronisedSlews);
+    benchmark->setAlignmentErrors(poleUp, poleEast, gearError);
+    benchmark->setTrackingCalibration(calibrateTracking);
+    benchmark->setGuideStars(guideStars);
+    benchmark->setSkyConditions(differentialMotion, cloudCover);
+    benchmark->setPipelinedGuiding(pipelinedGuiding);
+    benchmark->setGuideSubframe(guideSubframe);
+    benchmark->setAutomaticStarSelection(automaticStarSelection);
+    benchmark->setGuideAlgorithms(raAlgorithm, declAlgorithm);
+    if ((logOfNight.isEmpty() == false) && (benchmark->setGuideLog(logOfNight) == false)) {
+        printf("Could not open the guiding log %s\n", logOfNight.toLatin1().constData());
+    }
+    if (sequenceFile.isEmpty() == false) {
+        if (benchmark->loadTargets(sequenceFile) == false) {
+            printf("Could not read targets from %s\n", sequenceFile.toLatin1().constData());
+            return 1;
+        }
+    } else {
+        benchmark->generateTargets(numberOfTargets);
+    }
+    benchmark->runNight();
+    benchmark->printReport();
+    delete benchmark;
+    if (amisInterface != NULL) {
+        amisInterface->closeUSBConnection();
+        delete amisInterface;
+    }
+    delete g_VirtualMount;
+    delete g_AllData;
+    return 0;
+}
@@ -0,0 +1,344 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+#include "tsc_guidereplay.h"
+#include "tsc_guidealgorithm.h"
+#include <fstream>
+#include <sstream>
+#include <math.h>
+
+TSC_GuideReplay::TSC_GuideReplay(void) {
+    this->rateFactor[0] = this->rateFactor[1] = 1.0;
+    this->declBacklash = 0;
+    this->minMove = 0.3;
+    this->aggressiveness = 1.0;
+    this->hysteresisWeight = 0.9;
+    this->rms[0][0] = this->rms[0][1] = this->rms[1][0] = this->rms[1][1] = 0;
+    this->peak[0][0] = this->peak[0][1] = this->peak[1][0] = this->peak[1][1] = 0;
+    this->pulseSeconds[0] = this->pulseSeconds[1] = 0;
+    this->period = 0;
+}
+
+//---------------------------------------------------
+TSC_GuideReplay::~TSC_GuideReplay(void) {
+    this->segments.clear();
+}
+
+//---------------------------------------------------
+static void clearSegment(struct TSC_GuideLog::guideSegmentStruct *segment) {
+    segment->travelTime[0] = segment->travelTime[1] = 0;
+    segment->rotation[0][0] = segment->rotation[1][1] = 1;
+    segment->rotation[0][1] = segment->rotation[1][0] = 0;
+    segment->arcsecPerPixel[0] = segment->arcsecPerPixel[1] = 0;
+    segment->reference[0] = segment->reference[1] = 0;
+    segment->declBacklash = 0;
+    segment->backlashCompensated = false;
+    segment->method[0] = segment->method[1] = 0;
+    segment->frames.clear();
+}
+
+//---------------------------------------------------
+bool TSC_GuideReplay::loadLog(QString fileName, double secs) {
+    TSC_GuideLog *guideLog;
+    long idx;
+    bool isCSV;
+
+    this->segments.clear();
+    guideLog = new TSC_GuideLog();
+    isCSV = guideLog->read(fileName.toLatin1().constData());
+    if (isCSV == true) {
+        for (idx = 0; idx < guideLog->getNumberOfSegments(); idx++) {
+            this->segments.push_back(*guideLog->getSegment(idx));
+        }
+    }
+    delete guideLog;
+    if (isCSV == false) {
+        return this->readTextLog(fileName, secs);
+    }
+    return true;
+}
+
+//---------------------------------------------------
+// the lines of MainWindow::correctGuideStarPosition that matter here are the travel times of the calibration,
+// which start a segment, "Transformed position", which starts a frame, and the duration and direction of the
+// corrections. RA- and decl+ were sent for a positive deviation
+bool TSC_GuideReplay::readTextLog(QString fileName, double secs) {
+    struct TSC_GuideLog::guideSegmentStruct segment;
+    struct TSC_GuideLog::guideFrameStruct frame;
+    std::string line, key, value;
+    double duration[2] = {0, 0}, dx, dy, interval = 3.0;
+    long frameNumber = 0, idx;
+    size_t tab;
+    QByteArray ba = fileName.toLatin1();
+    const char *cfilename = ba.data();
+
+    if (secs > 0) {
+        interval = secs;
+    }
+    frame.centroid[0] = frame.centroid[1] = 0;
+    frame.snr = 0;
+    frame.declDirection = 0;
+    frame.stars = 1;
+    std::ifstream infile(cfilename);
+    while (std::getline(infile, line)) {
+        tab = line.find('\t');
+        if (tab == std::string::npos) {
+            continue;
+        }
+        key = line.substr(0, tab);
+        value = line.substr(tab + 1);
+        std::istringstream isValue(value);
+        if (key == "Travel time per Pixel in RA in ms:") {
+            clearSegment(&segment);
+            isValue >> segment.travelTime[0];
+            this->segments.push_back(segment);
+            frameNumber = 0;
+            continue;
+        }
+        if (this->segments.empty() == true) {
+            continue;
+        }
+        if (key == "Travel time per Pixel in Decl in ms:") {
+            isValue >> this->segments.back().travelTime[1];
+        } else if (key == "Transformed position:") {
+            if (isValue >> dx >> dy) {
+                frame.time = frameNumber*interval;
+                frame.deviation[0] = dx;
+                frame.deviation[1] = dy;
+                frame.pulse[0] = frame.pulse[1] = 0;
+                this->segments.back().frames.push_back(frame);
+                frameNumber++;
+            }
+        } else if (key == "RA correction duration:") {
+            isValue >> duration[0];
+        } else if (key == "Decl correction duration:") {
+            isValue >> duration[1];
+        } else if ((key == "RA correction direction:") && (this->segments.back().frames.empty() == false)) {
+            if (value.find("RA-") != std::string::npos) {
+                this->segments.back().frames.back().pulse[0] = duration[0];
+            } else {
+                this->segments.back().frames.back().pulse[0] = -duration[0];
+            }
+        } else if ((key == "Decl correction direction:") && (this->segments.back().frames.empty() == false)) {
+            if (value.find("Decl+") != std::string::npos) {
+                this->segments.back().frames.back().pulse[1] = duration[1];
+            } else {
+                this->segments.back().frames.back().pulse[1] = -duration[1];
+            }
+        }
+    }
+    infile.close();
+    for (idx = (long)this->segments.size() - 1; idx >= 0; idx--) {
+        if (this->segments[idx].frames.empty() == true) {
+            this->segments.erase(this->segments.begin() + idx);
+        }
+    }
+    return (this->segments.empty() == false);
+}
+
+//---------------------------------------------------
+long TSC_GuideReplay::getNumberOfSegments(void) {
+    return (long)this->segments.size();
+}
+
+//---------------------------------------------------
+long TSC_GuideReplay::getNumberOfFrames(void) {
+    long idx, frames = 0;
+
+    for (idx = 0; idx < (long)this->segments.size(); idx++) {
+        frames += (long)this->segments[idx].frames.size();
+    }
+    return frames;
+}
+
+//---------------------------------------------------
+double TSC_GuideReplay::getImageScale(long segment) {
+    return 0.5*(this->segments[segment].arcsecPerPixel[0] + this->segments[segment].arcsecPerPixel[1]);
+}
+
+//---------------------------------------------------
+bool TSC_GuideReplay::hasImageScale(void) {
+    long idx;
+
+    if (this->segments.empty() == true) {
+        return false;
+    }
+    for (idx = 0; idx < (long)this->segments.size(); idx++) {
+        if (this->getImageScale(idx) <= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//---------------------------------------------------
+void TSC_GuideReplay::setParameters(double minPix, double aggr, double weight) {
+    this->minMove = minPix;
+    this->aggressiveness = aggr;
+    this->hysteresisWeight = weight;
+}
+
+//---------------------------------------------------
+void TSC_GuideReplay::setMountModel(double raRate, double declRate, double backlashInPix) {
+    if (raRate > 0) {
+        this->rateFactor[0] = raRate;
+    }
+    if (declRate > 0) {
+        this->rateFactor[1] = declRate;
+    }
+    this->declBacklash = fmax(backlashInPix, 0);
+}
+
+//---------------------------------------------------
+void TSC_GuideReplay::resetMount(struct mountStateStruct *mount) {
+    mount->position[0] = mount->position[1] = 0;
+    mount->declDirection = 0;
+    mount->backlashLeft = 0;
+}
+
+//---------------------------------------------------
+// the backlash is taken to be taken up in the direction of the first decl pulse of a segment
+void TSC_GuideReplay::moveMount(struct mountStateStruct *mount, short axis, double pulse, double travelTime) {
+    double move, lost;
+    short direction;
+
+    if ((pulse == 0) || (travelTime <= 0)) {
+        return;
+    }
+    move = this->rateFactor[axis]*fabs(pulse)/travelTime;
+    if (axis == 1) {
+        direction = 1;
+        if (pulse < 0) {
+            direction = -1;
+        }
+        if ((mount->declDirection != 0) && (direction != mount->declDirection)) {
+            mount->backlashLeft = this->declBacklash;
+        }
+        mount->declDirection = direction;
+        lost = fmin(move, mount->backlashLeft);
+        mount->backlashLeft -= lost;
+        move -= lost;
+    }
+    mount->position[axis] += copysign(move, pulse);
+}
+
+//---------------------------------------------------
+// the pulses are rounded to ms and clipped to 2 s as in MainWindow
+void TSC_GuideReplay::replay(short raMethod, short declMethod) {
+    TSC_GuideAlgorithm *algorithm[2];
+    struct mountStateStruct recorded, replayed;
+    struct TSC_GuideLog::guideFrameStruct *frame;
+    double sqSum[2][2] = {{0, 0}, {0, 0}}, travelTime, scale, deviation, correction, pgduration;
+    long seg, idx, frames = 0, longestSegment = 0;
+    short axis;
+
+    algorithm[0] = new TSC_GuideAlgorithm();
+    algorithm[1] = new TSC_GuideAlgorithm();
+    algorithm[0]->setMethod(raMethod);
+    algorithm[1]->setMethod(declMethod);
+    for (axis = 0; axis < 2; axis++) {
+        algorithm[axis]->setParameters(this->minMove, this->aggressiveness, this->hysteresisWeight);
+        this->peak[axis][0] = this->peak[axis][1] = 0;
+        this->pulseSeconds[axis] = 0;
+    }
+    this->period = 0;
+    for (seg = 0; seg < (long)this->segments.size(); seg++) {
+        this->resetMount(&recorded);
+        this->resetMount(&replayed);
+        scale = this->getImageScale(seg);
+        for (axis = 0; axis < 2; axis++) {
+            algorithm[axis]->reset();
+            if (this->segments[seg].travelTime[axis] > 0) {
+                algorithm[axis]->setMaximumCorrection(2000.0/this->segments[seg].travelTime[axis]);
+            }
+        }
+        for (idx = 0; idx < (long)this->segments[seg].frames.size(); idx++) {
+            frame = &this->segments[seg].frames[idx];
+            for (axis = 0; axis < 2; axis++) {
+                travelTime = this->segments[seg].travelTime[axis];
+                deviation = frame->deviation[axis] + recorded.position[axis] - replayed.position[axis];
+                sqSum[axis][0] += deviation*deviation;
+                sqSum[axis][1] += deviation*deviation*scale*scale;
+                this->peak[axis][0] = fmax(this->peak[axis][0], fabs(deviation));
+                this->peak[axis][1] = fmax(this->peak[axis][1], fabs(deviation)*scale);
+                correction = algorithm[axis]->computeCorrection(deviation, frame->time);
+                if ((correction != 0) && (travelTime > 0)) {
+                    pgduration = fmin(round(travelTime*fabs(correction)), 2000);
+                    this->pulseSeconds[axis] += pgduration/1000.0;
+                    this->moveMount(&replayed, axis, copysign(pgduration, correction), travelTime);
+                }
+                this->moveMount(&recorded, axis, frame->pulse[axis], travelTime); // the track of the star moves on by the pulses of the log
+            }
+        }
+        frames += (long)this->segments[seg].frames.size();
+        if (this->segments[seg].frames.size() > this->segments[longestSegment].frames.size()) {
+            longestSegment = seg;
+        }
+        if (seg == longestSegment) {
+            this->period = algorithm[0]->getPeriod();
+        }
+    }
+    for (axis = 0; axis < 2; axis++) {
+        this->rms[axis][0] = this->rms[axis][1] = 0;
+        if (frames > 0) {
+            this->rms[axis][0] = sqrt(sqSum[axis][0]/frames);
+            this->rms[axis][1] = sqrt(sqSum[axis][1]/frames);
+        }
+    }
+    delete algorithm[0];
+    delete algorithm[1];
+}
+
+//---------------------------------------------------
+double TSC_GuideReplay::getRMS(short axis, bool inArcsec) {
+    return this->rms[axis][(inArcsec == true)];
+}
+
+//---------------------------------------------------
+double TSC_GuideReplay::getPeak(short axis, bool inArcsec) {
+    return this->peak[axis][(inArcsec == true)];
+}
+
+//---------------------------------------------------
+double TSC_GuideReplay::getPulseSeconds(short axis) {
+    return this->pulseSeconds[axis];
+}
+
+//---------------------------------------------------
+double TSC_GuideReplay::getRecordedRMS(short axis, bool inArcsec) {
+    double sqSum = 0, scale = 1.0, deviation;
+    long seg, idx, frames = 0;
+
+    for (seg = 0; seg < (long)this->segments.size(); seg++) {
+        if (inArcsec == true) {
+            scale = this->getImageScale(seg);
+        }
+        for (idx = 0; idx < (long)this->segments[seg].frames.size(); idx++) {
+            deviation = this->segments[seg].frames[idx].deviation[axis]*scale;
+            sqSum += deviation*deviation;
+        }
+        frames += (long)this->segments[seg].frames.size();
+    }
+    if (frames == 0) {
+        return 0;
+    }
+    return sqrt(sqSum/frames);
+}
+
+//---------------------------------------------------
+double TSC_GuideReplay::getPeriod(void) {
+    return this->period;
+}
@@ -0,0 +1,75 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+// replays a guiding log of TSC through the guide algorithms and a model of the mount. the log gives the
+// deviation of the star in RA and decl for every frame and the pulses that were sent; the deviation plus the
+// motion of the mount by all pulses before the frame is where the star would have been without guiding.
+// every algorithm guides on this track instead of the recorded one, and the deviation it leaves is scored.
+// the mount model moves the mount by the length of a pulse divided by the travel time per pixel of the
+// calibration, times a rate factor per axis, and loses the backlash in decl whenever the decl pulses change
+// direction. the same model is used to take the recorded pulses off the track, so the algorithm of the log
+// reproduces the recorded deviations whatever the model is. every segment of the log - a start of guiding -
+// resets the algorithms. GuidingLog.csv has the time of every frame; the text logs of older versions have no
+// times, and the frames are taken to follow each other at a fixed interval. deviations are in pixels of the
+// guide camera, or in arcsec if the log has the image scale.
+
+#ifndef TSC_GUIDEREPLAY_H
+#define TSC_GUIDEREPLAY_H
+
+#include <QString>
+#include <vector>
+#include "tsc_guidelog.h"
+
+class TSC_GuideReplay {
+public:
+    TSC_GuideReplay(void);
+    ~TSC_GuideReplay(void);
+    bool loadLog(QString, double); // GuidingLog.csv, or GuidingLog.tsl of older versions and the time between two frames in s; false if there are no frames
+    long getNumberOfSegments(void);
+    long getNumberOfFrames(void);
+    bool hasImageScale(void); // all segments have arcsec per pixel
+    void setParameters(double, double, double); // minimum move in pixels, aggressiveness and hysteresis weight, as in the guiding tab
+    void setMountModel(double, double, double); // rate of RA and decl as a fraction of the calibration, decl backlash in pixels
+    void replay(short, short); // guide algorithms for RA and decl, one of TSC_GuideAlgorithm::guideMethod
+    double getRMS(short, bool); // 0 is RA, 1 is decl; true in arcsec
+    double getPeak(short, bool);
+    double getPulseSeconds(short); // sum of the pulses sent
+    double getRecordedRMS(short, bool); // of the deviations in the log
+    double getPeriod(void); // of the periodic error in RA, as found by the predictive algorithm in the longest segment
+
+private:
+    struct mountStateStruct {
+        double position[2]; // motion by the pulses in pixels
+        short declDirection; // of the last decl pulse, 0 before the first one
+        double backlashLeft; // in pixels, to be taken up before the decl axis moves
+    };
+    std::vector<struct TSC_GuideLog::guideSegmentStruct> segments;
+    double rateFactor[2];
+    double declBacklash; // pixels
+    double minMove;
+    double aggressiveness;
+    double hysteresisWeight;
+    double rms[2][2]; // axis, pixels or arcsec
+    double peak[2][2];
+    double pulseSeconds[2];
+    double period;
+    bool readTextLog(QString, double);
+    void resetMount(struct mountStateStruct*);
+    void moveMount(struct mountStateStruct*, short, double, double); // axis, pulse in ms signed as in TSC_GuideLog, travel time in ms per pixel
+    double getImageScale(long); // arcsec per pixel of a segment
+};
+
+#endif // TSC_GUIDEREPLAY_H
@@ -0,0 +1,875 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+#include "tsc_nightbenchmark.h"
+#include "tsc_globaldata.h"
+#include "tsc_virtualmount.h"
+#include "usb_communications.h"
+#include <QElapsedTimer>
+#include <QDebug>
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+extern TSC_GlobalData *g_AllData;
+extern usbCommunications *amisInterface;
+extern TSC_VirtualMount *g_VirtualMount;
+
+static const char *algorithmNames[5] = {"hysteresis", "low pass", "resist switch", "PID", "predictive"}; // TSC_GuideAlgorithm::guideMethod
+
+TSC_NightBenchmark::TSC_NightBenchmark(unsigned int rseed) {
+    this->randomState = rseed*2246822519u + 7;
+    this->targetList = new TSC_Sequencer();
+    this->etaModel = new TSC_SlewTimeModel();
+    this->slewPlanner = new TSC_SlewPlanner();
+    this->synchronisedSlews = true;
+    this->driftCalibration = new TSC_DriftCalibration();
+    this->calibrateTracking = false;
+    this->trueAlignment[0] = 0;
+    this->trueAlignment[1] = 0;
+    this->trueAlignment[2] = 0;
+    this->lastRateUpdate = 0;
+    this->raStepsPending = 0;
+    this->declStepsPending = 0;
+    for (short axis = 0; axis < 2; axis++) {
+        this->etaModel->setParameters(axis, g_AllData->getSlewTimeModel(axis,0), g_AllData->getSlewTimeModel(axis,1),
+                                      g_AllData->getSlewTimeModel(axis,2), g_AllData->getSlewTimeModel(axis,3));
+    } // the model learns during the night, but the preferences are not touched
+    this->horizon = new TSC_Refraction();
+    this->sky = new TSC_VirtualSky(rseed);
+    this->guiding = new ocv_guiding();
+    this->guiding->setFocalLengthOfGuidescope(g_AllData->getGuideScopeFocalLength());
+    this->sky->setCamera(g_AllData->getCameraChipPixels(0,false), g_AllData->getCameraChipPixels(1,false),
+                         this->guiding->getArcSecsPerPix(0), 20.0); // the camera is a little rotated against RA/decl
+    this->StepperDriveRA = NULL;
+    this->StepperDriveDecl = NULL;
+    this->mountControl = NULL;
+    this->targetsWereLoaded = false;
+    this->lstAtStart = 18.0;
+    this->sessionLength = 8*3600.0;
+    this->guideExposure = 2.0;
+    this->guideStars = 1;
+    this->pipelinedGuiding = true;
+    this->guideSubframe = false;
+    this->automaticStarSelection = false;
+    this->guideAlgorithm[0] = new TSC_GuideAlgorithm();
+    this->guideAlgorithm[1] = new TSC_GuideAlgorithm();
+    this->guideLog = new TSC_GuideLog();
+    this->exposure.isOpen = false;
+    this->believedRA = 0;
+    this->believedDecl = 90;
+    this->guideParams.threshold = 50; // the default settings of the guiding tab
+    this->guideParams.guideRate = 0.5;
+    this->guideParams.aggressiveness = 1.0;
+    this->guideParams.hysteresisWeight = 0.9;
+    this->guideParams.maxDevInPix = 0.3;
+    this->guideParams.FOVFactor = 1.0;
+    memset(&this->results, 0, sizeof(this->results));
+}
+
+//---------------------------------------------------
+TSC_NightBenchmark::~TSC_NightBenchmark(void) {
+    if (this->StepperDriveRA != NULL) {
+        delete this->StepperDriveRA;
+    }
+    if (this->StepperDriveDecl != NULL) {
+        delete this->StepperDriveDecl;
+    }
+    if (this->mountControl != NULL) {
+        delete this->mountControl;
+    }
+    delete this->guiding;
+    delete this->sky;
+    delete this->horizon;
+    delete this->targetList;
+    delete this->etaModel;
+    delete this->slewPlanner;
+    delete this->driftCalibration;
+    delete this->guideAlgorithm[0];
+    delete this->guideAlgorithm[1];
+    delete this->guideLog;
+}
+
+//---------------------------------------------------
+bool TSC_NightBenchmark::loadTargets(QString fileName) {
+    this->targetList->clearTargets();
+    this->targetsWereLoaded = this->targetList->loadTargets(fileName);
+    return this->targetsWereLoaded;
+}
+
+//---------------------------------------------------
+void TSC_NightBenchmark::setSession(double lst, double hours) {
+    if ((lst >= 0) && (lst < 24)) {
+        this->lstAtStart = lst;
+    }
+    if (hours > 0) {
+        this->sessionLength = hours*3600.0;
+    }
+}
+
+//---------------------------------------------------
+void TSC_NightBenchmark::setGuiding(double expTime, double fwhm, double jitter) {
+    if (expTime > 0) {
+        this->guideExposure = expTime;
+    }
+    this->sky->setSeeing(fwhm, jitter);
+}
+
+//---------------------------------------------------
+void TSC_NightBenchmark::setGuideStars(long n) {
+    if (n >= 1) {
+        this->guideStars = n;
+    }
+}
+
+//---------------------------------------------------
+void TSC_NightBenchmark::setSkyConditions(double differentialMotion, double cloudCover) {
+    this->sky->setDifferentialMotion(differentialMotion);
+    this->sky->setClouds(cloudCover);
+}
+
+//---------------------------------------------------
+void TSC_NightBenchmark::setPipelinedGuiding(bool pipelined) {
+    this->pipelinedGuiding = pipelined;
+}
+
+//---------------------------------------------------
+void TSC_NightBenchmark::setGuideSubframe(bool subframeOn) {
+    this->guideSubframe = subframeOn;
+}
+
+//---------------------------------------------------
+void TSC_NightBenchmark::setGuideAlgorithms(short raMethod, short declMethod) {
+    this->guideAlgorithm[0]->setMethod(raMethod);
+    this->guideAlgorithm[1]->setMethod(declMethod);
+}
+
+//---------------------------------------------------
+void TSC_NightBenchmark::setAutomaticStarSelection(bool automatic) {
+    this->automaticStarSelection = automatic;
+}
+
+//---------------------------------------------------
+bool TSC_NightBenchmark::setGuideLog(QString fileName) {
+    return this->guideLog->open(fileName.toLatin1().constData());
+}
+
+//---------------------------------------------------
+void TSC_NightBenchmark::setMountErrors(double pe, double declDrift) {
+    g_VirtualMount->setPeriodicError(pe);
+    g_VirtualMount->setDeclinationDrift(declDrift);
+}
+
+//---------------------------------------------------
+void TSC_NightBenchmark::setSynchronisedSlews(bool isSynchronised) {
+    this->synchronisedSlews = isSynchronised;
+}
+
+//---------------------------------------------------
+void TSC_NightBenchmark::setAlignmentErrors(double up, double east, double gearErr) {
+    g_VirtualMount->setPolarMisalignment(up, east);
+    g_VirtualMount->setGearError(gearErr);
+    this->trueAlignment[0] = -gearErr/(1.0 + gearErr); // the calibration counts how much the drive turns too slowly
+    this->trueAlignment[1] = up;
+    this->trueAlignment[2] = east;
+}
+
+//---------------------------------------------------
+void TSC_NightBenchmark::setTrackingCalibration(bool isOn) {
+    this->calibrateTracking = isOn;
+}
+
+//---------------------------------------------------
+double TSC_NightBenchmark::getUniform(void) {
+    this->randomState = this->randomState*1664525u + 1013904223u;
+    return (this->randomState >> 8)/16777216.0;
+}
+
+//---------------------------------------------------
+double TSC_NightBenchmark::getAltitude(double ra, double decl) {
+    return this->horizon->getAltitude(g_VirtualMount->getLocalSiderealTime()*15.0 - ra, decl, g_AllData->getSiteCoords(0));
+}
+
+//---------------------------------------------------
+// the targets are spread over the night; each one stands within four hours of the meridian and at least
+// 30 degrees above the horizon at the time it is visited. the plan consists of 5 minute exposures.
+void TSC_NightBenchmark::generateTargets(long number) {
+    double lst, ha, decl, ra, perTarget, lat;
+    long cnt, tries;
+    short exposures;
+
+    if (number < 1) {
+        return;
+    }
+    this->targetList->clearTargets();
+    this->targetsWereLoaded = false;
+    lat = g_AllData->getSiteCoords(0);
+    perTarget = this->sessionLength/number;
+    exposures = (short)fmax(1, floor(perTarget/305.5));
+    for (cnt = 0; cnt < number; cnt++) {
+        lst = this->lstAtStart + (cnt + 0.5)*perTarget*1.00273791/3600.0;
+        tries = 0;
+        do {
+            ha = (this->getUniform() - 0.5)*120.0;
+            decl = lat - 50 + this->getUniform()*(85 - (lat - 50));
+            tries++;
+        } while ((this->horizon->getAltitude(ha, decl, lat) < 30) && (tries < 1000));
+        ra = fmod(lst*15.0 - ha + 720.0, 360.0);
+        this->targetList->addTarget(std::string("SIM-") + std::to_string(cnt + 1), ra, decl, exposures, 300);
+    }
+}
+
+//---------------------------------------------------
+// the same sequence of calls as in MainWindow::initiateStepperDrivers
+void TSC_NightBenchmark::initiateStepperDrivers(void) {
+    amisInterface = new usbCommunications(0x16c0);
+    this->StepperDriveRA = new QtContinuousStepper();
+    this->StepperDriveRA->changeMicroSteps(g_AllData->getMicroSteppingRatio(0));
+    this->StepperDriveRA->setGearRatioAndMicrosteps(g_AllData->getGearData(0)*g_AllData->getGearData(1)*
+        g_AllData->getGearData(2)/g_AllData->getGearData(3), g_AllData->getMicroSteppingRatio(0));
+    this->StepperDriveRA->setInitialParamsAndComputeBaseSpeed(g_AllData->getDriveParams(0,1), g_AllData->getDriveParams(0,2));
+    this->StepperDriveDecl = new QtKineticStepper();
+    this->StepperDriveDecl->changeMicroSteps(g_AllData->getMicroSteppingRatio(0));
+    this->StepperDriveDecl->setGearRatioAndMicrosteps(g_AllData->getGearData(4)*g_AllData->getGearData(5)*
+        g_AllData->getGearData(6)/g_AllData->getGearData(7), g_AllData->getMicroSteppingRatio(0));
+    this->StepperDriveDecl->setInitialParamsAndComputeBaseSpeed(g_AllData->getDriveParams(1,1), g_AllData->getDriveParams(1,2));
+    this->mountControl = new TSC_MountControl(this->StepperDriveRA, this->StepperDriveDecl, this->slewPlanner, this->etaModel);
+    this->mountControl->setGuideAlgorithms(this->guideAlgorithm[0], this->guideAlgorithm[1]); // no horizon mask; the targets are well above the horizon
+}
+
+//---------------------------------------------------
+bool TSC_NightBenchmark::isDriveActive(bool isRA) {
+    amisInterface->sendCommand("f0", isRA);
+    return (amisInterface->getReply(isRA).toLong() != 0);
+}
+
+//---------------------------------------------------
+void TSC_NightBenchmark::startRATracking(void) {
+    this->StepperDriveRA->stopDrive();
+    this->StepperDriveRA->changeMicroSteps(g_AllData->getMicroSteppingRatio(0));
+    this->StepperDriveRA->startTracking();
+}
+
+//---------------------------------------------------
+// MainWindow::updateTrackingRates with the correction from the tracking calibration as the only rate. the
+// interval is the virtual time since the last call instead of the one of the timer
+void TSC_NightBenchmark::updateTrackingRates(void) {
+    double interval, raRate = 0, declRate = 0, convertDegreesToMicrostepsRA, convertDegreesToMicrostepsDecl, raRateInSteps;
+    long raSpeed, declSpeed;
+
+    interval = g_VirtualMount->getVirtualTime() - this->lastRateUpdate;
+    if (interval < 1.0) {
+        return;
+    }
+    this->lastRateUpdate = g_VirtualMount->getVirtualTime();
+    if (this->calibrateTracking == true) {
+        this->driftCalibration->getDriftRates(g_VirtualMount->getLocalSiderealTime()*15.0 - this->believedRA,
+                                              this->believedDecl, &raRate, &declRate);
+        declRate = -declRate;
+    }
+    this->StepperDriveRA->setTrackingRateOffset(raRate);
+    convertDegreesToMicrostepsRA=1.0/g_AllData->getGearData(3)*g_AllData->getMicroSteppingRatio(0)*
+            g_AllData->getGearData(0)*g_AllData->getGearData(1)*g_AllData->getGearData(2);
+    raRateInSteps = (g_AllData->getCelestialSpeed() + raRate)*convertDegreesToMicrostepsRA;
+    this->raStepsPending += raRateInSteps*interval;
+    raSpeed = this->StepperDriveRA->getTrackingSpeed();
+    if (fabs(this->raStepsPending - raSpeed*interval) > fmax(0.25/3600.0*convertDegreesToMicrostepsRA, interval)) {
+        if (this->raStepsPending > raSpeed*interval) {
+            raSpeed = ceil(raRateInSteps);
+        } else {
+            raSpeed = floor(raRateInSteps);
+        }
+    }
+    this->raStepsPending -= raSpeed*interval;
+    this->StepperDriveRA->adjustTrackingSpeed(raSpeed);
+    if (this->calibrateTracking == false) {
+        return;
+    }
+    convertDegreesToMicrostepsDecl=1.0/g_AllData->getGearData(7)*g_AllData->getMicroSteppingRatio(0)*
+            g_AllData->getGearData(4)*g_AllData->getGearData(5)*g_AllData->getGearData(6);
+    this->declStepsPending += declRate*interval*convertDegreesToMicrostepsDecl;
+    declSpeed = lround(this->declStepsPending/interval);
+    this->declStepsPending -= declSpeed*interval;
+    if (declSpeed != this->StepperDriveDecl->getTrackingSpeed()) {
+        if (declSpeed == 0) {
+            this->StepperDriveDecl->stopDrive();
+        } else {
+            this->StepperDriveDecl->startTracking(declSpeed);
+        }
+    }
+}
+
+//---------------------------------------------------
+// the synchronised GoTo is planned and started by TSC_MountControl as in MainWindow::startGoToObject and
+// startSlewSegment. the independent slews TSC used before are computed here for comparison. the end of the
+// slew is detected by polling the drives every 100 ms, just like the event queue of MainWindow does. the
+// position of both motors is sampled to see how far the path departs from a straight line
+void TSC_NightBenchmark::doGoTo(double targetRA, double targetDecl) {
+    double travelRA, travelDecl, speedFactor, earthTravelDuringGOTOinMSteps, mstepRatio,
+           convertDegreesToMicrostepsDecl, convertDegreesToMicrostepsRA, speedRA, speedDecl, accRA, accDecl,
+           tStart, tSegment, actualDuration, ra, decl, err, startPos[2], endPos[2], progressRA, progressDecl;
+    qint64 timeEstimatedInRAInMS, timeEstimatedInDeclInMS, gotoETA;
+    long RASteps, DeclSteps, grossRASteps, segment, segments;
+    short RADriveDirection, DeclDriveDirection, iteration;
+    bool goToIsActiveInRA, goToIsActiveInDecl, raTrackingIsOn;
+    std::vector<double> pathRA, pathDecl;
+    unsigned long idx;
+
+    travelRA = this->mountControl->getShortestRATravel(this->believedRA, targetRA);
+    travelDecl = targetDecl - this->believedDecl;
+    segments = 1;
+    gotoETA = 0;
+    this->StepperDriveDecl->stopDrive();
+    tStart = g_VirtualMount->getVirtualTime();
+    startPos[0] = endPos[0] = g_VirtualMount->getMotorPosition(true);
+    startPos[1] = endPos[1] = g_VirtualMount->getMotorPosition(false);
+    if (this->synchronisedSlews == true) {
+        this->mountControl->planGoTo(g_VirtualMount->getLocalSiderealTime()*15.0 - this->believedRA, this->believedDecl,
+                                     travelRA, travelDecl, g_AllData->getHandBoxSpeeds(0), false);
+        segments = this->slewPlanner->getNumberOfSegments();
+        for (segment = 0; segment < segments; segment++) {
+            gotoETA += round(1000*this->slewPlanner->getSegmentDuration(segment));
+        }
+    } else {
+        if (travelRA < 0) {
+            RADriveDirection = -1;
+        } else {
+            RADriveDirection = 1;
+        }
+        if (travelDecl < 0) {
+            DeclDriveDirection = -1*g_AllData->getMFlipDecSign();
+        } else {
+            DeclDriveDirection = 1*g_AllData->getMFlipDecSign();
+        }
+        this->StepperDriveRA->changeMicroSteps(g_AllData->getMicroSteppingRatio(2));
+        this->StepperDriveDecl->changeMicroSteps(g_AllData->getMicroSteppingRatio(2));
+        mstepRatio = g_AllData->getMicroSteppingRatio(2)/((double)(g_AllData->getMicroSteppingRatio(0)));
+        speedFactor = g_AllData->getHandBoxSpeeds(0)*mstepRatio;
+        convertDegreesToMicrostepsDecl = 1.0/g_AllData->getGearData(7)*g_AllData->getMicroSteppingRatio(2)*
+                g_AllData->getGearData(4)*g_AllData->getGearData(5)*g_AllData->getGearData(6);
+        DeclSteps = round(fabs(travelDecl)*convertDegreesToMicrostepsDecl);
+        convertDegreesToMicrostepsRA = 1.0/g_AllData->getGearData(3)*g_AllData->getMicroSteppingRatio(2)*
+                g_AllData->getGearData(0)*g_AllData->getGearData(1)*g_AllData->getGearData(2);
+        RASteps = round(fabs(travelRA)*convertDegreesToMicrostepsRA);
+        speedRA = round(round(speedFactor/mstepRatio)*g_AllData->getCelestialSpeed()*convertDegreesToMicrostepsRA);
+        speedDecl = round(round(speedFactor/mstepRatio)*g_AllData->getCelestialSpeed()*convertDegreesToMicrostepsDecl);
+        accRA = this->StepperDriveRA->getKineticsFromController(2);
+        accDecl = this->StepperDriveDecl->getKineticsFromController(2);
+        timeEstimatedInDeclInMS = round(1000*this->etaModel->predictDuration(1, DeclSteps, speedDecl, accDecl));
+        grossRASteps = RASteps;
+        timeEstimatedInRAInMS = round(1000*this->etaModel->predictDuration(0, RASteps, speedRA, accRA));
+        for (iteration = 0; iteration < 3; iteration++) {
+            earthTravelDuringGOTOinMSteps = (g_AllData->getCelestialSpeed()*((double)timeEstimatedInRAInMS)/1000.0)*convertDegreesToMicrostepsRA;
+            if (RADriveDirection == 1) {
+                RASteps = grossRASteps + earthTravelDuringGOTOinMSteps;
+            } else {
+                RASteps = grossRASteps - earthTravelDuringGOTOinMSteps;
+            }
+            if (RASteps < 0) {
+                RASteps = 0;
+            }
+            timeEstimatedInRAInMS = round(1000*this->etaModel->predictDuration(0, RASteps, speedRA, accRA));
+        }
+        if (timeEstimatedInRAInMS > timeEstimatedInDeclInMS) {
+            gotoETA = timeEstimatedInRAInMS;
+        } else {
+            gotoETA = timeEstimatedInDeclInMS;
+        }
+        this->StepperDriveRA->stopDrive();
+        this->etaModel->startSlew(0, RASteps, speedRA, accRA);
+        this->etaModel->startSlew(1, DeclSteps, speedDecl, accDecl);
+        this->StepperDriveRA->travelForNSteps(RASteps, RADriveDirection, speedRA/(g_AllData->getCelestialSpeed()*convertDegreesToMicrostepsRA), false);
+        this->StepperDriveDecl->travelForNSteps(DeclSteps, DeclDriveDirection*g_AllData->getMFlipDecSign(),
+            speedDecl/(g_AllData->getCelestialSpeed()*convertDegreesToMicrostepsDecl), 0);
+    } // the independent slews TSC used before, started at once
+
+    raTrackingIsOn = true;
+    for (segment = 0; segment < segments; segment++) {
+        tSegment = g_VirtualMount->getVirtualTime();
+        if (this->synchronisedSlews == true) {
+            goToIsActiveInRA = this->mountControl->movesInSegment(segment, 0);
+            goToIsActiveInDecl = this->mountControl->movesInSegment(segment, 1);
+            if (goToIsActiveInRA == true) {
+                this->StepperDriveRA->stopDrive();
+                this->mountControl->startSegment(segment, 0);
+            }
+            if (goToIsActiveInDecl == true) {
+                this->mountControl->startSegment(segment, 1);
+            }
+        } else {
+            goToIsActiveInRA = goToIsActiveInDecl = true;
+        }
+        if (goToIsActiveInRA == true) {
+            raTrackingIsOn = false;
+        }
+        while ((goToIsActiveInRA == true) || (goToIsActiveInDecl == true)) {
+            g_VirtualMount->advanceTime(0.1);
+            if ((raTrackingIsOn == false) && (goToIsActiveInRA == false)) {
+                this->startRATracking();
+                raTrackingIsOn = true;
+            }
+            if (goToIsActiveInRA == true) {
+                endPos[0] = g_VirtualMount->getMotorPosition(true);
+            }
+            if (goToIsActiveInDecl == true) {
+                endPos[1] = g_VirtualMount->getMotorPosition(false);
+            }
+            pathRA.push_back(endPos[0]);
+            pathDecl.push_back(endPos[1]);
+            if ((goToIsActiveInRA == true) && (this->isDriveActive(true) == false)) {
+                goToIsActiveInRA = false;
+                this->etaModel->finishSlew(0, g_VirtualMount->getVirtualTime() - tSegment);
+            }
+            if ((goToIsActiveInDecl == true) && (this->isDriveActive(false) == false)) {
+                goToIsActiveInDecl = false;
+                this->etaModel->finishSlew(1, g_VirtualMount->getVirtualTime() - tSegment);
+            }
+        } // the loop of MainWindow::updateReadings during a GoTo; the axes stop at every waypoint
+    }
+    actualDuration = g_VirtualMount->getVirtualTime() - tStart;
+
+    this->mountControl->finishGoTo(g_AllData->getDriveParams(0,1), g_AllData->getDriveParams(1,1),
+                                   g_AllData->getDriveParams(1,2)); // terminateGoTo
+    this->StepperDriveDecl->stopDrive();
+    this->believedRA = targetRA;
+    this->believedDecl = targetDecl; // syncMountFromGoTo
+    this->startRATracking();
+    this->lastRateUpdate = g_VirtualMount->getVirtualTime();
+    this->raStepsPending = 0;
+    this->declStepsPending = 0;
+
+    g_VirtualMount->getPointing(&ra, &decl);
+    travelRA = ra - targetRA;
+    if (travelRA > 180) {
+        travelRA -= 360;
+    }
+    if (travelRA < -180) {
+        travelRA += 360;
+    }
+    err = 3600.0*sqrt(pow(travelRA*cos(targetDecl/180.0*M_PI), 2) + pow(decl - targetDecl, 2));
+    this->results.gotoCount++;
+    this->results.gotoErrSum += err;
+    this->results.gotoErrMax = fmax(this->results.gotoErrMax, err);
+    err = fabs(actualDuration - gotoETA/1000.0);
+    this->results.etaErrSum += err;
+    this->results.etaErrMax = fmax(this->results.etaErrMax, err);
+    this->results.slewSeconds += actualDuration;
+    if ((fabs(endPos[0] - startPos[0]) > 1) && (fabs(endPos[1] - startPos[1]) > 1)) {
+        err = 0;
+        for (idx = 0; idx < pathRA.size(); idx++) {
+            progressRA = (pathRA[idx] - startPos[0])/(endPos[0] - startPos[0]);
+            progressDecl = (pathDecl[idx] - startPos[1])/(endPos[1] - startPos[1]);
+            err = fmax(err, 100.0*fabs(progressRA - progressDecl));
+        }
+        this->results.pathCount++;
+        this->results.pathDevSum += err;
+        this->results.pathDevMax = fmax(this->results.pathDevMax, err);
+    } // the end positions are measured, so the backlash of the declination drive counts as travel
+}
+
+//---------------------------------------------------
+// drift of the tracking mount in arcsec/h; a part of it comes from the integer speeds of the AMIS. with the
+// tracking calibration, the field is plate solved every two minutes - the solutions scatter by an arcsec - and
+// the model is fitted again at the end
+void TSC_NightBenchmark::trackUnguided(double duration) {
+    double ra0, decl0, ra1, decl1, dRA, tEnd, nextSolution, step;
+
+    if (duration <= 0) {
+        return;
+    }
+    g_VirtualMount->getPointing(&ra0, &decl0);
+    if (this->calibrateTracking == true) {
+        this->driftCalibration->startField(true);
+    }
+    tEnd = g_VirtualMount->getVirtualTime() + duration;
+    nextSolution = g_VirtualMount->getVirtualTime();
+    while (g_VirtualMount->getVirtualTime() < tEnd) {
+        if ((this->calibrateTracking == true) && (g_VirtualMount->getVirtualTime() >= nextSolution)) {
+            g_VirtualMount->getPointing(&ra1, &decl1);
+            this->driftCalibration->addSolution(g_VirtualMount->getVirtualTime(), g_VirtualMount->getLocalSiderealTime(),
+                                                ra1 + (2*this->getUniform() - 1)/3600.0/cos(decl1/180.0*M_PI),
+                                                decl1 + (2*this->getUniform() - 1)/3600.0);
+            this->results.solutions++;
+            nextSolution += 120.0;
+        }
+        step = fmin(2.0, tEnd - g_VirtualMount->getVirtualTime());
+        g_VirtualMount->advanceTime(step);
+        this->updateTrackingRates();
+    }
+    g_VirtualMount->getPointing(&ra1, &decl1);
+    if (this->calibrateTracking == true) {
+        this->driftCalibration->fitModel();
+    }
+    dRA = ra1 - ra0;
+    if (dRA > 180) {
+        dRA -= 360;
+    }
+    if (dRA < -180) {
+        dRA += 360;
+    }
+    this->results.driftCount++;
+    this->results.driftRASum += fabs(dRA*cos(decl0/180.0*M_PI))*3600.0/(duration/3600.0);
+    this->results.driftDeclSum += fabs(decl1 - decl0)*3600.0/(duration/3600.0);
+}
+
+//---------------------------------------------------
+// the RA correction is carried out with the RA drive; tracking is resumed afterwards
+void TSC_NightBenchmark::raPulseGuide(long pulseDurationInMS, short direction) {
+    this->StepperDriveRA->stopDrive();
+    if (direction > 0) {
+        this->StepperDriveRA->travelForNSteps(1, (float)(1 + this->guideParams.guideRate));
+    } else {
+        this->StepperDriveRA->travelForNSteps(1, (float)(1 - this->guideParams.guideRate));
+    }
+    this->advanceClock(pulseDurationInMS/1000.0);
+    this->StepperDriveRA->stopDrive();
+    this->startRATracking();
+}
+
+//---------------------------------------------------
+void TSC_NightBenchmark::declPulseGuide(long pulseDurationInMS, short direction) {
+    this->StepperDriveDecl->travelForNSteps(direction, (float)this->guideParams.guideRate);
+    this->advanceClock(pulseDurationInMS/1000.0);
+    this->StepperDriveDecl->stopDrive();
+    this->StepperDriveDecl->resetSteppersAfterStop();
+}
+
+//---------------------------------------------------
+void TSC_NightBenchmark::startExposure(double expTime) {
+    this->exposure.isOpen = true;
+    this->exposure.subframe = this->subframe;
+    this->exposure.end = g_VirtualMount->getVirtualTime() + expTime;
+    this->exposure.samples = 0;
+    this->exposure.sumRA = 0;
+    this->exposure.sumDecl = 0;
+}
+
+//---------------------------------------------------
+// time passes in slices of 0.1 s so that the star image averages over guide pulses that fall into the exposure
+void TSC_NightBenchmark::advanceClock(double seconds) {
+    double now, slice, ra, decl, dRA;
+
+    now = g_VirtualMount->getVirtualTime();
+    while (seconds > 1e-9) {
+        slice = fmin(seconds, 0.1);
+        if ((this->exposure.isOpen == true) && (now < this->exposure.end)) {
+            slice = fmin(slice, this->exposure.end - now);
+        }
+        g_VirtualMount->advanceTime(slice);
+        now += slice;
+        seconds -= slice;
+        this->StepperDriveRA->finishBacklashTakeUp();
+        this->StepperDriveDecl->finishBacklashTakeUp(); // as in the event queue of MainWindow
+        if ((this->exposure.isOpen == true) && (now <= this->exposure.end + 1e-9)) {
+            g_VirtualMount->getPointing(&ra, &decl);
+            if (this->exposure.samples == 0) {
+                this->exposure.ra0 = ra;
+            }
+            dRA = ra - this->exposure.ra0;
+            if (dRA > 180) {
+                dRA -= 360;
+            }
+            if (dRA < -180) {
+                dRA += 360;
+            }
+            this->exposure.sumRA += dRA;
+            this->exposure.sumDecl += decl;
+            this->exposure.samples++;
+        }
+    }
+}
+
+//---------------------------------------------------
+void TSC_NightBenchmark::getExposurePointing(double *ra, double *decl) {
+    this->exposure.isOpen = false;
+    if (this->exposure.samples == 0) {
+        g_VirtualMount->getPointing(ra, decl);
+        return;
+    }
+    *ra = fmod(this->exposure.ra0 + this->exposure.sumRA/this->exposure.samples + 360.0, 360.0);
+    *decl = this->exposure.sumDecl/this->exposure.samples;
+}
+
+//---------------------------------------------------
+// the guiding loop of MainWindow::correctGuideStarPosition; the pulses are computed by TSC_MountControl with
+// the guide algorithms chosen for RA and decl. the calibration run is replaced by the values it would find:
+// the directions of RA+ and decl+ on the chip and the time for a correction of one pixel at the guide rate.
+void TSC_NightBenchmark::guideFor(double duration) {
+    QElapsedTimer wallClock;
+    double tEnd, ra0, decl0, ra, decl, x, y, x0, y0, xRA, yRA, xDecl, yDecl, norm, dRA, errRA, errDecl, err;
+    double rotMatrix[2][2], travelTimeMSRA, travelTimeMSDecl, refX, refY, cx, cy, dev[2];
+    double arcsecPerPix, lastArrival, readout, tStart;
+    float scaleFact, starX, starY;
+    bool starFound;
+    struct TSC_MountControl::guideStepStruct step;
+    struct TSC_GuideLog::guideSegmentStruct logSegment;
+    struct TSC_GuideLog::guideFrameStruct logFrame;
+
+    g_VirtualMount->getPointing(&ra0, &decl0);
+    this->subframe = QRect();
+    this->sky->setSubframe(this->subframe);
+    this->sky->renderFrame(ra0, decl0);
+    if (this->automaticStarSelection == true) {
+        wallClock.start();
+        starFound = this->guiding->findGuideStar(&starX, &starY, 0, this->guideParams.FOVFactor);
+        this->results.starSelectionMS += wallClock.nsecsElapsed()/1.0e6;
+        this->results.starSelections++;
+        x = starX;
+        y = starY;
+    } else {
+        starFound = this->sky->findGuideStar(&x, &y);
+    }
+    if (starFound == false) {
+        this->results.guideSegmentsWithoutStar++;
+        g_VirtualMount->advanceTime(duration);
+        return;
+    }
+    scaleFact = g_AllData->getCameraImageScalingFactor(false);
+    g_AllData->setInitialStarPosition(x*scaleFact, y*scaleFact); // the click on the star in the camera view
+    this->guiding->doGuideStarImgProcessing(this->guideParams.threshold, false, false, 1.0, 0, this->guideParams.FOVFactor, true, true);
+    this->guiding->initStarEnsemble(this->guideStars);
+    refX = g_AllData->getInitialStarPosition(2);
+    refY = g_AllData->getInitialStarPosition(3);
+
+    this->sky->projectToChip(ra0, decl0, ra0, decl0, &x0, &y0);
+    this->sky->projectToChip(ra0, decl0, ra0 - 0.01, decl0, &xRA, &yRA); // RA+ increases the hour angle
+    this->sky->projectToChip(ra0, decl0, ra0, decl0 + 0.01, &xDecl, &yDecl);
+    norm = sqrt((xRA - x0)*(xRA - x0) + (yRA - y0)*(yRA - y0));
+    rotMatrix[0][0] = (xRA - x0)/norm;
+    rotMatrix[0][1] = (yRA - y0)/norm;
+    norm = sqrt((xDecl - x0)*(xDecl - x0) + (yDecl - y0)*(yDecl - y0));
+    rotMatrix[1][0] = (xDecl - x0)/norm;
+    rotMatrix[1][1] = (yDecl - y0)/norm;
+    arcsecPerPix = this->guiding->getArcSecsPerPix(0);
+    travelTimeMSRA = arcsecPerPix/(this->guideParams.guideRate*g_AllData->getCelestialSpeed()*3.6*cos(decl0/180.0*M_PI));
+    travelTimeMSDecl = arcsecPerPix/(this->guideParams.guideRate*g_AllData->getCelestialSpeed()*3.6);
+    this->mountControl->setGuideCalibration(rotMatrix, travelTimeMSRA, travelTimeMSDecl);
+    this->mountControl->setGuideParameters(this->guideParams.maxDevInPix, this->guideParams.aggressiveness,
+                                           this->guideParams.hysteresisWeight, true); // decl+ of the virtual mount moves the star the other way, as with "Switch Decl"
+    this->mountControl->resetGuiding(); // a new guide star
+    if (this->guideLog->isOpen() == true) {
+        logSegment.travelTime[0] = travelTimeMSRA;
+        logSegment.travelTime[1] = travelTimeMSDecl;
+        memcpy(logSegment.rotation, rotMatrix, sizeof(logSegment.rotation));
+        logSegment.arcsecPerPixel[0] = logSegment.arcsecPerPixel[1] = arcsecPerPix;
+        logSegment.reference[0] = refX;
+        logSegment.reference[1] = refY;
+        logSegment.declBacklash = 0;
+        logSegment.backlashCompensated = false;
+        logSegment.method[0] = this->guideAlgorithm[0]->getMethod();
+        logSegment.method[1] = this->guideAlgorithm[1]->getMethod();
+        this->guideLog->startSegment(&logSegment);
+    }
+    logFrame.declDirection = 1;
+
+    tStart = g_VirtualMount->getVirtualTime(); // the frame timer of MainWindow starts with the reference
+    tEnd = tStart + duration;
+    lastArrival = g_VirtualMount->getVirtualTime();
+    if (g_VirtualMount->getVirtualTime() + this->guideExposure < tEnd) {
+        this->startExposure(this->guideExposure);
+        this->advanceClock(this->guideExposure);
+    }
+    while (this->exposure.isOpen == true) {
+        this->getExposurePointing(&ra, &decl); // the star image is where the mount pointed on average during the exposure
+        readout = 1.0;
+        if (this->exposure.subframe.isNull() == false) {
+            readout = this->exposure.subframe.width()*this->exposure.subframe.height()/(double)(g_AllData->getCameraChipPixels(0,false)*
+                g_AllData->getCameraChipPixels(1,false));
+        }
+        this->results.readoutFraction += readout;
+        this->advanceClock(0.02 + 0.18*readout); // download; 0.2 s for the full chip, most of it is the transfer
+        this->results.guideSeconds += g_VirtualMount->getVirtualTime() - lastArrival;
+        lastArrival = g_VirtualMount->getVirtualTime();
+        if ((this->pipelinedGuiding == true) && (g_VirtualMount->getVirtualTime() + this->guideExposure < tEnd)) {
+            this->startExposure(this->guideExposure);
+        } // TSC_GuidePipeline: the next exposure starts when the image has arrived, the correction falls into it
+        wallClock.start();
+        this->sky->setSubframe(this->exposure.subframe);
+        this->sky->renderFrame(ra, decl);
+        this->guiding->doGuideStarImgProcessing(this->guideParams.threshold, false, false, 1.0, 0, this->guideParams.FOVFactor, true, true);
+        if (this->guiding->getNumberOfEnsembleStars(false) > 1) {
+            if (this->guiding->doStarEnsembleProcessing() == true) {
+                this->results.ensembleFrames++;
+                this->results.ensembleStarsUsed += this->guiding->getNumberOfEnsembleStars(true);
+            }
+        } // as in MainWindow::displayGuideCamImage
+        if (this->guideSubframe == true) {
+            this->subframe = this->guiding->getGuideSubframe(this->subframe, this->guideParams.FOVFactor);
+        }
+        this->results.frameProcessingMS += wallClock.nsecsElapsed()/1.0e6;
+        this->advanceClock(0.05); // processing
+        dRA = ra - ra0;
+        if (dRA > 180) {
+            dRA -= 360;
+        }
+        if (dRA < -180) {
+            dRA += 360;
+        }
+        errRA = dRA*cos(decl0/180.0*M_PI)*3600.0;
+        errDecl = (decl - decl0)*3600.0;
+        err = sqrt(errRA*errRA + errDecl*errDecl);
+        this->results.guideFrames++;
+        this->results.guideSqSumRA += errRA*errRA;
+        this->results.guideSqSumDecl += errDecl*errDecl;
+        this->results.guideMax = fmax(this->results.guideMax, err);
+
+        cx = g_AllData->getInitialStarPosition(2);
+        cy = g_AllData->getInitialStarPosition(3);
+        dev[0] = cx - refX;
+        dev[1] = cy - refY;
+        this->results.measuredSqSum += (dev[0]*dev[0] + dev[1]*dev[1])*arcsecPerPix*arcsecPerPix;
+        logFrame.time = g_VirtualMount->getVirtualTime() - tStart;
+        this->mountControl->computeGuideStep(dev[0], dev[1], logFrame.time, &step);
+        logFrame.centroid[0] = cx;
+        logFrame.centroid[1] = cy;
+        logFrame.snr = this->guiding->getStarParameter(0);
+        logFrame.deviation[0] = step.deviation[0];
+        logFrame.deviation[1] = step.deviation[1];
+        logFrame.pulse[0] = logFrame.pulse[1] = 0;
+        logFrame.stars = 1;
+        if (this->guiding->getNumberOfEnsembleStars(false) > 1) {
+            logFrame.stars = this->guiding->getNumberOfEnsembleStars(true);
+        }
+        if (step.correction[0] != 0) {
+            this->results.pulseSeconds[0] += step.pulseDuration[0]/1000.0;
+            logFrame.pulse[0] = copysign(step.pulseDuration[0], step.correction[0]);
+            this->raPulseGuide(step.pulseDuration[0], step.pulseDirection[0]);
+        }
+        this->advanceClock(0.5);
+        if (step.correction[1] != 0) {
+            this->results.pulseSeconds[1] += step.pulseDuration[1]/1000.0;
+            logFrame.pulse[1] = copysign(step.pulseDuration[1], step.correction[1]);
+            this->declPulseGuide(step.pulseDuration[1], step.pulseDirection[1]);
+            logFrame.declDirection = step.pulseDirection[1];
+        }
+        this->guideLog->writeFrame(&logFrame);
+        this->advanceClock(0.25);
+        this->updateTrackingRates();
+        if (this->exposure.isOpen == true) {
+            if (g_VirtualMount->getVirtualTime() < this->exposure.end) {
+                this->advanceClock(this->exposure.end - g_VirtualMount->getVirtualTime());
+            }
+        } else if (g_VirtualMount->getVirtualTime() + this->guideExposure < tEnd) {
+            this->startExposure(this->guideExposure);
+            this->advanceClock(this->guideExposure);
+        }
+    }
+    if (this->guideAlgorithm[0]->getPeriod() > 0) {
+        this->results.periodSum += this->guideAlgorithm[0]->getPeriod();
+        this->results.periodCount++;
+    }
+    if (g_VirtualMount->getVirtualTime() < tEnd) {
+        g_VirtualMount->advanceTime(tEnd - g_VirtualMount->getVirtualTime());
+    }
+}
+
+//---------------------------------------------------
+// for every target: GoTo, ten minutes without guiding and the rest of the plan with guiding
+void TSC_NightBenchmark::runNight(void) {
+    QElapsedTimer wallClock;
+    double ra, decl, plan, unguided;
+    long idx;
+
+    wallClock.start();
+    this->initiateStepperDrivers();
+    g_VirtualMount->setStartConditions(this->lstAtStart, 0, 90);
+    this->believedRA = fmod(this->lstAtStart*15.0, 360.0);
+    this->believedDecl = 90; // the mount is synced in its park position at the pole; a tilted polar axis does not point there
+    this->startRATracking();
+    for (idx = 0; idx < this->targetList->getNumberOfTargets(); idx++) {
+        if (g_VirtualMount->getVirtualTime() >= this->sessionLength) {
+            break;
+        }
+        ra = this->targetList->getTargetCoordinates(idx, 0);
+        decl = this->targetList->getTargetCoordinates(idx, 1);
+        if (this->getAltitude(ra, decl) < 20) {
+            this->results.targetsSkipped++;
+            continue;
+        }
+        this->doGoTo(ra, decl);
+        this->results.targetsVisited++;
+        this->sky->selectField(ra, decl);
+        plan = fmin(this->targetList->getPlanDuration(idx), this->sessionLength - g_VirtualMount->getVirtualTime());
+        unguided = fmin(600.0, 0.25*plan);
+        this->trackUnguided(unguided);
+        this->guideFor(plan - unguided);
+    }
+    this->results.virtualSeconds = g_VirtualMount->getVirtualTime();
+    this->results.wallSeconds = wallClock.nsecsElapsed()/1.0e9;
+}
+
+//---------------------------------------------------
+void TSC_NightBenchmark::printReport(void) {
+    printf("TSC night benchmark\n");
+    printf("virtual time:             %10.1f s\n", this->results.virtualSeconds);
+    printf("wall clock time:          %10.1f s\n", this->results.wallSeconds);
+    if (this->results.wallSeconds > 0) {
+        printf("speed-up:                 %10.1f x\n", this->results.virtualSeconds/this->results.wallSeconds);
+    }
+    printf("targets visited/skipped:  %10ld / %ld\n", this->results.targetsVisited, this->results.targetsSkipped);
+    if (this->results.gotoCount > 0) {
+        printf("GoTo error mean/max:      %10.1f / %.1f arcsec\n", this->results.gotoErrSum/this->results.gotoCount, this->results.gotoErrMax);
+        printf("GoTo ETA error mean/max:  %10.2f / %.2f s\n", this->results.etaErrSum/this->results.gotoCount, this->results.etaErrMax);
+        printf("ETA model RA/decl:        %10.2f / %.2f acceleration factor, %.2f / %.2f s latency, %.2f / %.2f s rms\n",
+               this->etaModel->getParameter(0,0), this->etaModel->getParameter(1,0), this->etaModel->getParameter(0,1),
+               this->etaModel->getParameter(1,1), this->etaModel->getParameter(0,2), this->etaModel->getParameter(1,2));
+        printf("GoTo time total/mean:     %10.1f / %.1f s (%s axes)\n", this->results.slewSeconds, this->results.slewSeconds/this->results.gotoCount,
+               (this->synchronisedSlews == true) ? "synchronised" : "independent");
+    }
+    if (this->results.pathCount > 0) {
+        printf("path deviation mean/max:  %10.1f / %.1f %% of the travel\n", this->results.pathDevSum/this->results.pathCount,
+               this->results.pathDevMax);
+    }
+    if (this->results.driftCount > 0) {
+        printf("unguided drift RA/decl:   %10.1f / %.1f arcsec/h\n", this->results.driftRASum/this->results.driftCount,
+               this->results.driftDeclSum/this->results.driftCount);
+    }
+    if (this->calibrateTracking == true) {
+        printf("tracking calibration:     %10ld solutions in %ld fields, residual %.2f arcsec/min\n", this->results.solutions,
+               this->driftCalibration->getNumberOfFields(), this->driftCalibration->getResidual());
+        printf("RA rate error fit/true:   %10.3f / %.3f %%\n", 100.0*this->driftCalibration->getRateError(), 100.0*this->trueAlignment[0]);
+        printf("pole up fit/true:         %10.2f / %.2f arcmin\n", this->driftCalibration->getPoleOffset(0), this->trueAlignment[1]);
+        printf("pole east fit/true:       %10.2f / %.2f arcmin\n", this->driftCalibration->getPoleOffset(1), this->trueAlignment[2]);
+    }
+    if (this->results.guideFrames > 0) {
+        printf("guide frames:             %10ld\n", this->results.guideFrames);
+        printf("guide RMS RA/decl/total:  %10.2f / %.2f / %.2f arcsec\n", sqrt(this->results.guideSqSumRA/this->results.guideFrames),
+               sqrt(this->results.guideSqSumDecl/this->results.guideFrames),
+               sqrt((this->results.guideSqSumRA + this->results.guideSqSumDecl)/this->results.guideFrames));
+        printf("guide peak error:         %10.2f arcsec\n", this->results.guideMax);
+        printf("guide RMS as measured:    %10.2f arcsec\n", sqrt(this->results.measuredSqSum/this->results.guideFrames));
+        if (this->results.ensembleFrames > 0) {
+            printf("guide stars used:         %10.1f of %ld, in %ld frames\n", this->results.ensembleStarsUsed/(double)this->results.ensembleFrames,
+                   this->guideStars, this->results.ensembleFrames);
+        }
+        printf("frame processing:         %10.2f ms/frame\n", this->results.frameProcessingMS/this->results.guideFrames);
+        printf("guide cycle:              %10.2f s (%s)\n", this->results.guideSeconds/this->results.guideFrames,
+               (this->pipelinedGuiding == true) ? "pipelined" : "exposure after correction");
+        printf("guide readout:            %10.1f %% of the chip\n", 100*this->results.readoutFraction/this->results.guideFrames);
+        printf("guide algorithm RA/decl:  %10s / %s\n", algorithmNames[this->guideAlgorithm[0]->getMethod()],
+               algorithmNames[this->guideAlgorithm[1]->getMethod()]);
+        printf("guide pulses RA/decl:     %10.1f / %.1f s/h\n", 3600*this->results.pulseSeconds[0]/this->results.guideSeconds,
+               3600*this->results.pulseSeconds[1]/this->results.guideSeconds);
+        if (this->results.periodCount > 0) {
+            printf("periodic error found:     %10.0f s, worm %.0f s, in %ld targets\n", this->results.periodSum/this->results.periodCount,
+                   86164.1/g_AllData->getGearData(2), this->results.periodCount);
+        }
+    }
+    if (this->results.starSelections > 0) {
+        printf("guide star selection:     %10.2f ms/target (full frame search)\n", this->results.starSelectionMS/this->results.starSelections);
+    }
+    if (this->results.guideSegmentsWithoutStar > 0) {
+        printf("targets without guide star: %8ld\n", this->results.guideSegmentsWithoutStar);
+    }
+}
@@ -0,0 +1,164 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+// runs an observing night on the virtual mount. the drive classes, the guiding image processing, the
+// slew planner, the ETA model, the guide algorithms and the target list are the ones of TSC, and so are the
+// GoTo and the guide step: doGoTo and guideFor call TSC_MountControl as MainWindow does. the benchmark
+// replaces the GUI and the event queue around them by the virtual clock, and it leaves out refraction, the
+// meridian flip, the horizon mask and the guiding calibration run. for every target, the accuracy of the
+// GoTo, the drift of the mount without guiding and the guiding error are recorded. the errors are taken from the true position of the virtual mount, not from what TSC believes.
+
+#ifndef TSC_NIGHTBENCHMARK_H
+#define TSC_NIGHTBENCHMARK_H
+
+#include <QString>
+#include <QRect>
+#include "QtContinuousStepper.h"
+#include "QtKineticStepper.h"
+#include "ocv_guiding.h"
+#include "tsc_sequencer.h"
+#include "tsc_refraction.h"
+#include "tsc_slewtimemodel.h"
+#include "tsc_slewplanner.h"
+#include "tsc_mountcontrol.h"
+#include "tsc_driftcalibration.h"
+#include "tsc_guidealgorithm.h"
+#include "tsc_guidelog.h"
+#include "tsc_virtualsky.h"
+
+class TSC_NightBenchmark {
+public:
+    TSC_NightBenchmark(unsigned int); // seed for the targets and the sky
+    ~TSC_NightBenchmark(void);
+    bool loadTargets(QString); // a .tsq file as used by the sequencer
+    void generateTargets(long); // a number of random targets that are well above the horizon
+    void setSession(double, double); // LST at the start in hours and length of the night in hours
+    void setGuiding(double, double, double); // exposure time of the guide camera in s, seeing FWHM and image motion in arcsec
+    void setMountErrors(double, double); // periodic error amplitude in arcsec and declination drift in arcsec/min
+    void setSynchronisedSlews(bool); // false lets both axes of a GoTo ramp on their own, as TSC did before
+    void setAlignmentErrors(double, double, double); // tilt of the polar axis up and east in arcmin, RA gear error as a fraction
+    void setTrackingCalibration(bool); // plate solve while tracking unguided and correct the tracking rates from the drift
+    void setGuideStars(long); // number of stars for guiding, 1 is the selected star alone
+    void setSkyConditions(double, double); // part of the image motion that differs between stars, part of the chip covered by a passing cloud
+    void setPipelinedGuiding(bool); // false waits for the correction before the next guide exposure, as TSC did before
+    void setGuideSubframe(bool); // read out only the region around the guide stars, as ccd_client does with the "Subframe" checkbox
+    void setGuideAlgorithms(short, short); // for RA and decl, one of TSC_GuideAlgorithm::guideMethod
+    void setAutomaticStarSelection(bool); // true searches the rendered frame for the guide star as the "Find Star" button does
+    bool setGuideLog(QString); // writes the guide frames to a log as MainWindow does; false if it cannot be opened
+    void runNight(void);
+    void printReport(void);
+
+private:
+    QtContinuousStepper *StepperDriveRA;
+    QtKineticStepper *StepperDriveDecl;
+    ocv_guiding *guiding;
+    TSC_Sequencer *targetList;
+    TSC_Refraction *horizon;
+    TSC_SlewTimeModel *etaModel; // the GoTo ETA as in MainWindow, calibrated during the night
+    TSC_SlewPlanner *slewPlanner;
+    TSC_MountControl *mountControl; // created with the drives
+    bool synchronisedSlews;
+    TSC_DriftCalibration *driftCalibration;
+    bool calibrateTracking;
+    double trueAlignment[3]; // rate error, tilt up and east in arcmin of the virtual mount
+    double lastRateUpdate; // virtual time of the last call of updateTrackingRates
+    double raStepsPending;
+    double declStepsPending;
+    TSC_VirtualSky *sky;
+    unsigned int randomState;
+    bool targetsWereLoaded;
+    double lstAtStart;
+    double sessionLength; // in seconds
+    double guideExposure;
+    long guideStars;
+    bool pipelinedGuiding;
+    bool guideSubframe;
+    bool automaticStarSelection; // false takes the guide star from the catalog of the virtual sky
+    TSC_GuideAlgorithm *guideAlgorithm[2]; // RA and decl
+    TSC_GuideLog *guideLog;
+    QRect subframe; // for the next guide exposure; a null QRect is the full chip
+    struct exposureStruct {
+        bool isOpen;
+        QRect subframe;
+        double end; // virtual time
+        double ra0; // the first pointing; the others are summed relative to it
+        double sumRA;
+        double sumDecl;
+        long samples;
+    };
+    struct exposureStruct exposure;
+    double believedRA; // the position TSC assumes after the last sync
+    double believedDecl;
+    struct guideParamsStruct {
+        int threshold;
+        float guideRate;
+        float aggressiveness;
+        float hysteresisWeight;
+        float maxDevInPix;
+        float FOVFactor;
+    };
+    struct guideParamsStruct guideParams;
+    struct benchmarkResultsStruct {
+        long targetsVisited;
+        long targetsSkipped;
+        long gotoCount;
+        double gotoErrSum; // arcsec
+        double gotoErrMax;
+        double etaErrSum; // difference between estimated and actual slew time in s
+        double etaErrMax;
+        double slewSeconds; // sum of the measured GoTo durations
+        long pathCount; // GoTos that moved both axes
+        double pathDevSum; // largest difference of the progress of both axes during a GoTo, in % of the travel
+        double pathDevMax;
+        long driftCount;
+        double driftRASum; // arcsec/h
+        double driftDeclSum;
+        long solutions; // plate solutions taken for the tracking calibration
+        long guideFrames;
+        long guideSegmentsWithoutStar;
+        long starSelections; // searches of the full frame for the guide star
+        double starSelectionMS; // wall clock time for them
+        long ensembleFrames; // frames with an offset from several stars
+        long ensembleStarsUsed;
+        double guideSqSumRA; // true guiding error, arcsec^2
+        double guideSqSumDecl;
+        double guideMax;
+        double measuredSqSum; // guiding error as TSC measures it from the centroid
+        double frameProcessingMS; // wall clock time for rendering and centroiding
+        double guideSeconds; // virtual time from the first to the last guide frame
+        double pulseSeconds[2]; // sum of the guide pulses in RA and decl
+        double periodSum; // periods of the periodic error found by the predictive guide algorithm in RA, in s
+        long periodCount;
+        double readoutFraction; // sum of the parts of the chip read out for the guide frames
+        double virtualSeconds;
+        double wallSeconds;
+    };
+    struct benchmarkResultsStruct results;
+    void initiateStepperDrivers(void);
+    bool isDriveActive(bool);
+    void startRATracking(void);
+    void updateTrackingRates(void);
+    void doGoTo(double, double);
+    void trackUnguided(double);
+    void guideFor(double);
+    void startExposure(double);
+    void advanceClock(double); // advanceTime of the virtual mount; the pointing is sampled while an exposure is open
+    void getExposurePointing(double*, double*); // mean pointing during the last exposure
+    void raPulseGuide(long, short);
+    void declPulseGuide(long, short);
+    double getUniform(void);
+    double getAltitude(double, double);
+};
+
+#endif // TSC_NIGHTBENCHMARK_H
@@ -0,0 +1,291 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+#include "tsc_virtualamis.h"
+#include <stdlib.h>
+#include <math.h>
+
+TSC_VirtualAMIS::TSC_VirtualAMIS(bool isRA) {
+    this->isRABoard = isRA;
+    this->driverEnabled = true;
+    this->driveParams.steps = 20000; // the default parameters of the firmware
+    this->driveParams.maxSpeedInMicrosteps = 1000;
+    this->driveParams.acceleration = 1000;
+    this->driveParams.isActive = false;
+    this->driveParams.current = 800;
+    this->driveParams.stepMode = 16;
+    this->motorState.currentPos = 0;
+    this->motorState.targetPos = 0;
+    this->motorState.speed = 0;
+    this->fullStepPosition = 0;
+    this->load.isActive = false;
+    this->load.isStalled = false;
+}
+
+//---------------------------------------------------
+TSC_VirtualAMIS::~TSC_VirtualAMIS(void) {
+}
+
+//---------------------------------------------------
+// the command syntax is a character followed by a numerical value, just like in the loop() of the firmware
+QString TSC_VirtualAMIS::receiveCommand(QString cmd) {
+    char commandIdentifier;
+    long numVal;
+
+    if (cmd.isEmpty() == true) {
+        return QString();
+    }
+    commandIdentifier = cmd.at(0).toLatin1();
+    numVal = strtol(cmd.mid(1).toLatin1().constData(), NULL, 10);
+    switch (commandIdentifier) {
+    case 0x06:
+        if (this->isRABoard == true) {
+            return QString("TSC_RA");
+        }
+        return QString("TSC_DE");
+    case 'a':
+        if ((numVal > 0) && (numVal < 100000)) {
+            this->driveParams.acceleration = numVal;
+            return QString("Acceleration set");
+        }
+        return QString("Acceleration value not permitted");
+    case 'c':
+        if ((numVal > 10) && (numVal < 3000)) {
+            this->driveParams.current = numVal;
+            return QString("Current set. AMIS settings ok");
+        }
+        return QString("Current value not permitted");
+    case 'e':
+        this->driverEnabled = (numVal == 1);
+        if (this->driverEnabled == true) {
+            return QString("Stepper enabled");
+        }
+        return QString("Stepper disabled");
+    case 'f':
+        return this->reportAMISStates(numVal);
+    case 'm':
+        switch (numVal) {
+        case 1: case 2: case 4: case 8: case 16: case 32: case 64: case 128:
+            this->driveParams.stepMode = numVal;
+            return QString("Microsteps set. AMIS settings ok");
+        }
+        return QString("Invalid microstep parameter");
+    case 'o':
+        this->driverEnabled = true;
+        this->load.isStalled = false;
+        this->setCurrentPosition(0);
+        this->motorState.targetPos = this->driveParams.steps;
+        this->driveParams.isActive = true;
+        return QString("Drive started");
+    case 'r':
+        return QString("1");
+    case 's':
+        this->driveParams.steps = numVal;
+        return QString("Steps set");
+    case 'v':
+        if ((numVal >= 0) && (numVal < 100000)) {
+            this->driveParams.maxSpeedInMicrosteps = numVal;
+            return QString("Speed set");
+        }
+        return QString("Speed value not permitted");
+    case 'x':
+        this->stop();
+        return QString("Drive stopped");
+    case 'z':
+        this->setCurrentPosition(0);
+        return QString("Counter reset");
+    }
+    return QString();
+}
+
+//---------------------------------------------------
+QString TSC_VirtualAMIS::reportAMISStates(long what) {
+    switch (what) {
+    case 0:
+        if (this->isMoving() == true) {
+            return QString("1");
+        }
+        return QString("0");
+    case 1: // the ERR pin of the AMIS is high if all is well; it does not tell about lost steps
+        return QString("1");
+    case 2:
+        return QString("1");
+    case 5: // steps carried out since the last 'o'
+        return QString::number((long)(this->driveParams.steps - (this->motorState.targetPos - this->motorState.currentPos)));
+    case 6:
+        return QString::number(this->driveParams.stepMode);
+    case 7:
+        return QString::number(this->driveParams.maxSpeedInMicrosteps);
+    case 8:
+        return QString::number(this->driveParams.acceleration);
+    case 9:
+        return QString::number(this->driveParams.current);
+    case 10:
+        return QString::number(this->driveParams.steps);
+    }
+    return QString("-1");
+}
+
+//---------------------------------------------------
+// AccelStepper::setCurrentPosition() also sets the target and stops the motor immediately
+void TSC_VirtualAMIS::setCurrentPosition(double pos) {
+    this->motorState.currentPos = pos;
+    this->motorState.targetPos = pos;
+    this->motorState.speed = 0;
+}
+
+//---------------------------------------------------
+// AccelStepper::stop() sets a new target that can be reached with the deceleration ramp
+void TSC_VirtualAMIS::stop(void) {
+    double stepsToStop;
+
+    if (this->motorState.speed != 0) {
+        stepsToStop = floor(this->motorState.speed*this->motorState.speed/(2.0*this->driveParams.acceleration)) + 1;
+        if (this->motorState.speed > 0) {
+            this->motorState.targetPos = this->motorState.currentPos + stepsToStop;
+        } else {
+            this->motorState.targetPos = this->motorState.currentPos - stepsToStop;
+        }
+    }
+}
+
+//---------------------------------------------------
+bool TSC_VirtualAMIS::isMoving(void) {
+    if ((this->motorState.speed == 0) && (this->motorState.targetPos == this->motorState.currentPos)) {
+        return false;
+    }
+    return true;
+}
+
+//---------------------------------------------------
+bool TSC_VirtualAMIS::isEnabled(void) {
+    return this->driverEnabled;
+}
+
+//---------------------------------------------------
+void TSC_VirtualAMIS::setLoad(double accPerAmp, double frict, double corner) {
+    this->load.isActive = ((accPerAmp > 0) && (corner > 0));
+    this->load.accPerAmpere = accPerAmp;
+    this->load.friction = frict;
+    this->load.cornerSpeed = corner;
+    this->load.isStalled = false;
+}
+
+//---------------------------------------------------
+bool TSC_VirtualAMIS::hasStalled(void) {
+    return this->load.isStalled;
+}
+
+//---------------------------------------------------
+double TSC_VirtualAMIS::getMotorPosition(void) {
+    return this->fullStepPosition;
+}
+
+//---------------------------------------------------
+// long stretches at constant speed are the rule when tracking; they are computed in one go.
+// ramps are integrated in small steps.
+void TSC_VirtualAMIS::advanceTime(double dt) {
+    const double maxSubStep = 0.005;
+    double distance, stopDist, h;
+
+    if ((this->isMoving() == false) || (dt <= 0)) {
+        return;
+    }
+    distance = this->motorState.targetPos - this->motorState.currentPos;
+    stopDist = this->motorState.speed*this->motorState.speed/(2.0*this->driveParams.acceleration);
+    if ((fabs(this->motorState.speed) == this->driveParams.maxSpeedInMicrosteps) && (this->motorState.speed*distance > 0) &&
+        (fabs(distance) - fabs(this->motorState.speed)*dt > stopDist + 1)) {
+        this->motorState.currentPos += this->motorState.speed*dt;
+        if (this->getAvailableAcceleration(fabs(this->motorState.speed)) < 0) {
+            this->load.isStalled = true;
+        }
+        if (this->load.isStalled == false) {
+            this->fullStepPosition += this->motorState.speed*dt/this->driveParams.stepMode;
+        }
+        return;
+    }
+    while ((dt > 0) && (this->isMoving() == true)) {
+        if (dt > maxSubStep) {
+            h = maxSubStep;
+        } else {
+            h = dt;
+        }
+        this->runForTime(h);
+        dt -= h;
+    }
+}
+
+//---------------------------------------------------
+// in microsteps/s^2 at a speed in microsteps/s; without a load model, the motor never stalls
+double TSC_VirtualAMIS::getAvailableAcceleration(double speed) {
+    double fullStepSpeed;
+
+    if (this->load.isActive == false) {
+        return 1e12;
+    }
+    fullStepSpeed = speed/this->driveParams.stepMode;
+    return (this->load.accPerAmpere*this->driveParams.current/1000.0/(1.0 + fullStepSpeed/this->load.cornerSpeed) -
+            this->load.friction)*this->driveParams.stepMode;
+}
+
+//---------------------------------------------------
+// one integration step of the trapezoidal profile; the motor accelerates towards the maximum speed
+// and brakes when the remaining distance equals the stopping distance
+void TSC_VirtualAMIS::runForTime(double h) {
+    double distance, stopDist, acc, vmax, newSpeed, travel;
+    short dir;
+
+    acc = this->driveParams.acceleration;
+    vmax = this->driveParams.maxSpeedInMicrosteps;
+    distance = this->motorState.targetPos - this->motorState.currentPos;
+    if (distance > 0) {
+        dir = 1;
+    } else {
+        dir = -1;
+    }
+    stopDist = this->motorState.speed*this->motorState.speed/(2.0*acc);
+    newSpeed = this->motorState.speed;
+    if ((this->motorState.speed*dir < 0) || (fabs(distance) <= stopDist)) {
+        if (newSpeed > 0) {
+            newSpeed = fmax(0.0, newSpeed - acc*h);
+        } else {
+            newSpeed = fmin(0.0, newSpeed + acc*h);
+        } // brake - either at the end of the travel or because the motor runs in the wrong direction
+    } else {
+        if (fabs(newSpeed) > vmax) {
+            newSpeed = dir*fmax(vmax, fabs(newSpeed) - acc*h);
+        } else {
+            newSpeed = dir*fmin(vmax, fabs(newSpeed) + acc*h);
+        }
+    }
+    if (fabs(newSpeed - this->motorState.speed)/h > this->getAvailableAcceleration(fmax(fabs(newSpeed), fabs(this->motorState.speed))) + 1e-6) {
+        this->load.isStalled = true;
+    } // the ramp needs more torque than the motor has at this speed
+    travel = 0.5*(this->motorState.speed + newSpeed)*h;
+    if ((fabs(travel) >= fabs(distance)) && (travel*distance >= 0) && (fabs(newSpeed) <= sqrt(2.0*acc*fabs(distance)) + acc*h)) {
+        travel = distance;
+        newSpeed = 0;
+    } // the target is reached within this step
+    this->motorState.currentPos += travel;
+    this->motorState.speed = newSpeed;
+    if (this->load.isStalled == false) {
+        this->fullStepPosition += travel/this->driveParams.stepMode;
+    }
+    if ((this->motorState.speed == 0) && (fabs(this->motorState.targetPos - this->motorState.currentPos) < 1e-6)) {
+        this->motorState.currentPos = this->motorState.targetPos;
+    }
+    if (this->isMoving() == false) {
+        this->driveParams.isActive = false;
+    }
+}
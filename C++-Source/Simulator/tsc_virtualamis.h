@@ -0,0 +1,73 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+// a software model of one AMIS driver board with the teensy firmware from Hardware/2_AMIS_Drives.
+// it understands the same USB commands, answers with the same strings and moves a virtual motor
+// with the trapezoidal speed profile of the AccelStepper library. time is not taken from a clock
+// but advanced by the caller, so the motor can run much faster than real time.
+// optionally, the motor stalls if the torque does not suffice for the acceleration and the speed; the
+// torque is proportional to the current and drops with the speed like the pull-out curve of a stepper.
+
+#ifndef TSC_VIRTUALAMIS_H
+#define TSC_VIRTUALAMIS_H
+
+#include <QString>
+
+class TSC_VirtualAMIS {
+public:
+    TSC_VirtualAMIS(bool); // true for the RA board, false for the declination board
+    ~TSC_VirtualAMIS(void);
+    QString receiveCommand(QString); // process a command as sent via USB and return the reply of the firmware
+    void advanceTime(double); // let the motor run for a given time in seconds
+    double getMotorPosition(void); // position of the motor shaft in full steps since the board was created
+    bool isMoving(void);
+    bool isEnabled(void);
+    void setLoad(double, double, double); // acceleration per ampere and friction in full steps/s^2, speed in full steps/s where the torque is halved
+    bool hasStalled(void); // true if the motor stalled since the last 'o'
+
+private:
+    bool isRABoard;
+    bool driverEnabled;
+    struct kinematicParametersStruct {
+        long steps; // number of microsteps to be carried out after the next 'o'
+        long maxSpeedInMicrosteps; // maximum speed in msteps/s
+        long acceleration; // acceleration in msteps/s^2
+        bool isActive; // flag whether the drive is moving
+        long current; // maximum current per coil in milliAmpere
+        long stepMode; // microstepping ratio
+    };
+    struct kinematicParametersStruct driveParams;
+    struct accelStepperStateStruct {
+        double currentPos; // position in microsteps, as counted by the AccelStepper library
+        double targetPos;
+        double speed; // signed speed in microsteps/s
+    };
+    struct accelStepperStateStruct motorState;
+    double fullStepPosition; // accumulated motor position in full steps; not affected by counter resets or microstep changes
+    struct loadModelStruct {
+        bool isActive;
+        double accPerAmpere;
+        double friction;
+        double cornerSpeed;
+        bool isStalled; // the board goes on counting steps, but the shaft stands still
+    };
+    struct loadModelStruct load;
+    void runForTime(double);
+    double getAvailableAcceleration(double);
+    void setCurrentPosition(double);
+    void stop(void);
+    QString reportAMISStates(long);
+};
+
+#endif // TSC_VIRTUALAMIS_H
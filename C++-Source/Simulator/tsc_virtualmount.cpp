@@ -0,0 +1,166 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+#include "tsc_virtualmount.h"
+#include "tsc_globaldata.h"
+#include <math.h>
+
+extern TSC_GlobalData *g_AllData;
+
+TSC_VirtualMount::TSC_VirtualMount(void) {
+    this->raBoard = new TSC_VirtualAMIS(true);
+    this->declBoard = new TSC_VirtualAMIS(false);
+    this->virtualTime = 0;
+    this->lstAtStart = 0;
+    this->haAtStart = 0;
+    this->declAtStart = 90; // the mount starts parked at the pole
+    this->periodicErrorAmplitude = 0;
+    this->declDriftRate = 0;
+    this->gearError = 0;
+    this->poleTilt[0] = 0;
+    this->poleTilt[1] = 0;
+}
+
+//---------------------------------------------------
+TSC_VirtualMount::~TSC_VirtualMount(void) {
+    delete this->raBoard;
+    delete this->declBoard;
+}
+
+//---------------------------------------------------
+QString TSC_VirtualMount::sendCommand(QString cmd, bool isRA) {
+    if (isRA == true) {
+        return this->raBoard->receiveCommand(cmd);
+    }
+    return this->declBoard->receiveCommand(cmd);
+}
+
+//---------------------------------------------------
+void TSC_VirtualMount::advanceTime(double dt) {
+    if (dt <= 0) {
+        return;
+    }
+    this->raBoard->advanceTime(dt);
+    this->declBoard->advanceTime(dt);
+    this->virtualTime += dt;
+}
+
+//---------------------------------------------------
+double TSC_VirtualMount::getVirtualTime(void) {
+    return this->virtualTime;
+}
+
+//---------------------------------------------------
+double TSC_VirtualMount::getLocalSiderealTime(void) {
+    double lst;
+
+    lst = this->lstAtStart + this->virtualTime*1.00273791/3600.0;
+    return fmod(lst, 24.0);
+}
+
+//---------------------------------------------------
+void TSC_VirtualMount::setStartConditions(double lst, double ha, double decl) {
+    this->lstAtStart = lst;
+    this->haAtStart = ha - this->getRAAxisAngle();
+    this->declAtStart = decl - this->getDeclAxisAngle();
+}
+
+//---------------------------------------------------
+void TSC_VirtualMount::setPeriodicError(double amplitude) {
+    this->periodicErrorAmplitude = fabs(amplitude);
+}
+
+//---------------------------------------------------
+void TSC_VirtualMount::setDeclinationDrift(double rate) {
+    this->declDriftRate = rate;
+}
+
+//---------------------------------------------------
+void TSC_VirtualMount::setGearError(double err) {
+    this->gearError = err;
+}
+
+//---------------------------------------------------
+void TSC_VirtualMount::setPolarMisalignment(double up, double east) {
+    this->poleTilt[0] = up/60.0/180.0*M_PI;
+    this->poleTilt[1] = east/60.0/180.0*M_PI;
+}
+
+//---------------------------------------------------
+// positive motor steps increase the hour angle, just like tracking does
+double TSC_VirtualMount::getRAAxisAngle(void) {
+    return (1.0 + this->gearError)*this->raBoard->getMotorPosition()*g_AllData->getGearData(3)/
+            (g_AllData->getGearData(0)*g_AllData->getGearData(1)*g_AllData->getGearData(2));
+}
+
+//---------------------------------------------------
+// the declination drive counts backwards - see "directionfactor" in QtKineticStepper
+double TSC_VirtualMount::getDeclAxisAngle(void) {
+    return -this->declBoard->getMotorPosition()*g_AllData->getGearData(7)/
+            (g_AllData->getGearData(4)*g_AllData->getGearData(5)*g_AllData->getGearData(6));
+}
+
+//---------------------------------------------------
+// the worm turns once for 360/wormsize degrees of the RA axis; its error is modelled as a sine. the hour angle
+// and declination of the axes are taken in a frame whose pole is the polar axis of the mount; for small tilts,
+// the rotation to the celestial frame is t + r x t with r = (-east, up, 0). x points to the meridian on the
+// equator, y to the east and z to the celestial pole
+void TSC_VirtualMount::getPointing(double *ra, double *decl) {
+    double ha, dec, raAxis, wormPhase, t[3], r[3];
+
+    raAxis = this->getRAAxisAngle();
+    wormPhase = raAxis*g_AllData->getGearData(2)/360.0*2*M_PI;
+    ha = this->haAtStart + raAxis + this->periodicErrorAmplitude/3600.0*sin(wormPhase);
+    dec = this->declAtStart + this->getDeclAxisAngle() + this->declDriftRate/3600.0*this->virtualTime/60.0;
+    if ((this->poleTilt[0] != 0) || (this->poleTilt[1] != 0)) {
+        t[0] = cos(dec/180.0*M_PI)*cos(ha/180.0*M_PI);
+        t[1] = -cos(dec/180.0*M_PI)*sin(ha/180.0*M_PI);
+        t[2] = sin(dec/180.0*M_PI);
+        r[0] = t[0] + this->poleTilt[0]*t[2];
+        r[1] = t[1] + this->poleTilt[1]*t[2];
+        r[2] = t[2] - this->poleTilt[0]*t[0] - this->poleTilt[1]*t[1];
+        ha = atan2(-r[1], r[0])*180.0/M_PI;
+        dec = asin(fmax(-1.0, fmin(1.0, r[2]/sqrt(r[0]*r[0] + r[1]*r[1] + r[2]*r[2]))))*180.0/M_PI;
+    }
+    *decl = dec;
+    *ra = this->getLocalSiderealTime()*15.0 - ha;
+    while (*ra < 0) {
+        *ra += 360;
+    }
+    while (*ra >= 360) {
+        *ra -= 360;
+    }
+}
+
+//---------------------------------------------------
+bool TSC_VirtualMount::drivesAreMoving(void) {
+    return (this->raBoard->isMoving() || this->declBoard->isMoving());
+}
+
+//---------------------------------------------------
+void TSC_VirtualMount::setLoad(bool isRA, double accPerAmp, double friction, double cornerSpeed) {
+    if (isRA == true) {
+        this->raBoard->setLoad(accPerAmp, friction, cornerSpeed);
+    } else {
+        this->declBoard->setLoad(accPerAmp, friction, cornerSpeed);
+    }
+}
+
+//---------------------------------------------------
+double TSC_VirtualMount::getMotorPosition(bool isRA) {
+    if (isRA == true) {
+        return this->raBoard->getMotorPosition();
+    }
+    return this->declBoard->getMotorPosition();
+}
@@ -0,0 +1,59 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+// a german equatorial mount driven by two virtual AMIS boards. the mount owns the virtual clock;
+// the position of the axes is derived from the motor positions and the gear data in g_AllData.
+// a periodic error of the RA worm, an error of the RA gear ratio, a tilt of the polar axis and a
+// drift in declination can be added. all angles are given in decimal degrees, times in seconds.
+
+#ifndef TSC_VIRTUALMOUNT_H
+#define TSC_VIRTUALMOUNT_H
+
+#include <QString>
+#include "tsc_virtualamis.h"
+
+class TSC_VirtualMount {
+public:
+    TSC_VirtualMount(void);
+    ~TSC_VirtualMount(void);
+    QString sendCommand(QString, bool); // command for the RA (true) or decl board, returns the reply
+    void advanceTime(double); // let virtual time pass; both boards move accordingly
+    double getVirtualTime(void); // seconds since the start of the simulation
+    double getLocalSiderealTime(void); // in hours
+    void setStartConditions(double, double, double); // LST in hours, hour angle and declination of the mount at start
+    void setPeriodicError(double); // amplitude in arcsec
+    void setDeclinationDrift(double); // drift in arcsec/min
+    void setGearError(double); // fraction by which the RA axis turns more than the gear data say
+    void setPolarMisalignment(double, double); // tilt of the polar axis towards the zenith and towards the east in arcmin
+    void getPointing(double*, double*); // RA and declination the telescope actually points to
+    bool drivesAreMoving(void);
+    void setLoad(bool, double, double, double); // a stall model for the motor of an axis, see TSC_VirtualAMIS::setLoad
+    double getMotorPosition(bool); // position of the motor shaft in full steps; it does not move while the motor stalls
+
+private:
+    TSC_VirtualAMIS *raBoard;
+    TSC_VirtualAMIS *declBoard;
+    double virtualTime;
+    double lstAtStart;
+    double haAtStart;
+    double declAtStart;
+    double periodicErrorAmplitude;
+    double declDriftRate;
+    double gearError;
+    double poleTilt[2]; // up and east in radians
+    double getRAAxisAngle(void);
+    double getDeclAxisAngle(void);
+};
+
+#endif // TSC_VIRTUALMOUNT_H
@@ -0,0 +1,324 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+#include "tsc_virtualsky.h"
+#include "tsc_globaldata.h"
+#include <math.h>
+
+extern TSC_GlobalData *g_AllData;
+
+TSC_VirtualSky::TSC_VirtualSky(unsigned int rseed) {
+    int i;
+
+    this->seed = rseed;
+    this->noiseState = rseed*2654435761u + 1;
+    for (i = 0; i < 256; i++) {
+        this->grayTable.append(qRgb(i,i,i));
+    } // the same color table as in ccd_client
+    this->camera.width = 1280;
+    this->camera.height = 1024;
+    this->camera.arcsecPerPix = 1.07;
+    this->camera.rotation = 0;
+    this->camera.fwhm = 2.5;
+    this->camera.jitter = 0.5;
+    this->camera.differentialMotion = 0;
+    this->camera.cloudCover = 0;
+    this->camera.subframe = QRect();
+    this->frameCount = 0;
+    this->lastPointingRA = 0;
+    this->lastPointingDecl = 0;
+}
+
+//---------------------------------------------------
+TSC_VirtualSky::~TSC_VirtualSky(void) {
+}
+
+//---------------------------------------------------
+void TSC_VirtualSky::setCamera(int w, int h, double scale, double rot) {
+    if ((w > 0) && (h > 0)) {
+        this->camera.width = w;
+        this->camera.height = h;
+    }
+    if (scale > 0) {
+        this->camera.arcsecPerPix = scale;
+    }
+    this->camera.rotation = rot;
+}
+
+//---------------------------------------------------
+void TSC_VirtualSky::setSeeing(double fwhm, double jitter) {
+    if (fwhm > 0) {
+        this->camera.fwhm = fwhm;
+    }
+    this->camera.jitter = fabs(jitter);
+}
+
+//---------------------------------------------------
+void TSC_VirtualSky::setDifferentialMotion(double fraction) {
+    this->camera.differentialMotion = fmin(1.0, fmax(0.0, fraction));
+}
+
+//---------------------------------------------------
+void TSC_VirtualSky::setClouds(double cover) {
+    this->camera.cloudCover = fmin(1.0, fmax(0.0, cover));
+}
+
+//---------------------------------------------------
+void TSC_VirtualSky::setSubframe(QRect subframe) {
+    this->camera.subframe = subframe;
+}
+
+//---------------------------------------------------
+// the band of cloud moves from the left to the right; it lets 2% of the light through and has soft edges
+double TSC_VirtualSky::getTransparency(double x) {
+    const long period = 300;
+    double halfWidth, centre, dist;
+
+    if (this->camera.cloudCover <= 0) {
+        return 1.0;
+    }
+    halfWidth = 0.5*this->camera.cloudCover*this->camera.width;
+    centre = (this->frameCount%period)/(double)period*(this->camera.width + 2*halfWidth) - halfWidth;
+    dist = fabs(x - centre) - halfWidth;
+    if (dist >= 40) {
+        return 1.0;
+    }
+    if (dist <= 0) {
+        return 0.02;
+    }
+    return 0.02 + 0.98*dist/40.0;
+}
+
+//---------------------------------------------------
+// a linear congruential generator - fast, and the same on every platform
+double TSC_VirtualSky::getUniform(unsigned int *state) {
+    *state = (*state)*1664525u + 1013904223u;
+    return ((*state) >> 8)/16777216.0;
+}
+
+//---------------------------------------------------
+double TSC_VirtualSky::getGaussian(unsigned int *state) {
+    double u1, u2;
+
+    u1 = this->getUniform(state);
+    u2 = this->getUniform(state);
+    if (u1 < 1e-12) {
+        u1 = 1e-12;
+    }
+    return sqrt(-2.0*log(u1))*cos(2*M_PI*u2);
+}
+
+//---------------------------------------------------
+// about 150 stars down to magnitude 15 per square degree; the number of stars brighter than a
+// magnitude grows by a factor of 2.5 per magnitude
+void TSC_VirtualSky::addStarsFromCell(int raCell, int declCell) {
+    struct starEntry star;
+    unsigned int cellState;
+    long numberOfStars, cnt;
+    double u;
+
+    cellState = this->seed ^ ((unsigned int)raCell*73856093u) ^ ((unsigned int)(declCell+90)*19349663u);
+    this->getUniform(&cellState);
+    numberOfStars = round(150.0*cos((declCell + 0.5)/180.0*M_PI));
+    for (cnt = 0; cnt < numberOfStars; cnt++) {
+        star.ra = raCell + this->getUniform(&cellState);
+        star.decl = declCell + this->getUniform(&cellState);
+        u = this->getUniform(&cellState);
+        if (u < 1e-6) {
+            u = 1e-6;
+        }
+        star.mag = 15.0 + 2.5*log10(u);
+        this->fieldStars.push_back(star);
+    }
+}
+
+//---------------------------------------------------
+void TSC_VirtualSky::selectField(double ra, double decl) {
+    int raCell, declCell, raFrom, raTo, declFrom, declTo;
+    double cosDecl, raRange;
+
+    this->fieldStars.clear();
+    declFrom = (int)floor(decl - 1.5);
+    declTo = (int)floor(decl + 1.5);
+    if (declFrom < -90) {
+        declFrom = -90;
+    }
+    if (declTo > 89) {
+        declTo = 89;
+    }
+    cosDecl = cos(fmin(fabs(decl) + 1.5, 90.0)/180.0*M_PI);
+    if (cosDecl < 0.01) {
+        raRange = 180;
+    } else {
+        raRange = fmin(180.0, 1.5/cosDecl);
+    }
+    raFrom = (int)floor(ra - raRange);
+    raTo = (int)floor(ra + raRange);
+    if (raTo - raFrom >= 360) {
+        raFrom = 0;
+        raTo = 359;
+    }
+    for (declCell = declFrom; declCell <= declTo; declCell++) {
+        for (raCell = raFrom; raCell <= raTo; raCell++) {
+            this->addStarsFromCell(((raCell % 360) + 360) % 360, declCell);
+        }
+    }
+    this->lastPointingRA = ra;
+    this->lastPointingDecl = decl;
+}
+
+//---------------------------------------------------
+// gnomonic projection; north is up and east is left for a rotation of zero
+void TSC_VirtualSky::projectToChip(double ra, double decl, double ra0, double decl0, double *x, double *y) {
+    double dRA, d, d0, cosc, xi, eta, rot;
+
+    dRA = ra - ra0;
+    if (dRA > 180) {
+        dRA -= 360;
+    }
+    if (dRA < -180) {
+        dRA += 360;
+    }
+    dRA = dRA/180.0*M_PI;
+    d = decl/180.0*M_PI;
+    d0 = decl0/180.0*M_PI;
+    cosc = sin(d0)*sin(d) + cos(d0)*cos(d)*cos(dRA);
+    if (cosc <= 0.01) {
+        *x = *y = -1e6;
+        return;
+    }
+    xi = cos(d)*sin(dRA)/cosc*206264.8/this->camera.arcsecPerPix;
+    eta = (cos(d0)*sin(d) - sin(d0)*cos(d)*cos(dRA))/cosc*206264.8/this->camera.arcsecPerPix;
+    rot = this->camera.rotation/180.0*M_PI;
+    *x = 0.5*this->camera.width - xi*cos(rot) + eta*sin(rot);
+    *y = 0.5*this->camera.height - xi*sin(rot) - eta*cos(rot);
+}
+
+//---------------------------------------------------
+// peak gray value of a star for the default exposure; magnitude 12.5 is just at saturation
+float TSC_VirtualSky::getPeakValue(float mag) {
+    return 235.0*pow(10.0, -0.4*(mag - 12.5));
+}
+
+//---------------------------------------------------
+void TSC_VirtualSky::renderFrame(double ra, double decl) {
+    QImage *frame;
+    uchar *line;
+    double sx, sy, jx, jy, sigma, peak, dx, dy, val, common;
+    int px, py, x0, x1, y0, y1, halfBox;
+    std::vector<starEntry>::iterator star;
+    QRect readout;
+
+    readout = QRect(0, 0, this->camera.width, this->camera.height);
+    if (this->camera.subframe.isNull() == false) {
+        readout = readout.intersected(this->camera.subframe);
+    }
+    frame = new QImage(this->camera.width, this->camera.height, QImage::Format_Indexed8);
+    frame->setColorTable(this->grayTable);
+    for (py = 0; py < this->camera.height; py++) {
+        line = frame->scanLine(py);
+        for (px = 0; px < this->camera.width; px++) {
+            if (readout.contains(px, py) == true) {
+                line[px] = (uchar)(14 + 12*this->getUniform(&this->noiseState));
+            } else {
+                line[px] = 0;
+            }
+        }
+    } // background and read noise
+    jx = this->getGaussian(&this->noiseState)*this->camera.jitter/this->camera.arcsecPerPix;
+    jy = this->getGaussian(&this->noiseState)*this->camera.jitter/this->camera.arcsecPerPix; // image motion from seeing
+    sigma = this->camera.fwhm/2.355/this->camera.arcsecPerPix;
+    halfBox = (int)ceil(4*sigma);
+    common = sqrt(1.0 - this->camera.differentialMotion*this->camera.differentialMotion);
+    for (star = this->fieldStars.begin(); star != this->fieldStars.end(); star++) {
+        this->projectToChip(star->ra, star->decl, ra, decl, &sx, &sy);
+        if (this->camera.differentialMotion > 0) {
+            sx += common*jx + this->camera.differentialMotion*this->getGaussian(&this->noiseState)*this->camera.jitter/this->camera.arcsecPerPix;
+            sy += common*jy + this->camera.differentialMotion*this->getGaussian(&this->noiseState)*this->camera.jitter/this->camera.arcsecPerPix;
+        } else {
+            sx += jx;
+            sy += jy;
+        } // the total image motion of every star stays the same
+        if ((sx < -halfBox) || (sy < -halfBox) || (sx > this->camera.width + halfBox) || (sy > this->camera.height + halfBox)) {
+            continue;
+        }
+        peak = this->getPeakValue(star->mag)*this->getTransparency(sx);
+        if (peak < 2) {
+            continue;
+        }
+        x0 = (int)fmax(readout.left(), floor(sx) - halfBox);
+        x1 = (int)fmin(readout.right(), floor(sx) + halfBox);
+        y0 = (int)fmax(readout.top(), floor(sy) - halfBox);
+        y1 = (int)fmin(readout.bottom(), floor(sy) + halfBox);
+        for (py = y0; py <= y1; py++) {
+            line = frame->scanLine(py);
+            dy = py + 0.5 - sy;
+            for (px = x0; px <= x1; px++) {
+                dx = px + 0.5 - sx;
+                val = line[px] + peak*exp(-(dx*dx + dy*dy)/(2*sigma*sigma));
+                if (val > 255) {
+                    val = 255;
+                }
+                line[px] = (uchar)val;
+            }
+        }
+    }
+    g_AllData->storeCameraImage(*frame);
+    delete frame;
+    this->lastPointingRA = ra;
+    this->lastPointingDecl = decl;
+    this->frameCount++;
+}
+
+//---------------------------------------------------
+// the star has to stand out from the background, should stay on the chip when the mount drifts a little
+// and must be alone in the image processing window of ocv_guiding. a star with a peak value of about 180
+// is preferred; fainter stars suffer from noise, brighter ones saturate
+bool TSC_VirtualSky::findGuideStar(double *x, double *y) {
+    std::vector<starEntry>::iterator star;
+    std::vector<double> cx, cy, cpeak;
+    double sx, sy, bestDiff = 1e6;
+    size_t i, j;
+    bool isIsolated;
+    int margin;
+
+    margin = 150;
+    for (star = this->fieldStars.begin(); star != this->fieldStars.end(); star++) {
+        this->projectToChip(star->ra, star->decl, this->lastPointingRA, this->lastPointingDecl, &sx, &sy);
+        if ((sx >= 0) && (sy >= 0) && (sx < this->camera.width) && (sy < this->camera.height)) {
+            cx.push_back(sx);
+            cy.push_back(sy);
+            cpeak.push_back(this->getPeakValue(star->mag));
+        }
+    } // the stars on the chip
+    for (i = 0; i < cx.size(); i++) {
+        if ((cx[i] < margin) || (cy[i] < margin) || (cx[i] > this->camera.width - margin) ||
+            (cy[i] > this->camera.height - margin) || (cpeak[i] < 60) || (cpeak[i] > 600) || (fabs(cpeak[i] - 180) > bestDiff)) {
+            continue;
+        }
+        isIsolated = true;
+        for (j = 0; j < cx.size(); j++) {
+            if ((j != i) && (cpeak[j] > 20) && (fabs(cx[j] - cx[i]) < 100) && (fabs(cy[j] - cy[i]) < 100)) {
+                isIsolated = false;
+                break;
+            }
+        }
+        if (isIsolated == true) {
+            bestDiff = fabs(cpeak[i] - 180);
+            *x = cx[i];
+            *y = cy[i];
+        }
+    }
+    return (bestDiff < 1e6);
+}
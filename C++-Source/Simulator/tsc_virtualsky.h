@@ -0,0 +1,76 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+// a synthetic sky for the guide camera of the simulator. stars are created from a seeded random
+// generator for every square degree of the sky, so the same field always shows the same stars.
+// frames are rendered with gaussian star images, seeing, background and noise as 8 bit grayscale
+// QImages and handed to g_AllData - the same way ccd_client delivers the images of the real camera.
+// the image motion from seeing is common to all stars unless a part of it is set to differ between
+// them, as it does over the field of a guide camera; a passing cloud can dim a part of the field.
+// all angles are given in decimal degrees.
+
+#ifndef TSC_VIRTUALSKY_H
+#define TSC_VIRTUALSKY_H
+
+#include <QImage>
+#include <QRect>
+#include <vector>
+
+class TSC_VirtualSky {
+public:
+    TSC_VirtualSky(unsigned int); // seed for the star field and the noise
+    ~TSC_VirtualSky(void);
+    void setCamera(int, int, double, double); // chip width and height in pixels, arcsec per pixel, rotation of the chip in degrees
+    void setSeeing(double, double); // FWHM of the star images and rms of the image motion, both in arcsec
+    void setDifferentialMotion(double); // fraction of the image motion that differs from star to star, 0 moves all stars together
+    void setClouds(double); // fraction of the chip covered by a band of cloud that drifts across it in 300 frames
+    void setSubframe(QRect); // only this part of the chip is read out, the rest of the image is black as in TSC_GuidePipeline; a null QRect is the full chip
+    void selectField(double, double); // collect the stars around a RA and declination
+    void renderFrame(double, double); // render the image for the telescope pointing at RA and declination and store it in g_AllData
+    void projectToChip(double, double, double, double, double*, double*); // star RA and decl, pointing RA and decl -> pixel x and y
+    bool findGuideStar(double*, double*); // brightest unsaturated star near the center of the last frame; pixel coordinates
+
+private:
+    struct starEntry {
+        double ra;
+        double decl;
+        float mag;
+    };
+    std::vector<starEntry> fieldStars;
+    struct cameraStruct {
+        int width;
+        int height;
+        double arcsecPerPix;
+        double rotation;
+        double fwhm;
+        double jitter;
+        double differentialMotion;
+        double cloudCover;
+        QRect subframe;
+    };
+    struct cameraStruct camera;
+    QVector<QRgb> grayTable;
+    unsigned int seed;
+    unsigned int noiseState;
+    double lastPointingRA;
+    double lastPointingDecl;
+    long frameCount;
+    double getTransparency(double); // at a position along x of the chip in the current frame
+    double getUniform(unsigned int*);
+    double getGaussian(unsigned int*);
+    void addStarsFromCell(int, int);
+    float getPeakValue(float);
+};
+
+#endif // TSC_VIRTUALSKY_H
@@ -29,8 +29,30 @@ SOURCES += \
     ccd_client.cpp \
     QtKineticStepper.cpp \
     QtContinuousStepper.cpp \
+    tsc_backlashtakeup.cpp \
     spi_drive.cpp \
-    usb_communications.cpp
+    usb_communications.cpp \
+    tsc_refraction.cpp \
+    ephemerisTable.cpp \
+    tsc_sequencer.cpp \
+    tsc_slewtimemodel.cpp \
+    tsc_horizonmask.cpp \
+    tsc_encoderfusion.cpp \
+    tsc_coordinatebatch.cpp \
+    tsc_drivetuner.cpp \
+    tsc_flightrecorder.cpp \
+    tsc_slewplanner.cpp \
+    tsc_mountcontrol.cpp \
+    tsc_driftcalibration.cpp \
+    tsc_centroid.cpp \
+    tsc_starensemble.cpp \
+    tsc_guidepipeline.cpp \
+    tsc_fitsdecoder.cpp \
+    tsc_framebufferpool.cpp \
+    tsc_fitsheader.cpp \
+    tsc_guidealgorithm.cpp \
+    tsc_guidelog.cpp \
+    tsc_starfinder.cpp
 
 HEADERS  += \
     mainwindow.h \
@@ -42,8 +64,30 @@ HEADERS  += \
     ccd_client.h \
     QtKineticStepper.h \
     QtContinuousStepper.h \
+    tsc_backlashtakeup.h \
     spi_drive.h \
-    usb_communications.h
+    usb_communications.h \
+    tsc_refraction.h \
+    ephemerisTable.h \
+    tsc_sequencer.h \
+    tsc_slewtimemodel.h \
+    tsc_horizonmask.h \
+    tsc_encoderfusion.h \
+    tsc_coordinatebatch.h \
+    tsc_drivetuner.h \
+    tsc_flightrecorder.h \
+    tsc_slewplanner.h \
+    tsc_mountcontrol.h \
+    tsc_driftcalibration.h \
+    tsc_centroid.h \
+    tsc_starensemble.h \
+    tsc_guidepipeline.h \
+    tsc_fitsdecoder.h \
+    tsc_framebufferpool.h \
+    tsc_fitsheader.h \
+    tsc_guidealgorithm.h \
+    tsc_guidelog.h \
+    tsc_starfinder.h
 
 # INCLUDEPATH += /home/pi
 # INCLUDEPATH += /home/pi/libindi/libs/
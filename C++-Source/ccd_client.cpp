@@ -35,31 +35,24 @@ extern TSC_GlobalData *g_AllData;
 
 //------------------------------------------
 ccd_client::ccd_client() {
-    QRgb cval;
 
-    this->storeCamImages = false;
     this->cameraHasGain = true;
     this->ccd = NULL;
-    this->fitsqimage = NULL;
-    this->scaledfitsdata = nullptr;
     this->displayPMap = new QPixmap();
     this->serverMessage= new QString();
     this->ccdINDIName = new QString("QHY CCD QHY5-0-M-");
-    this->myVec =new QVector<QRgb>(256);
-    for(int i=0;i<256;i++) {
-        cval = qRgb(i,i,i);
-        this->myVec->insert(i, cval);
-    }
-    // setting colortable for grayscale QImages
-    this->expcounter=1;
-    this->simulatorCounter=10; // a helper for debugging
+    this->lastFrameHasStar = false;
+    this->subframeAvailable = true;
+    this->framePipeline = new TSC_GuidePipeline();
+    connect(this->framePipeline, SIGNAL(frameAvailable()), this, SLOT(takeFrameFromPipeline()), Qt::QueuedConnection); // the frames are decoded and measured on threads of the pipeline
+    this->framePipeline->start();
 }
 
 //------------------------------------------
 ccd_client::~ccd_client() {
-    delete fitsqimage;
+    this->framePipeline->stop();
+    delete framePipeline;
     delete displayPMap;
-    delete myVec;
     delete serverMessage;
     delete ccdINDIName;
 }
@@ -101,6 +94,9 @@ void ccd_client::disconnectFromServer(void) {
     this->ccd = NULL;
     this->disconnectServer();
     this->cameraHasGain = true;
+    this->subframeAvailable = true;
+    this->requestedSubframe = QRect();
+    this->activeSubframe = QRect();
 }
 
 //------------------------------------------
@@ -127,11 +123,63 @@ void ccd_client::takeExposure(int expTime) {
         }
         delete localTimer;
         if ((fexpt > 0.001) && (fexpt < 3600)) {
+            this->sendSubframe(); // the region to be read out is set before the exposure starts
             sendNewNumber(ccd_exposure);
         }
     }
 }
 
+//------------------------------------------
+// the guider only needs the region around the guide stars. a subframe is read out and transferred much
+// faster than the full chip; the pipeline puts it back to its place on the chip, so that the positions
+// of the stars do not change
+void ccd_client::setSubframe(QRect subframe) {
+    this->requestedSubframe = subframe;
+}
+
+//------------------------------------------
+QRect ccd_client::getSubframe(void) {
+    return this->requestedSubframe;
+}
+
+//------------------------------------------
+// sends the requested subframe to the camera if it has changed. if the camera does not know about
+// subframes, the full chip is used from now on
+void ccd_client::sendSubframe(void) {
+    QRect subframe;
+
+    subframe = this->requestedSubframe;
+    if (this->subframeAvailable == false) {
+        subframe = QRect();
+    }
+    if (subframe != this->activeSubframe) {
+        ccd_frame = ccd->getNumber("CCD_FRAME");
+        if ((ccd_frame == NULL) || (IUFindNumber(ccd_frame,"X") == NULL) || (IUFindNumber(ccd_frame,"Y") == NULL) ||
+            (IUFindNumber(ccd_frame,"WIDTH") == NULL) || (IUFindNumber(ccd_frame,"HEIGHT") == NULL)) {
+            qDebug() << "Camera cannot read out a subframe ...";
+            this->subframeAvailable = false;
+            subframe = QRect();
+        } else {
+            if (subframe.isNull() == true) {
+                IUFindNumber(ccd_frame,"X")->value = 0;
+                IUFindNumber(ccd_frame,"Y")->value = 0;
+                IUFindNumber(ccd_frame,"WIDTH")->value = this->frameSizeX;
+                IUFindNumber(ccd_frame,"HEIGHT")->value = this->frameSizeY;
+            } else {
+                IUFindNumber(ccd_frame,"X")->value = subframe.x();
+                IUFindNumber(ccd_frame,"Y")->value = subframe.y();
+                IUFindNumber(ccd_frame,"WIDTH")->value = subframe.width();
+                IUFindNumber(ccd_frame,"HEIGHT")->value = subframe.height();
+            }
+            sendNewNumber(ccd_frame);
+            this->activeSubframe = subframe;
+        }
+    }
+    this->subframeMutex.lock();
+    this->exposureSubframe = this->activeSubframe;
+    this->subframeMutex.unlock();
+}
+
 //------------------------------------------
 void ccd_client::sendGain(int gain) {
     float fgain;
@@ -204,7 +252,6 @@ void ccd_client::newMessage(INDI::BaseDevice *dp, int messageID) {
 bool ccd_client::getCCDParameters(bool isMainCCD) {
     INumberVectorProperty *ccd_params;
     QElapsedTimer *localTimer;
-    long imgsize;
 
     if (this->probeForCCD() == false) {
         qDebug() << "CCD not available...";
@@ -230,10 +277,6 @@ bool ccd_client::getCCDParameters(bool isMainCCD) {
     g_AllData->setCameraBitDepth((int)this->bitsPerPixel,isMainCCD);
     qDebug() << "Information retrieved: " << this->pixSizeX << "/" <<
         this->pixSizeY << "/" << this->frameSizeX << "/" << this->frameSizeY << "/" << this->bitsPerPixel;
-    imgsize=(this->frameSizeX*this->frameSizeY);
-    if (scaledfitsdata == nullptr) {
-        scaledfitsdata = new char [imgsize];
-    }
     if (isMainCCD == false) { // this stuff is only done for teh guide camera
         // now probe for gain
         this->sendGain(100);
@@ -257,18 +300,11 @@ bool ccd_client::getCCDParameters(bool isMainCCD) {
 }
 
 //------------------------------------------
-// receive a FITS file from the server.
-    // header is 2880, image is 1280x1024
+// receive a FITS file from the server. this is called by the thread of the INDI client; the data are
+// handed to the pipeline and the camera is free for the next exposure
 void ccd_client::newBLOB(IBLOB *bp) {
-    char *fitsdata = nullptr;
-    uint16_t *_16bitdata = nullptr;
-    uint16_t _16BitPixValA,_16BitPixValB, _16BitPixVal;
-    uint16_t histogram[66000];
-    long indFITS, indRAWFITS,lowerHInt, upperHInt, uCount, hCount, imax, imin;
-    QImage *smallQImage;
-    int imgwidth, imgheight,widgetWidth,widgetHeight;
-    float sfw,sfh, percentageClipped;
-    QString *efilename;
+    int imgwidth, imgheight;
+    QRect subframe;
 
     if (this->isAProbeImage == true) {
  //       this->saveBLOB(bp);
@@ -279,108 +315,53 @@ void ccd_client::newBLOB(IBLOB *bp) {
     imgwidth = g_AllData->getCameraChipPixels(0,false);
     imgheight = g_AllData->getCameraChipPixels(1,false);
     //retrieving the number of pixels on the chip
-
-    fitsdata = (static_cast<char *>(bp->blob));
-    fitsdata=fitsdata+2880;
-    // skipping the header which is 2880 bytes for the fits from the server
-
-    if (this->bitsPerPixel == 16) {
-        _16bitdata = new uint16_t [bp->bloblen-2880];
-        if (_16bitdata == nullptr) {
-            qDebug() << "couldn't allocate memory for 16 bit image";
-        }
-        indRAWFITS = 0;
-        for (indFITS = 0; indFITS < ((imgwidth*imgheight-2880)); indFITS++) {
-            _16BitPixValA = *fitsdata;;
-            fitsdata++;
-            _16BitPixValB = *fitsdata;
-            fitsdata++;
-            _16BitPixVal = _16BitPixValA*256+_16BitPixValB;
-            _16bitdata[indRAWFITS] = _16BitPixVal-32768;
-            indRAWFITS++;
-        }
-        for (indFITS = 0; indFITS < (imgwidth*imgheight); indFITS++) {
-            histogram[_16bitdata[indFITS]] +=1;
-        }
-        percentageClipped = imgwidth*imgheight/50.0; // the number of pixels to be clipped in the histogram
-        uCount = hCount = lowerHInt = upperHInt = 0;
-        do {
-            lowerHInt +=histogram[uCount];
-            uCount++;
-        } while (lowerHInt < percentageClipped);
-        uCount--;
-        hCount = 0;
-        do {
-            upperHInt += histogram[65535-hCount];
-            hCount++;
-        } while (upperHInt < percentageClipped);
-        hCount--;
-        imin=uCount;
-        imax=65535-hCount;
-        for (indFITS = 0; indFITS < (imgwidth*imgheight); indFITS++) {
-            if (_16bitdata[indFITS] < imin) {
-                _16bitdata[indFITS] = imin;
-            }
-            if (_16bitdata[indFITS] > imax) {
-                _16bitdata[indFITS] = imax;
-            }
-        } // so this is a stretch to 96% of the histogram content
-
-        for (indFITS = 0; indFITS < (imgwidth*imgheight); indFITS++) {
-            scaledfitsdata[indFITS] = ((char)(floor((_16bitdata[indFITS]-imin)/((float)(imax-imin))*250)));
-        }
-        delete _16bitdata;
+    this->subframeMutex.lock();
+    subframe = this->exposureSubframe;
+    this->subframeMutex.unlock();
+    if (subframe.isNull() == true) {
+        subframe = QRect(0, 0, imgwidth, imgheight);
+    } // the pipeline compares the size in the FITS header with the subframe
+    if (this->framePipeline->submitFrame(static_cast<char *>(bp->blob), bp->bloblen, imgwidth, imgheight, subframe) == true) {
+        emit this->imageReceived();
     }
-    // casting the INDI-BLOB containing the image data in FITS to an array of uints ...
-    if (this->bitsPerPixel == 8) {
-        fitsqimage = new QImage((uchar*)fitsdata, imgwidth, imgheight, QImage::Format_Indexed8);
-    } else {
-        fitsqimage = new QImage((uchar*)scaledfitsdata, imgwidth, imgheight, QImage::Format_Indexed8);
-    }
-    fitsqimage->setColorTable(*myVec);
-    g_AllData->storeCameraImage(*fitsqimage);
-    QCoreApplication::processEvents(QEventLoop::AllEvents,250);
-    // read the image data into a QImage, set a grayscale LUT, and mirror the image ...
-    if (this->storeCamImages==true) {
-        efilename=new QString("GuideCameraImage");
-        efilename->append(QString::number((double)expcounter,1,0));
-        efilename->append(".jpg");
-        fitsqimage->save(efilename->toLatin1(),0,-1);
-        this->expcounter++;
-        delete efilename;
+}
+
+//------------------------------------------
+// the pipeline has decoded an image, measured the guide star and scaled the image for the camera view;
+// if several frames are waiting, only the latest one is taken
+void ccd_client::takeFrameFromPipeline(void) {
+    struct TSC_GuidePipeline::guideFrameStruct frame;
+    bool frameTaken = false;
+
+    while (this->framePipeline->getFrame(&frame) == true) {
+        frameTaken = true;
     }
-    widgetWidth=g_AllData->getCameraDisplaySize(0,false);
-    widgetHeight=g_AllData->getCameraDisplaySize(1,false);
-    sfw = widgetWidth/(float)imgwidth;
-    sfh = widgetHeight/(float)imgheight;
-    if (sfw < sfh) {
-        g_AllData->setCameraImageScalingFactor(sfw,false);
-    } else {
-        g_AllData->setCameraImageScalingFactor(sfh,false);
+    if (frameTaken == false) {
+        return;
     }
-    // get the scaling factor for scaling the QImage to the QPixmap
-
-    //-----------------------------------------------------------------
-     // guide debugging code --- load a camera image for debugging here ...
-  /*   efilename=new QString("GuideSimulatorImages/TestCameraImage");
-     efilename->append(QString::number((double)simulatorCounter,1,0));
-     efilename->append(".jpg");
-     this->simulatorCounter++;
-     if (this->simulatorCounter > 40) {
-         this->simulatorCounter=10;
-     }
-     fitsqimage = new QImage(efilename->toLatin1());
-     delete efilename;
-     g_AllData->storeCameraImage(*fitsqimage);
+    g_AllData->storeCameraImage(frame.image);
+    g_AllData->setCameraImageScalingFactor(frame.scalingFactor,false);
+    this->framePipeline->setDisplaySize(g_AllData->getCameraDisplaySize(0,false),g_AllData->getCameraDisplaySize(1,false));
+    this->lastFrameHasStar = frame.starMeasured;
+    this->lastMeasurement = frame.measurement;
+    this->displayPMap->convertFromImage(frame.displayImage,0);
+    emit this->imageAvailable(displayPMap);
+}
 
-*/
-     //-----------------------------------------------------------------
+//------------------------------------------
+// the guide star as measured by the pipeline in the image that was delivered last; false if the pipeline
+// did not search for it
+bool ccd_client::getGuideStarMeasurement(struct ocv_guiding::guideStarMeasurementStruct *measurement) {
+    if (this->lastFrameHasStar == false) {
+        return false;
+    }
+    *measurement = this->lastMeasurement;
+    return true;
+}
 
-    smallQImage = new QImage(fitsqimage->scaled(widgetWidth,widgetHeight,Qt::KeepAspectRatio,Qt::FastTransformation));
-    this->displayPMap->convertFromImage(*smallQImage,0);
-    delete smallQImage;
-    emit this->imageAvailable(displayPMap);
-    QCoreApplication::processEvents(QEventLoop::AllEvents,250);
+//------------------------------------------
+TSC_GuidePipeline* ccd_client::getFramePipeline(void) {
+    return this->framePipeline;
 }
 
 //------------------------------------------
@@ -392,7 +373,7 @@ void ccd_client::sayGoodbyeToINDIServer(void) {
 //------------------------------------------
 
 void ccd_client::setStoreImageFlag(bool what) {
-    this->storeCamImages=what;
+    this->framePipeline->setStoreImages(what);
 }
 
 //------------------------------------------
@@ -22,10 +22,13 @@
 #include <QPixmap>
 #include <QVector>
 #include <QObject>
+#include <QRect>
+#include <QMutex>
 #include <QCoreApplication>
 #include <opencv2/core/core.hpp>
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
+#include "tsc_guidepipeline.h"
 
 using namespace cv;
 
@@ -45,6 +48,10 @@ class ccd_client:public QObject, public INDI::BaseClient {
     void disconnectFromServer(void);
     bool probeForCCD(void);
     bool cameraGainAvailable(void);
+    TSC_GuidePipeline* getFramePipeline(void);
+    bool getGuideStarMeasurement(struct ocv_guiding::guideStarMeasurementStruct*); // the guide star in the last image, if the pipeline searched for it
+    void setSubframe(QRect); // the part of the chip read out from the next exposure on; a null QRect is the full chip
+    QRect getSubframe(void);
 
 protected:
     virtual void newDevice(INDI::BaseDevice *dp);
@@ -69,21 +76,28 @@ private:
    double frameSizeY; // number of pixles in y-direction
    double bitsPerPixel; // depth of the camera
    bool cameraHasGain; // some cameras can set gain, some cannot ...
-   QImage* fitsqimage; // a qimage, generated form raw FITS data
-   char *scaledfitsdata; // in case of 16 bit data, this one holds the scaled 8 bit image
+   TSC_GuidePipeline *framePipeline; // decodes the FITS data and measures the guide star on threads of its own
    QPixmap* displayPMap; // a qpixmap, generated for GUI display form the qimage
-   bool newCameraImageAvailable; // name says it all
-   QVector<QRgb> *myVec; // a vector for grayscale conversion
+   bool lastFrameHasStar; // the pipeline has measured the guide star in the last image
+   struct ocv_guiding::guideStarMeasurementStruct lastMeasurement;
    QString *serverMessage; // a string for holding data non-image data from the INDI server
    INumberVectorProperty *ccd_exposure = NULL; // an INDI data structure on exposure time
    INumberVectorProperty *ccd_gain = NULL; // an INDI data structure on camera gain
-   long expcounter; // a counter for exposures
-   bool storeCamImages; // a boolean for handling storage of images to the SD card
-   short simulatorCounter; // a helper for debugging
+   INumberVectorProperty *ccd_frame = NULL; // an INDI data structure on the subframe
+   QRect requestedSubframe; // as set by "setSubframe"
+   QRect activeSubframe; // as sent to the camera
+   QRect exposureSubframe; // of the exposure that is running; read by the INDI thread in "newBLOB"
+   QMutex subframeMutex;
+   bool subframeAvailable; // false if the camera has no CCD_FRAME property
+   void sendSubframe(void);
    bool isAProbeImage; // a flag that causes storage rather than further processing of image data
    void saveBLOB(IBLOB*); // saves a BLOB to a FITS image
 
+private slots:
+   void takeFrameFromPipeline(void); // stores the image that has passed the pipeline and hands it to the GUI
+
 signals:
+   void imageReceived(void); // emitted by the INDI thread when the data of an exposure have arrived
    void imageAvailable(QPixmap*); // emitted when an image is available
    void messageFromINDIAvailable(void); // emitted when a message form INDI is available
 };
@@ -0,0 +1,191 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+#include "ephemerisTable.h"
+#include <QDebug>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <iostream>
+
+//-------------------------------------------------
+// reading a .csv file with the special format
+// number of datasets
+// object name
+// JulianDate[UT],RA[deg],Decl[deg]
+// the dates have to be in ascending order; the positions are apparent positions for the equinox of date
+ephemerisTable::ephemerisTable(QString filename) {
+    double jd, radec, decldec;
+    long counter;
+    char delimiter(',');    // data are .csv - comma-separated
+    QByteArray ba = filename.toLatin1();    //convert QString to QByteArray
+    const char *cfilename = ba.data();      // convert this to a C-string
+
+    this->numberOfEntries = 0;
+    std::ifstream infile(cfilename);        // open a file to read
+    std::string line;
+    std::getline(infile, line);     // the number of positions
+    std::istringstream iss(line);
+    iss >> this->numberOfEntries;
+    std::getline(infile, this->objectName);     // the name of the object
+    for (counter = 0; counter < this->numberOfEntries; counter++) {
+        std::getline(infile, line, delimiter);  // julian date
+        std::istringstream issjd(line);
+        std::getline(infile, line, delimiter);  // right ascension
+        std::istringstream issra(line);
+        std::getline(infile, line);             // declination
+        std::istringstream issdecl(line);
+        if (!(issjd >> jd) || !(issra >> radec) || !(issdecl >> decldec)) {
+            qDebug() << "Ephemeris ends prematurely at entry" << counter;
+            break;
+        }
+        if ((counter > 0) && (jd <= ephemerisEntries[counter-1].jd)) {
+            qDebug() << "Ephemeris dates are not ascending at entry" << counter;
+            break;
+        }
+        ephemerisEntries.push_back(ephemerisEntry());
+        ephemerisEntries[counter].jd=jd;
+        ephemerisEntries[counter].oRADec=radec;
+        ephemerisEntries[counter].oDeclDec=decldec;
+    }
+    this->numberOfEntries = (long)ephemerisEntries.size();
+    infile.close(); // close the file
+}
+
+//-------------------------------------------------
+ephemerisTable::~ephemerisTable() {
+    this->ephemerisEntries.clear();
+}
+
+//-------------------------------------------------
+long ephemerisTable::getNumberOfEntries(void) {
+    return this->numberOfEntries;
+}
+
+//-------------------------------------------------
+std::string ephemerisTable::getNameOfObject(void) {
+    return this->objectName;
+}
+
+//-------------------------------------------------
+bool ephemerisTable::isValid(void) {
+    return (this->numberOfEntries > 1);
+}
+
+//-------------------------------------------------
+// four-point lagrange interpolation between the neighbouring entries, J. Meeus, 2. ed, p.32; for tables
+// with only two or three entries, the polynomial has a lower order. RA is unwrapped at 0/360 degrees
+bool ephemerisTable::getPosition(double jd, double *ra, double *decl) {
+    long idx, first, last, i, j;
+    double raVals[4], weight, lra = 0, ldecl = 0;
+
+    if (this->isValid() == false) {
+        return false;
+    }
+    idx = this->findInterval(jd);
+    if (idx < 0) {
+        return false;
+    }
+    first = idx - 1;
+    last = idx + 2;
+    if (first < 0) {
+        first = 0;
+    }
+    if (last > this->numberOfEntries-1) {
+        last = this->numberOfEntries-1;
+    }
+    for (i = first; i <= last; i++) {
+        raVals[i-first] = ephemerisEntries[i].oRADec;
+        if ((raVals[i-first] - ephemerisEntries[idx].oRADec) > 180) {
+            raVals[i-first] -= 360;
+        }
+        if ((raVals[i-first] - ephemerisEntries[idx].oRADec) < -180) {
+            raVals[i-first] += 360;
+        }
+    }
+    for (i = first; i <= last; i++) {
+        weight = 1.0;
+        for (j = first; j <= last; j++) {
+            if (j != i) {
+                weight *= (jd - ephemerisEntries[j].jd)/(ephemerisEntries[i].jd - ephemerisEntries[j].jd);
+            }
+        }
+        lra += weight*raVals[i-first];
+        ldecl += weight*ephemerisEntries[i].oDeclDec;
+    }
+    while (lra < 0) {
+        lra += 360;
+    }
+    while (lra >= 360) {
+        lra -= 360;
+    }
+    *ra = lra;
+    *decl = ldecl;
+    return true;
+}
+
+//-------------------------------------------------
+// rates are derived from the interpolated positions ten seconds before and after the given date
+bool ephemerisTable::getRates(double jd, double *raRate, double *declRate) {
+    const double deltaT = 10.0; // half the interval for the central difference in seconds
+    double jdBefore, jdAfter, raBefore, declBefore, raAfter, declAfter, deltaRA;
+
+    jdBefore = jd - deltaT/86400.0;
+    jdAfter = jd + deltaT/86400.0;
+    if ((this->isValid() == false) || (jd < ephemerisEntries[0].jd) ||
+            (jd > ephemerisEntries[this->numberOfEntries-1].jd)) {
+        return false;
+    }
+    if (jdBefore < ephemerisEntries[0].jd) {
+        jdBefore = ephemerisEntries[0].jd;
+    }
+    if (jdAfter > ephemerisEntries[this->numberOfEntries-1].jd) {
+        jdAfter = ephemerisEntries[this->numberOfEntries-1].jd;
+    } // at the ends of the table, the difference is one-sided
+    this->getPosition(jdBefore, &raBefore, &declBefore);
+    this->getPosition(jdAfter, &raAfter, &declAfter);
+    deltaRA = raAfter - raBefore;
+    if (deltaRA > 180) {
+        deltaRA -= 360;
+    }
+    if (deltaRA < -180) {
+        deltaRA += 360;
+    }
+    *raRate = deltaRA/((jdAfter - jdBefore)*86400.0);
+    *declRate = (declAfter - declBefore)/((jdAfter - jdBefore)*86400.0);
+    return true;
+}
+
+//-------------------------------------------------
+// bisection for the entry that precedes the given date; returns -1 if the date is outside the table
+long ephemerisTable::findInterval(double jd) {
+    long lower, upper, middle;
+
+    if ((jd < ephemerisEntries[0].jd) || (jd > ephemerisEntries[this->numberOfEntries-1].jd)) {
+        return -1;
+    }
+    lower = 0;
+    upper = this->numberOfEntries-1;
+    while ((upper - lower) > 1) {
+        middle = (lower + upper)/2;
+        if (ephemerisEntries[middle].jd <= jd) {
+            lower = middle;
+        } else {
+            upper = middle;
+        }
+    }
+    return lower;
+}
+
+//--------------------------------------------------
@@ -0,0 +1,47 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+// a class for ephemerides of moving objects such as comets, asteroids or satellites. the table holds
+// positions over time; position and rates for any moment within the table are interpolated
+
+#ifndef EPHEMERISTABLE_H
+#define EPHEMERISTABLE_H
+
+#include <stdio.h>
+#include <QString>
+#include <vector>
+
+class ephemerisTable {
+public:
+    ephemerisTable(QString);
+    ~ephemerisTable(void);
+    long getNumberOfEntries(void);
+    std::string getNameOfObject(void);
+    bool isValid(void); // false if the file could not be read or has less than two entries
+    bool getPosition(double, double*, double*); // julian date -> RA and decl in degrees; false if the date is not covered
+    bool getRates(double, double*, double*); // julian date -> change of RA and decl in degrees/s
+
+private:
+    long numberOfEntries; // the number of positions in the table
+    std::string objectName; // the name of the object
+    struct ephemerisEntry {
+        double jd;
+        double oRADec;
+        double oDeclDec;
+    };
+    std::vector<ephemerisEntry> ephemerisEntries;
+    long findInterval(double);
+};
+
+#endif // EPHEMERISTABLE_H
@@ -38,6 +38,7 @@ lx200_communication::lx200_communication(void) {
     this->llat = 48;
     receivedRAFromLX = 0.0;
     receivedDeclFromLX = 0.0;
+    this->horizonMask = NULL;
     gotRACoordinates = false;
     gotDeclCoordinates = false;
     sendSimpleCoordinates=false; // determine the reponse format as ddd:mm or ddd:mm:ss
@@ -244,10 +245,19 @@ bool lx200_communication::handleBasicLX200Protocol(QString cmd) {
                 delete waitTimer; // just wait for 25 ms ...
                 this->gotDeclCoordinates=false;
                 this->gotRACoordinates=false;
-                assembledString->append("0");
-                this->sendCommand(2);
-                emit RS232slew();
-                QCoreApplication::processEvents(QEventLoop::AllEvents,25);
+                if (this->horizonMask != NULL) {
+                    this->horizonMask->setLatitude(g_AllData->getSiteCoords(0));
+                }
+                if ((this->horizonMask != NULL) &&
+                    (this->horizonMask->isReachable(g_AllData->getLocalSTime()*15.0 - this->receivedRAFromLX, this->receivedDeclFromLX) == false)) {
+                    assembledString->append("1Object below horizon#");
+                    this->sendCommand(2);
+                } else {
+                    assembledString->append("0");
+                    this->sendCommand(2);
+                    emit RS232slew();
+                    QCoreApplication::processEvents(QEventLoop::AllEvents,25);
+                } // the reply of the LX200 for a target below the horizon; the mount does not move
 
             }
         }
@@ -706,6 +716,12 @@ void lx200_communication::setNumberFormat(bool isSimple) {
 
 //----------------------------------------------------
 
+void lx200_communication::setHorizonMask(TSC_HorizonMask *mask) {
+    this->horizonMask = mask;
+}
+
+//----------------------------------------------------
+
 void lx200_communication::setSystemDateAndTime(void) {
     QString *systemCmd, *helper;
     time_t rawtime;
@@ -25,6 +25,7 @@
 #include <QtNetwork/QTcpServer>
 #include <QtNetwork/QTcpSocket>
 #include <QtNetwork/QHostAddress>
+#include "tsc_horizonmask.h"
 
 class lx200_communication:public QObject {
     Q_OBJECT
@@ -39,6 +40,7 @@ public:
     QString* getLX200ResponseDecl(void);
     void clearReplyString(void);
     void setNumberFormat(bool);
+    void setHorizonMask(TSC_HorizonMask*); // a GoTo that the mask rejects is answered with "below horizon"; it is not owned
 
 private:
     QString *replyStrLX;
@@ -52,6 +54,7 @@ private:
     QString *dateString;
     double receivedRAFromLX;
     double receivedDeclFromLX;
+    TSC_HorizonMask *horizonMask;
     double llong;
     double llat;
     int lutc;
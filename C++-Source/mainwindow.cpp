@@ -92,6 +92,61 @@ MainWindow::MainWindow(QWidget *parent):QMainWindow(parent), ui(new Ui::MainWind
     this->tcpHandBoxSendTimer->start(2000);
     this->checkDriveTimer = new QTimer();
     this->checkDriveTimer->start(5000);
+    this->trackingRateTimer = new QTimer();
+    this->trackingRateTimer->start(2000);
+    this->sequencerTimer = new QTimer(); // started when a sequence of targets is carried out
+    this->refraction = new TSC_Refraction(); // the model for correcting GoTo and tracking for atmospheric refraction
+    this->temperature = 10.0; // until the sensor on the HAT was read
+    this->refraction->setAtmosphericConditions(this->temperature, g_AllData->getAtmosphericPressure());
+    this->sequencer = new TSC_Sequencer(); // the list of targets for an unattended session
+    this->horizonMask = new TSC_HorizonMask(); // GoTos and catalog objects are checked against the horizon and the mount limits
+    this->catalogPositions = new TSC_CoordinateBatch();
+    this->horizonTimer = new QTimer();
+    this->horizonTimer->start(60000);
+    this->slewTimeModel = new TSC_SlewTimeModel(); // predicts the duration of GoTos from the slews measured so far
+    this->sequencer->setSlewTimeModel(this->slewTimeModel); // the sequencer sorts its targets with the same ETA
+    this->slewPlanner = new TSC_SlewPlanner();
+    for (short axis = 0; axis < 2; axis++) {
+        this->slewTimeModel->setParameters(axis, g_AllData->getSlewTimeModel(axis,0), g_AllData->getSlewTimeModel(axis,1),
+                                           g_AllData->getSlewTimeModel(axis,2), g_AllData->getSlewTimeModel(axis,3));
+    }
+    this->encoderFusion = new TSC_EncoderFusion(); // only used if the position is taken from encoders on the axes
+    this->encoderState.isReading = false;
+    this->applyEncoderSettings();
+    this->encoderTimer = new QTimer();
+    this->encoderTimer->start(1000);
+    this->sequencerState.step = sqIdle;
+    this->sequencerState.currentTarget = 0;
+    this->sequencerState.verificationAttempts = 0;
+    this->sequencerState.isBusy = false;
+    this->mflipTimer = new QTimer(); // checks when the mount reaches the meridian and the flip limit
+    this->mflipTimer->start(1000);
+    this->mflipState.step = mfIdle;
+    this->parkState.step = pkIdle;
+    this->parkState.learnsHome = false;
+    this->parkState.isBusy = false;
+    this->parkState.homingPhase = 0;
+    this->parkState.homingDirection = 1;
+    this->parkState.homingSpeed = 1;
+    this->parkState.waitsForRest = false;
+    this->parkTimer = new QTimer(); // watches the park state and the home switches
+    this->parkTimer->start(250);
+    this->autoTuneState.step = tnIdle;
+    this->autoTuneState.isBusy = false;
+    this->autoTuneTimer = new QTimer(); // runs the test slews of the auto-tuning
+    this->autoTuneTimer->start(250);
+    this->driveTuner = new TSC_DriveTuner();
+    this->driftCalState.step = dcIdle;
+    this->driftCalState.isBusy = false;
+    this->driftCalTimer = new QTimer(); // waits for the plate solutions of the tracking calibration
+    this->driftCalTimer->start(1000);
+    this->driftCalibration = new TSC_DriftCalibration();
+    this->driftCalibration->setModel(g_AllData->getTrackingCalibration(0), g_AllData->getTrackingCalibration(1),
+                                     g_AllData->getTrackingCalibration(2));
+    this->mflipState.seriesOnHold = false;
+    this->mflipState.guidingWasOn = false;
+    this->mflipState.mountWasFlipped = false;
+    this->mflipState.isBusy = false;
     this->UTDate = new QDate(QDate::currentDate());
     this->julianDay = this->UTDate->toJulianDay();
     this->UTTime = new QTime(QTime::currentTime());
@@ -100,10 +155,12 @@ MainWindow::MainWindow(QWidget *parent):QMainWindow(parent), ui(new Ui::MainWind
     currentYear = new QString(this->UTDate->currentDate().toString("yyyy"));
     ui->sbEpoch->setValue(currentYear->toInt());
     delete currentYear;
-    this->wcsInfoOutput = new QString();
 
     this->initiateStepperDrivers(); // initialise the driver boards
     qDebug() << "Steppers initialized";
+    this->flightRecorder = new TSC_FlightRecorder(); // 2^19 records of 64 bytes hold 14 hours at 10 records per second
+    this->flightRecorder->open(".TSCFlightRecorder.tfr", 524288);
+    this->flightRecorderCountElapsed.start();
 
         // set a bunch of flags and factors
     this->mountMotion.RATrackingIsOn=false;   // sidereal tracking is on if true
@@ -127,6 +184,7 @@ MainWindow::MainWindow(QWidget *parent):QMainWindow(parent), ui(new Ui::MainWind
     this->guidingState.guidingIsOn=false;
 
     g_AllData->setGuidingState(this->guidingState.guidingIsOn); // this has to be known in other classes, so every "guidingIsOn" state is copied
+    this->recordFlightData(TSC_FlightRecorder::frSessionStart, 0, 0);
     this->guidingState.calibrationIsRunning=false;
     this->guidingState.systemIsCalibrated=false;
     this->guidingState.calibrationImageReceived=false;
@@ -137,11 +195,9 @@ MainWindow::MainWindow(QWidget *parent):QMainWindow(parent), ui(new Ui::MainWind
     this->guidingState.maxDevInArcSec=0.0;
     this->guidingState.rmsDevInArcSec=0.0;
     this->guidingState.rmsDevInArcSecSum = 0.0;
-    this->guidingState.backlashCompensationInMS = 0.0;
     this->guidingState.noOfGuidingSteps = 0;
     this->guidingState.st4IsActive = false;
-    this->guidingState.raErrs[0] = this->guidingState.raErrs[1] = this->guidingState.raErrs[2] = 0;
-    this->guidingState.declErrs[0] = this->guidingState.declErrs[1] = this->guidingState.declErrs[2] = 0;
+    this->guidingState.correctionIsRunning = false;
     this->pulseGuideDuration = 500;
     this->dslrStates.dslrExposureIsRunning = false;
     this->dslrStates.dslrSeriesRunning = false;
@@ -225,6 +281,19 @@ MainWindow::MainWindow(QWidget *parent):QMainWindow(parent), ui(new Ui::MainWind
     ui->sbUTCOffs->setValue(g_AllData->getSiteCoords(2));
     ui->lcdHAPark->display(g_AllData->getParkingPosition(0));
     ui->lcdDecPark->display(g_AllData->getParkingPosition(1));
+    ui->sbMinAltitude->setValue(g_AllData->getMountLimits(0));
+    ui->sbHALimitEast->setValue(g_AllData->getMountLimits(1));
+    ui->sbHALimitWest->setValue(g_AllData->getMountLimits(2));
+    ui->cbHideUnreachable->setChecked(g_AllData->getHideUnreachableObjects());
+    ui->sbBacklashRA->setValue(g_AllData->getBacklash(0));
+    ui->sbBacklashDecl->setValue(g_AllData->getBacklash(1));
+    ui->cbDeclBacklashComp->setChecked(g_AllData->getBacklashCompensation());
+    ui->cbPositionSource->setCurrentIndex(g_AllData->getPositionSource());
+    ui->sbEncoderCountsRA->setValue(g_AllData->getEncoderParams(0,0));
+    ui->sbEncoderCountsDecl->setValue(g_AllData->getEncoderParams(1,0));
+    ui->cbInvertEncoderRA->setChecked(g_AllData->getEncoderParams(0,1) < 0);
+    ui->cbInvertEncoderDecl->setChecked(g_AllData->getEncoderParams(1,1) < 0);
+    ui->sbSlipThreshold->setValue(g_AllData->getEncoderSlipThreshold());
     const QFileInfo outputDir((g_AllData->getPathToImages()).toLatin1()) ;
     if (outputDir.exists() && outputDir.isDir() && outputDir.isReadable() && outputDir.isWritable()) {
         ui->lePathToFitsFile->setText(g_AllData->getPathToImages());
@@ -240,6 +309,12 @@ MainWindow::MainWindow(QWidget *parent):QMainWindow(parent), ui(new Ui::MainWind
         ui->cbMountIsEast->setEnabled(true);
     }
     ui->cbTimeFromLX200->setChecked(g_AllData->getTimeFromLX200Flag());
+    ui->cbRefraction->setChecked(g_AllData->getRefractionCorrection());
+    ui->sbPressure->setValue((int)round(g_AllData->getAtmosphericPressure()));
+    ui->cbDriftCorrection->setChecked(g_AllData->getTrackingCalibrationCorrection());
+    this->showDriftCalibration();
+    ui->cbAutoMFlip->setChecked(g_AllData->getAutoMFlip());
+    ui->sbMFlipLimit->setValue(g_AllData->getMFlipLimit());
     msRat = g_AllData->getMicroSteppingRatio(0);
     switch (msRat) {
         case 4: ui->rbNormal_4_AMIS->setChecked(true); break;
@@ -280,21 +355,38 @@ MainWindow::MainWindow(QWidget *parent):QMainWindow(parent), ui(new Ui::MainWind
     this->guidingFOVFactor=1.0; // location of the crosshair and size of the preview window are set
     ui->sbFLGuideScope->setValue(g_AllData->getGuideScopeFocalLength()); // get stored focal length for the guidescope
     this->guiding->setFocalLengthOfGuidescope(g_AllData->getGuideScopeFocalLength());
-    this->guidingLog=NULL;
+    ui->cbCentroidMethod->setCurrentIndex(g_AllData->getCentroidEstimator());
+    this->guiding->setCentroidEstimator(g_AllData->getCentroidEstimator()); // the estimator for the centroid of the guide star
+    this->camera_client->getFramePipeline()->setCentroidEstimator(g_AllData->getCentroidEstimator()); // the same in the pipeline of the camera class
+    ui->sbGuideStars->setValue(g_AllData->getNumberOfGuideStars());
+    ui->cbGuideAlgorithmRA->setCurrentIndex(g_AllData->getGuideAlgorithm(0));
+    ui->cbGuideAlgorithmDecl->setCurrentIndex(g_AllData->getGuideAlgorithm(1));
+    this->guideAlgorithm[0] = new TSC_GuideAlgorithm();
+    this->guideAlgorithm[0]->setMethod(g_AllData->getGuideAlgorithm(0));
+    this->guideAlgorithm[1] = new TSC_GuideAlgorithm();
+    this->guideAlgorithm[1]->setMethod(g_AllData->getGuideAlgorithm(1));
+    this->mountControl = new TSC_MountControl(this->StepperDriveRA, this->StepperDriveDecl, this->slewPlanner, this->slewTimeModel);
+    this->mountControl->setHorizonMask(this->horizonMask);
+    this->mountControl->setGuideAlgorithms(this->guideAlgorithm[0], this->guideAlgorithm[1]);
+    this->guidingLog = new TSC_GuideLog();
         // now read all catalog files, ending in "*.tsc"
     catalogDir = new QDir("Catalogs/");
-    filter << "*.tsc";
+    filter << "*.tsc" << "*.tse";
     catalogDir->setNameFilters(filter);
     catFiles = catalogDir->entryInfoList();
     foreach (catFileInfo, catFiles) {
         catfName = new QString((const QString)catFileInfo.fileName());
-        catfName->remove(((catfName->length())-4),4);
+        if (catfName->endsWith(".tsc") == true) {
+            catfName->remove(((catfName->length())-4),4);
+        } // ephemerides of moving objects ("*.tse") keep their ending so that they can be told apart
         ui->listWidgetCatalog->addItem(catfName->toLatin1());
         delete catfName;
     }
     delete catalogDir;
         // filled the selection with all ".tsc" files in the home directory
     this->objCatalog=NULL; // the topical catalogue
+    this->ephemeris=NULL; // or the ephemeris of a comet, asteroid or satellite
+    this->updateHorizonMask(); // horizon and limits from the preferences
     this->ra = 0.0;
     this->decl = 0.0; // the sync position - no sync for the mount was carried out - these are displayed in the GOTO textentry
     this->camView = new QDisplay2D(ui->guidingTab,550,400); // make the clickable scene view of 425 x 340 pixels
@@ -340,6 +432,7 @@ MainWindow::MainWindow(QWidget *parent):QMainWindow(parent), ui(new Ui::MainWind
     this->lx200SerialPort->setFlowControl(QSerialPort::NoFlowControl);
     this->lx200SerialData = new QByteArray();
     this->lx200Comm= new lx200_communication();
+    this->lx200Comm->setHorizonMask(this->horizonMask); // LX200 clients learn that a target is below the horizon before the GoTo
     this->LXSetNumberFormatToSimple(); // LX200 knows a simple and a complex number format for RA and Decl - set format to simple here ...
     // check whether LXserial is to be used by default
     ui->cbSerialLX200Default->setChecked(g_AllData->getLX200SerialFlag());
@@ -468,6 +561,7 @@ MainWindow::MainWindow(QWidget *parent):QMainWindow(parent), ui(new Ui::MainWind
     connect(this->tcpHandBoxSendTimer, SIGNAL(timeout()), this, SLOT(sendDataToTCPHandboxSlot())); // send status of TSC to the TCP-IP handbox if connected
     connect(this->auxDriveUpdateTimer, SIGNAL(timeout()),this, SLOT(updateAuxDriveStatus())); // event for checking focusmotors and updating the GUI information
     connect(this->checkDriveTimer, SIGNAL(timeout()), this, SLOT(getDriveError())); // check the AMIS boards for internalk errors
+    connect(this->trackingRateTimer, SIGNAL(timeout()), this, SLOT(updateTrackingRates())); // adapt the tracking rates to refraction and moving objects
     connect(ui->listWidgetCatalog,SIGNAL(itemClicked(QListWidgetItem*)),this,SLOT(catalogChosen(QListWidgetItem*))); // choose an available .tsc catalog
     connect(ui->listWidgetObject,SIGNAL(itemClicked(QListWidgetItem*)),this,SLOT(catalogObjectChosen())); // catalog selection
     connect(ui->listWidgetIPAddresses,SIGNAL(itemClicked(QListWidgetItem*)), this, SLOT(IPaddressChosen())); // selection of IP address for LX 200
@@ -481,9 +575,47 @@ MainWindow::MainWindow(QWidget *parent):QMainWindow(parent), ui(new Ui::MainWind
     connect(ui->cbIsGEM, SIGNAL(stateChanged(int)), this, SLOT(mountIsGerman())); // toggle whether mount is a GEM or not
     connect(ui->cbMountIsEast, SIGNAL(stateChanged(int)), this, SLOT(mountIsEast())); // act whether the mount is set to east-west
     connect(ui->cbTimeFromLX200, SIGNAL(stateChanged(int)), this, SLOT(setTimeFromLX200Flag())); // check whether time from LX200 is accepted or not
+    connect(ui->cbRefraction, SIGNAL(stateChanged(int)), this, SLOT(setRefractionCorrection())); // toggle correction of GoTo and tracking for refraction
+    connect(ui->sbPressure, SIGNAL(valueChanged(int)), this, SLOT(setAtmosphericPressure())); // the ambient pressure for the refraction model
+    connect(ui->cbEphemerisTracking, SIGNAL(stateChanged(int)), this, SLOT(setEphemerisTracking())); // toggle tracking of a moving object from an ephemeris
+    connect(this->sequencerTimer, SIGNAL(timeout()), this, SLOT(updateSequencer())); // advance the sequence of targets
+    connect(ui->pbSeqAdd, SIGNAL(clicked()), this, SLOT(seqAddObject())); // add the chosen catalog object to the sequence
+    connect(ui->pbSeqLoad, SIGNAL(clicked()), this, SLOT(seqLoadSequence())); // read a list of targets from a file
+    connect(ui->pbSeqRemove, SIGNAL(clicked()), this, SLOT(seqRemoveObject())); // remove the selected target from the sequence
+    connect(ui->pbSeqClear, SIGNAL(clicked()), this, SLOT(seqClearSequence())); // remove all targets
+    connect(ui->pbSeqOptimize, SIGNAL(clicked()), this, SLOT(seqOptimizeOrder())); // sort the targets for short slews and few meridian flips
+    connect(ui->pbSeqStart, SIGNAL(clicked()), this, SLOT(seqStart())); // carry out the sequence
+    connect(ui->pbSeqStop, SIGNAL(clicked()), this, SLOT(seqStop())); // stop the sequence
+    connect(this->mflipTimer, SIGNAL(timeout()), this, SLOT(updateMeridianFlip())); // predict and carry out the meridian flip
+    connect(ui->cbAutoMFlip, SIGNAL(stateChanged(int)), this, SLOT(setAutoMFlip())); // toggle the automatic flip during exposure series
+    connect(ui->sbMFlipLimit, SIGNAL(valueChanged(int)), this, SLOT(setMFlipLimit())); // store how long the mount may track past the meridian
+    connect(ui->pbStoreMountLimits, SIGNAL(clicked()), this, SLOT(storeMountLimits())); // store minimum altitude and hour angle limits
+    connect(ui->pbLoadHorizon, SIGNAL(clicked()), this, SLOT(loadHorizonProfile())); // read the horizon profile of the site from a file
+    connect(ui->pbClearHorizon, SIGNAL(clicked()), this, SLOT(clearHorizonProfile())); // the horizon is free again
+    connect(ui->cbHideUnreachable, SIGNAL(stateChanged(int)), this, SLOT(setHideUnreachable())); // toggle hiding of catalog objects that cannot be reached
+    connect(this->horizonTimer, SIGNAL(timeout()), this, SLOT(updateCatalogVisibility())); // objects rise and set
+    connect(ui->pbStoreBacklash, SIGNAL(clicked()), this, SLOT(storeBacklash())); // store the backlash of both axes in microsteps
+    connect(ui->cbDeclBacklashComp, SIGNAL(stateChanged(int)), this, SLOT(setBacklashCompensation())); // toggle taking up the backlash on every reversal
+    connect(this->encoderTimer, SIGNAL(timeout()), this, SLOT(updateEncoderPosition())); // read the encoders on the axes if there are any
+    connect(ui->pbStoreEncoders, SIGNAL(clicked()), this, SLOT(storeEncoderSettings())); // store the source of the position and the encoder parameters
+    connect(this->parkTimer, SIGNAL(timeout()), this, SLOT(updateParkState())); // invalidate the parked position once the mount moves; run the homing
+    connect(ui->pbUnpark, SIGNAL(clicked()), this, SLOT(unparkMount())); // leave the parking position and start tracking
+    connect(ui->pbHome, SIGNAL(clicked()), this, SLOT(startHoming())); // run to the home switches and sync there
+    connect(this->autoTuneTimer, SIGNAL(timeout()), this, SLOT(updateAutoTune())); // test slews for the auto-tuning of the drives
+    connect(ui->pbAutoTune, SIGNAL(clicked()), this, SLOT(startAutoTune())); // find the fastest settings the drives can carry
+    connect(ui->pbStopAutoTune, SIGNAL(clicked()), this, SLOT(stopAutoTune()));
+    connect(this->driftCalTimer, SIGNAL(timeout()), this, SLOT(updateDriftCalibration())); // plate solves for the tracking calibration
+    connect(ui->pbStartDriftCal, SIGNAL(clicked()), this, SLOT(startDriftCalibration())); // measure the drift of the tracking mount
+    connect(ui->pbStopDriftCal, SIGNAL(clicked()), this, SLOT(stopDriftCalibration()));
+    connect(ui->pbResetDriftCal, SIGNAL(clicked()), this, SLOT(resetDriftCalibration()));
+    connect(ui->cbDriftCorrection, SIGNAL(stateChanged(int)), this, SLOT(switchDriftCorrection())); // correct the tracking rates with the calibration
     connect(ui->sbCCDGain, SIGNAL(valueChanged(int)), this, SLOT(changeCCDGain())); // change the gain of the guiding camera via INDI
     connect(ui->sbMoveSpeed, SIGNAL(valueChanged(int)),this,SLOT(changeMoveSpeed())); // set factor for faster manual motion
     connect(ui->sbFLGuideScope, SIGNAL(valueChanged(int)), this, SLOT(changeGuideScopeFL())); // spinbox for guidescope - focal length
+    connect(ui->cbCentroidMethod, SIGNAL(currentIndexChanged(int)), this, SLOT(changeCentroidMethod())); // how the centroid of the guide star is computed
+    connect(ui->sbGuideStars, SIGNAL(valueChanged(int)), this, SLOT(changeNumberOfGuideStars())); // guide on an ensemble of stars
+    connect(ui->cbGuideAlgorithmRA, SIGNAL(currentIndexChanged(int)), this, SLOT(changeGuideAlgorithm())); // how deviations become guide pulses
+    connect(ui->cbGuideAlgorithmDecl, SIGNAL(currentIndexChanged(int)), this, SLOT(changeGuideAlgorithm()));
     connect(ui->sbAMaxRA_AMIS, SIGNAL(valueChanged(int)), this, SLOT(setMaxStepperAccRA())); // process input on stepper parameters in gear-tab
     connect(ui->sbCurrMaxRA_AMIS, SIGNAL(valueChanged(double)), this, SLOT(setMaxStepperCurrentRA())); // process input on stepper parameters in gear-tab
     connect(ui->sbAMaxDecl_AMIS, SIGNAL(valueChanged(int)), this, SLOT(setMaxStepperAccDecl())); // process input on stepper parameters in gear-tab
@@ -526,7 +658,7 @@ MainWindow::MainWindow(QWidget *parent):QMainWindow(parent), ui(new Ui::MainWind
     connect(ui->pbRAPlus, SIGNAL(clicked()),this,SLOT(RAMoveHandboxFwd())); // manual motion of the handbox - ra towards sunset
     connect(ui->pbRAMinus, SIGNAL(clicked()),this,SLOT(RAMoveHandboxBwd())); // manual motion of the handbox - ra towards dawn
     connect(ui->pbStoreDrive, SIGNAL(clicked()), this, SLOT(storeDriveData())); // store data to preferences
-    connect(ui->pbGoTo, SIGNAL(clicked()),this, SLOT(startGoToObject())); // start the slew routine
+    connect(ui->pbGoTo, SIGNAL(clicked()),this, SLOT(startGoToFromGUI())); // start the slew routine
     connect(ui->pbLX200Active, SIGNAL(clicked()), this, SLOT(switchToLX200())); // open the serial port for LX 200
     connect(ui->pbStartINDIServer, SIGNAL(clicked()), this, SLOT(deployINDICommand())); // call a system command to start an INDI server with given driver parameters
     connect(ui->pbStop1, SIGNAL(clicked()), this, SLOT(emergencyStop())); // kill all motion immediately
@@ -538,6 +670,7 @@ MainWindow::MainWindow(QWidget *parent):QMainWindow(parent), ui(new Ui::MainWind
     connect(ui->pbTCPHBDisable, SIGNAL(clicked()), this, SLOT(disconnectHandboxFromIPSocket())); // disconnect the TCP/IP handbox und shut down server
     connect(ui->pbClearLXLog, SIGNAL(clicked()), this, SLOT(clearLXLog())); // delete the log of LX200 commands
     connect(ui->pbSelectGuideStar, SIGNAL(clicked()), this, SLOT(selectGuideStar())); // select a guide star defined by crosshair in the QDisplay - widget
+    connect(ui->pbFindGuideStar, SIGNAL(clicked()), this, SLOT(findGuideStar())); // search the whole image for the best guide star and confirm it
     connect(ui->pbConfirmGuideStar, SIGNAL(clicked()), this, SLOT(confirmGuideStar())); // just disables the follwing GUI elements in the autoguiding process
     connect(ui->pbGuiding,SIGNAL(clicked()), this, SLOT(doAutoGuiding())); // instantiate all variables for autoguiding and set a flag that takes care of correction in "displayGuideCamImage" and "correctGuideStarPosition"
     connect(ui->pbStoreFL, SIGNAL(clicked()), this, SLOT(storeGuideScopeFL())); // store focal length of guidescope to preferences
@@ -587,6 +720,7 @@ MainWindow::MainWindow(QWidget *parent):QMainWindow(parent), ui(new Ui::MainWind
     connect(this->camView,SIGNAL(currentViewStatusSignal(QPointF)),this->camView,SLOT(currentViewStatusSlot(QPointF)),Qt::QueuedConnection); // position the crosshair in the camera view by mouse...
     connect(this->guiding,SIGNAL(determinedGuideStarCentroid()), this->camView,SLOT(currentViewStatusSlot()),Qt::QueuedConnection); // an overload of the precious slot that allows for positioning the crosshair after a centroid was computed during guiding...
     connect(this->camera_client,SIGNAL(imageAvailable(QPixmap*)),this,SLOT(displayGuideCamImage(QPixmap*)),Qt::QueuedConnection); // display image from ccd if one was received from INDI; also takes care of autoguiding. triggered by signal
+    connect(this->camera_client,SIGNAL(imageReceived()),this,SLOT(startNextCamShot()),Qt::QueuedConnection); // the next exposure starts while the last one is still processed by the pipeline of the camera class
     connect(this->camera_client,SIGNAL(messageFromINDIAvailable()),this,SLOT(handleServerMessage()),Qt::QueuedConnection); // display messages from INDI if signal was received
     connect(this->guiding,SIGNAL(guideImagePreviewAvailable()),this,SLOT(displayGuideStarPreview()),Qt::QueuedConnection); // handle preview of the processed guidestar image
     connect(this, SIGNAL(tcpHandboxDataReceived()), this, SLOT(handleHandbox()),Qt::QueuedConnection); // handle data comming from the TCP/IP handbox
@@ -621,6 +755,7 @@ MainWindow::MainWindow(QWidget *parent):QMainWindow(parent), ui(new Ui::MainWind
             g_AllData->setMFlipParams(1,false);
         }
     }
+    this->restoreParkedPosition(); // a mount that was parked before is ready for GoTo without a sync
 }
 
 //------------------------------------------------------------------
@@ -647,6 +782,7 @@ short MainWindow::initiateStepperDrivers(void) {
                                                       g_AllData->getGearData(6 )/g_AllData->getGearData(7 ),
                                                       g_AllData->getMicroSteppingRatio(0));
     this->StepperDriveDecl->setInitialParamsAndComputeBaseSpeed(draccDecl,drcurrDecl); // setting initial parameters for the declination drive
+    this->applyBacklashModel(g_AllData->getBacklashCompensation());
     return 0;
 }
 //------------------------------------------------------------------
@@ -710,6 +846,7 @@ void MainWindow::updateReadings() {
     qint64 topicalTime; // g_AllData contains an monotonic global timer that is reset if a sync occcurs
     double relativeTravelRA, relativeTravelDecl,totalGearRatio, hourAngleForDisplay; // a few helpers
     bool wasInGoTo = false, isInGoTo = false, isEast;
+    QString starQuality;
 
     isEast = g_AllData->getMFlipParams(1); // store east/west flag for GEMs in case a meridian flip occurs. after a flip,
     // the "isEast" checkbox is deactivated.
@@ -725,6 +862,8 @@ void MainWindow::updateReadings() {
         ui->cbDither->setEnabled(false);
     }
     this->updateTimeAndDate();
+    this->StepperDriveRA->finishBacklashTakeUp();
+    this->StepperDriveDecl->finishBacklashTakeUp(); // tracking or a continuous motion starts once the slack is taken up
 
     if (this->tcpHandboxIsConnected == true) {
         if (this->HBSocket->bytesAvailable()) {
@@ -734,6 +873,17 @@ void MainWindow::updateReadings() {
 
     if (this->ccdCameraIsAcquiring == true) { // the to be analysed by the opencv in guiding is checked for saturated pixels
         ui->cbSaturation->setChecked(this->guiding->isPixelAtSaturation());
+        if (this->guiding->getStarParameter(1) > 0) {
+            starQuality = QString("SNR ") + QString::number((double)this->guiding->getStarParameter(0),'f',1) +
+                QString(" FWHM ") + QString::number(this->guiding->getStarParameter(1)*this->guiding->getArcSecsPerPix(0),'f',1) + QString("\" ");
+            if ((this->guidingState.guidingIsOn == true) && (this->guiding->getNumberOfEnsembleStars(false) > 1)) {
+                starQuality.append(QString::number(this->guiding->getNumberOfEnsembleStars(true)) + QString("/") +
+                    QString::number(this->guiding->getNumberOfEnsembleStars(false)) + QString(" stars"));
+            } else {
+                starQuality.append(QString("HFD ") + QString::number((double)this->guiding->getStarParameter(2),'f',1));
+            } // while guiding on several stars, the number of stars in the last offset is more interesting
+            ui->lStarQuality->setText(starQuality);
+        } // the quality of the guide star from the last centroid
     }
 
     if (this->dslrStates.dslrExposureIsRunning == true) { // check a timer and update display of the remaining time ...
@@ -808,6 +958,16 @@ void MainWindow::updateReadings() {
         } // after 180 degrees, the declination travel simply stops
     }
 
+    if (this->StepperDriveDecl->getTrackingSpeed() != 0) { // the declination drive follows a moving object or refraction
+        topicalTime = g_AllData->getTimeSinceLastSync() - this->mountMotion.DeclTrackingElapsedTimeInMS;
+        this->mountMotion.DeclTrackingElapsedTimeInMS+=topicalTime;
+        totalGearRatio = g_AllData->getGearData(4 )*g_AllData->getGearData(5 )*g_AllData->getGearData(6 );
+        relativeTravelDecl= this->mountMotion.DeclDriveDirection*g_AllData->getMFlipDecSign()*
+                labs(this->StepperDriveDecl->getTrackingSpeed())*topicalTime*g_AllData->getGearData(7 )/
+                (1000.0*g_AllData->getMicroSteppingRatio(0)*totalGearRatio); // the commanded speed is used as the drive runs for a day
+        g_AllData->incrementActualScopePosition(0.0, relativeTravelDecl);
+    }
+
     if ((this->mountMotion.GoToIsActiveInRA == true) || (this->mountMotion.GoToIsActiveInDecl == true)) {
         wasInGoTo = true;
     } // checks whether GoTo is active
@@ -817,11 +977,17 @@ void MainWindow::updateReadings() {
         if ((this->mountMotion.RATrackingIsOn == false) && (this->mountMotion.GoToIsActiveInRA == false) && (this->isInParking == false)) {
             this->startRATracking(); // start tracking if RA slew ended
         }
-        if (this->isDriveActive(true) == false) {
+        if ((this->mountMotion.GoToIsActiveInRA == true) && (this->isDriveActive(true) == false)) {
             this->mountMotion.GoToIsActiveInRA = false;
+            if (this->slewTimeModel->finishSlew(0, this->elapsedGoToTime->elapsed()/1000.0) == true) {
+                this->storeSlewTimeModel(0);
+            }
         }
-        if (this->isDriveActive(false) == false) {
+        if ((this->mountMotion.GoToIsActiveInDecl == true) && (this->isDriveActive(false) == false)) {
             this->mountMotion.GoToIsActiveInDecl = false;
+            if (this->slewTimeModel->finishSlew(1, this->elapsedGoToTime->elapsed()/1000.0) == true) {
+                this->storeSlewTimeModel(1);
+            }
         }
         ui->lcdGotoTime->display(round((this->gotoETA-this->elapsedGoToTime->elapsed())*0.001));
         if (this->mountMotion.GoToIsActiveInRA==true) {
@@ -852,6 +1018,13 @@ void MainWindow::updateReadings() {
         }
     }
 
+    if ((this->mountMotion.GoToIsActiveInRA == true) || ((this->mountMotion.RADriveIsMoving == true) && (this->guidingState.guidingIsOn == false))) {
+        this->encoderState.axisHasSlewed[0] = true;
+    }
+    if ((this->mountMotion.GoToIsActiveInDecl == true) || ((this->mountMotion.DeclDriveIsMoving == true) && (this->guidingState.guidingIsOn == false))) {
+        this->encoderState.axisHasSlewed[1] = true;
+    } // the travel during acceleration is only estimated, so the encoders replace step counting after slews
+
     this->currentRAString->clear(); // compose the right asccension as string - similar to the routine in the LX200 class
     this->currentRAString->append(this->generateCoordinateString(g_AllData->getActualScopePosition(2),true));
     this->currentDeclString->clear();
@@ -889,8 +1062,13 @@ void MainWindow::updateReadings() {
     }
 
     if ((wasInGoTo == true) && (isInGoTo == false)) { // slew has stopped
-        this->terminateGoTo(false);
+        if (this->slewSegment < this->slewPlanner->getNumberOfSegments() - 1) {
+            this->startSlewSegment(this->slewSegment + 1);
+        } else {
+            this->terminateGoTo(false);
+        } // the axes stop at every waypoint
     }
+    this->recordFlightData(TSC_FlightRecorder::frPeriodic, 0, 0);
 }
 //------------------------------------------------------------------------
 // a routine that computes a string out of decimal coordinates for RA and decl
@@ -1050,6 +1228,8 @@ void MainWindow::stopRATracking(void) {
 //------------------------------------------------------------------
 // synchronizes the mount to given coordinates and sets the monotonic timer to zero
 void MainWindow::syncMount(void) {
+    float syncRA, syncDecl;
+
     if (this->StepperDriveRA->getStopped() == false) { // stop tracking
         this->stopRATracking();
     }
@@ -1057,7 +1237,13 @@ void MainWindow::syncMount(void) {
         this->mountMotion.DeclDriveIsMoving=false;
         this->StepperDriveDecl->stopDrive();
     } // stop the declination drive as well ...
-    g_AllData->setSyncPosition(this->ra, this->decl);
+    this->stopDeclTracking(); // the monotonic timer is reset by the sync
+    syncRA = this->ra;
+    syncDecl = this->decl;
+    if (this->isInParking == false) {
+        this->correctTargetForRefraction(&syncRA, &syncDecl); // the object is seen at its apparent position
+    }
+    g_AllData->setSyncPosition(syncRA, syncDecl);
     // convey right ascension and declination to the global parameters;
     // a microtimer starts ...
     this->startRATracking(); // start tracking again
@@ -1081,7 +1267,8 @@ void MainWindow::syncMountFromGoTo(void) {
         this->mountMotion.DeclDriveIsMoving=false;
         this->StepperDriveDecl->stopDrive();
     } // stop the declination drive as well ...
-    g_AllData->setSyncPosition(this->ra, this->decl);
+    this->stopDeclTracking(); // the monotonic timer is reset by the sync
+    g_AllData->setSyncPosition(this->targetRA, this->targetDecl); // the target of the GoTo, corrected for refraction if needed
     // convey right ascension and declination to the global parameters;
     // a microtimer starts ...
     this->startRATracking(); // start tracking again
@@ -1101,9 +1288,14 @@ void MainWindow::syncMount(float lra, float lde, bool isEmergencyStop) {
         this->mountMotion.DeclDriveIsMoving=false;
         this->StepperDriveDecl->stopDrive();
     } // stop the declination drive as well ...
+    this->stopDeclTracking(); // the monotonic timer is reset by the sync
     g_AllData->setSyncPosition(lra, lde);
     // convey right ascension and declination to the global parameters;
     // a microtimer starts ...
+    this->StepperDriveRA->refreshStepCounter(); // the RA drive may be tracking
+    g_AllData->setAxisSteps(this->StepperDriveRA->getStepCounter(), this->StepperDriveDecl->getStepCounter(), true);
+    // the step counters of the drives at the position of the sync, for the mount state
+    this->recordFlightData(TSC_FlightRecorder::frSync, 0, 0);
     if (isEmergencyStop == false) {
         this->startRATracking(); // start tracking again
     }
@@ -1113,18 +1305,28 @@ void MainWindow::syncMount(float lra, float lde, bool isEmergencyStop) {
     ui->pbStorePark->setEnabled(true);
 }
 //---------------------------------------------------------------------
-// that one handles GOTO-commands. it leaves when the destination is reached ...
-void MainWindow::startGoToObject(void) {
-    double travelRA, travelDecl, absShortRATravel, speedFactorRA, speedFactorDecl,TRamp, SRamp,
-           SAtFullSpeed, TAtFullSpeed, earthTravelDuringGOTOinMSteps, mstepRatio,
-           convertDegreesToMicrostepsDecl,convertDegreesToMicrostepsRA, targetHA, localHA; // variables for assessing travel time and so on
-  //  qint64 timestampGOTOStarted; // various time stamps
-    qint64 timeEstimatedInRAInMS = 0; // estimate for travel time in RA [ms]
-    qint64 timeEstimatedInDeclInMS = 0; // estimate for travel time in Decl [ms]
-    long int RASteps, DeclSteps; // microsteps for travel plus a correction measure
-    int timeForProcessingEventQueue = 100; // should be the same as the time for the event queue given in this->timer
+// the GoTo button
+void MainWindow::startGoToFromGUI(void) {
+    this->startGoToObject(true);
+}
+
+//---------------------------------------------------------------------
+// that one handles GOTO-commands. it leaves when the destination is reached ... a message box would block
+// the sequencer and LX200 clients; it is only shown for the GoTo button
+void MainWindow::startGoToObject(bool showMessages) {
+    double travelRA, travelDecl, targetHA, localHA; // variables for assessing travel time and so on
     short flipResult = 0;
+    QMessageBox unreachableMsg;
 
+    if ((this->isInParking == false) && (this->isTargetReachable(this->ra, this->decl) == false)) {
+        qDebug() << "GoTo rejected - the target is below the horizon or outside the mount limits";
+        if (showMessages == true) {
+            unreachableMsg.setWindowTitle("TSC GoTo");
+            unreachableMsg.setText("The target is below the horizon or outside the mount limits.");
+            unreachableMsg.exec();
+        }
+        return;
+    } // nothing has moved yet
     g_AllData->setCelestialSpeed(0); // make sure that the drive speed is sidereal
     ui->rbSiderealSpeed->setChecked(true);
     ui->pbGoTo->setEnabled(false); // disable pushbutton for GOTO
@@ -1133,19 +1335,17 @@ void MainWindow::startGoToObject(void) {
     if (this->ccdCameraIsAcquiring == true) { // slewing and transfer of FITS images at the same time cause erratic behaviour,
         this->stopCCDAcquisition();           // the guiding camera acquisition is terminated if active
     }
+    this->targetRA = this->ra;
+    this->targetDecl = this->decl; // destination as given by LX200 or the menu of TSC
+    if (this->isInParking == false) {
+        this->correctTargetForRefraction(&this->targetRA, &this->targetDecl); // slew to the apparent position of the object
+    }
     this->syncMount(g_AllData->getActualScopePosition(2), g_AllData->getActualScopePosition(1),false);
     // make a sync to the topicalposition
 
-    travelRA=((g_AllData->getActualScopePosition(0))+g_AllData->getCelestialSpeed()*g_AllData->getTimeSinceLastSync()/1000.0)-this->ra;
-    if (fabs(travelRA) > 180) {
-        absShortRATravel = 360.0 - fabs(travelRA);
-        if (travelRA > 0) {
-            travelRA = -absShortRATravel;
-        } else {
-            travelRA = absShortRATravel;
-        }
-    } // determine the shorter travel path
-    travelDecl=this->decl-g_AllData->getActualScopePosition(1); // travel in both axes based on current position
+    travelRA=this->mountControl->getShortestRATravel((g_AllData->getActualScopePosition(0))+
+            g_AllData->getCelestialSpeed()*g_AllData->getTimeSinceLastSync()/1000.0, this->targetRA); // determine the shorter travel path
+    travelDecl=this->targetDecl-g_AllData->getActualScopePosition(1); // travel in both axes based on current position
 
     localHA = (g_AllData->getLocalSTime()*15 - g_AllData->getActualScopePosition(2));
     while (localHA < 0) {
@@ -1162,7 +1362,7 @@ void MainWindow::startGoToObject(void) {
         targetHA += 360;
     }// calculated the estimated hour angle at target position
 
-    flipResult = this->checkForFlip(g_AllData->getMFlipParams(1),localHA,targetHA, g_AllData->getActualScopePosition(1), this->decl);
+    flipResult = this->checkForFlip(g_AllData->getMFlipParams(1),localHA,targetHA, g_AllData->getActualScopePosition(1), this->targetDecl);
     if (flipResult != 0) {
         if (flipResult == -1) {
             travelRA = -(180 - travelRA);
@@ -1172,94 +1372,78 @@ void MainWindow::startGoToObject(void) {
         travelDecl=(90 - g_AllData->getActualScopePosition(1))*2-travelDecl;
     } // modified travel for meridian flip if needed
 
-
-    this->targetRA = this->ra;
-    this->targetDecl = this->decl; // destination as given by LX200 or the menu of TSC
-    if (travelRA < 0) {
-        this->mountMotion.RADriveDirection = -1;
-    } else {
-        this->mountMotion.RADriveDirection = 1;
-    } // determine direction in RA
-    if (travelDecl < 0) {
-        this->mountMotion.DeclDriveDirection = -1*g_AllData->getMFlipDecSign();
-    } else {
-        this->mountMotion.DeclDriveDirection = 1*g_AllData->getMFlipDecSign();
-    } // determine direction in declination
-
-    this->raState = slew;
-    this->deState = slew;
-    this->StepperDriveRA->changeMicroSteps(g_AllData->getMicroSteppingRatio(2));
-    this->StepperDriveDecl->changeMicroSteps(g_AllData->getMicroSteppingRatio(2));
-    mstepRatio = g_AllData->getMicroSteppingRatio(2)/((double)(g_AllData->getMicroSteppingRatio(0)));
-    speedFactorDecl=ui->sbGoToSpeed->value()*mstepRatio;
-    speedFactorRA=ui->sbGoToSpeed->value()*mstepRatio;    // set the drive speed to GOTO speed according to spinbox in GUI
-    convertDegreesToMicrostepsDecl=1.0/g_AllData->getGearData(7)*g_AllData->getMicroSteppingRatio(2)*
-            g_AllData->getGearData(4)*g_AllData->getGearData(5)*g_AllData->getGearData(6);
-    DeclSteps=round(fabs(travelDecl)*convertDegreesToMicrostepsDecl); // determine the number of microsteps necessary to reach target. direction is already given and unimportant here ...
-    convertDegreesToMicrostepsRA=1.0/g_AllData->getGearData(3)*g_AllData->getMicroSteppingRatio(2)*
-            g_AllData->getGearData(0)*g_AllData->getGearData(1)*g_AllData->getGearData(2);
-    RASteps=round(fabs(travelRA)*convertDegreesToMicrostepsRA); // determine the number of microsteps necessary to reach target. direction is already given and unimportant here ...
-    // ------------------------------- computed gross distance for ra and decl
-    TRamp = (this->StepperDriveDecl->getKineticsFromController(3)*(speedFactorDecl))/this->StepperDriveDecl->getKineticsFromController(2);// time needed until drive reaches full speed - vel/acc ...
-    SRamp = 0.5*this->StepperDriveDecl->getKineticsFromController(2)*TRamp*TRamp; // travel in microsteps until full speed is reached
-    SAtFullSpeed = fabs(DeclSteps)-2.0*SRamp; // travel after acceleration and before de-acceleration
-    if (SAtFullSpeed < 0) {
-        TAtFullSpeed=sqrt(DeclSteps/this->StepperDriveDecl->getKineticsFromController(2));// if the travel is so short that full speed cannot be reached: consider a ramp that stops at the end of travel
-        timeEstimatedInDeclInMS = (TAtFullSpeed)*1000+timeForProcessingEventQueue; // time in microseconds estimated for Declination-Travel
-    } else {
-        TAtFullSpeed = SAtFullSpeed/(this->StepperDriveDecl->getKineticsFromController(3)*speedFactorDecl);
-        timeEstimatedInDeclInMS = (TAtFullSpeed+2.0*TRamp)*1000+timeForProcessingEventQueue; // time in microseconds estimated for Declination-Travel
-    }
-    // Now repeat that computation for the RA drive
-    TRamp = (this->StepperDriveRA->getKineticsFromController(3)*(speedFactorRA))/this->StepperDriveRA->getKineticsFromController(2);
-    SRamp = 0.5*this->StepperDriveRA->getKineticsFromController(2)*TRamp*TRamp;
-    SAtFullSpeed = fabs(RASteps)-2.0*SRamp;
-    if (SAtFullSpeed < 0) {
-        TAtFullSpeed=sqrt(RASteps/this->StepperDriveRA->getKineticsFromController(2));
-        timeEstimatedInRAInMS = (TAtFullSpeed)*1000+timeForProcessingEventQueue;
-    } else {
-        TAtFullSpeed = SAtFullSpeed/(this->StepperDriveRA->getKineticsFromController(3)*speedFactorRA);
-        timeEstimatedInRAInMS = (TAtFullSpeed+2.0*TRamp)*1000+timeForProcessingEventQueue;
-    }
-
-    earthTravelDuringGOTOinMSteps=(g_AllData->getCelestialSpeed()*((double)timeEstimatedInRAInMS)/1000.0)*
-            convertDegreesToMicrostepsRA; // determine the addition of earth travel in sideral time into account
-
-        // compensate for earth travel in fwd or bwd direction
-    if (this->mountMotion.RADriveDirection == 1) {
-        RASteps=RASteps+earthTravelDuringGOTOinMSteps;
-    } else {
-        RASteps=RASteps-earthTravelDuringGOTOinMSteps;
-    }
-    timeEstimatedInRAInMS = RASteps/((double)this->StepperDriveRA->getKineticsFromController(3)*(speedFactorRA))*1000; // correct RA travel time for this additional motion
+    if (this->mountControl->planGoTo(localHA, g_AllData->getActualScopePosition(1), travelRA, travelDecl, ui->sbGoToSpeed->value(),
+                                     ((flipResult == 0) && (this->isInParking == false))) == false) {
+        qDebug() << "GoTo aborted - no path clear of the horizon and the mount limits";
+        this->setControlsForGoto(true);
+        this->setControlsForRATracking(false);
+        ui->pbGoTo->setEnabled(true); // the mount keeps tracking where it is
+        if (showMessages == true) {
+            unreachableMsg.setWindowTitle("TSC GoTo");
+            unreachableMsg.setText("There is no path to the target that stays clear of the horizon and the mount limits.");
+            unreachableMsg.exec();
+        }
+        return;
+    } // the planner sets both axes to the GoTo speed according to the spinbox in the GUI
     // finished travel time considerations ...
-    this->approximateGOTOSpeedRA=RASteps/(timeEstimatedInRAInMS/1000.0); // for LX 200 display, a mean speed during GOTO not taking ramps into account is computed; it is shortened to avoid overshooting (in graphical display)
-    this->approximateGOTOSpeedDecl=DeclSteps/(timeEstimatedInDeclInMS/1000.0); // same as above
-    if (timeEstimatedInRAInMS > timeEstimatedInDeclInMS) {
-        gotoETA = timeEstimatedInRAInMS;
-    } else {
-        gotoETA = timeEstimatedInDeclInMS;
-    }
+    this->terminateAllMotion(); // stop the drives
+    this->startSlewSegment(0);
+    ui->pbStartTracking->setEnabled(false);
+}
+
+//------------------------------------------------------------------
+// starts one part of a planned GoTo. both axes are set to the speed and acceleration of the plan so that they
+// arrive together; an axis that does not move in this segment keeps tracking, or stands still in declination
+void MainWindow::startSlewSegment(long segment) {
+    double timeEstimatedInMS;
+    long RASteps, DeclSteps, seg;
+    bool moveRA, moveDecl;
+
+    this->slewSegment = segment;
+    RASteps = this->slewPlanner->getSegmentSteps(segment, 0);
+    DeclSteps = this->slewPlanner->getSegmentSteps(segment, 1);
+    moveRA = this->mountControl->movesInSegment(segment, 0);
+    moveDecl = this->mountControl->movesInSegment(segment, 1);
+    this->mountMotion.RADriveDirection = this->slewPlanner->getSegmentDirection(segment, 0);
+    this->mountMotion.DeclDriveDirection = this->slewPlanner->getSegmentDirection(segment, 1)*g_AllData->getMFlipDecSign();
+    timeEstimatedInMS = 0;
+    for (seg = segment; seg < this->slewPlanner->getNumberOfSegments(); seg++) {
+        timeEstimatedInMS += 1000*this->slewPlanner->getSegmentDuration(seg);
+    }
+    if (timeEstimatedInMS < 100) {
+        timeEstimatedInMS = 100;
+    } // the end of a slew is not detected before the next tick of the event queue
+    this->gotoETA = round(timeEstimatedInMS);
     ui->lcdGotoTime->display(round(gotoETA/1000.0)); // determined the estimated duration of the GoTo - Process and display it in the GUI. it is reduced in the event queue
+    timeEstimatedInMS = fmax(100, 1000*this->slewPlanner->getSegmentDuration(segment));
+    this->approximateGOTOSpeedRA=RASteps/(timeEstimatedInMS/1000.0); // for LX 200 display, a mean speed during GOTO not taking ramps into account is computed; it is shortened to avoid overshooting (in graphical display)
+    this->approximateGOTOSpeedDecl=DeclSteps/(timeEstimatedInMS/1000.0); // same as above; both axes arrive together
     // let the games begin ... GOTO is ready to start ...
-    this->terminateAllMotion(); // stop the drives
     this->elapsedGoToTime->start(); // a second timer in the class to measure the time elapsed during goto - needed for updates in the event queue
-    this->StepperDriveRA->travelForNSteps(RASteps,this->mountMotion.RADriveDirection,round(speedFactorRA/mstepRatio),false);
-    this->mountMotion.GoToIsActiveInRA=true;
-    this->mountMotion.RAGoToElapsedTimeInMS=g_AllData->getTimeSinceLastSync();
-    //timestampGOTOStarted = g_AllData->getTimeSinceLastSync();
-    ui->pbStartTracking->setEnabled(false);
-    this->StepperDriveDecl->travelForNSteps(DeclSteps,this->mountMotion.DeclDriveDirection*g_AllData->getMFlipDecSign(),round(speedFactorDecl/mstepRatio),0);
-    this->mountMotion.GoToIsActiveInDecl=true;
-    this->mountMotion.DeclGoToElapsedTimeInMS=g_AllData->getTimeSinceLastSync(); // now, all drives are started and timestamps were taken
+    if (moveRA == true) {
+        if (this->mountMotion.RATrackingIsOn == true) {
+            this->stopRATracking();
+        }
+        this->raState = slew;
+        this->mountControl->startSegment(segment, 0);
+        this->mountMotion.RAGoToElapsedTimeInMS=g_AllData->getTimeSinceLastSync();
+    } else if ((this->mountMotion.RATrackingIsOn == false) && (this->isInParking == false)) {
+        this->startRATracking();
+    }
+    this->mountMotion.GoToIsActiveInRA = moveRA;
+    if (moveDecl == true) {
+        this->deState = slew;
+        this->mountControl->startSegment(segment, 1); // the measured durations are used to refine the ETA
+        this->mountMotion.DeclGoToElapsedTimeInMS=g_AllData->getTimeSinceLastSync(); // now, all drives are started and timestamps were taken
+    }
+    this->mountMotion.GoToIsActiveInDecl = moveDecl;
+    this->recordFlightData(TSC_FlightRecorder::frGoToStart, 0, 0);
 }
 
 //------------------------------------------------------------------
 // this routine handles finishing a GoTo
 void MainWindow::terminateGoTo(bool calledAsEmergencyStop) {
     qDebug() << "Parking state: " << this->isInParking;
-    this->ra=this->targetRA;
-    this->decl=this->targetDecl;
 
     ui->lcdGotoTime->display(0); // set the LCD counter to zero again
     this->setControlsForGoto(true);
@@ -1267,7 +1451,8 @@ void MainWindow::terminateGoTo(bool calledAsEmergencyStop) {
     this->setControlsForRATravel(true); // set GUI back in base state
     this->mountMotion.GoToIsActiveInRA=false;
     this->mountMotion.GoToIsActiveInDecl=false; // just to make sure - slew has ENDED here ...
-    this->StepperDriveDecl->changeMicroSteps(g_AllData->getMicroSteppingRatio(0));
+    this->slewSegment = this->slewPlanner->getNumberOfSegments(); // no waypoints left
+    this->mountControl->finishGoTo(ui->sbAMaxRA_AMIS->value(), ui->sbAMaxDecl_AMIS->value(), round(ui->sbCurrMaxDecl_AMIS->value()));
     if (this->isInParking == false) {
         if (calledAsEmergencyStop == false) {
             this->syncMountFromGoTo(); // sync the mount to desired position
@@ -1282,13 +1467,32 @@ void MainWindow::terminateGoTo(bool calledAsEmergencyStop) {
         ui->pbStartTracking->setDisabled(false);
         this->stopRATracking();
         this->isInParking = false;
+        if (this->parkState.step == pkParking) {
+            if (calledAsEmergencyStop == false) {
+                this->parkState.step = pkParked;
+                g_AllData->setAxisSteps(this->StepperDriveRA->getStepCounter(), this->StepperDriveDecl->getStepCounter(), false);
+                g_AllData->storeMountState(true); // the mount may now be switched off
+                ui->lParkState->setText("Parked");
+            } else {
+                this->parkState.step = pkIdle;
+            }
+        }
     }
     this->deState = guideTrack;
-    this->StepperDriveDecl->setInitialParamsAndComputeBaseSpeed((double)ui->sbAMaxDecl_AMIS->value(),
-                                                                ((double)(round(ui->sbCurrMaxDecl_AMIS->value()))));
     this->meridianFlipDisabledForPolarParking = false; // if this was a flip to the north pole, it is done now ...
 }
 
+//------------------------------------------------------------------
+// the ETA model was refitted after a slew in one axis; the parameters and the accuracy go to the preferences,
+// which are written with the next change of a setting or when TSC is shut down
+void MainWindow::storeSlewTimeModel(short axis) {
+    short what;
+
+    for (what = 0; what < 4; what++) {
+        g_AllData->setSlewTimeModel(axis, what, this->slewTimeModel->getParameter(axis, what));
+    }
+}
+
 //------------------------------------------------------------------
 // a routine that checks whether a meridian flip is necessary; returns 0 for no flip, 1, for a flip to west, -1 for a flip to east
 short MainWindow::checkForFlip(bool isEast, float ha, float gha, float dec, float gDec) {
@@ -1472,8 +1676,13 @@ void MainWindow::gotoParkPosition(void) {
     if (fabs(this->decl) > 85) {
         this->meridianFlipDisabledForPolarParking = true;
     }
-    this->startGoToObject();
-    this->isInParking = true;
+    this->isInParking = true; // the park position is a mechanical position and must not be corrected for refraction
+    this->parkState.step = pkParking;
+    this->startGoToObject(false);
+    this->isInParking = true; // starting the GoTo restarts tracking, which resets the flag
+    if ((this->mountMotion.GoToIsActiveInRA == false) && (this->mountMotion.GoToIsActiveInDecl == false)) {
+        this->parkState.step = pkIdle;
+    } // the GoTo was not started
 
 }
 
@@ -1482,6 +1691,7 @@ void MainWindow::gotoParkPosition(void) {
 void MainWindow::syncParkPosition(void) {
     this->ra   = g_AllData->getLocalSTime()*15 - g_AllData->getParkingPosition(0);
     this->decl = g_AllData->getParkingPosition(1);
+    this->isInParking = true; // no refraction correction for the park position; the flag is reset when tracking starts
     this->syncMount(); // sync the mount
 }
 
@@ -1504,6 +1714,8 @@ void MainWindow::shutDownProgram() {
     outfile << ostr.data();
     outfile.close(); // close the file
     ostr.clear();  // save the state of the GEM in a separate file at shutdown
+    qDebug() << "Storing the GoTo ETA model...";
+    g_AllData->storeGlobalData(); // the model is refitted after every GoTo, but only written to the preferences here
     qDebug() << "Shutting down camera...";
     this->ccdCameraIsAcquiring=false;
     this->waitForNMSecs((ui->sbExposureTime->value())*1000);
@@ -1518,12 +1730,28 @@ void MainWindow::shutDownProgram() {
         emergencyStopAuxDrives();
     }
     qDebug() << "Freeing memory ...";
+    delete refraction;
+    delete sequencer;
+    delete slewTimeModel;
+    delete slewPlanner;
+    delete mountControl;
+    delete horizonMask;
+    delete encoderFusion;
+    delete flightRecorder;
+    delete guidingLog;
+    delete guideAlgorithm[0];
+    delete guideAlgorithm[1];
+    delete driftCalibration;
+    delete driveTuner;
+    delete catalogPositions;
+    if (this->ephemeris != NULL) {
+        delete this->ephemeris;
+    }
     delete currentRAString;
     delete currentDeclString;
     delete currentHAString;
     delete coordString;
     delete textEntry;
-    delete wcsInfoOutput;
     delete camImg;
     delete guideStarPrev;
     qDebug() << "Freeing SPI ...";
@@ -1590,6 +1818,18 @@ void MainWindow::terminateAllMotion(void) {
 // emergency stop of all motion
 void MainWindow::emergencyStop(void) {
     this->mountMotion.emergencyStopTriggered=true;
+    this->recordFlightData(TSC_FlightRecorder::frEmergencyStop, 0, 0);
+    if (this->sequencerState.step != sqIdle) {
+        this->seqStop();
+    }
+    if ((this->mflipState.step != mfIdle) || (this->mflipState.seriesOnHold == true)) {
+        this->mflipState.step = mfIdle;
+        this->mflipState.seriesOnHold = false;
+        if (this->dslrStates.dslrSeriesRunning == true) {
+            this->terminateDSLRSeries(); // a series on hold would never resume
+        }
+        ui->leMFlipState->setText("Stopped");
+    }
     this->StepperDriveRA->stopDrive();
     this->StepperDriveDecl->stopDrive();
     if ((this->mountMotion.GoToIsActiveInRA == true) || (this->mountMotion.GoToIsActiveInDecl == true)) {
@@ -1726,6 +1966,7 @@ void MainWindow::setINDISAddrAndPort(void) {
             ui->pbExpose->setEnabled(true);
             ui->cbIndiIsUp->setChecked(true);
             ui->cbStoreGuideCamImgs->setEnabled(true);
+            ui->cbGuideSubframe->setEnabled(true);
             this->getCCDParameters(false);
             this->storeCCDData(false);
             if (camera_client->cameraGainAvailable() == true) {
@@ -1742,6 +1983,7 @@ void MainWindow::setINDISAddrAndPort(void) {
             ui->pbExpose->setEnabled(false);
             ui->cbIndiIsUp->setChecked(false);
             ui->cbStoreGuideCamImgs->setEnabled(false);
+            ui->cbGuideSubframe->setEnabled(false);
             noCamBoxMsg.setWindowTitle("Critical INDI error");
             noCamBoxMsg.setText("Camera not available - is it connected?");
             noCamBoxMsg.exec();
@@ -1971,6 +2213,7 @@ void MainWindow::startCCDAcquisition(void) {
     this->takeSingleCamShot();
     this->waitForNMSecs(200);
     ui->pbSelectGuideStar->setEnabled(true);
+    ui->pbFindGuideStar->setEnabled(true);
     ui->pbDisconnectFromServer->setEnabled(false);
     ui->tabImageProc->setEnabled(true);
 }
@@ -2046,6 +2289,7 @@ void MainWindow::displayGuideCamImage(QPixmap *camPixmap) {
     int thrshld,beta;
     float newX, newY,alpha;
     bool medianOn, lpOn;
+    struct ocv_guiding::guideStarMeasurementStruct starMeasurement;
 
     this->camImageWasReceived= true;
     thrshld = ui->hsThreshold->value();
@@ -2062,25 +2306,55 @@ void MainWindow::displayGuideCamImage(QPixmap *camPixmap) {
         if (this->guidingState.calibrationIsRunning == true) { // autoguider is calibrating
             this->guidingState.calibrationImageReceived=true; // in calibration, this camera image is to be used
         } // we only take a single shot here
-        if ((this->ccdCameraIsAcquiring==true) && (this->guidingState.guidingIsOn==false)) { // if the flag for taking another one is true ...
-            this->waitForNMSecs(100);
-            this->takeSingleCamShot(); // ... request another one from INDI
-            this->waitForNMSecs(500);
-        } else {
+        if ((this->ccdCameraIsAcquiring==false) || (this->guidingState.guidingIsOn==true)) { // another one was already requested in "startNextCamShot" if acquisition is on ...
             ui->pbExpose->setEnabled(true); // if acquisition is disabled, set the GUI so that it can be enabled
         }
-        if ((this->guidingState.guidingIsOn==true) && (this->guidingState.systemIsCalibrated==true)) { // if autoguiding is active and system is calibrated
+        if ((this->guidingState.guidingIsOn==true) && (this->guidingState.systemIsCalibrated==true) &&
+            (this->guidingState.correctionIsRunning==false)) { // if autoguiding is active and system is calibrated
+            this->guidingState.correctionIsRunning = true;
             this->guidingState.noOfGuidingSteps++; // every odd one, corrections are applied ...
             ui->lcdGuidesteps->display((int)(this->guidingState.noOfGuidingSteps));
-            this->guiding->doGuideStarImgProcessing(thrshld,medianOn, lpOn,alpha,beta,this->guidingFOVFactor,this->guidingState.guideStarSelected, true); // ... process the guide star subimage
+            if ((this->guidingState.noOfGuidingSteps > 1) && (this->camera_client->getGuideStarMeasurement(&starMeasurement) == true)) {
+                this->guiding->applyGuideStarMeasurement(&starMeasurement, true); // the pipeline of the camera class has already processed the guide star subimage
+            } else {
+                this->guiding->doGuideStarImgProcessing(thrshld,medianOn, lpOn,alpha,beta,this->guidingFOVFactor,this->guidingState.guideStarSelected, true); // ... process the guide star subimage
+            }
+            if (this->guidingState.noOfGuidingSteps == 1) {
+                this->guiding->initStarEnsemble(g_AllData->getNumberOfGuideStars()); // the references for guiding on several stars
+            } else if (this->guiding->getNumberOfEnsembleStars(false) > 1) {
+                this->guiding->doStarEnsembleProcessing(); // replaces the guide star position by the offset of all stars
+            }
             newX = g_AllData->getInitialStarPosition(2);
             newY = g_AllData->getInitialStarPosition(3); // the star centroid found in "doGuideStarImgProcessing" was stored in the global struct ...
-            this->waitForNMSecs(2500);
+            this->camera_client->getFramePipeline()->setStarSearch(newX, newY, thrshld, medianOn, lpOn, alpha, beta,
+                this->guidingFOVFactor); // ... the pipeline looks for the star there in the next image ...
+            if (ui->cbGuideSubframe->isChecked() == true) {
+                this->camera_client->setSubframe(this->guiding->getGuideSubframe(this->camera_client->getSubframe(),
+                    this->guidingFOVFactor)); // ... the camera reads out the region around the stars, or the full chip if the star was lost ...
+            } else {
+                this->camera_client->setSubframe(QRect());
+            }
             correctGuideStarPosition(newX,newY); // ... and is used to correct the position
+            this->guidingState.correctionIsRunning = false;
         }
     }
 }
 
+//------------------------------------------------------------------
+// the camera class has received the data of an exposure and processes them on the threads of its
+// pipeline. the next exposure is requested right away; while guiding, the correction for the last
+// image then falls into this exposure, and the guide cycle is the exposure time plus the download
+void MainWindow::startNextCamShot(void) {
+    if (g_AllData->getINDIState(false) == false) {
+        return;
+    }
+    if ((this->guidingState.guidingIsOn==true) && (this->guidingState.systemIsCalibrated==true)) {
+        this->takeSingleCamShot();
+    } else if (this->ccdCameraIsAcquiring==true) {
+        this->takeSingleCamShot();
+    }
+}
+
 //------------------------------------------------------------------
 // retrieve parameters for the guide CCD from the camera class
  bool MainWindow::getCCDParameters(bool isMainCCD) {
@@ -2183,83 +2457,59 @@ void MainWindow::displayGuideCamImage(QPixmap *camPixmap) {
 //------------------------------------------------------------------
 //------------------------------------------------------------------
 // correct guide star position here. called from "displayGuideCamImage".
+// the exposure of the next image is already running
 double MainWindow::correctGuideStarPosition(float cx, float cy) {
-    float devVector[2], devVectorRotated[2],errx,erry,err, devRA, devDecl;
+    float devVector[2],errx,erry,err;
     int pgduration;
-    double aggressiveness, runningRMS, hysteresisWeight, prevWeights;
-    QString logString, errString;
+    double aggressiveness, runningRMS, hysteresisWeight, corrRA, corrDecl, frameTime;
+    QString errString;
+    struct TSC_MountControl::guideStepStruct step;
+    struct TSC_GuideLog::guideSegmentStruct logSegment;
+    struct TSC_GuideLog::guideFrameStruct logFrame;
 
-    hysteresisWeight = ui->sbHysteresisWeight->value(); // the weight for the last error ...
-    prevWeights = (1.0-hysteresisWeight)/2.0;
+    hysteresisWeight = ui->sbHysteresisWeight->value(); // the weight for the last error in the running average ...
     aggressiveness = ui->sbGuideAggressiveness->value(); // a value that dampens the response - values between 0.7 and 1.3
+    this->mountControl->setGuideCalibration(this->rotMatrixGuidingXToRA, this->guidingState.travelTime_ms_RA, this->guidingState.travelTime_ms_Decl);
+    this->mountControl->setGuideParameters(ui->sbMaxDevInGuiding->value(), aggressiveness, hysteresisWeight, ui->cbSwitchDecl->isChecked());
     if (this->guidingState.noOfGuidingSteps == 1) {
         ui->leDevRaPix->setText("0");
         ui->leDevDeclPix->setText("0"); 
         this->guideStarPosition.centrX = cx;
         this->guideStarPosition.centrY = cy;
-        if (ui->cbLogGuidingData->isChecked()==true) {
-            logString.append("Travel time per Pixel in RA in ms:\t");
-            this->guidingLog->write(logString.toLatin1(),logString.length());
-            logString.clear();
-            logString.append(QString::number((double)this->guidingState.travelTime_ms_RA,'g',3));
-            logString.append("\n");
-            this->guidingLog->write(logString.toLatin1(),logString.length());
-            logString.clear();
-            logString.append("Travel time per Pixel in Decl in ms:\t");
-            this->guidingLog->write(logString.toLatin1(),logString.length());
-            logString.clear();
-            logString.append(QString::number((double)this->guidingState.travelTime_ms_Decl,'g',3));
-            logString.append("\n");
-            this->guidingLog->write(logString.toLatin1(),logString.length());
-            logString.clear();
-            logString.append("Rotation matrix:\t");
-            this->guidingLog->write(logString.toLatin1(),logString.length());
-            logString.clear();
-            logString.append(QString::number((double)this->rotMatrixGuidingXToRA[0][0],'g',3));
-            logString.append("\t");
-            logString.append(QString::number((double)this->rotMatrixGuidingXToRA[0][1],'g',3));
-            logString.append("\n");
-            this->guidingLog->write(logString.toLatin1(),logString.length());
-            logString.clear();
-            logString.append("\t");
-            logString.append(QString::number((double)this->rotMatrixGuidingXToRA[1][0],'g',3));
-            logString.append("\t");
-            logString.append(QString::number((double)this->rotMatrixGuidingXToRA[1][1],'g',3));
-            logString.append("\n");
-            this->guidingLog->write(logString.toLatin1(),logString.length());
-            logString.clear();
-            logString.append("Decl backlash in ms:\t");
-            this->guidingLog->write(logString.toLatin1(),logString.length());
-            logString.clear();
-            logString.append(QString::number((double)this->guidingState.backlashCompensationInMS,'g',3));
-            logString.append("\n");
-            this->guidingLog->write(logString.toLatin1(),logString.length());
-            logString.clear();
-            logString.append("Guidestar-position:\t");
-            logString.append(QString::number((double)cx,'g',3));
-            logString.append("\t");
-            logString.append(QString::number((double)cy,'g',3));
-            logString.append("\n");
-            this->guidingLog->write(logString.toLatin1(),logString.length());
-            logString.clear();
+        this->mountControl->resetGuiding(); // a new reference; the algorithms forget the past frames
+        this->guidingState.frameTimer.start();
+        if (this->guidingLog->isOpen() == true) {
+            logSegment.travelTime[0] = this->guidingState.travelTime_ms_RA;
+            logSegment.travelTime[1] = this->guidingState.travelTime_ms_Decl;
+            logSegment.rotation[0][0] = this->rotMatrixGuidingXToRA[0][0];
+            logSegment.rotation[0][1] = this->rotMatrixGuidingXToRA[0][1];
+            logSegment.rotation[1][0] = this->rotMatrixGuidingXToRA[1][0];
+            logSegment.rotation[1][1] = this->rotMatrixGuidingXToRA[1][1];
+            logSegment.arcsecPerPixel[0] = this->guiding->getArcSecsPerPix(0);
+            logSegment.arcsecPerPixel[1] = this->guiding->getArcSecsPerPix(1);
+            logSegment.reference[0] = cx;
+            logSegment.reference[1] = cy;
+            logSegment.declBacklash = g_AllData->getBacklash(1);
+            logSegment.backlashCompensated = ui->cbDeclBacklashComp->isChecked();
+            logSegment.method[0] = this->guideAlgorithm[0]->getMethod();
+            logSegment.method[1] = this->guideAlgorithm[1]->getMethod();
+            this->guidingLog->startSegment(&logSegment);
         }
         this->guidingState.rmsDevInArcSec = 0.0;
         this->guidingState.rmsDevInArcSecSum = 0.0;
         this->guidingState.maxDevInArcSec = 0;
         ui->leMaxGuideErr->setText("0/0");
-        this->takeSingleCamShot();
-        this->waitForNMSecs(250);
         return 0.0;
     } // when called for the first time, make the current centroid the reference ...
-    if (ui->cbLogGuidingData->isChecked()==true) {
-        logString.append("Measured centroid:\t");
-        logString.append(QString::number((double)cx,'g',3));
-        logString.append("\t");
-        logString.append(QString::number((double)cy,'g',3));
-        logString.append("\n");
-        this->guidingLog->write(logString.toLatin1(),logString.length());
-        logString.clear();
+    logFrame.centroid[0] = cx;
+    logFrame.centroid[1] = cy;
+    logFrame.snr = this->guiding->getStarParameter(0);
+    logFrame.stars = 1;
+    if (this->guiding->getNumberOfEnsembleStars(false) > 1) {
+        logFrame.stars = this->guiding->getNumberOfEnsembleStars(true);
     }
+    logFrame.pulse[0] = 0;
+    logFrame.pulse[1] = 0;
 
     // now compute the deviation
     devVector[0]=-(this->guideStarPosition.centrX - cx);
@@ -2278,151 +2528,64 @@ double MainWindow::correctGuideStarPosition(float cx, float cy) {
         errString.append("/");
         errString.append(QString::number(runningRMS,'g',2));
         ui->leMaxGuideErr->setText(errString);
-        if (ui->cbLogGuidingData->isChecked()==true) {
-            logString.append("Current deviation:\t");
-            logString.append(QString::number((double)devVector[0],'g',3));
-            logString.append("\t");
-            logString.append(QString::number((double)devVector[1],'g',3));
-            logString.append("\n");
-            this->guidingLog->write(logString.toLatin1(),logString.length());
-            logString.clear();
-        }
-    }
-    devVectorRotated[0]=(this->rotMatrixGuidingXToRA[0][0]*devVector[0]+this->rotMatrixGuidingXToRA[0][1]*devVector[1]);
-    devVectorRotated[1]=(this->rotMatrixGuidingXToRA[1][0]*devVector[0]+this->rotMatrixGuidingXToRA[1][1]*devVector[1]);
-    // the deviation vector is rotated to the ra/decl coordinate system and inverted as we want to move in the other direction
-    if (ui->cbLogGuidingData->isChecked()==true) {
-            logString.append("Transformed position:\t");
-            logString.append(QString::number((double)devVectorRotated[0],'g',3));
-            logString.append("\t");
-            logString.append(QString::number((double)devVectorRotated[1],'g',3));
-            logString.append("\n");
-            this->guidingLog->write(logString.toLatin1(),logString.length());
-            logString.clear();
-    }
-
-    this->guidingState.raErrs[0] = this->guidingState.raErrs[1];
-    this->guidingState.raErrs[1] = this->guidingState.raErrs[2];
-    this->guidingState.raErrs[2] = devVectorRotated[0]; // compute a runing average of the two past errors and the current one to dampen guiding motion
-    devRA=(prevWeights*this->guidingState.raErrs[0]+prevWeights*this->guidingState.raErrs[1]+
-           hysteresisWeight*this->guidingState.raErrs[2]); // this is the moving average
+    }
+    frameTime = this->guidingState.frameTimer.elapsed()/1000.0;
+    this->mountControl->computeGuideStep(devVector[0], devVector[1], frameTime, &step);
+    // the deviation vector is rotated to the ra/decl coordinate system; the corrections are in pixels, 0 if the star is left alone
+    logFrame.deviation[0] = step.deviation[0];
+    logFrame.deviation[1] = step.deviation[1];
+    corrRA = step.correction[0];
+    corrDecl = step.correction[1];
     // carry out the correction in RA
 
-    if (fabs(devVectorRotated[0]) > ui->sbMaxDevInGuiding->value()) {
-        pgduration=round(aggressiveness*this->guidingState.travelTime_ms_RA*fabs(devRA)); // pulse guide duration in ra
-        if (pgduration > 2000) {
-            pgduration = 2000;
-        }
-        if (ui->cbLogGuidingData->isChecked()==true) {
-            logString.append("RA correction duration:\t");
-            logString.append(QString::number((double)pgduration,'g',3));
-            logString.append("\n");
-            this->guidingLog->write(logString.toLatin1(),logString.length());
-            logString.clear();
-        }
+    if (corrRA != 0) {
+        pgduration=step.pulseDuration[0]; // pulse guide duration in ra
+        logFrame.pulse[0] = copysign(pgduration, corrRA);
         ui->lcdPulseGuideDuration->display(pgduration); // set the duration for the slew in RA - this value is used in the pulseguideroutine
         this->pulseGuideDuration=pgduration;
         ui->lePulseRAMS->setText(textEntry->number(pgduration));
-        if (devRA > 0) {
-            ui->leDevRaPix->setText(textEntry->number(-devRA,'g',2));
-            this->raPGBwdGd(pgduration);
-            if (ui->cbLogGuidingData->isChecked()==true) {
-                logString.append("RA correction direction:\t RA-\n");
-                this->guidingLog->write(logString.toLatin1(),logString.length());
-                logString.clear();
-            }
+        if (corrRA > 0) {
+            ui->leDevRaPix->setText(textEntry->number(-corrRA,'g',2));
         } else {
-            ui->leDevRaPix->setText(textEntry->number(devRA,'g',2));
-            this->raPGFwdGd(pgduration);
-            if (ui->cbLogGuidingData->isChecked()==true) {
-                logString.append("RA correction direction:\t RA+\n");
-                this->guidingLog->write(logString.toLatin1(),logString.length());
-                logString.clear();
-            }
+            ui->leDevRaPix->setText(textEntry->number(corrRA,'g',2));
         }
+        this->raPulseGuide(pgduration, step.pulseDirection[0]);
     } else {
         ui->lePulseRAMS->setText("0");
     }
     this->waitForDriveStop(true,false); // just to make sure that drive has stopped moving, should not be an issue as guiding is unthreaded
     this->waitForNMSecs(500);
-    // carry out the correction in decl
+    // carry out the correction in decl; the "Switch Decl" checkbox is applied to the direction of the pulse
 
-    this->guidingState.declErrs[0] = this->guidingState.declErrs[1];
-    this->guidingState.declErrs[1] = this->guidingState.declErrs[2];
-    this->guidingState.declErrs[2] = devVectorRotated[1]; // now compute a running average for declination
-    devDecl = (prevWeights*this->guidingState.declErrs[0]+prevWeights*this->guidingState.declErrs[1]+hysteresisWeight*this->guidingState.declErrs[2]);
-
-    if (fabs(devVectorRotated[1]) > ui->sbMaxDevInGuiding->value()) {
-        pgduration=round(aggressiveness*this->guidingState.travelTime_ms_Decl*fabs(devDecl)); // pulse guide duration in decl
-        if (pgduration > 2000) {
-            pgduration = 2000;
-        }
-        if (ui->cbLogGuidingData->isChecked()==true) {
-                logString.append("Decl correction duration:\t");
-                logString.append(QString::number((double)pgduration,'g',3));
-                logString.append("\n");
-                this->guidingLog->write(logString.toLatin1(),logString.length());
-                logString.clear();
-        }
-        if (devDecl < 0) {
+    if (corrDecl != 0) {
+        pgduration=step.pulseDuration[1]; // pulse guide duration in decl
+        logFrame.pulse[1] = copysign(pgduration, corrDecl);
+        if (corrDecl < 0) {
             if (this->guidingState.declinationDriveDirection < 0) {
                 this->guidingState.declinationDriveDirection = +1; // switch state to positive travel
-                if (ui->cbDeclBacklashComp->isChecked()==true) { // carry out compensation if checkbox is activated
-                    this->compensateDeclBacklashPG(-this->guidingState.declinationDriveDirection); // trying to invert the correction direction ... hopefully correct
-                    if (ui->cbLogGuidingData->isChecked()==true) {
-                            logString.append("Decl backlash activated.\n");
-                            this->guidingLog->write(logString.toLatin1(),logString.length());
-                            logString.clear();
-                        }
-                }
                 ui->lcdPulseGuideDuration->display(pgduration); // set the duration for the slew in Decl - this value is used in the pulseguideroutine
                 this->pulseGuideDuration=pgduration;
             }
-            ui->lePulseDeclMS->setText(textEntry->number(pgduration));
-            ui->leDevDeclPix->setText(textEntry->number(-devDecl,'g',2));
-            if (ui->cbSwitchDecl->isChecked() == false) {
-                this->declPGMinusGd(pgduration);
-            } else {
-                this->declPGPlusGd(pgduration);
-            }
-            if (ui->cbLogGuidingData->isChecked()==true) {
-                logString.append("Decl correction direction:\t Decl-\n");
-                this->guidingLog->write(logString.toLatin1(),logString.length());
-                logString.clear();
-            }
+            ui->leDevDeclPix->setText(textEntry->number(-corrDecl,'g',2));
         } else {
             if (this->guidingState.declinationDriveDirection > 0) {
                 this->guidingState.declinationDriveDirection = -1; // switch state to negative travel
-                if (ui->cbDeclBacklashComp->isChecked()==true) {
-                    this->compensateDeclBacklashPG(-this->guidingState.declinationDriveDirection); // trying to invert the correction direction ... hopefully correct
-                if (ui->cbLogGuidingData->isChecked()==true) {
-                            logString.append("Decl backlash activated.\n");
-                            this->guidingLog->write(logString.toLatin1(),logString.length());
-                            logString.clear();
-                        }
-                }
                 ui->lcdPulseGuideDuration->display(pgduration); // set the duration for the slew in Decl - this value is used in the pulseguideroutine
                 this->pulseGuideDuration=pgduration;
             }
-            ui->lePulseDeclMS->setText(textEntry->number(pgduration));
-            ui->leDevDeclPix->setText(textEntry->number(devDecl,'g',2));
-            if (ui->cbSwitchDecl->isChecked() == false) {
-                this->declPGPlusGd(pgduration);
-            } else {
-                this->declPGMinusGd(pgduration);
-            }
-            if (ui->cbLogGuidingData->isChecked()==true) {
-                logString.append("Decl correction direction:\t Decl+\n");
-                this->guidingLog->write(logString.toLatin1(),logString.length());
-                logString.clear();
-            }
+            ui->leDevDeclPix->setText(textEntry->number(corrDecl,'g',2));
         }
+        ui->lePulseDeclMS->setText(textEntry->number(pgduration));
+        this->declinationPulseGuide(pgduration, step.pulseDirection[1]);
     } else {
         ui->lePulseDeclMS->setText("0");
     }
-    this->waitForDriveStop(false,false);
-    this->takeSingleCamShot();
-    this->waitForNMSecs(250);
+    if (this->guidingLog->isOpen() == true) {
+        logFrame.time = frameTime;
+        logFrame.declDirection = this->guidingState.declinationDriveDirection;
+        this->guidingLog->writeFrame(&logFrame);
+    }
+    this->waitForDriveStop(false,false); // the next image was already requested in "startNextCamShot"
     return 0.0;
 }
 
@@ -2465,7 +2628,8 @@ void MainWindow::calibrateAutoGuider(void) {
         travelPerMSInRACorr, travelPerMSInDeclCorr, travelTimeInMSForOnePixRA,
         travelTimeInMSForOnePixDecl,tTimeOnePix[4],lengthOfTravel, lengthOfTravelDeclPlus,
         lengthOfTravelDeclMinus,relativeAngle[4],avrgAngle, sdevAngle,
-        avrgDeclBacklashInPixel, sdevBacklashPix, declBacklashInPixel[4];
+        avrgDeclBacklashInPixel, sdevBacklashPix, declBacklashInPixel[4], declArcsecPerMicrostep;
+    long declBacklashInMicrosteps;
     float alpha;
     int thrshld,beta,imgProcWindowSize;
     bool medianOn, lpOn;
@@ -2477,6 +2641,7 @@ void MainWindow::calibrateAutoGuider(void) {
     this->StepperDriveDecl->changeMicroSteps(g_AllData->getMicroSteppingRatio(0));
     this->guidingState.calibrationIsRunning=true;
     this->guidingState.systemIsCalibrated=false;
+    this->applyBacklashModel(false); // the travel has to be measured without compensation
     ui->teCalibrationStatus->clear();
     this->calibrationToBeTerminated = false;
     ui->pbTerminateCal->setEnabled(true);
@@ -2756,9 +2921,17 @@ void MainWindow::calibrateAutoGuider(void) {
                                 (declBacklashInPixel[1]-avrgDeclBacklashInPixel)*(declBacklashInPixel[1]-avrgDeclBacklashInPixel)+
                                 (declBacklashInPixel[2]-avrgDeclBacklashInPixel)*(declBacklashInPixel[2]-avrgDeclBacklashInPixel)+
                                 (declBacklashInPixel[3]-avrgDeclBacklashInPixel)*(declBacklashInPixel[3]-avrgDeclBacklashInPixel)));
-    this->guidingState.backlashCompensationInMS=fabs(avrgDeclBacklashInPixel)*travelTimeInMSForOnePixDecl; // determine length of travel for backlash compensation
-    this->displayCalibrationStatus("Backlash compensation: ", (float)this->guidingState.backlashCompensationInMS,"[ms]");
-    this->displayCalibrationStatus("Standard deviation: ", sdevBacklashPix,"[ms]");
+    declArcsecPerMicrostep = 3600.0*g_AllData->getGearData(7)/(g_AllData->getGearData(4)*g_AllData->getGearData(5)*
+        g_AllData->getGearData(6)*g_AllData->getMicroSteppingRatio(0));
+    if (declArcsecPerMicrostep > 0) {
+        declBacklashInMicrosteps = round(fabs(avrgDeclBacklashInPixel)*arcsecPPix[1]/declArcsecPerMicrostep); // the drive works in microsteps, not in pixels
+        g_AllData->setBacklash(1, declBacklashInMicrosteps);
+        g_AllData->storeGlobalData();
+        ui->sbBacklashDecl->setValue(declBacklashInMicrosteps);
+    }
+    this->displayCalibrationStatus("Backlash in Decl: ", (float)g_AllData->getBacklash(1),"[microsteps]");
+    this->displayCalibrationStatus("Standard deviation: ", sdevBacklashPix,"[pix]");
+    this->applyBacklashModel(g_AllData->getBacklashCompensation());
     this->guidingState.systemIsCalibrated=true; // "systemIsCalibrated" - flag set to true
     setControlsForAutoguiderCalibration(true);
     this->guidingState.travelTime_ms_RA=travelTimeInMSForOnePixRA;
@@ -2788,6 +2961,7 @@ void MainWindow::calibrationTerminationStuffToBeDone(void) {
     this->guidingState.rotationAngle=0.0;
     ui->pbTerminateCal->setEnabled(true);
     setControlsForAutoguiderCalibration(true);
+    this->applyBacklashModel(g_AllData->getBacklashCompensation());
     this->startRATracking();
     this->startCCDAcquisition(); // starting ccd acquisition again in a permanent mode ...
     this->calibrationToBeTerminated = false;
@@ -2823,7 +2997,6 @@ void MainWindow::skipCalibration(void) {
     this->rotMatrixGuidingXToRA[0][1]=sin(avrgAngle);
     this->rotMatrixGuidingXToRA[1][0]=-sin(avrgAngle);
     this->rotMatrixGuidingXToRA[1][1]=cos(avrgAngle);
-    this->guidingState.backlashCompensationInMS=0;
     this->guidingState.calibrationIsRunning=false; // "calibrationIsRunning" - flag set to false
     this->guidingState.systemIsCalibrated=true; // "systemIsCalibrated" - flag set to true
     setControlsForAutoguiderCalibration(true);
@@ -2917,7 +3090,6 @@ void MainWindow::resetGuidingCalibration(void) {
         this->guidingState.maxDevInArcSec=0.0;
         this->guidingState.rmsDevInArcSec=0.0;
         this->guidingState.rmsDevInArcSecSum = 0.0;
-        this->guidingState.backlashCompensationInMS=0.0;
         this->guidingState.noOfGuidingSteps = 0;
         this->guidingState.st4IsActive=false;
         ui->pbGuiding->setEnabled(false);
@@ -2934,24 +3106,20 @@ void MainWindow::resetGuidingCalibration(void) {
 // prepare the GUI and the flags for autoguiding; the actual work is done
 // in "displayGuideCamImage" and "correctGuideStarPosition" ...
 void MainWindow::doAutoGuiding(void) {
+    double logValues[3];
 
     if (this->guidingState.guidingIsOn == false) {
         this->raState = guideTrack;
         this->deState = guideTrack;
         this->StepperDriveRA->changeMicroSteps(g_AllData->getMicroSteppingRatio(0));
         this->StepperDriveDecl->changeMicroSteps(g_AllData->getMicroSteppingRatio(0));
-        this->guidingState.raErrs[0] = this->guidingState.raErrs[1] =
-        this->guidingState.raErrs[2] = 0;
-        this->guidingState.declErrs[0] = this->guidingState.declErrs[1] =
-        this->guidingState.declErrs[2] = 0;
         ui->rbSiderealSpeed->setChecked(true); // make sure that sidereal speed is set...
         this->setTrackingRate();
         this->guidingState.maxDevInArcSec=0.0;
         this->guidingState.rmsDevInArcSec=0.0;
         this->guidingState.guidingIsOn = true;
         if (ui->cbLogGuidingData->isChecked()==true) {
-            this->guidingLog = new QFile("GuidingLog.tsl");
-            this->guidingLog->open((QIODevice::ReadWrite | QIODevice::Text));
+            this->guidingLog->open("GuidingLog.csv"); // a segment is started with the reference in "correctGuideStarPosition"
         }
         g_AllData->setGuidingState(this->guidingState.guidingIsOn); // this has to be known in other classes, so every "guidingIsOn" state is copied
         this->setControlsForGuiding(false);
@@ -2962,13 +3130,25 @@ void MainWindow::doAutoGuiding(void) {
         this->abortCCDAcquisition(); // stop the stream
         this->waitForCalibrationImage(); // wait to get a stable image
     } else {
+        this->guidingState.guidingIsOn = false; // first, so that "startNextCamShot" requests no more images
+        this->camera_client->getFramePipeline()->stopStarSearch();
+        this->camera_client->setSubframe(QRect()); // the full chip for the next images
         this->abortCCDAcquisition();
-        this->guidingState.guidingIsOn = false;
         this->guidingState.calibrationIsRunning=false; // "calibrationIsRunning" - flag set to false
-        if (ui->cbLogGuidingData->isChecked()==true) {
-            if (this->guidingLog != NULL) {
-                this->guidingLog->close();
-            }
+        if (this->guidingLog->isOpen() == true) {
+            logValues[0] = this->camera_client->getFramePipeline()->getStageTime(0);
+            logValues[1] = this->camera_client->getFramePipeline()->getStageTime(1);
+            logValues[2] = this->camera_client->getFramePipeline()->getStageTime(2);
+            this->guidingLog->writeParameter("pipeline_decode_detect_display_ms", logValues, 3);
+            logValues[0] = this->camera_client->getFramePipeline()->getDroppedFrames();
+            logValues[1] = this->camera_client->getFramePipeline()->getBufferAllocations();
+            this->guidingLog->writeParameter("frames_dropped_buffers_allocated", logValues, 2);
+            if (this->guideAlgorithm[0]->getPeriod() > 0) {
+                logValues[0] = this->guideAlgorithm[0]->getPeriod();
+                logValues[1] = this->guideAlgorithm[0]->getPeriodicAmplitude();
+                this->guidingLog->writeParameter("periodic_error_s_px", logValues, 2);
+            } // found by the predictive guide algorithm
+            this->guidingLog->close();
         }
         g_AllData->setGuidingState(this->guidingState.guidingIsOn); // this has to be known in other classes, so every "guidingIsOn" state is copied
         ui->pbGuiding->setText("Guide");
@@ -3009,6 +3189,27 @@ void MainWindow::selectGuideStar(void) {
     }
 }
 
+//------------------------------------------------------------------
+// slot for finding a guide star without clicking on it. the whole camera image is
+// searched, and the best star is taken as if it had been selected and confirmed
+void MainWindow::findGuideStar(void) {
+    float starX, starY, scaling;
+    QMessageBox noStarMsg;
+
+    if ((this->ccdCameraIsAcquiring==true) && (this->camImageWasReceived==true)) {
+        if (this->guiding->findGuideStar(&starX, &starY, 0, this->guidingFOVFactor) == false) {
+            qDebug() << "No guide star found in the camera image";
+            noStarMsg.setWindowTitle("TSC Guiding");
+            noStarMsg.setText("No guide star found in the camera image - the stars may be too faint, saturated or too close to each other.");
+            noStarMsg.exec();
+            return;
+        }
+        scaling = g_AllData->getCameraImageScalingFactor(false);
+        g_AllData->setInitialStarPosition(starX*scaling, starY*scaling); // like a click on the star in the camera view
+        this->confirmGuideStar();
+    }
+}
+
 //------------------------------------------------------------------
 // slot activated when the guide star is found; just enables the next GUI
 // element; everything is just the same as in "selectGuideStar()"
@@ -3062,6 +3263,29 @@ void MainWindow::displayGuideStarPreview(void) {
     ui->lPreview->setPixmap(*guideStarPrev);
 }
 
+//------------------------------------------------------------------
+// slot for the combobox that selects the estimator for the centroid of the guide star
+void MainWindow::changeCentroidMethod(void) {
+    this->guiding->setCentroidEstimator(ui->cbCentroidMethod->currentIndex());
+    this->camera_client->getFramePipeline()->setCentroidEstimator(ui->cbCentroidMethod->currentIndex());
+    g_AllData->setCentroidEstimator(ui->cbCentroidMethod->currentIndex());
+}
+
+//------------------------------------------------------------------
+// slot for the comboboxes that select the guide algorithms in RA and decl; they are locked while guiding
+void MainWindow::changeGuideAlgorithm(void) {
+    this->guideAlgorithm[0]->setMethod(ui->cbGuideAlgorithmRA->currentIndex());
+    this->guideAlgorithm[1]->setMethod(ui->cbGuideAlgorithmDecl->currentIndex());
+    g_AllData->setGuideAlgorithm(0, ui->cbGuideAlgorithmRA->currentIndex());
+    g_AllData->setGuideAlgorithm(1, ui->cbGuideAlgorithmDecl->currentIndex());
+}
+
+//------------------------------------------------------------------
+// slot for the spinbox that sets the number of stars for guiding; it is used when guiding starts
+void MainWindow::changeNumberOfGuideStars(void) {
+    g_AllData->setNumberOfGuideStars(ui->sbGuideStars->value());
+}
+
 //------------------------------------------------------------------
 // slot for storing the input from a spinbox on guide scope focal length
 void MainWindow::changeGuideScopeFL(void) {
@@ -3575,7 +3799,7 @@ void MainWindow::LXslewMount(void) {
                 lestr.append(this->generateCoordinateString(this->decl,false));
                 ui->lineEditDecl->setText(lestr);
                 ui->leLX200Decl->setText(lestr);
-                this->startGoToObject();
+                this->startGoToObject(false);
             }
         }
     }
@@ -4027,6 +4251,8 @@ void MainWindow::killHandBoxMotion(void) {
 // slot called by timeout of ST4Timer
 void MainWindow::readST4Port(void) {
     if (this->guidingState.st4IsActive== true) {
+        this->StepperDriveRA->finishBacklashTakeUp();
+        this->StepperDriveDecl->finishBacklashTakeUp(); // a correction starts without waiting for the event queue
         this->handleST4State();
     }
 }
@@ -4063,6 +4289,7 @@ void MainWindow::startST4Guiding(void) {
     ui->pbClearLXLog->setEnabled(false);
     ui->photoTab->setEnabled(false);
     ui->locationTab->setEnabled(false);
+    ui->sequenceTab->setEnabled(false);
     this->commSPIParams.guiData->clear(); // now fill the SPI queue with ST4 state requests
     this->commSPIParams.guiData->append("g");
     this->spiDrOnChan0->spidrReceiveCommand(*commSPIParams.guiData);
@@ -4097,6 +4324,7 @@ void MainWindow::stopST4Guiding(void) {
     ui->cbLXSimpleNumbers->setEnabled(true);
     ui->photoTab->setEnabled(true);
     ui->locationTab->setEnabled(true);
+    ui->sequenceTab->setEnabled(true);
     ui->cbLX200Logs->setEnabled(true);
     ui->pbClearLXLog->setEnabled(true);
     ui->pbStartST4->setEnabled(true);
@@ -4261,7 +4489,12 @@ void MainWindow::declinationPulseGuide(long pulseDurationInMS, short direction)
     deTimer = new QElapsedTimer();
     this->StepperDriveDecl->travelForNSteps(direction,(float)ui->sbGuidingRate->value());
     deTimer->start();
-    while (deTimer->elapsed() < pulseDurationInMS);
+    this->recordFlightData(TSC_FlightRecorder::frGuidePulseDecl, 0, direction*pulseDurationInMS);
+    while (deTimer->elapsed() < pulseDurationInMS) {
+        if (this->StepperDriveDecl->finishBacklashTakeUp() == true) {
+            deTimer->restart();
+        } // the pulse starts once the slack is taken up
+    }
     this->StepperDriveDecl->stopDrive();
     this->StepperDriveDecl->resetSteppersAfterStop();
     delete deTimer;
@@ -4329,14 +4562,19 @@ void MainWindow::raPulseGuide(long pulseDurationInMS, short direction) { // to b
     raTimer = new QElapsedTimer();
 
     if (direction > 0) {
-        this->StepperDriveDecl->travelForNSteps(1,(float)(1+ui->sbGuidingRate->value()));
+        this->StepperDriveRA->travelForNSteps(1,(float)(1+ui->sbGuidingRate->value()));
     } else {
-        this->StepperDriveDecl->travelForNSteps(1,(float)(1-ui->sbGuidingRate->value()));
+        this->StepperDriveRA->travelForNSteps(1,(float)(1-ui->sbGuidingRate->value()));
     }
     raTimer->start();
-    while (raTimer->elapsed() < pulseDurationInMS);
-    this->StepperDriveDecl->stopDrive();
-    this->StepperDriveDecl->resetSteppersAfterStop();
+    this->recordFlightData(TSC_FlightRecorder::frGuidePulseRA, direction*pulseDurationInMS, 0);
+    while (raTimer->elapsed() < pulseDurationInMS) {
+        if (this->StepperDriveRA->finishBacklashTakeUp() == true) {
+            raTimer->restart();
+        } // the pulse starts once the slack is taken up
+    }
+    this->StepperDriveRA->stopDrive();
+    this->StepperDriveRA->resetSteppersAfterStop();
     delete raTimer;
 
     this->mountMotion.RADriveIsMoving=false;
@@ -4348,21 +4586,6 @@ void MainWindow::raPulseGuide(long pulseDurationInMS, short direction) { // to b
     this->setControlsForRATravel(true);
 }
 
-//-----------------------------------------------------------------------
-// this one is called during guiding. it compensates for declination backlash if
-// the direction changes.
-void MainWindow::compensateDeclBacklashPG(short ddir) { // to be revised
-    long compSteps;
-
-    if (this->guidingState.systemIsCalibrated == true) { // compensate backlash only if system was calibrated ...
-        compSteps=round(g_AllData->getCelestialSpeed()*(g_AllData->getGearData(4))*
-                (g_AllData->getGearData(5)*(g_AllData->getGearData(6)*
-                (g_AllData->getMicroSteppingRatio(0)/(g_AllData->getGearData(7)))*
-                (this->guidingState.backlashCompensationInMS/1000.0)))); // sidereal speed in declination*compensation time in s == # of steps for compensation
-        this->StepperDriveDecl->travelForNSteps(compSteps, ddir, 1,false);
-    }
-}
-
 //-----------------------------------------------------------------------
 //-----------------------------------------------------------------------
 //-----------------------------------------------------------------------
@@ -4376,11 +4599,14 @@ void MainWindow::setControlsForGuiding(bool isEnabled) {
     ui->sbExposureTime->setEnabled(isEnabled);
     ui->tabCCDAcq->setEnabled(isEnabled);
     ui->pbSelectGuideStar->setEnabled(isEnabled);
+    ui->pbFindGuideStar->setEnabled(isEnabled);
     ui->hsThreshold->setEnabled(isEnabled);
     ui->hsIContrast->setEnabled(isEnabled);
     ui->hsIBrightness->setEnabled(isEnabled);
     ui->cbMedianFilter->setEnabled(isEnabled);
     ui->cbLowPass->setEnabled(isEnabled);
+    ui->cbCentroidMethod->setEnabled(isEnabled);
+    ui->sbGuideStars->setEnabled(isEnabled);
     ui->rbFOVDbl->setEnabled(isEnabled);
     ui->rbFOVHalf->setEnabled(isEnabled);
     ui->rbFOVStd->setEnabled(isEnabled);
@@ -4391,6 +4617,8 @@ void MainWindow::setControlsForGuiding(bool isEnabled) {
     ui->hsThreshold->setEnabled(isEnabled);
     ui->gbAuxdrives->setEnabled(isEnabled);
     ui->sbMaxDevInGuiding->setEnabled(isEnabled);
+    ui->cbGuideAlgorithmRA->setEnabled(isEnabled);
+    ui->cbGuideAlgorithmDecl->setEnabled(isEnabled);
     ui->cbDeclBacklashComp->setEnabled(isEnabled);
     ui->cbLogGuidingData->setEnabled(isEnabled);
     ui->pbResetGdErr->setEnabled(isEnabled);
@@ -4578,6 +4806,11 @@ void MainWindow::catalogChosen(QListWidgetItem* catalogName) {
     ui->listWidgetCatalog->blockSignals(true);
     if (this->objCatalog != NULL) {
         delete this->objCatalog;
+        this->objCatalog = NULL;
+    }
+    if (this->ephemeris != NULL) {
+        delete this->ephemeris;
+        this->ephemeris = NULL;
     }
     if (g_AllData->wasMountSynced() == true) {
         ui->pbGoTo->setEnabled(true);
@@ -4586,15 +4819,28 @@ void MainWindow::catalogChosen(QListWidgetItem* catalogName) {
     catalogPath = new QString("Catalogs/");
     catName = new QString(catalogName->text());
     catalogPath->append(catName);
-    catalogPath->append(QString(".tsc"));
-    this->objCatalog = new currentObjectCatalog(*catalogPath);
-    maxObj = this->objCatalog->getNumberOfObjects();
     ui->listWidgetObject->clear();
-    for (counterForObjects = 0; counterForObjects < maxObj; counterForObjects++) {
-        objectName=this->objCatalog->getNamesOfObjects(counterForObjects);
-        ui->listWidgetObject->addItem(QString(objectName.data()));
+    this->catalogPositions->clear();
+    if (catName->endsWith(".tse") == true) { // an ephemeris holds a single moving object
+        this->ephemeris = new ephemerisTable(*catalogPath);
+        if (this->ephemeris->isValid() == true) {
+            ui->listWidgetObject->addItem(QString(this->ephemeris->getNameOfObject().data()));
+        } else {
+            qDebug() << "Ephemeris" << catalogPath->toLatin1() << "could not be read";
+        }
+        ui->lcdCatEpoch->display(QString::number(QDate::currentDate().year())); // positions are given for the equinox of date
+    } else {
+        catalogPath->append(QString(".tsc"));
+        this->objCatalog = new currentObjectCatalog(*catalogPath);
+        maxObj = this->objCatalog->getNumberOfObjects();
+        for (counterForObjects = 0; counterForObjects < maxObj; counterForObjects++) {
+            objectName=this->objCatalog->getNamesOfObjects(counterForObjects);
+            ui->listWidgetObject->addItem(QString(objectName.data()));
+            this->catalogPositions->addObject(this->objCatalog->getRADec(counterForObjects), this->objCatalog->getDeclDec(counterForObjects));
+        }
+        ui->lcdCatEpoch->display(QString::number(this->objCatalog->getEpoch()));
     }
-    ui->lcdCatEpoch->display(QString::number(this->objCatalog->getEpoch()));
+    this->updateCatalogVisibility();
     ui->listWidgetCatalog->blockSignals(false);
     delete catalogPath;
     delete catName;
@@ -4640,6 +4886,20 @@ void MainWindow::catalogObjectChosen(void) {
         ui->lineEditDecl->setText(lestr);
         ui->pbSync->setEnabled(true);
     }
+    if ((this->ephemeris != NULL) && (indexInList == 0)) { // moving objects are taken at their position right now
+        if (this->ephemeris->getPosition(this->getCurrentJulianDate(), &epRA, &epDecl) == true) {
+            this->ra=epRA;
+            this->decl=epDecl;
+            lestr.append(this->generateCoordinateString(this->ra,true));
+            ui->lineEditRA->setText(lestr);
+            lestr.clear();
+            lestr.append(this->generateCoordinateString(this->decl,false));
+            ui->lineEditDecl->setText(lestr);
+            ui->pbSync->setEnabled(true);
+        } else {
+            qDebug() << "The ephemeris does not cover the current date";
+        }
+    }
 }
 
 //------------------------------------------------------------------
@@ -4849,6 +5109,7 @@ void MainWindow::storeSiteData(void)  {
     g_AllData->setSiteParams(guilat,guilong,guiUTCOffs);
     g_AllData->setSiteParams(ui->leControllerName->text());
     g_AllData->storeGlobalData();
+    this->updateHorizonMask(); // the altitude of the targets depends on the latitude
 }
 
 //----------------------------------------------------------------------
@@ -5058,7 +5319,7 @@ void MainWindow::updateDSLRGUIAndCountdown(void) {
 
     remTime = (this->dslrStates.dslrExpTime - round(this->dslrStates.dslrExpElapsed.elapsed()/1000.0));
     ui->lcdDSLRTimeRemaining->display(QString::number(remTime));
-    if (this->dslrStates.dslrExpElapsed.elapsed() > this->ui->sbDSLRDuration->value()*1000) {
+    if (this->dslrStates.dslrExpElapsed.elapsed() > this->dslrStates.dslrExpTime*1000) {
         digitalWrite(1,0); // set wiring pi pin 1=tip/expose to low ...
         this->waitForNMSecs(250);
         ui->pbDSLRSingleShot->setEnabled(true);
@@ -5094,7 +5355,11 @@ void MainWindow::startDSLRSeries(void) {
         ui->sbDSLRRepetitions->setEnabled(false);
         ui->lcdDSLRExpsDone->display("1");
         this->dslrStates.dslrExpElapsed.restart();
-        this->handleDSLRSingleExposure();
+        if (this->mfIsDue(ui->sbDSLRDuration->value()) == true) {
+            this->mflipState.seriesOnHold = true; // the series starts after the flip
+        } else {
+            this->handleDSLRSingleExposure();
+        }
         ui->sbPauseBetweenExpSeries->setEnabled(false);
     }
 }
@@ -5119,6 +5384,10 @@ void MainWindow::takeNextExposureInSeries(void) {
         ui->cbDither->setEnabled(false);
         this->dslrStates.noOfExposuresLeft--;
         expsTaken=this->dslrStates.noOfExposures-this->dslrStates.noOfExposuresLeft;
+        if (this->mfIsDue(ui->sbDSLRDuration->value()+pauseBetweenExpsInMS/1000.0) == true) {
+            this->mflipState.seriesOnHold = true; // the next exposure would not end before the flip limit;
+            return; // "updateMeridianFlip" carries out the flip and resumes the series
+        }
 
         if (this->guidingState.guidingIsOn == true) {
             inGuiding = true; // dithering turns guiding off; after that, the routine waits until guiding is on again.
@@ -5310,6 +5579,9 @@ void MainWindow::getTemperature(void) {
     float lTmp = 0;
     char lastC;
 
+    if (this->encoderState.isReading == true) {
+        return; // the encoders are read via the HAT arduino right now; the temperature is read in the next call
+    }
     this->commSPIParams.guiData->clear();
     this->commSPIParams.guiData->append("p");
     this->spiDrOnChan0->spidrReceiveCommand(*commSPIParams.guiData);
@@ -5356,6 +5628,7 @@ void MainWindow::getTemperature(void) {
         if (lTmp > -40) {
             this->temperature = lTmp;
             ui->lcdTemp->display(this->temperature);
+            this->refraction->setAtmosphericConditions(this->temperature, g_AllData->getAtmosphericPressure());
         } else {
             this->temperature = 0;
             ui->lcdTemp->display('-');
@@ -5887,6 +6160,7 @@ void MainWindow::mountIsGerman(void) {
 void MainWindow::mountIsEast(void) {
 
     if (ui->cbIsGEM->isChecked() == true) {
+        this->StepperDriveDecl->refreshStepCounter(); // the steps of the last move are counted with the old declination sign
         if (ui->cbMountIsEast->isChecked() == true) {
             g_AllData->setMFlipParams(1,true);
             g_AllData->setDeclinationSign(1); // sets the declination sign
@@ -5917,108 +6191,807 @@ void MainWindow::setTimeFromLX200Flag(void) {
 //-------------------------------------------------------------------------
 //-------------------------------------------------------------------------
 //-------------------------------------------------------------------------
-// plate solving routines -------------------------------------------------
-// this is a dummy by now ...
-void MainWindow::psTakeImage(void) {
-   // QImage *solveImage;
-    QString *pth;
-
-    ui->pbSolveFieldPS->setEnabled(false);
-    ui->pbSyncPS->setEnabled(false);
-    if (g_AllData->getPathToImages().length() != 0) {
-        pth = new QString(g_AllData->getPathToImages().toLatin1());
-        pth->append("bubble.fits");
-        g_AllData->setPathToImageToBeSolved(pth->toLatin1());
-        delete pth;
-        ui->pbSolveFieldPS->setEnabled(true);
+// routines for correcting GoTo and tracking for atmospheric refraction and for tracking moving objects
 
+//-------------------------------------------------------------------------
+// a slot for storing whether refraction is taken into account
+void MainWindow::setRefractionCorrection(void) {
+    if (ui->cbRefraction->isChecked() == true) {
+        g_AllData->setRefractionCorrection(true);
     } else {
-        qDebug() << "no path to images available";
+        g_AllData->setRefractionCorrection(false);
     }
+    g_AllData->storeGlobalData(); // save the value to the preferences
+    this->updateTrackingRates(); // go back to the plain celestial speed if nothing else modifies it
 }
 
-//--------------------------------------------------------------------------
-// slot for choosing a directory
-void MainWindow::psChooseFITSDirectory(void) {
-    QFileDialog dialog;
-    QString theChosenPath;
+//-------------------------------------------------------------------------
+// a slot for the ambient pressure; there is no barometer on the HAT, so it is entered on the main tab
+void MainWindow::setAtmosphericPressure(void) {
+    g_AllData->setAtmosphericPressure((float)ui->sbPressure->value());
+    this->refraction->setAtmosphericConditions(this->temperature, g_AllData->getAtmosphericPressure());
+    g_AllData->storeGlobalData(); // save the value to the preferences
+}
 
-    dialog.setFileMode(QFileDialog::DirectoryOnly);
-    dialog.setOption(QFileDialog::ShowDirsOnly, true);
-    dialog.exec();
-    if (dialog.selectedFiles().empty() == false) {
-        theChosenPath = (dialog.selectedFiles().at(0));
-        const QFileInfo newDir(theChosenPath.toLatin1()) ;
-        if (newDir.exists() && newDir.isDir() && newDir.isReadable() && newDir.isWritable()) {
-            theChosenPath.append("/");
-            g_AllData->setPathToImages(theChosenPath);
-            ui->lePathToFitsFile->setText(g_AllData->getPathToImages());
+//-------------------------------------------------------------------------
+// a slot that switches tracking of a comet, asteroid or satellite on and off. the rates from the
+// ephemeris are relative to the stars, therefore the mount has to track at sidereal speed
+void MainWindow::setEphemerisTracking(void) {
+    if (ui->cbEphemerisTracking->isChecked() == true) {
+        if (ui->rbSiderealSpeed->isChecked() == false) {
+            g_AllData->setCelestialSpeed(0);
+            ui->rbSiderealSpeed->setChecked(true);
+            if (this->mountMotion.RATrackingIsOn == true) {
+                this->stopRATracking();
+                this->startRATracking();
+            }
         }
     }
+    this->updateTrackingRates();
 }
 
-//---------------------------------------------------------------------------
-// slot that triggers astrometry.net
-void MainWindow::psStartSolving(void) {
-    QString* solveCommand;
-
-    double fieldSize, slow, maxSize;
-    short dsFact = 1;
+//-------------------------------------------------------------------------
+// converts catalog coordinates to the position where the object is actually seen;
+// does nothing if refraction correction is switched off
+void MainWindow::correctTargetForRefraction(float *lra, float *ldecl) {
+    double appRA, appDecl;
 
-    ui->cbFieldSolved->setChecked(false);
-    ui->pbKillAMetry->setEnabled(true);
-    ui->cbPSInProgress->setChecked(true);
-    g_AllData->setBooleanPSParams(0,true); // platesolving in progress
-    g_AllData->setBooleanPSParams(1,false); // no success so far
-    g_AllData->setBooleanPSParams(2, false); // no error so far
-    if (g_AllData->getCameraPixelSize(0,true) >= g_AllData->getCameraPixelSize(1,true)) {
-        maxSize = (g_AllData->getCameraChipPixels(0,true));
-    } else {
-        maxSize = (g_AllData->getCameraChipPixels(1,true));
-    }
-    if (maxSize > 2000) {
-        dsFact = 2;
-    }
-    if (maxSize > 4000) {
-        dsFact = 4;
-    }
-    this->waitForNMSecs(250);
-    fieldSize = 2*this->psComputeFOVForMainCCD();
-    slow = fieldSize/3.0;
-    solveCommand = new QString("solve-field --ra ");
-    solveCommand->append(QString::number((double)g_AllData->getActualScopePosition(2),'g',6));
-    solveCommand->append(" --dec ");
-    solveCommand->append(QString::number((double)g_AllData->getActualScopePosition(1),'g',6));
-    solveCommand->append(" --radius ");
-    solveCommand->append(QString::number((double)(ui->sbPSSearchRad->value())));
-    solveCommand->append(" --scale-units degwidth --overwrite --match none --rdls none --wcs none --no-plots ");
-    solveCommand->append(" --scale-low ");
-    solveCommand->append(QString::number(slow));
-    solveCommand->append(" --scale-high ");
-    solveCommand->append(QString::number(fieldSize));
-    solveCommand->append(" --downsample ");
-    solveCommand->append(QString::number(dsFact));
-    solveCommand->append(" ");
-    solveCommand->append(g_AllData->getPathToImageToBeSolved().toLatin1());
-    qDebug() << "Process command: " << solveCommand->toLatin1();
-    this->astroMetryProcess->start(solveCommand->toLatin1());
-    if (!this->astroMetryProcess->waitForStarted()) {
-        g_AllData->setBooleanPSParams(0,false);
-        g_AllData->setBooleanPSParams(2, true);
-        qDebug() << "Process did not start ...";
+    if (g_AllData->getRefractionCorrection() == true) {
+        this->refraction->getApparentPosition(*lra, *ldecl, g_AllData->getLocalSTime(), g_AllData->getSiteCoords(0),
+                                              &appRA, &appDecl);
+        *lra = appRA;
+        *ldecl = appDecl;
     }
-    delete solveCommand;
-    ui->Control->setCursor(Qt::BusyCursor);
-    connect(this->astroMetryProcess, SIGNAL(readyReadStandardOutput()), this, SLOT(psDisplayAstrometryNetOutput()));
 }
 
-//-----------------------------------------------------------------------------
-// a slot for setting the search radius
-void MainWindow::psSetSearchRadiusForPS(void) {
-    double val;
+//-------------------------------------------------------------------------
+// the julian date including the fraction of the day; this->julianDay refers to 0h UT
+double MainWindow::getCurrentJulianDate(void) {
+    double secSinceMidnight;
 
-    val = ui->sbPSSearchRad->value();
-    g_AllData->setPSSearchRad(val);
+    secSinceMidnight=UTTime->currentTime().hour()*3600.0+UTTime->currentTime().minute()*60.0+UTTime->currentTime().second()+UTTime->currentTime().msec()/1000.0;
+    return (this->julianDay + secSinceMidnight/86400.0);
+}
+
+//-------------------------------------------------------------------------
+// halts the slow motion of the declination drive; microsteps not yet carried out are dropped
+void MainWindow::stopDeclTracking(void) {
+    if (this->StepperDriveDecl->getTrackingSpeed() != 0) {
+        this->StepperDriveDecl->stopDrive();
+    }
+    this->declStepsPending = 0;
+}
+
+//-------------------------------------------------------------------------
+// slot called by trackingRateTimer. refraction changes with altitude, and comets, asteroids and satellites move
+// relative to the stars. both add a rate in hour angle on top of the celestial speed of the RA drive and a rate
+// in declination, and so does the correction from the tracking calibration. the drives only run at integer
+// numbers of microsteps/s; the speeds are therefore chosen so that the fractions of microsteps add up, which
+// also covers rates below 1 microstep/s. the RA drive switches between the two speeds next to its rate only when
+// it is more than a quarter of an arcsecond ahead or behind, so "v" is not sent in every interval
+void MainWindow::updateTrackingRates(void) {
+    double trueRA, trueDecl, haRate = 0, declRate = 0, ephRARate, ephDeclRate, calRARate, calDeclRate,
+           convertDegreesToMicrostepsRA, convertDegreesToMicrostepsDecl, intervalInS, raRateInSteps;
+    long raSpeed, declSpeed;
+    bool ratesAreActive = false;
+
+    if ((this->mountMotion.RADriveIsMoving == true) || (this->mountMotion.DeclDriveIsMoving == true) ||
+            (this->mountMotion.GoToIsActiveInRA == true) || (this->mountMotion.GoToIsActiveInDecl == true) ||
+            (this->guidingState.st4IsActive == true) || (this->guidingState.calibrationIsRunning == true) ||
+            (this->guidingState.correctionIsRunning == true) || (this->guidingState.guidingIsOn == true)) {
+        return; // correct only if nothing else is moving the drives; tracking is resumed afterwards
+    }
+    if ((this->mountMotion.RATrackingIsOn == true) && (g_AllData->wasMountSynced() == true)) {
+        if (g_AllData->getRefractionCorrection() == true) {
+            this->refraction->getTruePosition(g_AllData->getActualScopePosition(2), g_AllData->getActualScopePosition(1),
+                                              g_AllData->getLocalSTime(), g_AllData->getSiteCoords(0), &trueRA, &trueDecl);
+            this->refraction->getRefractionRates(trueRA, trueDecl, g_AllData->getLocalSTime(), g_AllData->getSiteCoords(0),
+                                                 &haRate, &declRate);
+            ratesAreActive = true;
+        }
+        if ((ui->cbEphemerisTracking->isChecked() == true) && (this->ephemeris != NULL)) {
+            if (this->ephemeris->getRates(this->getCurrentJulianDate(), &ephRARate, &ephDeclRate) == true) {
+                haRate -= ephRARate; // an object moving eastwards lags behind the stars
+                declRate += ephDeclRate;
+                ratesAreActive = true;
+            }
+        }
+        if (g_AllData->getPositionSource() != 0) {
+            haRate += this->encoderFusion->getTrackingRate(); // make up for slip of the RA gears measured by the encoder
+        }
+        if (g_AllData->getTrackingCalibrationCorrection() == true) {
+            this->driftCalibration->getDriftRates(g_AllData->getLocalSTime()*15.0 - g_AllData->getActualScopePosition(2),
+                                                  g_AllData->getActualScopePosition(1), &calRARate, &calDeclRate);
+            haRate += calRARate; // the RA drive turns too slowly, or the tilted polar axis carries the field off
+            declRate -= calDeclRate;
+            ratesAreActive = true;
+        }
+    }
+    this->StepperDriveRA->setTrackingRateOffset(haRate); // the speed at which tracking starts again after a slew or a guide pulse
+    intervalInS = this->trackingRateTimer->interval()/1000.0;
+    if ((this->mountMotion.RATrackingIsOn == true) && (this->StepperDriveRA->getStopped() == false)) {
+        convertDegreesToMicrostepsRA=1.0/g_AllData->getGearData(3)*g_AllData->getMicroSteppingRatio(0)*
+                g_AllData->getGearData(0)*g_AllData->getGearData(1)*g_AllData->getGearData(2);
+        raRateInSteps = (g_AllData->getCelestialSpeed() + haRate)*convertDegreesToMicrostepsRA;
+        this->raStepsPending += raRateInSteps*intervalInS;
+        raSpeed = this->StepperDriveRA->getTrackingSpeed();
+        if (fabs(this->raStepsPending - raSpeed*intervalInS) > fmax(0.25/3600.0*convertDegreesToMicrostepsRA, intervalInS)) {
+            if (this->raStepsPending > raSpeed*intervalInS) {
+                raSpeed = ceil(raRateInSteps);
+            } else {
+                raSpeed = floor(raRateInSteps);
+            }
+        } // the drive keeps its speed while it is less than 0.25 arcsec, and at least one microstep/s times the interval, off
+        this->raStepsPending -= raSpeed*intervalInS;
+        this->StepperDriveRA->adjustTrackingSpeed(raSpeed); // sent on the fly and only if the speed changes, the drive does not stop
+    } else {
+        this->raStepsPending = 0;
+    }
+    if (ratesAreActive == false) {
+        this->stopDeclTracking();
+        return;
+    }
+    convertDegreesToMicrostepsDecl=1.0/g_AllData->getGearData(7)*g_AllData->getMicroSteppingRatio(0)*
+            g_AllData->getGearData(4)*g_AllData->getGearData(5)*g_AllData->getGearData(6);
+    this->declStepsPending += declRate*intervalInS*convertDegreesToMicrostepsDecl;
+    declSpeed = lround(this->declStepsPending/intervalInS);
+    this->declStepsPending -= declSpeed*intervalInS; // the remainder is carried out in the next interval
+    if (declSpeed != this->StepperDriveDecl->getTrackingSpeed()) {
+        if (declSpeed == 0) {
+            this->StepperDriveDecl->stopDrive();
+        } else {
+            if (this->StepperDriveDecl->getTrackingSpeed() == 0) {
+                this->deState = guideTrack;
+                this->StepperDriveDecl->changeMicroSteps(g_AllData->getMicroSteppingRatio(0));
+                this->mountMotion.DeclTrackingElapsedTimeInMS = g_AllData->getTimeSinceLastSync();
+            }
+            if (declSpeed < 0) {
+                this->mountMotion.DeclDriveDirection = -1*g_AllData->getMFlipDecSign();
+            } else {
+                this->mountMotion.DeclDriveDirection = g_AllData->getMFlipDecSign();
+            } // the direction is kept like for the other decl motions, see updateReadings
+            this->StepperDriveDecl->startTracking(declSpeed);
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+//-------------------------------------------------------------------------
+//-------------------------------------------------------------------------
+// routines for unattended sessions with a sequence of targets
+
+//-------------------------------------------------------------------------
+// a slot that adds the object chosen in the catalog tab together with the exposure plan
+void MainWindow::seqAddObject(void) {
+    if (ui->listWidgetObject->currentItem() == NULL) {
+        qDebug() << "No catalog object chosen";
+        return;
+    }
+    this->sequencer->addTarget(ui->listWidgetObject->currentItem()->text().toStdString(), this->ra, this->decl,
+                               ui->sbSeqExposures->value(), ui->sbSeqExpTime->value());
+    this->seqUpdateList();
+}
+
+//-------------------------------------------------------------------------
+// a slot that reads a list of targets from a ".tsq" file
+void MainWindow::seqLoadSequence(void) {
+    QString fileName;
+
+    fileName = QFileDialog::getOpenFileName(this, "Load Sequence", "Catalogs/", "Sequences (*.tsq)");
+    if (fileName.isEmpty() == false) {
+        if (this->sequencer->loadTargets(fileName) == false) {
+            qDebug() << "Could not read sequence" << fileName.toLatin1();
+        }
+        this->seqUpdateList();
+    }
+}
+
+//-------------------------------------------------------------------------
+void MainWindow::seqRemoveObject(void) {
+    this->sequencer->removeTarget(ui->listWidgetSequence->currentRow());
+    this->seqUpdateList();
+}
+
+//-------------------------------------------------------------------------
+void MainWindow::seqClearSequence(void) {
+    this->sequencer->clearTargets();
+    this->seqUpdateList();
+}
+
+//-------------------------------------------------------------------------
+// sorts the targets starting from the current position of the mount and displays the estimated duration
+void MainWindow::seqOptimizeOrder(void) {
+    double overheadInS = 5.0, duration;
+
+    if (ui->cbSeqVerifyPS->isChecked() == true) {
+        overheadInS += 60.0; // a rough guess for taking an image and solving it
+    }
+    this->seqSetSlewParameters();
+    duration = this->sequencer->optimizeOrder(g_AllData->getLocalSTime(), g_AllData->getActualScopePosition(2),
+                                              g_AllData->getActualScopePosition(1), overheadInS);
+    ui->lcdSeqETA->display(round(duration/60.0));
+    this->seqUpdateList();
+}
+
+//-------------------------------------------------------------------------
+// a slot that starts the session; the mount has to be synced
+void MainWindow::seqStart(void) {
+    if ((this->sequencer->getNumberOfTargets() == 0) || (g_AllData->wasMountSynced() == false)) {
+        ui->leSeqState->setText("Nothing to do or mount not synced");
+        return;
+    }
+    this->sequencerState.currentTarget = 0;
+    this->sequencerState.verificationAttempts = 0;
+    this->sequencerState.step = sqStartSlew;
+    this->seqSetControls(false);
+    this->sequencerTimer->start(1000);
+}
+
+//-------------------------------------------------------------------------
+// a slot that ends the session; a running exposure series or plate solving process is terminated as well
+void MainWindow::seqStop(void) {
+    sequencerStep lastStep;
+
+    this->sequencerTimer->stop();
+    lastStep = this->sequencerState.step;
+    this->sequencerState.step = sqIdle;
+    if ((lastStep == sqExposing) && (this->dslrStates.dslrSeriesRunning == true)) {
+        this->terminateDSLRSeries();
+    }
+    if ((lastStep == sqPSExposing) && (this->dslrStates.dslrExposureIsRunning == true)) {
+        this->terminateDSLRSingleShot();
+    }
+    if ((lastStep == sqSolving) && (this->astroMetryProcess->state() != QProcess::NotRunning)) {
+        this->psKillAstrometryNet();
+    }
+    this->seqSetControls(true);
+    ui->leSeqState->setText("Stopped");
+}
+
+//-------------------------------------------------------------------------
+// slot called by sequencerTimer. every call checks whether the current step is finished and starts the next one;
+// slews, plate solving and exposures run on their own in the meantime. the pointing is verified on a new exposure
+// of the main camera; without a new image, the exposures are taken without verification
+void MainWindow::updateSequencer(void) {
+    const qint64 settlingTimeInMS = 3000; // let the mount calm down before an image is taken
+    const int psExposureTimeInS = 10;
+    const qint64 imageTimeoutInMS = 120000; // time for the camera software to write the image after the exposure
+    const qint64 solvingTimeoutInMS = 180000;
+    const short maxVerificationAttempts = 2; // number of re-slews if the mount does not point at the target
+    double deviation, tolerance, raRad, declRad, psRARad, psDeclRad;
+    long idx;
+    QString stateText;
+
+    if ((this->sequencerState.isBusy == true) || (this->sequencerState.step == sqIdle)) {
+        return;
+    } // the routines called below process events, so this slot may be called again before it has finished
+    this->sequencerState.isBusy = true;
+    idx = this->sequencerState.currentTarget;
+    switch (this->sequencerState.step) {
+    case sqStartSlew:
+        if (idx >= this->sequencer->getNumberOfTargets()) {
+            this->sequencerTimer->stop();
+            this->sequencerState.step = sqIdle;
+            this->seqSetControls(true);
+            ui->leSeqState->setText("Sequence done");
+            break;
+        }
+        stateText = QString("Slewing to ") + QString(this->sequencer->getTargetName(idx).data()) + QString(" (") +
+                QString::number(idx+1) + QString("/") + QString::number(this->sequencer->getNumberOfTargets()) + QString(")");
+        ui->leSeqState->setText(stateText);
+        ui->listWidgetSequence->setCurrentRow(idx);
+        this->ra = this->sequencer->getTargetCoordinates(idx, 0);
+        this->decl = this->sequencer->getTargetCoordinates(idx, 1);
+        if (this->isTargetReachable(this->ra, this->decl) == false) {
+            qDebug() << "Sequencer: skipping" << this->sequencer->getTargetName(idx).data() << "- it cannot be reached";
+            this->sequencerState.currentTarget++;
+            break;
+        } // the next target is tried on the next call
+        this->sequencerState.step = sqSlewing;
+        this->startGoToObject(false);
+        if ((this->mountMotion.GoToIsActiveInRA == false) && (this->mountMotion.GoToIsActiveInDecl == false)) {
+            qDebug() << "Sequencer: skipping" << this->sequencer->getTargetName(idx).data() << "- no clear path";
+            this->sequencerState.step = sqStartSlew;
+            this->sequencerState.currentTarget++;
+        } // the GoTo was not started
+        break;
+    case sqSlewing:
+        if ((this->mountMotion.GoToIsActiveInRA == false) && (this->mountMotion.GoToIsActiveInDecl == false)) {
+            this->sequencerState.step = sqSettling;
+            this->sequencerState.stepElapsed.start();
+        }
+        break;
+    case sqSettling:
+        if (this->sequencerState.stepElapsed.elapsed() > settlingTimeInMS) {
+            if ((ui->cbSeqVerifyPS->isChecked() == true) && (g_AllData->getPathToImages().length() != 0)) {
+                ui->leSeqState->setText("Exposing for plate solving");
+                this->sequencerState.step = sqPSExposing;
+                this->sequencerState.stepElapsed.start();
+                this->psExposeImage(psExposureTimeInS);
+            } else {
+                this->seqStartExposures();
+            }
+        }
+        break;
+    case sqPSExposing:
+        if (this->psNewImageIsAvailable() == true) {
+            ui->leSeqState->setText("Plate solving");
+            this->sequencerState.step = sqSolving;
+            this->sequencerState.stepElapsed.start();
+            this->psStartSolving();
+        } else if ((this->dslrStates.dslrExposureIsRunning == false) &&
+                   (this->sequencerState.stepElapsed.elapsed() > psExposureTimeInS*1000 + imageTimeoutInMS)) {
+            qDebug() << "Sequencer: no new image from the main camera, exposures are taken without verification";
+            this->seqStartExposures();
+        }
+        break;
+    case sqSolving:
+        if ((g_AllData->getBooleanPSParams(0) == false) && (this->astroMetryProcess->state() == QProcess::NotRunning)) {
+            if (g_AllData->getBooleanPSParams(1) == true) {
+                raRad = this->ra/180.0*M_PI;
+                declRad = this->decl/180.0*M_PI;
+                psRARad = this->psRA/180.0*M_PI;
+                psDeclRad = this->psDecl/180.0*M_PI;
+                deviation = acos(fmin(1.0, sin(declRad)*sin(psDeclRad) + cos(declRad)*cos(psDeclRad)*cos(raRad - psRARad)))/M_PI*180.0;
+                tolerance = this->psComputeFOVForMainCCD()/10.0;
+                if ((deviation > tolerance) && (this->sequencerState.verificationAttempts < maxVerificationAttempts)) {
+                    this->sequencerState.verificationAttempts++;
+                    this->syncPSCoordinates(); // the mount is synced where it really points ...
+                    this->ra = this->sequencer->getTargetCoordinates(idx, 0);
+                    this->decl = this->sequencer->getTargetCoordinates(idx, 1);
+                    this->sequencerState.step = sqStartSlew; // ... and the target is approached again
+                    break;
+                }
+            } else {
+                qDebug() << "Plate solving failed, exposures are taken nevertheless";
+            }
+            this->seqStartExposures();
+        } else {
+            if (this->sequencerState.stepElapsed.elapsed() > solvingTimeoutInMS) {
+                this->psKillAstrometryNet(); // the next call finds the process finished without success
+            }
+        }
+        break;
+    case sqExposing:
+        if ((this->dslrStates.dslrSeriesRunning == false) && (this->dslrStates.dslrExposureIsRunning == false)) {
+            this->sequencerState.currentTarget++;
+            this->sequencerState.verificationAttempts = 0;
+            this->sequencerState.step = sqStartSlew;
+        }
+        break;
+    default:
+        break;
+    }
+    this->sequencerState.isBusy = false;
+}
+
+//-------------------------------------------------------------------------
+// starts the exposure series for the current target with the DSLR routines
+void MainWindow::seqStartExposures(void) {
+    long idx;
+
+    idx = this->sequencerState.currentTarget;
+    ui->leSeqState->setText(QString("Exposing ") + QString(this->sequencer->getTargetName(idx).data()));
+    this->sequencerState.step = sqExposing;
+    ui->sbDSLRDuration->setValue(round(this->sequencer->getExposureTime(idx)));
+    ui->sbDSLRRepetitions->setValue(this->sequencer->getNumberOfExposures(idx));
+    this->startDSLRSeries();
+}
+
+//-------------------------------------------------------------------------
+void MainWindow::seqUpdateList(void) {
+    long idx;
+    QString entry;
+
+    ui->listWidgetSequence->clear();
+    for (idx = 0; idx < this->sequencer->getNumberOfTargets(); idx++) {
+        entry = QString(this->sequencer->getTargetName(idx).data()) + QString(": ") +
+                QString::number(this->sequencer->getNumberOfExposures(idx)) + QString(" x ") +
+                QString::number(this->sequencer->getExposureTime(idx)) + QString(" s");
+        ui->listWidgetSequence->addItem(entry);
+    }
+}
+
+//-------------------------------------------------------------------------
+// conveys the GoTo speed and the acceleration set in the controllers to the sequencer, converted to degrees.
+// the sequencer applies the fitted acceleration factor and latency of the slew time model itself
+void MainWindow::seqSetSlewParameters(void) {
+    double speed, convertDegreesToMicrostepsRA, convertDegreesToMicrostepsDecl;
+
+    speed = ui->sbGoToSpeed->value()*g_AllData->getCelestialSpeed();
+    convertDegreesToMicrostepsDecl=1.0/g_AllData->getGearData(7)*g_AllData->getMicroSteppingRatio(2)*
+            g_AllData->getGearData(4)*g_AllData->getGearData(5)*g_AllData->getGearData(6);
+    convertDegreesToMicrostepsRA=1.0/g_AllData->getGearData(3)*g_AllData->getMicroSteppingRatio(2)*
+            g_AllData->getGearData(0)*g_AllData->getGearData(1)*g_AllData->getGearData(2);
+    this->sequencer->setSlewParameters(speed, this->StepperDriveRA->getKineticsFromController(2)/convertDegreesToMicrostepsRA,
+                                       speed, this->StepperDriveDecl->getKineticsFromController(2)/convertDegreesToMicrostepsDecl);
+    this->sequencer->setMountParameters(g_AllData->getSiteCoords(0), g_AllData->getMFlipParams(0), g_AllData->getMFlipParams(1));
+}
+
+//-------------------------------------------------------------------------
+void MainWindow::seqSetControls(bool isEnabled) {
+    ui->pbSeqAdd->setEnabled(isEnabled);
+    ui->pbSeqLoad->setEnabled(isEnabled);
+    ui->pbSeqRemove->setEnabled(isEnabled);
+    ui->pbSeqClear->setEnabled(isEnabled);
+    ui->pbSeqOptimize->setEnabled(isEnabled);
+    ui->pbSeqStart->setEnabled(isEnabled);
+    ui->sbSeqExposures->setEnabled(isEnabled);
+    ui->sbSeqExpTime->setEnabled(isEnabled);
+    ui->cbSeqVerifyPS->setEnabled(isEnabled);
+    ui->pbSeqStop->setEnabled(!isEnabled);
+}
+
+//-------------------------------------------------------------------------
+//-------------------------------------------------------------------------
+//-------------------------------------------------------------------------
+// routines for carrying out the meridian flip of a GEM during an exposure series
+
+//-------------------------------------------------------------------------
+void MainWindow::setAutoMFlip(void) {
+    g_AllData->setAutoMFlip(ui->cbAutoMFlip->isChecked());
+    g_AllData->storeGlobalData(); // save the value to the preferences
+}
+
+//-------------------------------------------------------------------------
+void MainWindow::setMFlipLimit(void) {
+    g_AllData->setMFlipLimit(ui->sbMFlipLimit->value());
+    g_AllData->storeGlobalData(); // save the value to the preferences
+}
+
+//-------------------------------------------------------------------------
+// computes the time in seconds until the object tracked by a GEM pointing east reaches the meridian and the flip limit.
+// returns false if no flip lies ahead, for instance if the mount is already west or "checkForFlip" would not flip
+// because of the declination. the hour angle grows with the drive speed; the small additional rates from refraction
+// and ephemeris tracking are not considered as the prediction is updated every second anyway.
+bool MainWindow::mfGetTimeToFlip(double *secsToMeridian, double *secsToLimit) {
+    double trueRA, trueDecl, ha, haRate;
+
+    if ((g_AllData->getMFlipParams(0) == false) || (g_AllData->getMFlipParams(1) == true) ||
+            (g_AllData->wasMountSynced() == false) || (this->mountMotion.RATrackingIsOn == false)) {
+        return false;
+    }
+    trueRA = g_AllData->getActualScopePosition(2);
+    trueDecl = g_AllData->getActualScopePosition(1);
+    if (g_AllData->getRefractionCorrection() == true) {
+        this->refraction->getTruePosition(g_AllData->getActualScopePosition(2), g_AllData->getActualScopePosition(1),
+                                          g_AllData->getLocalSTime(), g_AllData->getSiteCoords(0), &trueRA, &trueDecl);
+    }
+    if (g_AllData->getActualScopePosition(1) < g_AllData->getMaxDeclForNoFlip()) {
+        return false; // "checkForFlip" does not flip for low declinations
+    }
+    ha = g_AllData->getLocalSTime()*15.0 - trueRA;
+    while (ha > 180) {
+        ha -= 360;
+    }
+    while (ha <= -180) {
+        ha += 360;
+    } // hour angle east of the meridian is negative here
+    haRate = g_AllData->getCelestialSpeed(); // degrees per second
+    if (haRate <= 0) {
+        return false;
+    }
+    *secsToMeridian = -ha/haRate;
+    *secsToLimit = (g_AllData->getMFlipLimit()/4.0 - ha)/haRate; // one minute of time is 0.25 degrees
+    return true;
+}
+
+//-------------------------------------------------------------------------
+// called at the boundaries of an exposure series; the next exposure is only started if it ends before the flip limit
+bool MainWindow::mfIsDue(double secondsNeeded) {
+    double secsToMeridian, secsToLimit;
+
+    if ((g_AllData->getAutoMFlip() == false) || (this->mflipState.step != mfIdle)) {
+        return false;
+    }
+    if (this->mfGetTimeToFlip(&secsToMeridian, &secsToLimit) == false) {
+        return false;
+    }
+    if (secsToLimit < secondsNeeded) {
+        qDebug() << "Meridian flip due in" << secsToLimit << "s, series is put on hold";
+        return true;
+    }
+    return false;
+}
+
+//-------------------------------------------------------------------------
+// continues a series that was put on hold with the next exposure
+void MainWindow::mfResumeSeries(void) {
+    this->mflipState.step = mfIdle;
+    this->mflipState.seriesOnHold = false;
+    if (this->dslrStates.dslrSeriesRunning == true) {
+        ui->lcdDSLRExpsDone->display(QString::number(this->dslrStates.noOfExposures-this->dslrStates.noOfExposuresLeft+1));
+        this->handleDSLRSingleExposure();
+    }
+}
+
+//-------------------------------------------------------------------------
+// after the flip, the guiding camera is turned upside down with respect to the sky; a rotation of the calibration
+// by 180 degrees saves a new calibration. the declination sign of the drive is already switched by the flip.
+void MainWindow::mfRotateGuidingCalibration(void) {
+    short i, j;
+
+    for (i = 0; i < 2; i++) {
+        for (j = 0; j < 2; j++) {
+            this->rotMatrixGuidingXToRA[i][j] *= -1;
+        }
+    }
+    this->guidingState.rotationAngle += M_PI;
+    if (this->guidingState.rotationAngle > M_PI) {
+        this->guidingState.rotationAngle -= 2*M_PI;
+    }
+}
+
+//-------------------------------------------------------------------------
+// slot called by mflipTimer. it displays the time to the meridian and to the flip limit. if an exposure series
+// was put on hold by "mfIsDue", the object has to cross the meridian before a GoTo to its own position flips the
+// mount. afterwards, the guide star is searched at the position mirrored at the center of the guiding camera,
+// guiding is restarted and the series is resumed.
+void MainWindow::updateMeridianFlip(void) {
+    const double minSecsPastMeridian = 60; // "checkForFlip" needs the object west of the meridian
+    const qint64 settlingTimeInMS = 3000;
+    const qint64 reacquisitionTimeoutInMS = 60000;
+    const qint64 guidingTimeoutInMS = 120000;
+    double secsToMeridian = 0, secsToLimit = 0, trueRA, trueDecl;
+    float starX, starY, scaling;
+    bool flipIsAhead;
+
+    if (this->mflipState.isBusy == true) {
+        return;
+    } // the routines called below process events, so this slot may be called again before it has finished
+    this->mflipState.isBusy = true;
+    switch (this->mflipState.step) {
+    case mfIdle:
+        flipIsAhead = this->mfGetTimeToFlip(&secsToMeridian, &secsToLimit);
+        if (flipIsAhead == true) {
+            ui->lcdTimeToMeridian->display(round(secsToMeridian/60.0));
+            ui->lcdTimeToFlip->display(round(secsToLimit/60.0));
+        } else {
+            ui->lcdTimeToMeridian->display(0);
+            ui->lcdTimeToFlip->display(0);
+        }
+        if (this->mflipState.seriesOnHold == false) {
+            break;
+        }
+        if (this->dslrStates.dslrSeriesRunning == false) {
+            this->mflipState.seriesOnHold = false; // the series was terminated while waiting
+            ui->leMFlipState->setText("Series terminated");
+            break;
+        }
+        if ((flipIsAhead == false) || (g_AllData->getAutoMFlip() == false)) {
+            ui->leMFlipState->setText("No flip needed");
+            this->mfResumeSeries();
+            break;
+        }
+        if ((secsToMeridian > -minSecsPastMeridian) || (this->mountMotion.GoToIsActiveInRA == true) ||
+                (this->mountMotion.GoToIsActiveInDecl == true)) {
+            ui->leMFlipState->setText("Series on hold, waiting for meridian");
+            break;
+        }
+        ui->leMFlipState->setText("Flipping");
+        this->mflipState.guidingWasOn = this->guidingState.guidingIsOn;
+        if (this->guidingState.guidingIsOn == true) {
+            this->guideStarPosition.centrX = g_AllData->getInitialStarPosition(2);
+            this->guideStarPosition.centrY = g_AllData->getInitialStarPosition(3);
+            this->doAutoGuiding(); // stop guiding
+        }
+        trueRA = g_AllData->getActualScopePosition(2);
+        trueDecl = g_AllData->getActualScopePosition(1);
+        if (g_AllData->getRefractionCorrection() == true) {
+            this->refraction->getTruePosition(g_AllData->getActualScopePosition(2), g_AllData->getActualScopePosition(1),
+                                              g_AllData->getLocalSTime(), g_AllData->getSiteCoords(0), &trueRA, &trueDecl);
+        } // "startGoToObject" corrects the target for refraction again
+        this->mflipState.savedRA = this->ra;
+        this->mflipState.savedDecl = this->decl;
+        this->ra = trueRA;
+        this->decl = trueDecl;
+        this->mflipState.step = mfSlewing;
+        this->startGoToObject(false); // a GoTo to the current position of the object flips the mount
+        this->ra = this->mflipState.savedRA;
+        this->decl = this->mflipState.savedDecl;
+        break;
+    case mfSlewing:
+        if ((this->mountMotion.GoToIsActiveInRA == false) && (this->mountMotion.GoToIsActiveInDecl == false)) {
+            this->mflipState.mountWasFlipped = g_AllData->getMFlipParams(1);
+            if (this->mflipState.mountWasFlipped == false) {
+                qDebug() << "Meridian flip was not carried out by the GoTo";
+            }
+            this->mflipState.step = mfSettling;
+            this->mflipState.stepElapsed.start();
+        }
+        break;
+    case mfSettling:
+        if (this->mflipState.stepElapsed.elapsed() > settlingTimeInMS) {
+            if ((this->mflipState.guidingWasOn == true) && (this->guidingState.systemIsCalibrated == true) &&
+                    (g_AllData->getINDIState(false) == true)) {
+                ui->leMFlipState->setText("Searching guide star");
+                this->camImageWasReceived = false;
+                this->startCCDAcquisition();
+                this->mflipState.step = mfReacquiring;
+                this->mflipState.stepElapsed.start();
+            } else {
+                if (this->mflipState.mountWasFlipped == true) {
+                    ui->leMFlipState->setText("Flip done");
+                } else {
+                    ui->leMFlipState->setText("Flip failed");
+                }
+                this->mfResumeSeries();
+            }
+        }
+        break;
+    case mfReacquiring:
+        if (this->camImageWasReceived == true) {
+            starX = this->guideStarPosition.centrX;
+            starY = this->guideStarPosition.centrY;
+            if (this->mflipState.mountWasFlipped == true) {
+                starX = g_AllData->getCameraChipPixels(0,false) - starX;
+                starY = g_AllData->getCameraChipPixels(1,false) - starY;
+                this->mfRotateGuidingCalibration();
+            } // the field is rotated by 180 degrees around the optical axis
+            this->guiding->findGuideStar(&starX, &starY, 90*this->guidingFOVFactor, this->guidingFOVFactor); // the star nearest to the expected position; if none is found, the position is kept
+            scaling = g_AllData->getCameraImageScalingFactor(false);
+            g_AllData->setInitialStarPosition(starX*scaling, starY*scaling); // like a click on the star in the camera view
+            this->confirmGuideStar();
+            ui->tabGuide->setEnabled(true);
+            ui->leMFlipState->setText("Guiding");
+            this->mflipState.step = mfGuiding;
+            this->mflipState.stepElapsed.start();
+            this->doAutoGuiding();
+        } else {
+            if (this->mflipState.stepElapsed.elapsed() > reacquisitionTimeoutInMS) {
+                qDebug() << "No image from the guiding camera after the meridian flip";
+                this->stopCCDAcquisition();
+                ui->leMFlipState->setText("Flip done, not guiding");
+                this->mfResumeSeries();
+            }
+        }
+        break;
+    case mfGuiding:
+        if ((this->guidingState.guidingIsOn == true) && (this->guidingState.noOfGuidingSteps >= 4)) {
+            ui->leMFlipState->setText("Flip done");
+            this->mfResumeSeries(); // guiding has stabilized
+        } else {
+            if ((this->guidingState.guidingIsOn == false) || (this->mflipState.stepElapsed.elapsed() > guidingTimeoutInMS)) {
+                qDebug() << "Guiding did not resume after the meridian flip";
+                ui->leMFlipState->setText("Flip done, check guiding");
+                this->mfResumeSeries();
+            }
+        }
+        break;
+    default:
+        break;
+    }
+    this->mflipState.isBusy = false;
+}
+
+//-------------------------------------------------------------------------
+//-------------------------------------------------------------------------
+//-------------------------------------------------------------------------
+// plate solving routines -------------------------------------------------
+// this is a dummy by now ...
+void MainWindow::psTakeImage(void) {
+   // QImage *solveImage;
+    QString *pth;
+
+    ui->pbSolveFieldPS->setEnabled(false);
+    ui->pbSyncPS->setEnabled(false);
+    if (g_AllData->getPathToImages().length() != 0) {
+        pth = new QString(g_AllData->getPathToImages().toLatin1());
+        pth->append("bubble.fits");
+        g_AllData->setPathToImageToBeSolved(pth->toLatin1());
+        delete pth;
+        ui->pbSolveFieldPS->setEnabled(true);
+
+    } else {
+        qDebug() << "no path to images available";
+    }
+}
+
+//-------------------------------------------------------------------------
+// TSC only triggers the DSLR and cannot download its images; the camera software has to write the image to be
+// solved. the time of the file tells a new image from the one of an earlier exposure
+void MainWindow::psExposeImage(int duration) {
+    int durationSetByUser;
+
+    durationSetByUser = ui->sbDSLRDuration->value();
+    ui->sbDSLRDuration->setValue(duration);
+    this->psExposureStart = QDateTime::currentDateTime();
+    this->psTakeImage(); // sets the path of the image to be solved
+    this->handleDSLRSingleExposure(); // the exposure time is kept in dslrStates from now on
+    ui->sbDSLRDuration->setValue(durationSetByUser);
+}
+
+//-------------------------------------------------------------------------
+bool MainWindow::psNewImageIsAvailable(void) {
+    if (this->dslrStates.dslrExposureIsRunning == true) {
+        return false;
+    }
+    QFileInfo imageFile(g_AllData->getPathToImageToBeSolved());
+    return ((imageFile.exists() == true) && (imageFile.lastModified() > this->psExposureStart));
+}
+
+//--------------------------------------------------------------------------
+// slot for choosing a directory
+void MainWindow::psChooseFITSDirectory(void) {
+    QFileDialog dialog;
+    QString theChosenPath;
+
+    dialog.setFileMode(QFileDialog::DirectoryOnly);
+    dialog.setOption(QFileDialog::ShowDirsOnly, true);
+    dialog.exec();
+    if (dialog.selectedFiles().empty() == false) {
+        theChosenPath = (dialog.selectedFiles().at(0));
+        const QFileInfo newDir(theChosenPath.toLatin1()) ;
+        if (newDir.exists() && newDir.isDir() && newDir.isReadable() && newDir.isWritable()) {
+            theChosenPath.append("/");
+            g_AllData->setPathToImages(theChosenPath);
+            ui->lePathToFitsFile->setText(g_AllData->getPathToImages());
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+// slot that triggers astrometry.net
+void MainWindow::psStartSolving(void) {
+    QString* solveCommand;
+
+    double fieldSize, slow, maxSize;
+    short dsFact = 1;
+
+    ui->cbFieldSolved->setChecked(false);
+    ui->pbKillAMetry->setEnabled(true);
+    ui->cbPSInProgress->setChecked(true);
+    g_AllData->setBooleanPSParams(0,true); // platesolving in progress
+    g_AllData->setBooleanPSParams(1,false); // no success so far
+    g_AllData->setBooleanPSParams(2, false); // no error so far
+    if (g_AllData->getCameraPixelSize(0,true) >= g_AllData->getCameraPixelSize(1,true)) {
+        maxSize = (g_AllData->getCameraChipPixels(0,true));
+    } else {
+        maxSize = (g_AllData->getCameraChipPixels(1,true));
+    }
+    if (maxSize > 2000) {
+        dsFact = 2;
+    }
+    if (maxSize > 4000) {
+        dsFact = 4;
+    }
+    this->waitForNMSecs(250);
+    fieldSize = 2*this->psComputeFOVForMainCCD();
+    slow = fieldSize/3.0;
+    solveCommand = new QString("solve-field --ra ");
+    solveCommand->append(QString::number((double)g_AllData->getActualScopePosition(2),'g',6));
+    solveCommand->append(" --dec ");
+    solveCommand->append(QString::number((double)g_AllData->getActualScopePosition(1),'g',6));
+    solveCommand->append(" --radius ");
+    solveCommand->append(QString::number((double)(ui->sbPSSearchRad->value())));
+    solveCommand->append(" --scale-units degwidth --overwrite --match none --rdls none --wcs none --no-plots ");
+    solveCommand->append(" --scale-low ");
+    solveCommand->append(QString::number(slow));
+    solveCommand->append(" --scale-high ");
+    solveCommand->append(QString::number(fieldSize));
+    solveCommand->append(" --downsample ");
+    solveCommand->append(QString::number(dsFact));
+    solveCommand->append(" ");
+    solveCommand->append(g_AllData->getPathToImageToBeSolved().toLatin1());
+    qDebug() << "Process command: " << solveCommand->toLatin1();
+    this->astroMetryProcess->start(solveCommand->toLatin1());
+    if (!this->astroMetryProcess->waitForStarted()) {
+        g_AllData->setBooleanPSParams(0,false);
+        g_AllData->setBooleanPSParams(2, true);
+        qDebug() << "Process did not start ...";
+    }
+    delete solveCommand;
+    ui->Control->setCursor(Qt::BusyCursor);
+    connect(this->astroMetryProcess, SIGNAL(readyReadStandardOutput()), this, SLOT(psDisplayAstrometryNetOutput()));
+}
+
+//-----------------------------------------------------------------------------
+// a slot for setting the search radius
+void MainWindow::psSetSearchRadiusForPS(void) {
+    double val;
+
+    val = ui->sbPSSearchRad->value();
+    g_AllData->setPSSearchRad(val);
 }
 
 //-----------------------------------------------------------------------------
@@ -6029,166 +7002,1318 @@ void MainWindow::psHandleEndOfAstronomyNetProcess(int code , QProcess::ExitStatu
     QDir *psDirectory;
     QStringList solvedFiles;
 
-    this->waitForNMSecs(1000); // just take a little breath
-    psDirectory = new QDir(g_AllData->getPathToImages().toLatin1());
-    solvedFiles = psDirectory->entryList(nameFilter);
-    delete psDirectory; // searching for a .solved file in the directory where astrometry.net operates
+    this->waitForNMSecs(1000); // just take a little breath
+    psDirectory = new QDir(g_AllData->getPathToImages().toLatin1());
+    solvedFiles = psDirectory->entryList(nameFilter);
+    delete psDirectory; // searching for a .solved file in the directory where astrometry.net operates
+
+    if (status == QProcess::NormalExit) {
+        if (solvedFiles.isEmpty() == false) {
+            qDebug() << ".solved file found";
+            ui->cbFieldSolved->setChecked(true);
+            this->psreadCoordinatesFromFITS();
+        } else {
+            g_AllData->setBooleanPSParams(0, false); // astrometry.net gave up
+        }
+    } else {
+        g_AllData->setBooleanPSParams(0, false);
+        g_AllData->setBooleanPSParams(2, true);
+        if (this->sequencerState.step == sqIdle) {
+            amnetCrashMsg.setWindowTitle("Astrometry net error");
+            amnetCrashMsg.setText("Astrometry.net engine crashed or terminated...");
+            amnetCrashMsg.exec();
+        } else {
+            qDebug() << "Astrometry.net engine crashed or terminated..."; // no dialog while the sequencer runs unattended
+        }
+    }
+    ui->cbPSInProgress->setChecked(false);
+    ui->pbKillAMetry->setEnabled(false);
+    ui->Control->setCursor(Qt::ArrowCursor);
+}
+
+//--------------------------------------------------------------------------------
+// compute the field of view and derive the oversampling factor and the index range from this
+double MainWindow::psComputeFOVForMainCCD(void) {
+    double maxSize, fov;
+
+    if (g_AllData->getCameraPixelSize(0,true) >= g_AllData->getCameraPixelSize(1,true)) {
+        maxSize = (g_AllData->getCameraChipPixels(0,true) * g_AllData->getCameraPixelSize(0,true))/1000.0;
+    } else {
+        maxSize = (g_AllData->getCameraChipPixels(1,true) * g_AllData->getCameraPixelSize(1,true))/1000.0; // find the maximum chip dimension in mm
+    }
+    fov = 53.26*maxSize/(g_AllData->getMainScopeFocalLength());
+    qDebug() << "Field of View is: " << fov;
+    qDebug() << "Max. Chip Size: " << maxSize;
+    return fov;
+}
+
+//--------------------------------------------------------------------------------------
+// a slot that kills astrometry.net
+void MainWindow::psKillAstrometryNet(void) {
+    this->astroMetryProcess->terminate();
+    ui->cbPSInProgress->setEnabled(false);
+    ui->pbKillAMetry->setEnabled(false);
+}
+
+//--------------------------------------------------------------------------------------
+// a slot that handles astrometry.net output
+void MainWindow::psDisplayAstrometryNetOutput(void) {
+    QProcess *p = dynamic_cast<QProcess *>( sender() );
+    QString *line;
+
+    if (p) {
+      line = new QString(p->readAllStandardOutput());
+      ui->tbAstroMetry->append(line->toLatin1());
+      delete line;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+// read the coordinates from the FITS file after solving; the center of the image is computed from the
+// WCS keywords that astrometry.net wrote to the header of the .new file
+void MainWindow::psreadCoordinatesFromFITS(void) {
+    QString *newFileName, *raString, *deString;
+    float equinox;
+    double solvedRA = 0, solvedDec = 0;
+    bool solvedCenterCoordsFound = false;
+    double meeusM, meeusN, deltaRA, deltaDecl,raRadians, declRadians,corrRA, corrDecl;
+    TSC_FitsHeader *solvedHeader;
+
+    newFileName = new QString(g_AllData->getPathToImageToBeSolved().toLatin1());
+    if (newFileName->isEmpty() == false) {
+        newFileName->chop(4);
+        newFileName->append("new");
+        solvedHeader = new TSC_FitsHeader();
+        if (solvedHeader->readFile(newFileName->toLatin1().constData()) == false) {
+            qDebug() << "Cannot read wcs data...";
+        } else {
+            solvedCenterCoordsFound = solvedHeader->getCenterCoordinates(&solvedRA, &solvedDec);
+            if (solvedCenterCoordsFound) {
+                equinox = this->UTDate->year();
+                meeusM=(3.07234+0.00186*((equinox-1900)/100.0))*0.00416667; // factor m, J. Meeus, 3. ed, p.63, given in degrees
+                meeusN=(20.0468-0.0085*((equinox-1900)/100.0))/(3600.0);  // factor n, in degrees
+                raRadians=solvedRA/180.0*3.141592653589793;
+                declRadians=solvedDec/180.0*3.141592653589793;
+                deltaRA = meeusM+meeusN*sin(raRadians)*tan(declRadians);
+                deltaDecl = meeusN*cos(raRadians);
+                corrRA= solvedRA+deltaRA*((double)(this->UTDate->year()-equinox));
+                if (corrRA > 360) {
+                    corrRA-=360;
+                } // that one is clear,right - avoid more than 24h RA ...
+                corrDecl=solvedDec+deltaDecl*((double)(this->UTDate->year()-equinox));
+                if (corrDecl > 90) {
+                    corrDecl = 90; // don't know what else to do here
+                }
+                if (corrDecl <-90) {
+                    corrDecl = -90;
+                }
+                raString = new QString(*this->generateCoordinateString(corrRA, true));
+                deString=new QString(*this->generateCoordinateString(corrDecl, false));
+                ui->lePSRASolved->setText(*raString);
+                ui->lePSDeclSolved->setText(*deString);
+                delete raString;
+                delete deString;
+                this->psRA = corrRA;
+                this->psDecl = corrDecl;
+            }
+        }
+        delete solvedHeader;
+    }
+    delete newFileName;
+    ui->pbSyncPS->setEnabled(true);
+    g_AllData->setBooleanPSParams(0, false);
+    g_AllData->setBooleanPSParams(1, solvedCenterCoordsFound);
+    g_AllData->setBooleanPSParams(2, false);
+}
+
+//-----------------------------------------------------------------------------------------------
+// a slot that syncs to the found coordinates
+void MainWindow::syncPSCoordinates(void) {
+    if (g_AllData->getBooleanPSParams(1) == true) {
+        this->ra = this->psRA;
+        this->decl = this->psDecl;
+        this->syncMount();
+        ui->pbSyncPS->setEnabled(false);
+    }
+}
+
+//-------------------------------------------------------------------------
+// passes the limits and the horizon profile from the preferences to the mask
+void MainWindow::updateHorizonMask(void) {
+    long idx;
+
+    this->horizonMask->setLatitude(g_AllData->getSiteCoords(0));
+    this->horizonMask->setMountLimits(g_AllData->getMountLimits(0), g_AllData->getMountLimits(1)*15.0, g_AllData->getMountLimits(2)*15.0);
+    this->horizonMask->clearHorizon();
+    for (idx = 0; idx < g_AllData->getNumberOfHorizonPoints(); idx++) {
+        this->horizonMask->addHorizonPoint(g_AllData->getHorizonPoint(idx, 0), g_AllData->getHorizonPoint(idx, 1));
+    }
+    this->sequencer->setHorizonMask(this->horizonMask);
+    this->updateHorizonList();
+    this->updateCatalogVisibility();
+}
+
+//-------------------------------------------------------------------------
+void MainWindow::updateHorizonList(void) {
+    long idx;
+
+    ui->listWidgetHorizon->clear();
+    for (idx = 0; idx < this->horizonMask->getNumberOfHorizonPoints(); idx++) {
+        ui->listWidgetHorizon->addItem(QString::number(this->horizonMask->getHorizonPoint(idx, 0), 'f', 1) + QString(", ") +
+                                       QString::number(this->horizonMask->getHorizonPoint(idx, 1), 'f', 1));
+    }
+}
+
+//-------------------------------------------------------------------------
+// the latitude may have been changed by a LX200 client, so it is set on every call; this is cheap
+bool MainWindow::isTargetReachable(double lra, double ldecl) {
+    this->horizonMask->setLatitude(g_AllData->getSiteCoords(0));
+    return this->horizonMask->isReachable(g_AllData->getLocalSTime()*15.0 - lra, ldecl);
+}
+
+//-------------------------------------------------------------------------
+void MainWindow::storeMountLimits(void) {
+    g_AllData->setMountLimits(ui->sbMinAltitude->value(), ui->sbHALimitEast->value(), ui->sbHALimitWest->value());
+    g_AllData->storeGlobalData();
+    this->updateHorizonMask();
+}
+
+//-------------------------------------------------------------------------
+void MainWindow::loadHorizonProfile(void) {
+    QString fileName;
+    long idx;
+
+    fileName = QFileDialog::getOpenFileName(this, "Load Horizon Profile", "Catalogs/", "Horizon Profiles (*.tsh)");
+    if (fileName.isEmpty() == false) {
+        if (this->horizonMask->loadHorizon(fileName) == false) {
+            qDebug() << "Could not read horizon profile" << fileName.toLatin1();
+            return;
+        }
+        g_AllData->clearHorizonProfile();
+        for (idx = 0; idx < this->horizonMask->getNumberOfHorizonPoints(); idx++) {
+            g_AllData->addHorizonPoint(this->horizonMask->getHorizonPoint(idx, 0), this->horizonMask->getHorizonPoint(idx, 1));
+        }
+        g_AllData->storeGlobalData();
+        this->updateHorizonMask();
+    }
+}
+
+//-------------------------------------------------------------------------
+void MainWindow::clearHorizonProfile(void) {
+    g_AllData->clearHorizonProfile();
+    g_AllData->storeGlobalData();
+    this->updateHorizonMask();
+}
+
+//-------------------------------------------------------------------------
+void MainWindow::setHideUnreachable(void) {
+    g_AllData->setHideUnreachableObjects(ui->cbHideUnreachable->isChecked());
+    g_AllData->storeGlobalData();
+    this->updateCatalogVisibility();
+}
+
+//-------------------------------------------------------------------------
+// hidden items keep their row, so the index of the list still is the index in the catalog. the positions
+// of all catalog objects are converted in one go; for NGC and IC, this is much faster than one call per object
+void MainWindow::updateCatalogVisibility(void) {
+    long idx;
+    double lra, ldecl;
+    bool hide, isReachable;
+
+    hide = g_AllData->getHideUnreachableObjects();
+    if (this->objCatalog != NULL) {
+        if (hide == true) {
+            this->catalogPositions->setLatitude(g_AllData->getSiteCoords(0));
+            this->catalogPositions->convert(g_AllData->getLocalSTime());
+            this->horizonMask->setLatitude(g_AllData->getSiteCoords(0));
+        }
+        for (idx = 0; (idx < ui->listWidgetObject->count()) && (idx < this->catalogPositions->getNumberOfObjects()); idx++) {
+            isReachable = true;
+            if (hide == true) {
+                isReachable = this->horizonMask->isReachableAltAz(this->catalogPositions->getHourAngle(idx), this->objCatalog->getDeclDec(idx),
+                    this->catalogPositions->getAltitude(idx), this->catalogPositions->getAzimuth(idx));
+            }
+            ui->listWidgetObject->item(idx)->setHidden(isReachable == false);
+        }
+    }
+    if ((this->ephemeris != NULL) && (ui->listWidgetObject->count() > 0)) {
+        if (this->ephemeris->getPosition(this->getCurrentJulianDate(), &lra, &ldecl) == true) {
+            ui->listWidgetObject->item(0)->setHidden((hide == true) && (this->isTargetReachable(lra, ldecl) == false));
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+// the drives take up the backlash themselves whenever they reverse - in GoTo, handbox motion, dithering and guiding
+void MainWindow::applyBacklashModel(bool compensationIsOn) {
+    this->StepperDriveRA->setBacklash(g_AllData->getBacklash(0));
+    this->StepperDriveDecl->setBacklash(g_AllData->getBacklash(1));
+    this->StepperDriveRA->setBacklashCompensation(compensationIsOn);
+    this->StepperDriveDecl->setBacklashCompensation(compensationIsOn);
+}
+
+//-------------------------------------------------------------------------
+// the declination backlash is measured during calibration of the autoguider; the RA drive only reverses
+// after slews to the east, and its backlash has to be entered here
+void MainWindow::storeBacklash(void) {
+    g_AllData->setBacklash(0, ui->sbBacklashRA->value());
+    g_AllData->setBacklash(1, ui->sbBacklashDecl->value());
+    g_AllData->storeGlobalData();
+    if (this->guidingState.calibrationIsRunning == false) {
+        this->applyBacklashModel(g_AllData->getBacklashCompensation());
+    }
+}
+
+//-------------------------------------------------------------------------
+void MainWindow::setBacklashCompensation(void) {
+    g_AllData->setBacklashCompensation(ui->cbDeclBacklashComp->isChecked());
+    g_AllData->storeGlobalData();
+    if (this->guidingState.calibrationIsRunning == false) {
+        this->applyBacklashModel(g_AllData->getBacklashCompensation());
+    }
+}
+
+//-------------------------------------------------------------------------
+//-------------------------------------------------------------------------
+//-------------------------------------------------------------------------
+// routines for encoders on the axes. TSC counts the position from the speed of the drives; with encoders,
+// the position is corrected from their readings, and slip of the gears is detected and made up in RA
+
+//-------------------------------------------------------------------------
+void MainWindow::applyEncoderSettings(void) {
+    short axis;
+
+    for (axis = 0; axis < 2; axis++) {
+        this->encoderFusion->setEncoder(axis, g_AllData->getEncoderParams(axis,0), (short)g_AllData->getEncoderParams(axis,1));
+    }
+    this->encoderFusion->setSlipThreshold(g_AllData->getEncoderSlipThreshold());
+    this->encoderFusion->reset();
+    this->encoderFusion->setClosedLoop(false);
+    this->encoderState.hasPosition = false;
+    this->encoderState.axisHasSlewed[0] = false;
+    this->encoderState.axisHasSlewed[1] = false;
+}
+
+//-------------------------------------------------------------------------
+// a slot that stores the source of the position and the parameters of the encoders
+void MainWindow::storeEncoderSettings(void) {
+    g_AllData->setPositionSource(ui->cbPositionSource->currentIndex());
+    g_AllData->setEncoderParams(0, ui->sbEncoderCountsRA->value(), ui->cbInvertEncoderRA->isChecked() ? -1 : 1);
+    g_AllData->setEncoderParams(1, ui->sbEncoderCountsDecl->value(), ui->cbInvertEncoderDecl->isChecked() ? -1 : 1);
+    g_AllData->setEncoderSlipThreshold(ui->sbSlipThreshold->value());
+    g_AllData->storeGlobalData();
+    this->applyEncoderSettings();
+    if (g_AllData->getPositionSource() == 0) {
+        ui->lEncoderState->setText("Position from step counting");
+    }
+}
+
+//-------------------------------------------------------------------------
+// reads the counts of the encoder on an axis. the extended firmware of the AMIS boards returns them for the
+// command "f11". on the HAT, the arduino latches the counts of both encoders on "r" (RA) or "c" (declination)
+// and delivers them as 8 hex digits, most significant first, one per call on SPI channel 0. as with the
+// temperature, a byte arrives with the next call, and "g" switches the stream of responses back to ST4
+bool MainWindow::readEncoder(bool isRA, long *counts) {
+    QString reply, latch;
+    unsigned long val;
+    short digit;
+    bool isValid = false;
+
+    switch (g_AllData->getPositionSource()) {
+    case 1:
+        if (amisInterface->sendCommand("f11", isRA) == true) {
+            reply = amisInterface->getReply(isRA);
+            *counts = reply.trimmed().toLong(&isValid);
+        }
+        break;
+    case 2:
+        if (this->commSPIParams.chan0IsOpen == false) {
+            break;
+        }
+        if (isRA == true) {
+            latch = "r";
+        } else {
+            latch = "c";
+        }
+        this->commSPIParams.guiData->clear();
+        this->commSPIParams.guiData->append(latch);
+        this->spiDrOnChan0->spidrReceiveCommand(*commSPIParams.guiData);
+        this->waitForNMSecs(25);
+        if (this->spiDrOnChan0->getResponse() == latch.at(0).toLatin1()) {
+            this->spiDrOnChan0->spidrReceiveCommand(*commSPIParams.guiData);
+            this->waitForNMSecs(25);
+        } // the arduino was too slow - repeat the call
+        for (digit = 0; digit < 8; digit++) {
+            this->commSPIParams.guiData->clear();
+            if (digit < 7) {
+                this->commSPIParams.guiData->append("n");
+            } else {
+                this->commSPIParams.guiData->append("g");
+            }
+            this->spiDrOnChan0->spidrReceiveCommand(*commSPIParams.guiData);
+            this->waitForNMSecs(25);
+            reply.append(this->spiDrOnChan0->getResponse());
+        }
+        val = reply.toULong(&isValid, 16); // trash in the SPI register is not a hex digit
+        *counts = (long)val;
+        break;
+    default:
+        break;
+    }
+    return isValid;
+}
+
+//-------------------------------------------------------------------------
+// slot called by encoderTimer. the travel from step counting since the last call is compared with the
+// travel of the encoders, and the position is corrected. a sync or a pole crossing moves the position
+// without any travel of the axes; the next readings then become the new reference
+void MainWindow::updateEncoderPosition(void) {
+    long counts[2];
+    double stepTravel[2] = {0, 0}, correction[2], dt = 0;
+    qint64 sinceSync;
+    short declSign, axis;
+    bool slipped = false;
+    QString state;
+
+    if ((g_AllData->getPositionSource() == 0) || (this->encoderState.isReading == true)) {
+        return;
+    }
+    this->encoderState.isReading = true;
+    if ((this->readEncoder(true, &counts[0]) == false) || (this->readEncoder(false, &counts[1]) == false)) {
+        this->encoderState.isReading = false;
+        ui->lEncoderState->setText("No valid encoder readings");
+        return;
+    }
+    this->encoderState.isReading = false;
+    sinceSync = g_AllData->getTimeSinceLastSync();
+    declSign = g_AllData->getMFlipDecSign();
+    if ((this->encoderState.hasPosition == false) || (sinceSync < this->encoderState.lastTimeSinceSync) ||
+            (declSign != this->encoderState.lastDeclSign)) {
+        this->encoderFusion->reset();
+    } else {
+        stepTravel[0] = this->encoderState.lastHA - g_AllData->getActualScopePosition(0);
+        if (stepTravel[0] > 180) {
+            stepTravel[0] -= 360;
+        }
+        if (stepTravel[0] < -180) {
+            stepTravel[0] += 360;
+        } // the hour angle wraps at 360 degrees
+        stepTravel[1] = (g_AllData->getActualScopePosition(1) - this->encoderState.lastDecl)*declSign; // travel of the axis, not of the declination
+        dt = (sinceSync - this->encoderState.lastTimeSinceSync)/1000.0;
+    }
+    for (axis = 0; axis < 2; axis++) {
+        correction[axis] = this->encoderFusion->update(axis, stepTravel[axis], counts[axis], dt, this->encoderState.axisHasSlewed[axis]);
+        this->encoderState.axisHasSlewed[axis] = false;
+        if (this->encoderFusion->hasSlipped(axis) == true) {
+            slipped = true;
+            qDebug() << "Slip of axis" << axis << "- deviation from the encoder" << this->encoderFusion->getDeviation(axis) << "arcsec";
+        }
+    }
+    g_AllData->incrementActualScopePosition(correction[0], correction[1]*declSign);
+    this->encoderState.lastHA = g_AllData->getActualScopePosition(0);
+    this->encoderState.lastDecl = g_AllData->getActualScopePosition(1);
+    this->encoderState.lastTimeSinceSync = sinceSync;
+    this->encoderState.lastDeclSign = g_AllData->getMFlipDecSign();
+    this->encoderState.hasPosition = true;
+    this->encoderFusion->setClosedLoop((this->mountMotion.RATrackingIsOn == true) && (this->guidingState.guidingIsOn == false) &&
+                                       (this->mountMotion.RADriveIsMoving == false) && (this->mountMotion.GoToIsActiveInRA == false) &&
+                                       (g_AllData->wasMountSynced() == true)); // guiding corrects slip itself
+    state = QString("RA: %1\" - Decl: %2\"").arg(this->encoderFusion->getDeviation(0), 0, 'f', 1).arg(this->encoderFusion->getDeviation(1), 0, 'f', 1);
+    if (slipped == true) {
+        state.append(" - slip");
+    }
+    ui->lEncoderState->setText(state);
+}
+
+//-------------------------------------------------------------------------
+//-------------------------------------------------------------------------
+//-------------------------------------------------------------------------
+// routines for parking and homing. when the mount is parked, the position of the axes is written to a state
+// file; after a power cycle, TSC is synced from it and ready for GoTo. the file is invalidated as soon as the
+// mount moves again. without a valid state, the mount can be homed against limit switches on the axes
+
+//-------------------------------------------------------------------------
+// called at startup
+void MainWindow::restoreParkedPosition(void) {
+    double parkedHA, parkedDecl, parkedRA;
+
+    if (g_AllData->restoreMountState(&parkedHA, &parkedDecl) == false) {
+        ui->lParkState->setText("Not parked");
+        return;
+    }
+    parkedRA = g_AllData->getLocalSTime()*15 - parkedHA;
+    while (parkedRA < 0) {
+        parkedRA += 360;
+    }
+    while (parkedRA >= 360) {
+        parkedRA -= 360;
+    }
+    ui->cbMountIsEast->setChecked(g_AllData->getMFlipParams(1));
+    this->StepperDriveRA->setStepCounter(g_AllData->getAxisSteps(0));
+    this->StepperDriveDecl->setStepCounter(g_AllData->getAxisSteps(1)); // the drives continue counting where they stopped
+    this->syncMount(parkedRA, parkedDecl, true); // the mount stays at rest
+    this->parkState.step = pkParked;
+    ui->lParkState->setText("Parked - restored");
+}
+
+//-------------------------------------------------------------------------
+// a slot that starts tracking from the parking position
+void MainWindow::unparkMount(void) {
+    if (this->parkState.step != pkParked) {
+        return;
+    }
+    g_AllData->storeMountState(false);
+    this->parkState.step = pkIdle;
+    ui->lParkState->setText("Not parked");
+    this->startRATracking();
+}
+
+//-------------------------------------------------------------------------
+// the extended firmware of the AMIS boards reports the state of the home switch of an axis for the command
+// "f12" - 1 if the switch is closed, 0 if it is open. any other reply means that there are no switches
+short MainWindow::readHomeSwitch(bool isRA) {
+    QString reply;
+    long state = -1;
+    bool isValid = false;
+
+    if (amisInterface->sendCommand("f12", isRA) == true) {
+        reply = amisInterface->getReply(isRA);
+        state = reply.trimmed().toLong(&isValid);
+    }
+    if ((isValid == false) || (state < 0) || (state > 1)) {
+        return -1;
+    }
+    return (short)state;
+}
+
+//-------------------------------------------------------------------------
+// the search runs like a motion from the handbox, so the position is counted as usual while the drives move.
+// the speed is the one of the homing phase, not the one set for the handbox
+void MainWindow::toggleHomingMotion(bool isRA, short direction, float speed) {
+    double speedFactor[2];
+    bool moveSpeedWasSet;
+
+    speedFactor[0] = this->mountMotion.RASpeedFactor;
+    speedFactor[1] = this->mountMotion.DeclSpeedFactor;
+    moveSpeedWasSet = ui->rbMoveSpeed->isChecked();
+    this->mountMotion.RASpeedFactor = speed;
+    this->mountMotion.DeclSpeedFactor = speed;
+    ui->rbMoveSpeed->setChecked(true); // the microstepping ratio for fast motion
+    if (isRA == true) {
+        if (direction*g_AllData->getHomeSearchDirection(0) > 0) {
+            this->RAMoveHandboxFwd();
+        } else {
+            this->RAMoveHandboxBwd();
+        }
+    } else {
+        if (direction*g_AllData->getHomeSearchDirection(1) > 0) {
+            this->declinationMoveHandboxUp();
+        } else {
+            this->declinationMoveHandboxDown();
+        }
+    }
+    this->mountMotion.RASpeedFactor = speedFactor[0];
+    this->mountMotion.DeclSpeedFactor = speedFactor[1];
+    if (moveSpeedWasSet == false) {
+        ui->rbCorrSpeed->setChecked(true);
+        if ((this->mountMotion.RADriveIsMoving == false) && (this->mountMotion.DeclDriveIsMoving == false)) {
+            ui->sbMoveSpeed->setEnabled(true);
+        } // as after a handbox motion at the correction speed
+    }
+}
+
+//-------------------------------------------------------------------------
+// the drive stops late when it reaches the switch at the homing speed. it therefore backs off until the switch
+// opens and approaches it again at a tenth of the homing speed; the axis is zeroed where the slow approach stops
+void MainWindow::startHomingPhase(bool isRA, short phase) {
+    QString axisName;
+
+    this->parkState.homingPhase = phase;
+    this->parkState.waitsForRest = false;
+    this->parkState.stepElapsed.restart();
+    if (phase == 0) {
+        this->parkState.homingSpeed = g_AllData->getHomingSpeed();
+    } else {
+        this->parkState.homingSpeed = round(g_AllData->getHomingSpeed()/10.0);
+        if (this->parkState.homingSpeed < 2) {
+            this->parkState.homingSpeed = 2;
+        } // the RA drive moves at the speed minus the sidereal one when it runs backwards
+    }
+    if (phase == 1) {
+        this->parkState.homingDirection = -1;
+    } else {
+        this->parkState.homingDirection = 1;
+    }
+    if (isRA == true) {
+        axisName = "RA";
+    } else {
+        axisName = "Decl";
+    }
+    if (phase == 0) {
+        ui->lParkState->setText(QString("Homing in ") + axisName);
+    } else {
+        ui->lParkState->setText(QString("Homing in ") + axisName + QString(" - slow"));
+    }
+    this->toggleHomingMotion(isRA, this->parkState.homingDirection, this->parkState.homingSpeed);
+}
+
+//-------------------------------------------------------------------------
+// a slot that starts the search for the home switches, first in RA, then in declination. on a synced mount,
+// the first homing stores the position of the switches; afterwards, homing syncs the mount there
+void MainWindow::startHoming(void) {
+    if ((this->parkState.step == pkHomingRA) || (this->parkState.step == pkHomingDecl) ||
+            (this->mountMotion.GoToIsActiveInRA == true) || (this->mountMotion.GoToIsActiveInDecl == true) ||
+            (this->mountMotion.RADriveIsMoving == true) || (this->mountMotion.DeclDriveIsMoving == true) ||
+            (this->guidingState.guidingIsOn == true)) {
+        return;
+    }
+    if ((g_AllData->isHomePositionKnown() == false) && (g_AllData->wasMountSynced() == false)) {
+        ui->lParkState->setText("Sync to learn home");
+        return;
+    }
+    if ((this->readHomeSwitch(true) < 0) || (this->readHomeSwitch(false) < 0)) {
+        ui->lParkState->setText("No home switches");
+        return;
+    }
+    if (this->parkState.step == pkParked) {
+        g_AllData->storeMountState(false);
+    } // the mount moves, and a power cut during homing must not restore the old position
+    this->parkState.learnsHome = !g_AllData->isHomePositionKnown();
+    if (this->mountMotion.RATrackingIsOn == true) {
+        this->stopRATracking();
+    }
+    this->stopDeclTracking();
+    this->trackingBeforeHandboxMotionStarted = false; // the mount rests at the switches
+    this->parkState.step = pkHomingRA;
+    this->startHomingPhase(true, 0);
+}
+
+//-------------------------------------------------------------------------
+void MainWindow::finishHoming(bool switchesWereFound) {
+    double homeRA, ha;
+
+    if (switchesWereFound == false) {
+        this->parkState.step = pkIdle;
+        ui->lParkState->setText("Homing failed");
+        qDebug() << "Homing failed - no switch was found";
+        return;
+    }
+    if (this->parkState.learnsHome == true) {
+        ha = g_AllData->getLocalSTime()*15 - g_AllData->getActualScopePosition(2);
+        while (ha < 0) {
+            ha += 360;
+        }
+        while (ha >= 360) {
+            ha -= 360;
+        }
+        g_AllData->setHomePosition(ha, g_AllData->getActualScopePosition(1), g_AllData->getMFlipDecSign(), g_AllData->getMFlipParams(1));
+        g_AllData->storeGlobalData();
+        ui->lParkState->setText("Home learned");
+    } else {
+        homeRA = g_AllData->getLocalSTime()*15 - g_AllData->getHomePosition(0);
+        while (homeRA < 0) {
+            homeRA += 360;
+        }
+        while (homeRA >= 360) {
+            homeRA -= 360;
+        }
+        g_AllData->setDeclinationSign((short)g_AllData->getHomePosition(2));
+        g_AllData->setMFlipParams(1, (g_AllData->getHomePosition(3) > 0.5));
+        ui->cbMountIsEast->setChecked(g_AllData->getMFlipParams(1));
+        this->syncMount(homeRA, g_AllData->getHomePosition(1), true);
+        ui->lParkState->setText("Homed");
+    }
+    this->parkState.step = pkParked; // the mount rests at the switches like in a parking position
+    g_AllData->setAxisSteps(this->StepperDriveRA->getStepCounter(), this->StepperDriveDecl->getStepCounter(), false);
+    g_AllData->storeMountState(true);
+}
 
-    if (status == QProcess::NormalExit) {
-        if (solvedFiles.isEmpty() == false) {
-            qDebug() << ".solved file found";
-            ui->cbFieldSolved->setChecked(true);
-            this->psreadCoordinatesFromFITS();
+//-------------------------------------------------------------------------
+// slot called by parkTimer
+void MainWindow::updateParkState(void) {
+    qint64 homingTimeoutInMS;
+    double travelInDegrees;
+    short switchState;
+    bool isRA;
+
+    if (this->parkState.isBusy == true) {
+        return;
+    }
+    this->parkState.isBusy = true;
+    switch (this->parkState.step) {
+    case pkParked:
+        if ((this->mountMotion.RATrackingIsOn == true) || (this->mountMotion.RADriveIsMoving == true) ||
+                (this->mountMotion.DeclDriveIsMoving == true) || (this->mountMotion.GoToIsActiveInRA == true) ||
+                (this->mountMotion.GoToIsActiveInDecl == true) || (this->StepperDriveDecl->getTrackingSpeed() != 0)) {
+            g_AllData->storeMountState(false); // the position in the state file is no longer valid
+            this->parkState.step = pkIdle;
+            ui->lParkState->setText("Not parked");
+        }
+        break;
+    case pkHomingRA:
+    case pkHomingDecl:
+        isRA = (this->parkState.step == pkHomingRA);
+        if (this->parkState.waitsForRest == true) {
+            if (this->isDriveActive(isRA) == false) {
+                if (this->parkState.homingPhase < 2) {
+                    this->startHomingPhase(isRA, this->parkState.homingPhase + 1);
+                } else if (isRA == true) {
+                    this->parkState.step = pkHomingDecl;
+                    this->startHomingPhase(false, 0);
+                } else {
+                    this->finishHoming(true);
+                }
+            } // the position is only counted correctly, and the axis only zeroed, once the drive is at rest
+            break;
+        }
+        if (this->parkState.homingPhase == 0) {
+            travelInDegrees = 180; // half a turn of the axis
+        } else {
+            travelInDegrees = 5; // the ramp of the search and the hysteresis of the switch
+        }
+        homingTimeoutInMS = (qint64)(1.5*1000.0*travelInDegrees/(this->parkState.homingSpeed*g_AllData->getCelestialSpeed()));
+        // with a margin for the ramps
+        switchState = this->readHomeSwitch(isRA);
+        if ((switchState >= 0) && ((switchState == 1) == (this->parkState.homingPhase != 1))) {
+            this->toggleHomingMotion(isRA, this->parkState.homingDirection, this->parkState.homingSpeed);
+            this->parkState.waitsForRest = true; // the switch was reached, or it has opened when backing off
+        } else {
+            if ((switchState < 0) || (this->parkState.stepElapsed.elapsed() > homingTimeoutInMS) ||
+                    ((isRA == true) && (this->mountMotion.RADriveIsMoving == false)) ||
+                    ((isRA == false) && (this->mountMotion.DeclDriveIsMoving == false))) {
+                if (((isRA == true) && (this->mountMotion.RADriveIsMoving == true)) ||
+                        ((isRA == false) && (this->mountMotion.DeclDriveIsMoving == true))) {
+                    this->toggleHomingMotion(isRA, this->parkState.homingDirection, this->parkState.homingSpeed);
+                }
+                this->finishHoming(false);
+            } // the drive has travelled too far without reaching the switch
         }
+        break;
+    default:
+        break;
+    }
+    this->parkState.isBusy = false;
+}
+
+//-------------------------------------------------------------------------
+//-------------------------------------------------------------------------
+// auto-tuning of the drives. every test is a slew away from the start and back with the settings proposed
+// by the TSC_DriveTuner; a stall shows as an error on the ERR pin of the AMIS, as a travel that the encoders
+// did not see, or as a shift of the guide star. without encoders and a guide star, only the ERR pin is
+// checked, and it does not tell about lost steps.
+void MainWindow::startAutoTune(void) {
+    if ((this->autoTuneState.step != tnIdle) || (this->mountMotion.GoToIsActiveInRA == true) ||
+            (this->mountMotion.GoToIsActiveInDecl == true) || (this->mountMotion.RADriveIsMoving == true) ||
+            (this->mountMotion.DeclDriveIsMoving == true) || (this->guidingState.guidingIsOn == true) ||
+            (this->guidingState.calibrationIsRunning == true) || (this->sequencerState.step != sqIdle) ||
+            (this->mflipState.step != mfIdle) || (this->parkState.step == pkParking) ||
+            (this->parkState.step == pkHomingRA) || (this->parkState.step == pkHomingDecl)) {
+        ui->lAutoTuneState->setText("Mount is busy");
+        return;
+    }
+    if ((this->StepperDriveRA->getErrorFromDriver() == true) || (this->StepperDriveDecl->getErrorFromDriver() == true)) {
+        ui->lAutoTuneState->setText("A driver reports an error");
+        return;
+    }
+    this->autoTuneState.useEncoders = (g_AllData->getPositionSource() != 0);
+    this->autoTuneState.useCamera = ((g_AllData->getINDIState(false) == true) && (this->guidingState.guideStarSelected == true));
+    if ((this->autoTuneState.useEncoders == false) && (this->autoTuneState.useCamera == false)) {
+        ui->lAutoTuneState->setText("Needs encoders or a guide star");
+        return;
+    } // without them, lost steps are not detected, and the trial values would be stored as safe
+    if (this->parkState.step == pkParked) {
+        g_AllData->storeMountState(false);
+        this->parkState.step = pkIdle;
+        ui->lParkState->setText("Not parked");
+    } // a stall would leave the mount somewhere else
+    this->autoTuneState.trackingWasOn = this->mountMotion.RATrackingIsOn;
+    if ((this->autoTuneState.useCamera == true) && (this->ccdCameraIsAcquiring == true)) {
+        this->abortCCDAcquisition();
+    }
+    if (this->autoTuneState.useCamera == true) {
+        if (this->mountMotion.RATrackingIsOn == false) {
+            this->startRATracking();
+        } // the guide star has to stay in place while the declination drive is tested
     } else {
-        amnetCrashMsg.setWindowTitle("Astrometry net error");
-        amnetCrashMsg.setText("Astrometry.net engine crashed or terminated...");
-        amnetCrashMsg.exec();
+        if (this->mountMotion.RATrackingIsOn == true) {
+            this->stopRATracking();
+        }
     }
-    ui->cbPSInProgress->setChecked(false);
-    ui->pbKillAMetry->setEnabled(false);
-    ui->Control->setCursor(Qt::ArrowCursor);
+    this->stopDeclTracking();
+    this->applyBacklashModel(false); // the encoders have to see the travel that was commanded
+    this->setControlsForGoto(false);
+    ui->pbAutoTune->setEnabled(false);
+    ui->pbStopAutoTune->setEnabled(true);
+    this->driveTuner->setLimits(ui->sbAMaxRA_AMIS->maximum(), fmin(3.0, ui->sbTuneMaxCurrent->value()), ui->sbGoToSpeed->maximum());
+    this->driveTuner->start(ui->sbAMaxRA_AMIS->value(), ui->sbCurrMaxRA_AMIS->value(), ui->sbGoToSpeed->value());
+    this->autoTuneState.isRA = true;
+    this->autoTuneState.imageRequested = false;
+    this->autoTuneState.positionIsLost = false;
+    this->autoTuneState.step = tnReference;
 }
 
-//--------------------------------------------------------------------------------
-// compute the field of view and derive the oversampling factor and the index range from this
-double MainWindow::psComputeFOVForMainCCD(void) {
-    double maxSize, fov;
+//-------------------------------------------------------------------------
+void MainWindow::stopAutoTune(void) {
+    if (this->autoTuneState.step == tnIdle) {
+        return;
+    }
+    this->StepperDriveRA->stopDrive();
+    this->StepperDriveDecl->stopDrive();
+    this->finishAutoTune(false);
+    ui->lAutoTuneState->setText("Stopped - check the position");
+}
 
-    if (g_AllData->getCameraPixelSize(0,true) >= g_AllData->getCameraPixelSize(1,true)) {
-        maxSize = (g_AllData->getCameraChipPixels(0,true) * g_AllData->getCameraPixelSize(0,true))/1000.0;
+//-------------------------------------------------------------------------
+double MainWindow::getTuneStepsPerDegree(bool isRA) {
+    short offset = 0;
+
+    if (isRA == false) {
+        offset = 4;
+    }
+    return g_AllData->getMicroSteppingRatio(2)*g_AllData->getGearData(offset)*g_AllData->getGearData(offset+1)*
+        g_AllData->getGearData(offset+2)/g_AllData->getGearData(offset+3);
+}
+
+//-------------------------------------------------------------------------
+void MainWindow::applyTuneSettings(void) {
+    if (this->autoTuneState.isRA == true) {
+        this->StepperDriveRA->setStepperParams(this->driveTuner->getTrialAcceleration(), 1);
+        this->StepperDriveRA->setStepperParams(this->driveTuner->getTrialCurrent(), 3);
     } else {
-        maxSize = (g_AllData->getCameraChipPixels(1,true) * g_AllData->getCameraPixelSize(1,true))/1000.0; // find the maximum chip dimension in mm
+        this->StepperDriveDecl->setStepperParams(this->driveTuner->getTrialAcceleration(), 1);
+        this->StepperDriveDecl->setStepperParams(this->driveTuner->getTrialCurrent(), 3);
     }
-    fov = 53.26*maxSize/(g_AllData->getMainScopeFocalLength());
-    qDebug() << "Field of View is: " << fov;
-    qDebug() << "Max. Chip Size: " << maxSize;
-    return fov;
+    ui->lAutoTuneState->setText(QString(this->autoTuneState.isRA ? "RA" : "Decl") + QString(" test ") +
+        QString::number(this->driveTuner->getNumberOfTests() + 1) + QString(": ") +
+        QString::number(this->driveTuner->getTrialAcceleration(), 'f', 0) + QString(" mstp/s^2, ") +
+        QString::number(this->driveTuner->getTrialCurrent(), 'f', 2) + QString(" A, ") +
+        QString::number(this->driveTuner->getTrialSpeed()) + QString("x"));
 }
 
-//--------------------------------------------------------------------------------------
-// a slot that kills astrometry.net
-void MainWindow::psKillAstrometryNet(void) {
-    this->astroMetryProcess->terminate();
-    ui->cbPSInProgress->setEnabled(false);
-    ui->pbKillAMetry->setEnabled(false);
+//-------------------------------------------------------------------------
+// the RA drive does not track during its test, so the slew back falls short by the travel of the sky.
+// the duration is taken from the GoTo ETA model; the mount then points to the same stars as before
+void MainWindow::startTuneSlew(short direction) {
+    double stepsPerDegree, speed, acc, travelOfSky;
+    long steps;
+    short iteration;
+
+    stepsPerDegree = this->getTuneStepsPerDegree(this->autoTuneState.isRA);
+    speed = this->driveTuner->getTrialSpeed()*g_AllData->getCelestialSpeed()*stepsPerDegree;
+    acc = this->driveTuner->getTrialAcceleration();
+    if (direction > 0) {
+        steps = this->driveTuner->getTestTravel(stepsPerDegree, speed);
+        this->autoTuneState.outSteps = steps;
+        this->autoTuneState.hasStalled = false;
+    } else {
+        steps = this->autoTuneState.outSteps;
+        if (this->autoTuneState.isRA == true) {
+            for (iteration = 0; iteration < 3; iteration++) {
+                travelOfSky = g_AllData->getCelestialSpeed()*(this->autoTuneState.testElapsed.elapsed()/1000.0 +
+                    this->slewTimeModel->predictDuration(0, steps, speed, acc))*stepsPerDegree;
+                steps = this->autoTuneState.outSteps - lround(travelOfSky);
+            }
+            if (steps < 0) {
+                steps = 0;
+            }
+        }
+    }
+    if ((this->autoTuneState.useEncoders == true) && (this->readEncoder(this->autoTuneState.isRA, &this->autoTuneState.encoderCounts) == false)) {
+        this->autoTuneState.useEncoders = false;
+        qDebug() << "Auto-tuning: no readings from the encoders";
+    }
+    this->autoTuneState.legSteps = steps;
+    if (this->autoTuneState.isRA == true) {
+        this->StepperDriveRA->changeMicroSteps(g_AllData->getMicroSteppingRatio(2));
+        this->StepperDriveRA->travelForNSteps(steps, direction, this->driveTuner->getTrialSpeed(), false);
+    } else {
+        this->StepperDriveDecl->changeMicroSteps(g_AllData->getMicroSteppingRatio(2));
+        this->StepperDriveDecl->travelForNSteps(steps, direction, this->driveTuner->getTrialSpeed(), false);
+    }
+    this->autoTuneState.stepElapsed.restart();
 }
 
-//--------------------------------------------------------------------------------------
-// a slot that handles astrometry.net output
-void MainWindow::psDisplayAstrometryNetOutput(void) {
-    QProcess *p = dynamic_cast<QProcess *>( sender() );
-    QString *line;
+//-------------------------------------------------------------------------
+// the encoder sees the travel of the axis; the backlash is lost when the drive reverses
+bool MainWindow::checkTuneLeg(void) {
+    double stepsPerDegree, countsPerDegree, expectedCounts, tolerance;
+    long counts;
+    short axis = 1;
 
-    if (p) {
-      line = new QString(p->readAllStandardOutput());
-      ui->tbAstroMetry->append(line->toLatin1());
-      delete line;
+    if (this->autoTuneState.useEncoders == false) {
+        return false;
+    }
+    if (this->autoTuneState.isRA == true) {
+        axis = 0;
+    }
+    if (this->readEncoder(this->autoTuneState.isRA, &counts) == false) {
+        return false;
     }
+    stepsPerDegree = this->getTuneStepsPerDegree(this->autoTuneState.isRA);
+    countsPerDegree = g_AllData->getEncoderParams(axis, 0)/360.0;
+    expectedCounts = this->autoTuneState.legSteps/stepsPerDegree*countsPerDegree;
+    tolerance = g_AllData->getEncoderSlipThreshold()/3600.0*countsPerDegree + g_AllData->getBacklash(axis)*
+        g_AllData->getMicroSteppingRatio(2)/((double)g_AllData->getMicroSteppingRatio(0))/stepsPerDegree*countsPerDegree;
+    return (labs(this->encoderFusion->getCountDifference(axis, counts, this->autoTuneState.encoderCounts)) <
+            expectedCounts - fmax(2.0, tolerance)); // the counts wrap at a full revolution
 }
 
-//--------------------------------------------------------------------------------------
-// a slot that handles wcsinfo output
-void MainWindow::psReadWCSInfoOutput(void) {
-    QProcess *p = dynamic_cast<QProcess *>( sender() );
-    QString *line;
+//-------------------------------------------------------------------------
+void MainWindow::requestTuneImage(void) {
+    this->camImageWasReceived = false;
+    this->autoTuneState.imageRequested = true;
+    this->autoTuneState.stepElapsed.restart();
+    this->takeSingleCamShot();
+}
 
-    if (p) {
-      line = new QString(p->readAllStandardOutput());
-      this->wcsInfoOutput->append(line);
-      delete line;
+//-------------------------------------------------------------------------
+// the same processing of the guide star as in the calibration of the autoguider
+bool MainWindow::getTuneStarPosition(double *x, double *y) {
+    this->autoTuneState.imageRequested = false;
+    this->guiding->doGuideStarImgProcessing(ui->hsThreshold->value(), ui->cbMedianFilter->isChecked(), ui->cbLowPass->isChecked(),
+        ui->hsIContrast->value()/100.0, ui->hsIBrightness->value(), this->guidingFOVFactor, this->guidingState.guideStarSelected, true);
+    *x = g_AllData->getInitialStarPosition(2);
+    *y = g_AllData->getInitialStarPosition(3);
+    return ((*x > 0) && (*y > 0));
+}
+
+//-------------------------------------------------------------------------
+void MainWindow::evaluateTuneTest(void) {
+    short axis = 1;
+
+    if (this->autoTuneState.isRA == true) {
+        axis = 0;
+    }
+    if ((this->autoTuneState.useEncoders == false) && (this->autoTuneState.useCamera == false)) {
+        this->finishAutoTune(false);
+        ui->lAutoTuneState->setText("Lost encoders and guide star - nothing stored");
+        return;
+    } // a test that nothing has checked must not count as passed
+    if ((this->autoTuneState.hasStalled == true) && (this->autoTuneState.useEncoders == false)) {
+        this->autoTuneState.positionIsLost = true;
+    } // the guide star only tells that steps were lost, not how many
+    this->driveTuner->reportTest(this->autoTuneState.hasStalled);
+    if (this->driveTuner->isFinished() == false) {
+        this->autoTuneState.step = tnReference;
+        return;
+    }
+    if (this->driveTuner->hasFailed() == true) {
+        this->finishAutoTune(false);
+        ui->lAutoTuneState->setText(QString(this->autoTuneState.isRA ? "RA" : "Decl") + QString(" stalls at all settings") +
+            QString(this->autoTuneState.positionIsLost ? " - sync the mount" : ""));
+        return;
+    }
+    this->autoTuneState.results[axis][0] = this->driveTuner->getResult(0);
+    this->autoTuneState.results[axis][1] = this->driveTuner->getResult(1);
+    this->autoTuneState.results[axis][2] = this->driveTuner->getResult(2);
+    qDebug() << "Auto-tuning of axis" << axis << ":" << this->driveTuner->getNumberOfTests() << "tests," <<
+        this->driveTuner->getNumberOfStalls() << "stalls";
+    if (this->autoTuneState.isRA == true) {
+        this->StepperDriveRA->setStepperParams(this->autoTuneState.results[0][0], 1);
+        this->StepperDriveRA->setStepperParams(this->autoTuneState.results[0][1], 3);
+        this->autoTuneState.isRA = false;
+        this->driveTuner->start(ui->sbAMaxDecl_AMIS->value(), ui->sbCurrMaxDecl_AMIS->value(), ui->sbGoToSpeed->value());
+        this->autoTuneState.step = tnReference;
+    } else {
+        this->finishAutoTune(true);
     }
 }
 
-//---------------------------------------------------------------------------------------
-// read the coordinates from the FITS file after solving; read EQUINOX, CRVAL1 and CRVAL2 from header
-void MainWindow::psreadCoordinatesFromFITS(void) {
-    QString *newFileName, *datastring, *wcsProcess, *raString, *deString;
-    float equinox, solvedRA = 0, solvedDec = 0;
-    bool solvedCenterCoordsFound = false;
-    double meeusM, meeusN, deltaRA, deltaDecl,raRadians, declRadians,corrRA, corrDecl;
-    QProcess *readWCSInfo;
-    QStringList wcsResults;
-    int idx;
+//-------------------------------------------------------------------------
+// the results go to the GUI; the spinboxes convey them to the drives and to the global data
+void MainWindow::finishAutoTune(bool isComplete) {
+    long speed;
 
-    newFileName = new QString(g_AllData->getPathToImageToBeSolved().toLatin1());
-    wcsProcess = new QString("wcsinfo ");
-    datastring = new QString();
-    if (newFileName->isEmpty() == false) {
-        newFileName->chop(4);
-        newFileName->append("new");
+    this->autoTuneState.step = tnIdle;
+    this->autoTuneState.imageRequested = false;
+    this->StepperDriveDecl->changeMicroSteps(g_AllData->getMicroSteppingRatio(0));
+    if (isComplete == true) {
+        speed = lround(fmin(this->autoTuneState.results[0][2], this->autoTuneState.results[1][2]));
+        ui->sbAMaxRA_AMIS->setValue(lround(this->autoTuneState.results[0][0]));
+        ui->sbCurrMaxRA_AMIS->setValue(floor(this->autoTuneState.results[0][1]*10)/10.0); // the spinboxes have one decimal
+        ui->sbAMaxDecl_AMIS->setValue(lround(this->autoTuneState.results[1][0]));
+        ui->sbCurrMaxDecl_AMIS->setValue(floor(this->autoTuneState.results[1][1]*10)/10.0);
+        ui->sbGoToSpeed->setValue(speed);
+        g_AllData->setHandBoxSpeeds(ui->sbGoToSpeed->value(), ui->sbMoveSpeed->value());
+        g_AllData->storeGlobalData();
+        ui->lAutoTuneState->setText(QString("Done - GoTo speed ") + QString::number(speed) + QString("x") +
+            QString(this->autoTuneState.positionIsLost ? " - sync the mount" : ""));
+    } else {
+        this->StepperDriveRA->setStepperParams(ui->sbAMaxRA_AMIS->value(), 1);
+        this->StepperDriveRA->setStepperParams(ui->sbCurrMaxRA_AMIS->value(), 3);
+        this->StepperDriveDecl->setStepperParams(ui->sbAMaxDecl_AMIS->value(), 1);
+        this->StepperDriveDecl->setStepperParams(ui->sbCurrMaxDecl_AMIS->value(), 3);
+    } // the settings in the GUI are still the ones from before
+    if ((this->autoTuneState.trackingWasOn == true) && (this->mountMotion.RATrackingIsOn == false)) {
+        this->startRATracking();
+    }
+    if ((this->autoTuneState.trackingWasOn == false) && (this->mountMotion.RATrackingIsOn == true)) {
+        this->stopRATracking();
+    }
+    this->applyBacklashModel(g_AllData->getBacklashCompensation());
+    this->setControlsForGoto(true);
+    ui->pbAutoTune->setEnabled(true);
+    ui->pbStopAutoTune->setEnabled(false);
+}
 
-        wcsProcess->append(newFileName);
-        readWCSInfo = new QProcess();
-        readWCSInfo->start(wcsProcess->toLatin1());
-        if (!readWCSInfo->waitForStarted()) {
-            qDebug() << "Cannot read wcs data...";
+//-------------------------------------------------------------------------
+// slot called by autoTuneTimer. taking images and reading the encoders processes events, so the slot may be called again
+void MainWindow::updateAutoTune(void) {
+    const qint64 slewTimeoutInMS = 120000;
+    const double maxStarShiftInArcsec = 30; // tracking is not restarted at the exact moment
+    double x, y, stepsPerDegree;
+    bool isRA;
+
+    if ((this->autoTuneState.step == tnIdle) || (this->autoTuneState.isBusy == true)) {
+        return;
+    }
+    this->autoTuneState.isBusy = true;
+    isRA = this->autoTuneState.isRA;
+    switch (this->autoTuneState.step) {
+    case tnReference:
+        if (this->autoTuneState.imageRequested == false) {
+            this->applyTuneSettings();
+            if (this->autoTuneState.useCamera == true) {
+                this->requestTuneImage();
+                break;
+            }
         } else {
-            connect(readWCSInfo, SIGNAL(readyReadStandardOutput()), this, SLOT(psReadWCSInfoOutput()));
-            do {
-                QCoreApplication::processEvents(QEventLoop::AllEvents, 1000);
-            } while (!readWCSInfo->waitForFinished() );
-            delete readWCSInfo;
-            wcsResults = this->wcsInfoOutput->split('\n');
-            for (idx = 0; idx < wcsResults.size(); idx++) {
-                datastring->append(wcsResults.at(idx));
-                if (datastring->startsWith("ra_center ") == true) {
-                    datastring->remove("ra_center ");
-                    solvedRA = datastring->toFloat();
-                }
-                if (datastring->startsWith("dec_center ") == true) {
-                    datastring->remove("dec_center ");
-                    solvedDec = datastring->toFloat();
-                    solvedCenterCoordsFound = true;
+            if (this->camImageWasReceived == false) {
+                if (this->autoTuneState.stepElapsed.elapsed() > ui->sbExposureTime->value()*5000 + 5000) {
+                    this->autoTuneState.useCamera = false;
+                    this->autoTuneState.imageRequested = false;
+                    qDebug() << "Auto-tuning: no image from the guide camera";
                 }
-                datastring->clear();
+                break;
             }
-            if (solvedCenterCoordsFound) {
-                equinox = this->UTDate->year();
-                meeusM=(3.07234+0.00186*((equinox-1900)/100.0))*0.00416667; // factor m, J. Meeus, 3. ed, p.63, given in degrees
-                meeusN=(20.0468-0.0085*((equinox-1900)/100.0))/(3600.0);  // factor n, in degrees
-                raRadians=solvedRA/180.0*3.141592653589793;
-                declRadians=solvedDec/180.0*3.141592653589793;
-                deltaRA = meeusM+meeusN*sin(raRadians)*tan(declRadians);
-                deltaDecl = meeusN*cos(raRadians);
-                corrRA= solvedRA+deltaRA*((double)(this->UTDate->year()-equinox));
-                if (corrRA > 360) {
-                    corrRA-=360;
-                } // that one is clear,right - avoid more than 24h RA ...
-                corrDecl=solvedDec+deltaDecl*((double)(this->UTDate->year()-equinox));
-                if (corrDecl > 90) {
-                    corrDecl = 90; // don't know what else to do here
-                }
-                if (corrDecl <-90) {
-                    corrDecl = -90;
-                }
-                raString = new QString(*this->generateCoordinateString(corrRA, true));
-                deString=new QString(*this->generateCoordinateString(corrDecl, false));
-                ui->lePSRASolved->setText(*raString);
-                ui->lePSDeclSolved->setText(*deString);
-                delete raString;
-                delete deString;
-                this->psRA = corrRA;
-                this->psDecl = corrDecl;
+            if (this->getTuneStarPosition(&this->autoTuneState.starPosition[0], &this->autoTuneState.starPosition[1]) == false) {
+                this->autoTuneState.useCamera = false;
+            }
+        }
+        if ((isRA == true) && (this->mountMotion.RATrackingIsOn == true)) {
+            this->stopRATracking();
+        }
+        this->autoTuneState.testElapsed.start();
+        this->startTuneSlew(1);
+        this->autoTuneState.step = tnOut;
+        break;
+    case tnOut:
+    case tnBack:
+        this->encoderState.axisHasSlewed[isRA ? 0 : 1] = true; // the test slews are not counted in updateReadings; the encoders
+                                                            // replace step counting, as after a GoTo
+        if (this->autoTuneState.stepElapsed.elapsed() > slewTimeoutInMS) {
+            this->stopAutoTune();
+            ui->lAutoTuneState->setText("Test slew does not end");
+            break;
+        }
+        if ((this->autoTuneState.stepElapsed.elapsed() < 500) || (this->isDriveActive(isRA) == true)) {
+            break;
+        }
+        if (this->checkTuneLeg() == true) {
+            this->autoTuneState.hasStalled = true;
+        }
+        if (this->autoTuneState.step == tnOut) {
+            this->startTuneSlew(-1);
+            this->autoTuneState.step = tnBack;
+            break;
+        }
+        if (isRA == true) {
+            this->StepperDriveRA->stopDrive();
+            if (this->autoTuneState.useEncoders == false) {
+                stepsPerDegree = this->getTuneStepsPerDegree(true);
+                g_AllData->incrementActualScopePosition((this->autoTuneState.outSteps - this->autoTuneState.legSteps)/stepsPerDegree, 0.0);
+            } // the difference of the slews follows the sky
+            if (this->autoTuneState.useCamera == true) {
+                this->startRATracking();
+            }
+        } else {
+            this->StepperDriveDecl->stopDrive();
+        }
+        if (((isRA == true) && (this->StepperDriveRA->getErrorFromDriver() == true)) ||
+                ((isRA == false) && (this->StepperDriveDecl->getErrorFromDriver() == true))) {
+            this->autoTuneState.hasStalled = true;
+        }
+        if (this->autoTuneState.useEncoders == true) {
+            this->updateEncoderPosition();
+        } // the position follows the encoders at once, also after a stall
+        if (this->autoTuneState.useCamera == true) {
+            this->requestTuneImage();
+            this->autoTuneState.step = tnCheck;
+        } else {
+            this->evaluateTuneTest();
+        }
+        break;
+    case tnCheck:
+        if (this->camImageWasReceived == false) {
+            if (this->autoTuneState.stepElapsed.elapsed() > ui->sbExposureTime->value()*5000 + 5000) {
+                this->autoTuneState.imageRequested = false;
+                this->autoTuneState.useCamera = false;
+                qDebug() << "Auto-tuning: no image from the guide camera";
+                this->evaluateTuneTest();
             }
+            break;
+        }
+        if ((this->getTuneStarPosition(&x, &y) == false) ||
+                (sqrt(pow((x - this->autoTuneState.starPosition[0])*this->guiding->getArcSecsPerPix(0), 2) +
+                      pow((y - this->autoTuneState.starPosition[1])*this->guiding->getArcSecsPerPix(1), 2)) > maxStarShiftInArcsec)) {
+            this->autoTuneState.hasStalled = true;
         }
+        this->evaluateTuneTest();
+        break;
+    default:
+        break;
     }
-    delete wcsProcess;
-    delete datastring;
-    delete newFileName;
-    ui->pbSyncPS->setEnabled(true);
-    g_AllData->setBooleanPSParams(false, 0);
-    g_AllData->setBooleanPSParams(true, 1);
-    g_AllData->setBooleanPSParams(false, 2);
+    this->autoTuneState.isBusy = false;
 }
 
-//-----------------------------------------------------------------------------------------------
-// a slot that syncs to the found coordinates
-void MainWindow::syncPSCoordinates(void) {
-    if (g_AllData->getBooleanPSParams(1) == true) {
-        this->ra = this->psRA;
-        this->decl = this->psDecl;
-        this->syncMount();
-        ui->pbSyncPS->setEnabled(false);
+//-------------------------------------------------------------------------
+// one record of the flight recorder. the position is the one counted in updateReadings; the rates are the
+// ones sent to the drives, so a motion that is not counted shows up as a rate without a change in position.
+// the step counters are the cached ones of the drives; a long move such as tracking is counted every 5 s
+void MainWindow::recordFlightData(TSC_FlightRecorder::flightEvent event, float pulseRA, float pulseDecl) {
+    struct TSC_FlightRecorder::flightRecordStruct rec;
+    uint16_t flags = 0;
+
+    if (this->flightRecorder->isOpen() == false) {
+        return;
+    }
+    if (this->mountMotion.RATrackingIsOn == true) {
+        flags |= TSC_FlightRecorder::ffTracking;
+    }
+    if (this->mountMotion.GoToIsActiveInRA == true) {
+        flags |= TSC_FlightRecorder::ffGoToRA;
+    }
+    if (this->mountMotion.GoToIsActiveInDecl == true) {
+        flags |= TSC_FlightRecorder::ffGoToDecl;
+    }
+    if (this->mountMotion.RADriveIsMoving == true) {
+        flags |= TSC_FlightRecorder::ffRAMoving;
+    }
+    if (this->mountMotion.DeclDriveIsMoving == true) {
+        flags |= TSC_FlightRecorder::ffDeclMoving;
+    }
+    if (this->guidingState.guidingIsOn == true) {
+        flags |= TSC_FlightRecorder::ffGuiding;
+    }
+    if (g_AllData->getMFlipParams(1) == true) {
+        flags |= TSC_FlightRecorder::ffEast;
+    }
+    if (this->parkState.step == pkParked) {
+        flags |= TSC_FlightRecorder::ffParked;
+    }
+    if ((ui->cbErrRA->isChecked() == true) || (ui->cbErrDecl->isChecked() == true)) {
+        flags |= TSC_FlightRecorder::ffDriverError;
+    } // polled in getDriveError
+    if (this->flightRecorderCountElapsed.elapsed() > 5000) {
+        this->StepperDriveRA->refreshStepCounter();
+        this->StepperDriveDecl->refreshStepCounter();
+        this->flightRecorderCountElapsed.restart();
+    } // in between, the counters are the ones of the last stop, which costs no "f5" on the USB
+    rec.event = event;
+    rec.flags = flags;
+    rec.stepsRA = this->StepperDriveRA->getStepCounter();
+    rec.stepsDecl = this->StepperDriveDecl->getStepCounter(); // as counted by the drives, not by the model of the position
+    rec.rateRA = this->StepperDriveRA->getCommandedRate()*3600.0;
+    rec.rateDecl = this->StepperDriveDecl->getCommandedRate()*3600.0;
+    rec.guidePulseRA = pulseRA;
+    rec.guidePulseDecl = pulseDecl;
+    rec.usbLatencyRA = amisInterface->getRoundTripTime(true);
+    rec.usbLatencyDecl = amisInterface->getRoundTripTime(false);
+    rec.flipStep = this->mflipState.step;
+    rec.sequencerStep = this->sequencerState.step;
+    this->flightRecorder->record(&rec);
+}
+
+//-------------------------------------------------------------------------
+//-------------------------------------------------------------------------
+// calibration of the tracking rates. the tracking mount is plate solved a few times, minutes apart; the drift
+// of the solutions gives the rate error of the RA drive and the tilt of the polar axis, see TSC_DriftCalibration.
+// every run is a field of its own; fields at different hour angles tell the tilt up and east apart, so the
+// solutions are kept until the calibration is reset. every image is a new exposure of the DSLR; TSC cannot
+// download it, so the camera software has to write it to the image to be solved. a run without new images
+// stops and stores nothing, as solving the same image again gives no drift.
+void MainWindow::startDriftCalibration(void) {
+    if ((this->driftCalState.step != dcIdle) || (this->mountMotion.GoToIsActiveInRA == true) ||
+            (this->mountMotion.GoToIsActiveInDecl == true) || (this->mountMotion.RADriveIsMoving == true) ||
+            (this->mountMotion.DeclDriveIsMoving == true) || (this->guidingState.guidingIsOn == true) ||
+            (this->guidingState.calibrationIsRunning == true) || (this->sequencerState.step != sqIdle) ||
+            (this->mflipState.step != mfIdle) || (this->autoTuneState.step != tnIdle) ||
+            (this->dslrStates.dslrSeriesRunning == true) || (this->dslrStates.dslrExposureIsRunning == true)) {
+        ui->lDriftCalState->setText("Mount is busy");
+        return;
+    }
+    if ((this->mountMotion.RATrackingIsOn == false) || (g_AllData->wasMountSynced() == false)) {
+        ui->lDriftCalState->setText("Sync the mount and start tracking");
+        return;
+    }
+    if (g_AllData->getPathToImages().length() == 0) {
+        ui->lDriftCalState->setText("No directory for plate solving");
+        return;
+    }
+    this->driftCalibration->startField(g_AllData->getTrackingCalibrationCorrection());
+    this->driftCalState.frames = 0;
+    this->driftCalState.runElapsed.start();
+    ui->pbStartDriftCal->setEnabled(false);
+    ui->pbStopDriftCal->setEnabled(true);
+    this->startDriftCalFrame();
+}
+
+//-------------------------------------------------------------------------
+void MainWindow::stopDriftCalibration(void) {
+    if (this->driftCalState.step == dcIdle) {
+        return;
+    }
+    if ((this->driftCalState.step == dcExposing) && (this->dslrStates.dslrExposureIsRunning == true)) {
+        this->terminateDSLRSingleShot();
+    }
+    if (this->astroMetryProcess->state() != QProcess::NotRunning) {
+        this->psKillAstrometryNet();
+    }
+    this->finishDriftCalibration(false);
+    ui->lDriftCalState->setText("Stopped");
+}
+
+//-------------------------------------------------------------------------
+// forgets all fields; tracking goes back to the plain celestial speed
+void MainWindow::resetDriftCalibration(void) {
+    if (this->driftCalState.step != dcIdle) {
+        return;
+    }
+    this->driftCalibration->clear();
+    this->driftCalibration->setModel(0, 0, 0);
+    g_AllData->setTrackingCalibration(0, 0, 0);
+    g_AllData->storeGlobalData();
+    this->showDriftCalibration();
+    this->updateTrackingRates();
+}
+
+//-------------------------------------------------------------------------
+// a slot for the checkbox that applies the calibration to the tracking rates
+void MainWindow::switchDriftCorrection(void) {
+    g_AllData->setTrackingCalibrationCorrection(ui->cbDriftCorrection->isChecked());
+    g_AllData->storeGlobalData();
+    if (this->driftCalState.step != dcIdle) {
+        this->driftCalibration->startField(g_AllData->getTrackingCalibrationCorrection());
+    } // the drift changes from here on
+    this->updateTrackingRates();
+}
+
+//-------------------------------------------------------------------------
+// the image is stamped with the middle of the exposure
+void MainWindow::startDriftCalFrame(void) {
+    double duration;
+
+    duration = ui->sbDSLRDuration->value();
+    this->driftCalState.imageTime = this->driftCalState.runElapsed.elapsed()/1000.0 + duration/2.0;
+    this->driftCalState.imageLST = g_AllData->getLocalSTime() + 1.0027379*duration/7200.0;
+    this->driftCalState.step = dcExposing;
+    this->driftCalState.stepElapsed.start();
+    ui->lDriftCalState->setText(QString("Exposing image ") + QString::number(this->driftCalState.frames + 1) + QString(" of ") +
+                                QString::number(ui->sbDriftCalFrames->value()));
+    this->psExposeImage(duration);
+}
+
+//-------------------------------------------------------------------------
+void MainWindow::finishDriftCalibration(bool fitModel) {
+    this->driftCalState.step = dcIdle;
+    ui->pbStartDriftCal->setEnabled(true);
+    ui->pbStopDriftCal->setEnabled(false);
+    if (fitModel == false) {
+        return;
+    }
+    if (this->driftCalibration->fitModel() == false) {
+        ui->lDriftCalState->setText("Too few solutions for a calibration");
+        return;
+    }
+    g_AllData->setTrackingCalibration(this->driftCalibration->getRateError(), this->driftCalibration->getPoleOffset(0),
+                                      this->driftCalibration->getPoleOffset(1));
+    g_AllData->storeGlobalData();
+    this->showDriftCalibration();
+    qDebug() << "Tracking calibration from" << this->driftCalibration->getNumberOfFields() << "fields, residual"
+             << this->driftCalibration->getResidual() << "arcsec/min";
+    this->updateTrackingRates();
+}
+
+//-------------------------------------------------------------------------
+// the rate error is also shown as the gear ratio of RA that the drive actually has
+void MainWindow::showDriftCalibration(void) {
+    double rateError, gearRatio;
+
+    rateError = g_AllData->getTrackingCalibration(0);
+    if ((rateError == 0) && (g_AllData->getTrackingCalibration(1) == 0) && (g_AllData->getTrackingCalibration(2) == 0)) {
+        ui->lDriftCalState->setText("No calibration");
+        return;
+    }
+    gearRatio = g_AllData->getGearData(0)*g_AllData->getGearData(1)*g_AllData->getGearData(2)/(1.0 - rateError);
+    ui->lDriftCalState->setText(QString("Rate ") + QString::number(100.0*rateError, 'f', 3) + QString("%, pole ") +
+                                QString::number(g_AllData->getTrackingCalibration(1), 'f', 1) + QString("' up ") +
+                                QString::number(g_AllData->getTrackingCalibration(2), 'f', 1) + QString("' E, gear ") +
+                                QString::number(gearRatio, 'f', 1));
+}
+
+//-------------------------------------------------------------------------
+// slot called by driftCalTimer. any motion of the mount other than tracking ends the field
+void MainWindow::updateDriftCalibration(void) {
+    const qint64 solvingTimeoutInMS = 180000;
+    const qint64 imageTimeoutInMS = 120000; // time for the camera software to write the image after the exposure
+
+    if ((this->driftCalState.step == dcIdle) || (this->driftCalState.isBusy == true)) {
+        return;
+    }
+    this->driftCalState.isBusy = true;
+    if ((this->mountMotion.RATrackingIsOn == false) || (this->mountMotion.GoToIsActiveInRA == true) ||
+            (this->mountMotion.GoToIsActiveInDecl == true) || (this->mountMotion.RADriveIsMoving == true) ||
+            (this->mountMotion.DeclDriveIsMoving == true) || (this->guidingState.guidingIsOn == true) ||
+            (this->guidingState.st4IsActive == true)) {
+        this->finishDriftCalibration(this->driftCalState.step == dcWaiting);
+        if (this->driftCalState.frames < 2) {
+            ui->lDriftCalState->setText("Mount moved - calibration stopped");
+        }
+        this->driftCalState.isBusy = false;
+        return;
+    }
+    switch (this->driftCalState.step) {
+    case dcExposing:
+        if (this->psNewImageIsAvailable() == true) {
+            this->driftCalState.step = dcSolving;
+            this->driftCalState.stepElapsed.start();
+            ui->lDriftCalState->setText(QString("Solving image ") + QString::number(this->driftCalState.frames + 1) + QString(" of ") +
+                                        QString::number(ui->sbDriftCalFrames->value()));
+            this->psStartSolving();
+        } else if ((this->dslrStates.dslrExposureIsRunning == false) &&
+                   (this->driftCalState.stepElapsed.elapsed() > this->dslrStates.dslrExpTime*1000 + imageTimeoutInMS)) {
+            this->finishDriftCalibration(false);
+            ui->lDriftCalState->setText("No new image from the main camera - calibration stopped");
+        }
+        break;
+    case dcSolving:
+        if ((g_AllData->getBooleanPSParams(0) == false) && (this->astroMetryProcess->state() == QProcess::NotRunning)) {
+            if (g_AllData->getBooleanPSParams(1) == true) {
+                this->driftCalibration->addSolution(this->driftCalState.imageTime, this->driftCalState.imageLST, this->psRA, this->psDecl);
+            } else {
+                qDebug() << "Tracking calibration: plate solving failed";
+            }
+            this->driftCalState.frames++;
+            if (this->driftCalState.frames >= ui->sbDriftCalFrames->value()) {
+                this->finishDriftCalibration(true);
+            } else {
+                this->driftCalState.step = dcWaiting;
+                this->driftCalState.stepElapsed.start();
+                ui->lDriftCalState->setText(QString("Waiting for image ") + QString::number(this->driftCalState.frames + 1));
+            }
+        } else {
+            if (this->driftCalState.stepElapsed.elapsed() > solvingTimeoutInMS) {
+                this->psKillAstrometryNet(); // the next call finds the process finished without success
+            }
+        }
+        break;
+    case dcWaiting:
+        if (this->driftCalState.stepElapsed.elapsed() > ui->sbDriftCalInterval->value()*60000) {
+            this->startDriftCalFrame();
+        }
+        break;
+    default:
+        break;
     }
+    this->driftCalState.isBusy = false;
 }
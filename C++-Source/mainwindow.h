@@ -19,6 +19,7 @@
 #include <QtWidgets/QMainWindow>
 #include <QListWidgetItem>
 #include <QElapsedTimer>
+#include <QDateTime>
 #include <QFile>
 #include <QtSerialPort/QSerialPort>
 #include <QtSerialPort/QSerialPortInfo>
@@ -34,6 +35,21 @@
 #include "wiringPi.h"
 #include "ocv_guiding.h"
 #include "spi_drive.h"
+#include "tsc_refraction.h"
+#include "ephemerisTable.h"
+#include "tsc_sequencer.h"
+#include "tsc_slewtimemodel.h"
+#include "tsc_horizonmask.h"
+#include "tsc_encoderfusion.h"
+#include "tsc_coordinatebatch.h"
+#include "tsc_drivetuner.h"
+#include "tsc_flightrecorder.h"
+#include "tsc_slewplanner.h"
+#include "tsc_mountcontrol.h"
+#include "tsc_driftcalibration.h"
+#include "tsc_fitsheader.h"
+#include "tsc_guidealgorithm.h"
+#include "tsc_guidelog.h"
 
 namespace Ui {
 class MainWindow;
@@ -44,6 +60,11 @@ class MainWindow : public QMainWindow {
 
 public:
     enum driveSpeed {guideTrack, move, slew};
+    enum sequencerStep {sqIdle, sqStartSlew, sqSlewing, sqSettling, sqPSExposing, sqSolving, sqExposing};
+    enum mflipStep {mfIdle, mfSlewing, mfSettling, mfReacquiring, mfGuiding};
+    enum parkStep {pkIdle, pkParking, pkParked, pkHomingRA, pkHomingDecl};
+    enum autoTuneStep {tnIdle, tnReference, tnOut, tnBack, tnCheck};
+    enum driftCalStep {dcIdle, dcExposing, dcSolving, dcWaiting};
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow();
 
@@ -81,7 +102,7 @@ private slots: // callbacks for (mainly) GUI widgets
     void killHandBoxMotion(void);
     void setCorrectionSpeed(void);
     void setMoveSpeed(void);
-    void startGoToObject(void);
+    void startGoToFromGUI(void);
     void changeMoveSpeed(void);
     void invertRADirection(void);
     void IPaddressChosen(void);
@@ -106,6 +127,7 @@ private slots: // callbacks for (mainly) GUI widgets
     void LXsyncMount(void);
     void LXslewMount(void);
     void displayGuideCamImage(QPixmap*);
+    void startNextCamShot(void); // called when the data of an exposure have arrived
     void emergencyStop(void);
     void handleServerMessage(void);
     void deployINDICommand(void);
@@ -123,10 +145,14 @@ private slots: // callbacks for (mainly) GUI widgets
     void LXSetNumberFormatToSimple(void);
     void enableCamImageStorage(void);
     void selectGuideStar(void);
+    void findGuideStar(void);
     void doAutoGuiding(void);
     void displayGuideStarPreview(void);
     void changePrevImgProc(void);
     void changeGuideScopeFL(void);
+    void changeCentroidMethod(void);
+    void changeNumberOfGuideStars(void);
+    void changeGuideAlgorithm(void);
     void storeGuideScopeFL(void);
     void setHalfFOV(void);
     void setDoubleFOV(void);
@@ -199,8 +225,42 @@ private slots: // callbacks for (mainly) GUI widgets
     void psHandleEndOfAstronomyNetProcess(int, QProcess::ExitStatus);
     void psKillAstrometryNet(void);
     void psDisplayAstrometryNetOutput(void);
-    void psReadWCSInfoOutput(void);
     void syncPSCoordinates(void);
+    void setRefractionCorrection(void);
+    void setAtmosphericPressure(void);
+    void setEphemerisTracking(void);
+    void updateTrackingRates(void);
+    void seqAddObject(void);
+    void seqLoadSequence(void);
+    void seqRemoveObject(void);
+    void seqClearSequence(void);
+    void seqOptimizeOrder(void);
+    void seqStart(void);
+    void seqStop(void);
+    void updateSequencer(void);
+    void setAutoMFlip(void);
+    void setMFlipLimit(void);
+    void updateMeridianFlip(void);
+    void storeMountLimits(void);
+    void loadHorizonProfile(void);
+    void clearHorizonProfile(void);
+    void setHideUnreachable(void);
+    void updateCatalogVisibility(void);
+    void storeBacklash(void);
+    void setBacklashCompensation(void);
+    void updateEncoderPosition(void);
+    void storeEncoderSettings(void);
+    void unparkMount(void);
+    void startHoming(void);
+    void updateParkState(void);
+    void startAutoTune(void);
+    void stopAutoTune(void);
+    void updateAutoTune(void);
+    void startDriftCalibration(void);
+    void stopDriftCalibration(void);
+    void updateDriftCalibration(void);
+    void resetDriftCalibration(void);
+    void switchDriftCorrection(void);
 
 private:
     struct mountMotionStruct { // a struct holding all relevant data ont the state of the mount
@@ -217,6 +277,7 @@ private:
         qint64 RAtrackingElapsedTimeInMS; // timestamp for elapsed time of the tracking since last call to clock-sync
         qint64 RAMoveElapsedTimeInMS;
         qint64 DeclMoveElapsedTimeInMS; // timestamp for elapsed time of the tracking since last call to clock-sync
+        qint64 DeclTrackingElapsedTimeInMS; // same for the slow motion of the decl drive when tracking moving objects
         qint64 RAGoToElapsedTimeInMS;
         qint64 DeclGoToElapsedTimeInMS;
         bool btMoveNorth; // true when handbox command is active
@@ -242,11 +303,10 @@ private:
         double maxDevInArcSec; // maximum error in seconds of arc duign guiding
         double rmsDevInArcSec; // rms error in " during guiding
         double rmsDevInArcSecSum; // running sum of squared errors for RMS computation
-        double backlashCompensationInMS; // additional pulse to be issued if declination travel is inverted
         long noOfGuidingSteps; // number of acquired autoguider images
+        bool correctionIsRunning; // images that arrive while the mount is corrected are only displayed
         bool st4IsActive; // true if ST4 is active
-        float raErrs[3];
-        float declErrs[3];
+        QElapsedTimer frameTimer; // the time of the guide frames for the guide algorithms
     };
 
     struct DSLRStateStruct {
@@ -261,6 +321,65 @@ private:
         float tempAtSeriesStart;
     };
 
+    struct sequencerStateStruct { // the state of an unattended session with several targets
+        sequencerStep step; // what the sequencer does right now
+        long currentTarget; // index of the target in the sequence
+        short verificationAttempts; // number of re-slews after plate solving for the current target
+        bool isBusy; // guards updateSequencer against being re-entered while events are processed
+        QElapsedTimer stepElapsed; // time spent in the current step
+    };
+
+    struct mflipStateStruct { // the state of a meridian flip carried out during an exposure series
+        mflipStep step; // what the flip routine does right now
+        bool seriesOnHold; // the exposure series waits at an exposure boundary until the flip is done
+        bool guidingWasOn; // guiding is stopped for the flip and restarted afterwards
+        bool mountWasFlipped; // true if the GoTo has really changed the side of the pier
+        bool isBusy; // guards updateMeridianFlip against being re-entered while events are processed
+        float savedRA; // the object chosen in the catalog, restored after the flip GoTo
+        float savedDecl;
+        QElapsedTimer stepElapsed;
+    };
+
+    struct parkStateStruct { // parking, unparking and homing against the limit switches
+        parkStep step;
+        bool learnsHome; // the mount is synced, and the position of the home switches is stored
+        bool isBusy; // reading the switches processes events, so the slot may be called again
+        short homingPhase; // 0 searches the switch at the homing speed, 1 backs off from it, 2 approaches it slowly
+        short homingDirection; // +1 towards the switch, -1 away from it
+        float homingSpeed; // multiple of the sidereal speed in the current phase
+        bool waitsForRest; // the drive was stopped and runs down its ramp
+        QElapsedTimer stepElapsed;
+    };
+
+    struct autoTuneStateStruct { // test slews for finding the acceleration, current and GoTo speed the drives can carry
+        autoTuneStep step;
+        bool isRA; // the axis under test; RA is tested first
+        bool isBusy;
+        bool useEncoders; // stalls are detected from the travel measured by the encoders ...
+        bool useCamera; // ... and from the position of the guide star before and after the test
+        bool imageRequested;
+        bool trackingWasOn;
+        bool hasStalled; // a stall was detected in the current test
+        bool positionIsLost; // a test stalled, and there were no encoders to correct the position
+        long outSteps; // microsteps of the slew away from the start
+        long legSteps; // microsteps of the slew that is running
+        long encoderCounts; // counts at the start of the slew that is running
+        double starPosition[2]; // ccd x and y of the guide star at the start of the test
+        double results[2][3]; // acceleration, current and GoTo speed found for RA and declination
+        QElapsedTimer testElapsed; // RA stands still from the reference image on
+        QElapsedTimer stepElapsed;
+    };
+
+    struct encoderStateStruct { // bookkeeping for fusing the readings of the axis encoders with step counting
+        bool hasPosition; // false until the first readings after a sync, a pole crossing or a change of the settings
+        bool axisHasSlewed[2]; // a GoTo or a handbox motion took place since the last readings
+        bool isReading; // the readout waits for the hardware, and the timer must not start a second one
+        double lastHA; // the position after the last readings
+        double lastDecl;
+        qint64 lastTimeSinceSync;
+        short lastDeclSign;
+    };
+
     struct currentCommunicationParameters {
         bool chan0IsOpen;
         bool chan1IsOpen;
@@ -280,9 +399,25 @@ private:
     struct mountMotionStruct mountMotion;
     struct currentGuideStarPosition guideStarPosition;
     struct guidingStateStruct guidingState;
+    struct driftCalStateStruct { // plate solves of the tracking mount for calibrating the tracking rates
+        driftCalStep step;
+        bool isBusy;
+        long frames; // images taken in this run
+        double imageTime; // time in s since the start of the run and LST at the middle of the last exposure
+        double imageLST;
+        QElapsedTimer runElapsed;
+        QElapsedTimer stepElapsed;
+    };
+
     struct DSLRStateStruct dslrStates;
     struct currentCommunicationParameters commSPIParams;
     struct ST4StateStruct st4State;
+    struct sequencerStateStruct sequencerState;
+    struct mflipStateStruct mflipState;
+    struct encoderStateStruct encoderState;
+    struct parkStateStruct parkState;
+    struct autoTuneStateStruct autoTuneState;
+    struct driftCalStateStruct driftCalState;
     driveSpeed raState = guideTrack;
     driveSpeed deState = guideTrack;
     QtContinuousStepper *StepperDriveRA;
@@ -294,6 +429,14 @@ private:
     QTimer *tempUpdateTimer;
     QTimer *tcpHandBoxSendTimer;
     QTimer *checkDriveTimer;
+    QTimer *trackingRateTimer;
+    QTimer *sequencerTimer;
+    QTimer *mflipTimer;
+    QTimer *horizonTimer; // the sky turns, so the list of reachable catalog objects is refreshed
+    QTimer *encoderTimer;
+    QTimer *parkTimer;
+    QTimer *autoTuneTimer;
+    QTimer *driftCalTimer;
     QDate *UTDate;
     QTime *UTTime;
     QTimeZone *timeZone;
@@ -302,9 +445,23 @@ private:
     QPixmap *camImg;
     QPixmap *guideStarPrev;
     currentObjectCatalog *objCatalog;
+    ephemerisTable *ephemeris; // the table of positions of a moving object, NULL if a regular catalog is chosen
     QDisplay2D *camView;
     QElapsedTimer *elapsedGoToTime;
     ocv_guiding *guiding; // the class that does image processing for guiding
+    TSC_Refraction *refraction; // the model for atmospheric refraction
+    TSC_Sequencer *sequencer; // the list of targets for an unattended session
+    TSC_SlewTimeModel *slewTimeModel; // the ETA of GoTos, calibrated from measured slews
+    TSC_SlewPlanner *slewPlanner; // moves both axes of a GoTo on a straight line, split at waypoints if needed
+    TSC_MountControl *mountControl; // the drive commands of GoTos and guide steps, shared with the night benchmark of the simulator
+    TSC_HorizonMask *horizonMask; // horizon profile and mount limits of the site
+    TSC_CoordinateBatch *catalogPositions; // alt/az of all objects in the chosen catalog, computed at once
+    TSC_DriveTuner *driveTuner; // proposes the settings for the test slews of the auto-tuning
+    TSC_FlightRecorder *flightRecorder; // records the state of the mount at every tick of the event queue
+    QElapsedTimer flightRecorderCountElapsed; // the drives are asked for the steps of a running move every few seconds only
+    TSC_DriftCalibration *driftCalibration; // rate error of the RA drive and tilt of the polar axis from the drift of plate solved images
+    TSC_EncoderFusion *encoderFusion; // corrects the position from step counting with the readings of the axis encoders
+    TSC_GuideAlgorithm *guideAlgorithm[2]; // turns the deviation of the guide star into the guide pulses in RA and decl
     ccd_client *camera_client;
     ccd_client *psMaincamera_client;
     QTcpServer *LXServer;
@@ -321,6 +478,8 @@ private:
     SPI_Drive *spiDrOnChan0;
     short initiateStepperDrivers(void);
     void terminateGoTo(bool);
+    void startSlewSegment(long);
+    void storeSlewTimeModel(short);
     bool LX200SerialPortIsUp;
     bool camImageWasReceived; // a flag set to true if a cam image came in
     bool lx200IsOn;
@@ -336,16 +495,20 @@ private:
     float ra; // right ascension of a current object
     float decl;// declination of a current object
     double gotoETA; // estimated time of arrival for goto
+    long slewSegment = 0; // the part of a GoTo between two waypoints that is carried out
     float targetRA;
     float targetDecl;  // coordinates for GoTo
     float psRA = 0;
     float psDecl = 0; // coordinates from platesolving
+    QDateTime psExposureStart; // the image to be solved has to be written after this
     short RAdriveDirectionForNorthernHemisphere;
     double approximateGOTOSpeedDecl;  // for display of travel, store an average travel speed here,
     double approximateGOTOSpeedRA;    // taking into account the acceleration ramps...
     float guidingFOVFactor;
     double rotMatrixGuidingXToRA[2][2];
     float temperature;
+    double declStepsPending = 0; // fractions of microsteps in declination not yet carried out by the decl drive when tracking
+    double raStepsPending = 0; // the same for the RA drive, whose tracking speed is also an integer
     int pulseGuideDuration;
     QString *textEntry;
     QString *bt_HandboxCommand;
@@ -353,8 +516,7 @@ private:
     QString *currentDeclString;
     QString *currentHAString;
     QString *coordString;
-    QString *wcsInfoOutput;
-    QFile *guidingLog;
+    TSC_GuideLog *guidingLog; // "GuidingLog.csv", one row per guide frame
     QProcess *astroMetryProcess;
     qint64 *ametryPID;
     bool isDriveActive(bool);
@@ -382,7 +544,6 @@ private:
     void declPGMinusGd(long);
     void raPGFwdGd(long);
     void raPGBwdGd(long);
-    void compensateDeclBacklashPG(short);
     void handleST4State(void);
     void doDeclinationMoveForST4(short);
     bool getCCDParameters(bool);
@@ -423,6 +584,44 @@ private:
     short checkForFlip(bool, float, float, float, float);
     double psComputeFOVForMainCCD(void);
     void psreadCoordinatesFromFITS(void);
+    void correctTargetForRefraction(float*, float*);
+    void stopDeclTracking(void);
+    double getCurrentJulianDate(void);
+    void seqUpdateList(void);
+    void seqSetSlewParameters(void);
+    void seqSetControls(bool);
+    void seqStartExposures(void);
+    void psExposeImage(int); // a DSLR exposure of the given seconds for plate solving
+    bool psNewImageIsAvailable(void); // true once the exposure is done and the image to be solved was written after its start
+    bool mfGetTimeToFlip(double*, double*); // seconds until the meridian and until the flip limit are reached
+    bool mfIsDue(double); // true if the flip limit is reached within the given number of seconds
+    void mfResumeSeries(void);
+    void mfRotateGuidingCalibration(void);
+    void updateHorizonMask(void);
+    void updateHorizonList(void);
+    bool isTargetReachable(double, double); // RA and decl in degrees
+    void startGoToObject(bool); // true shows a message box if the GoTo is not possible
+    void applyBacklashModel(bool); // passes the backlash of both axes to the drives and switches compensation on or off
+    void applyEncoderSettings(void);
+    bool readEncoder(bool, long*); // true for RA; returns false if no valid counts were received
+    void restoreParkedPosition(void);
+    short readHomeSwitch(bool); // true for RA; 1 if the switch is closed, 0 if it is open, -1 if there is no switch
+    void toggleHomingMotion(bool, short, float); // starts or stops the motion of an axis when homing; true for RA,
+                                                 // +1 towards the switch, multiple of the sidereal speed
+    void startHomingPhase(bool, short); // true for RA and the phase as in parkStateStruct
+    void finishHoming(bool); // true if the switches were found
+    double getTuneStepsPerDegree(bool); // microsteps per degree of an axis at the microstepping ratio for slews
+    void applyTuneSettings(void);
+    void startTuneSlew(short); // +1 away from the start, -1 back
+    bool checkTuneLeg(void); // true if the encoder saw less travel than commanded
+    void requestTuneImage(void);
+    bool getTuneStarPosition(double*, double*);
+    void evaluateTuneTest(void);
+    void finishAutoTune(bool); // true if both axes were tuned and the results are to be stored
+    void startDriftCalFrame(void);
+    void finishDriftCalibration(bool); // true if the model is to be fitted to the solutions
+    void showDriftCalibration(void);
+    void recordFlightData(TSC_FlightRecorder::flightEvent, float, float); // event and guide pulses in RA and decl in ms
 
 signals:
     void dslrExposureDone(void);
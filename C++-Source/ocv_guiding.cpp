@@ -38,6 +38,11 @@ ocv_guiding::ocv_guiding(void) {
     this->arcsecPerPixX=1.07276;
     this->arcsecPerPixY=1.07276;
     this->maxGrayVal = 0;
+    this->centroidEngine = new TSC_Centroid();
+    this->starEnsemble = new TSC_StarEnsemble();
+    this->starFinder = new TSC_StarFinder();
+    this->starParameters[0] = this->starParameters[1] = this->starParameters[2] = 0;
+    this->starFound = false;
 }
 
 //---------------------------------------------------
@@ -47,15 +52,19 @@ ocv_guiding::~ocv_guiding() {
     delete myVec;
     delete processedImage;
     delete prevPMap;
+    delete centroidEngine;
+    delete starEnsemble;
+    delete starFinder;
 }
 
 //---------------------------------------------------
+// wraps the pixels of the QImage without copying them; the matrix must not be written to
 void ocv_guiding::convertQImgToMat(void) {
 
     this->currentImageOCVMat=Mat(this->currentImageQImg->height(),
     this->currentImageQImg->width(), CV_8UC1,
-    const_cast<uchar*>(this->currentImageQImg->bits()),
-    static_cast<size_t>(this->currentImageQImg->bytesPerLine())).clone();
+    const_cast<uchar*>(this->currentImageQImg->constBits()),
+    static_cast<size_t>(this->currentImageQImg->bytesPerLine()));
 }
 
 //---------------------------------------------------
@@ -94,12 +103,28 @@ double ocv_guiding::getArcSecsPerPix(short what) {
     }
 }
 
+//---------------------------------------------------
+void ocv_guiding::setCentroidEstimator(short est) {
+    this->centroidEngine->setEstimator(est);
+    this->starEnsemble->setEstimator(est);
+    this->starFinder->setEstimator(est);
+}
+
+//---------------------------------------------------
+float ocv_guiding::getStarParameter(short what) {
+    if ((what < 0) || (what > 2)) {
+        return 0;
+    }
+    return this->starParameters[what];
+}
+
 //---------------------------------------------------
 // reports whether pixels in the analysed picture are at
 // saturation - this is to be avoided. an alarm can be set if this
-// function return true
+// function return true. 16 bit images are stretched to 250 at most, and
+// only the pixels saturated on the chip are above, see TSC_FitsDecoder
 bool ocv_guiding::isPixelAtSaturation(void) {
-    if (this->maxGrayVal < 250) {
+    if (this->maxGrayVal <= 250) {
         return false;
     } else {
         return true;
@@ -108,70 +133,238 @@ bool ocv_guiding::isPixelAtSaturation(void) {
 
 //---------------------------------------------------
 // computes the centroid of a star in a subimage and
-// does all the image processing for guiding
+// does all the image processing for guiding. the centroid is taken by
+// TSC_Centroid from the pixels of the camera image, or from the filtered subimage
+// if a filter is selected; threshold, contrast and brightness only change the preview
 void ocv_guiding::doGuideStarImgProcessing(int gsThreshold,bool medianOn, bool lpOn, float cntrst,int briteness,float FOVfact,bool starSelected, bool updateCentroid) {
+    struct guideStarMeasurementStruct measurement;
+
+    if (starSelected==true) {
+        *this->currentImageQImg = *g_AllData->getCameraImage(); // a shallow copy; constBits() does not detach it
+        if (measureGuideStar(*this->currentImageQImg, g_AllData->getInitialStarPosition(2), g_AllData->getInitialStarPosition(3),
+                gsThreshold, medianOn, lpOn, cntrst, briteness, FOVfact, this->centroidEngine, &measurement) == true) {
+            this->applyGuideStarMeasurement(&measurement, updateCentroid);
+        } else {
+            this->starFound = false;
+        }
+    }
+}
+
+//---------------------------------------------------
+// the image processing of "doGuideStarImgProcessing" without the state of the class, so that it can also run
+// in the detection stage of TSC_GuidePipeline with an engine of its own. the star is searched around the
+// given position in pixels of the camera image; false if the subimage is too small for a star
+bool ocv_guiding::measureGuideStar(const QImage &camImage, float ccdX, float ccdY, int gsThreshold, bool medianOn, bool lpOn,
+        float cntrst, int briteness, float FOVfact, TSC_Centroid *engine, struct guideStarMeasurementStruct *result) {
     int clicx,clicy;
     Point tLeft, bRight;
     float centroidX, centroidY;
+    cv::Mat fullImage, subImage, filteredImage, previewImage;
     QImage *prevImg;
-    cv::Mat mask;
-    cv::Moments cvmoms;
-    float scaleFact;
-    double minPixVal, maxPixVal;
+    bool starFound;
 
-    if (starSelected==true) {
-        delete currentImageQImg;
-        this->currentImageQImg = new QImage(*g_AllData->getCameraImage());
-        clicx = round(g_AllData->getInitialStarPosition(2));
-        clicy = round(g_AllData->getInitialStarPosition(3));
-        convertQImgToMat();
-        tLeft.x=clicx-(90*FOVfact);
-        tLeft.y=clicy-(90*FOVfact);
-        bRight.x=clicx+(90*FOVfact);
-        bRight.y=clicy+(90*FOVfact);
-        if (tLeft.x < 0) {
-            tLeft.x=0;
-        }
-        if (tLeft.y < 0) {
-            tLeft.y=0;
-        }
-        if (bRight.x > maxX) {
-            bRight.x = maxX;
-        }
-        if (bRight.y > maxY) {
-            bRight.y = maxY;
-        }
-        Rect R(tLeft,bRight); //Create a rect
-        this->currentImageOCVMat = this->currentImageOCVMat(R).clone(); //Crop the region of interest using above rect
-        this->currentImageOCVMat.convertTo(this->currentImageOCVMat, -1, cntrst, briteness); // do intensity operations
+    clicx = round(ccdX);
+    clicy = round(ccdY);
+    fullImage = Mat(camImage.height(), camImage.width(), CV_8UC1, const_cast<uchar*>(camImage.constBits()),
+        static_cast<size_t>(camImage.bytesPerLine())); // the pixels of the camera image; the filters write into other matrices
+    tLeft.x=clicx-(90*FOVfact);
+    tLeft.y=clicy-(90*FOVfact);
+    bRight.x=clicx+(90*FOVfact);
+    bRight.y=clicy+(90*FOVfact);
+    if (tLeft.x < 0) {
+        tLeft.x=0;
+    }
+    if (tLeft.y < 0) {
+        tLeft.y=0;
+    }
+    if (bRight.x > fullImage.cols) {
+        bRight.x = fullImage.cols;
+    }
+    if (bRight.y > fullImage.rows) {
+        bRight.y = fullImage.rows;
+    } // maxX and maxY are the chip size, which the image may not have yet
+    if ((bRight.x-tLeft.x < 8) || (bRight.y-tLeft.y < 8)) {
+        return false;
+    }
+    Rect R(tLeft,bRight); //Create a rect
+    subImage = fullImage(R); // the region of interest, sharing the pixels of the camera image
+    if ((medianOn == true) || (lpOn == true)) {
         if (medianOn== true) {
-            cv::medianBlur(this->currentImageOCVMat,this->currentImageOCVMat, 3);
+            cv::medianBlur(subImage,filteredImage, 3);
+            subImage = filteredImage;
         } // run a 3x3 median filter if desired
         if (lpOn == true) {
-            cv::GaussianBlur(this->currentImageOCVMat,this->currentImageOCVMat, Size(5,5), 0, BORDER_DEFAULT);
+            cv::GaussianBlur(subImage,filteredImage, Size(5,5), 0, BORDER_DEFAULT);
+            subImage = filteredImage;
         }
-        cv::threshold(this->currentImageOCVMat,this->currentImageOCVMat, gsThreshold, 255,3); // apply the selected threshold
-        cv::minMaxLoc(this->currentImageOCVMat, &minPixVal, &maxPixVal);
-        this->maxGrayVal = maxPixVal; // the subimage should not contain pixels with a saturated value; this is checked ...
-        convertMatToQImg(); 
-        prevImg = new QImage(processedImage->scaled(180,180,Qt::KeepAspectRatio,Qt::FastTransformation));
-        prevPMap->convertFromImage(*prevImg,0);
-        delete prevImg;
-        cvmoms = moments(this->currentImageOCVMat,true);
-        if (cvmoms.m00 > 0.01) {
-            centroidX=(cvmoms.m10/(float)cvmoms.m00);
-            centroidY=(cvmoms.m01/(float)cvmoms.m00);
-            scaleFact=g_AllData->getCameraImageScalingFactor(false);
-            if (updateCentroid == true) {
-                g_AllData->setInitialStarPosition(((tLeft.x+centroidX)*scaleFact),((tLeft.y+centroidY)*scaleFact));
-                // this is tricky - correct the position of the manually selected guide star,
-                // store this in the global struct and send a signal to the camera view to
-                // correct the camera view QGraphicsView ...
-            } // ... and that is only done if one wnats to update the centroid; this is not the case in the image-processing mode
-            emit guideImagePreviewAvailable();
-            emit determinedGuideStarCentroid();
+        starFound = engine->measure(subImage.data, subImage.step, 0, 0, subImage.cols, subImage.rows);
+        centroidX = engine->getCentroid(0);
+        centroidY = engine->getCentroid(1);
+    } else {
+        starFound = engine->measure(fullImage.data, fullImage.step, tLeft.x, tLeft.y, subImage.cols, subImage.rows);
+        centroidX = engine->getCentroid(0)-tLeft.x;
+        centroidY = engine->getCentroid(1)-tLeft.y;
+    } // the centroid is relative to the top left corner of the subimage
+    result->starFound = starFound;
+    result->peak = engine->getPeakValue(); // the subimage should not contain pixels with a saturated value; this is checked ...
+    result->centroid[0] = tLeft.x+centroidX;
+    result->centroid[1] = tLeft.y+centroidY;
+    result->starParameters[0] = engine->getSNR();
+    result->starParameters[1] = engine->getFWHM();
+    result->starParameters[2] = engine->getHFD();
+    subImage.convertTo(previewImage, -1, cntrst, briteness); // do intensity operations for the preview
+    cv::threshold(previewImage,previewImage, gsThreshold, 255,3); // apply the selected threshold
+    prevImg = new QImage(previewImage.data, previewImage.cols, previewImage.rows, static_cast<int>(previewImage.step), QImage::Format_Indexed8);
+    result->preview = prevImg->scaled(180,180,Qt::KeepAspectRatio,Qt::FastTransformation); // a copy; previewImage goes out of scope
+    delete prevImg;
+    return true;
+}
+
+//---------------------------------------------------
+// takes over a measurement from "measureGuideStar"; the preview is set, and if a star was found, its
+// parameters and, if desired, its position
+void ocv_guiding::applyGuideStarMeasurement(const struct guideStarMeasurementStruct *measurement, bool updateCentroid) {
+    QImage prevImg;
+    float scaleFact;
+
+    this->maxGrayVal = measurement->peak;
+    this->starFound = measurement->starFound;
+    prevImg = measurement->preview;
+    prevImg.setColorTable(*myVec);
+    prevPMap->convertFromImage(prevImg,0);
+    if (measurement->starFound == true) {
+        this->starParameters[0] = measurement->starParameters[0];
+        this->starParameters[1] = measurement->starParameters[1];
+        this->starParameters[2] = measurement->starParameters[2];
+        scaleFact=g_AllData->getCameraImageScalingFactor(false);
+        if (updateCentroid == true) {
+            g_AllData->setInitialStarPosition(measurement->centroid[0]*scaleFact,measurement->centroid[1]*scaleFact);
+            // this is tricky - correct the position of the manually selected guide star,
+            // store this in the global struct and send a signal to the camera view to
+            // correct the camera view QGraphicsView ...
+        } // ... and that is only done if one wnats to update the centroid; this is not the case in the image-processing mode
+        emit guideImagePreviewAvailable();
+        emit determinedGuideStarCentroid();
+    }
+}
+
+//---------------------------------------------------
+// the stars of the ensemble are taken from the camera image when guiding starts. the guide star
+// is the one found by "doGuideStarImgProcessing", and the references are its position and the
+// positions of the other stars in this image
+long ocv_guiding::initStarEnsemble(long maxStars) {
+    *this->currentImageQImg = *g_AllData->getCameraImage();
+    return this->starEnsemble->findStars(this->currentImageQImg->constBits(), this->currentImageQImg->bytesPerLine(),
+        this->currentImageQImg->width(), this->currentImageQImg->height(), g_AllData->getInitialStarPosition(2),
+        g_AllData->getInitialStarPosition(3), maxStars);
+}
+
+//---------------------------------------------------
+// to be called after "doGuideStarImgProcessing"; the stars are expected where the guide star
+// has moved. if some stars are found, the guide star position in g_AllData is replaced by the
+// reference position plus the robust offset of all stars. if the guide star itself was lost,
+// guiding goes on with the others
+bool ocv_guiding::doStarEnsembleProcessing(void) {
+    float scaleFact;
+    double predX, predY;
+
+    if (this->starEnsemble->getNumberOfStars() == 0) {
+        return false;
+    }
+    *this->currentImageQImg = *g_AllData->getCameraImage();
+    predX = g_AllData->getInitialStarPosition(2)-this->starEnsemble->getReferencePosition(0,0);
+    predY = g_AllData->getInitialStarPosition(3)-this->starEnsemble->getReferencePosition(0,1);
+    if (this->starEnsemble->measureOffset(this->currentImageQImg->constBits(), this->currentImageQImg->bytesPerLine(),
+        this->currentImageQImg->width(), this->currentImageQImg->height(), predX, predY) == false) {
+        return false;
+    }
+    scaleFact=g_AllData->getCameraImageScalingFactor(false);
+    g_AllData->setInitialStarPosition((this->starEnsemble->getReferencePosition(0,0)+this->starEnsemble->getOffset(0))*scaleFact,
+        (this->starEnsemble->getReferencePosition(0,1)+this->starEnsemble->getOffset(1))*scaleFact);
+    emit determinedGuideStarCentroid();
+    return true;
+}
+
+//---------------------------------------------------
+long ocv_guiding::getNumberOfEnsembleStars(bool onlyUsed) {
+    if (onlyUsed == true) {
+        return this->starEnsemble->getNumberOfStarsUsed();
+    }
+    return this->starEnsemble->getNumberOfStars();
+}
+
+//---------------------------------------------------
+
+//---------------------------------------------------
+bool ocv_guiding::guideStarWasFound(void) {
+    return this->starFound;
+}
+
+//---------------------------------------------------
+// searches the whole camera image for guide stars. the position is in pixels of the camera image; if a radius
+// is given, the star nearest to the position within the radius is taken, which finds the guide star again after
+// a dither or a meridian flip. otherwise, the position is not read, and the best guide star of the frame is taken.
+// the FOV factor sets the window of "measureGuideStar", which should not contain a brighter star
+bool ocv_guiding::findGuideStar(float *x, float *y, float radius, float FOVfact) {
+    long idx = 0;
+
+    *this->currentImageQImg = *g_AllData->getCameraImage();
+    this->starFinder->setSearchWindow((int)ceil(90*FOVfact));
+    if (this->starFinder->findStars(this->currentImageQImg->constBits(), this->currentImageQImg->bytesPerLine(),
+            this->currentImageQImg->width(), this->currentImageQImg->height(), 20) == 0) {
+        return false;
+    }
+    if (radius > 0) {
+        idx = this->starFinder->getNearestStar(*x, *y, radius);
+        if (idx < 0) {
+            return false;
         }
     }
+    *x = this->starFinder->getStar(idx)->position[0];
+    *y = this->starFinder->getStar(idx)->position[1];
+    return true;
 }
 
 //---------------------------------------------------
+// the part of the chip that guiding needs in the next images: the window around the guide star that
+// "measureGuideStar" searches and the boxes of the other stars of the ensemble, with a margin for the drift.
+// the subframe is only moved when a star came closer than half of the margin to its edge, so that the
+// camera does not get a new frame in every guide cycle. the full chip is returned as a null QRect if the
+// guide star was lost, or if the subframe would be more than half of the chip
+QRect ocv_guiding::getGuideSubframe(const QRect &current, float FOVfact) {
+    QRect chip, needed, subframe;
+    int halfWindow, halfBox, margin, x, y, right, bottom;
+    long idx;
+
+    chip = QRect(0, 0, g_AllData->getCameraChipPixels(0,false), g_AllData->getCameraChipPixels(1,false));
+    if ((this->starFound == false) || (chip.isEmpty() == true)) {
+        return QRect();
+    }
+    halfWindow = (int)ceil(90*FOVfact);
+    margin = halfWindow/2+8;
+    x = (int)round(g_AllData->getInitialStarPosition(2));
+    y = (int)round(g_AllData->getInitialStarPosition(3));
+    needed = QRect(x-halfWindow, y-halfWindow, 2*halfWindow, 2*halfWindow);
+    halfBox = this->starEnsemble->getBoxSize()/2;
+    for (idx = 1; idx < this->starEnsemble->getNumberOfStars(); idx++) {
+        x = (int)round(this->starEnsemble->getReferencePosition(idx,0)+this->starEnsemble->getOffset(0));
+        y = (int)round(this->starEnsemble->getReferencePosition(idx,1)+this->starEnsemble->getOffset(1));
+        needed = needed.united(QRect(x-halfBox, y-halfBox, 2*halfBox, 2*halfBox));
+    } // the other stars of the ensemble, where they are expected now
+    if ((current.isNull() == false) &&
+        (current.contains(needed.adjusted(-margin/2, -margin/2, margin/2, margin/2).intersected(chip)) == true)) {
+        return current;
+    }
+    subframe = needed.adjusted(-margin, -margin, margin, margin).intersected(chip);
+    right = subframe.right()+1;
+    bottom = subframe.bottom()+1;
+    subframe.setLeft(subframe.left()/8*8);
+    subframe.setTop(subframe.top()/8*8); // many cameras read out subframes in steps of a few pixels only
+    subframe.setWidth((right-subframe.left()+7)/8*8);
+    subframe.setHeight((bottom-subframe.top()+7)/8*8);
+    subframe = subframe.intersected(chip);
+    if (2*subframe.width()*subframe.height() > chip.width()*chip.height()) {
+        return QRect();
+    }
+    return subframe;
+}
@@ -23,20 +23,42 @@
 //#include <types_c.h>
 #include <QImage>
 #include <QPixmap>
+#include <QRect>
+#include "tsc_centroid.h"
+#include "tsc_starensemble.h"
+#include "tsc_starfinder.h"
 
 using namespace cv;
 
 class ocv_guiding:public QObject {
 Q_OBJECT
     public:
+        struct guideStarMeasurementStruct {
+            bool starFound;
+            float centroid[2]; // in pixels of the camera image
+            float starParameters[3]; // SNR, FWHM and HFD
+            int peak;
+            QImage preview; // the processed subimage, scaled for the preview
+        };
         ocv_guiding(void);
         ~ocv_guiding();
         QPoint* getGuideStarCentroid(void);
         void doGuideStarImgProcessing(int,bool, bool, float,int,float,bool, bool);
+        static bool measureGuideStar(const QImage&, float, float, int, bool, bool, float, int, float, TSC_Centroid*,
+            struct guideStarMeasurementStruct*); // thread safe; the image, the position of the star and the parameters of "doGuideStarImgProcessing"
+        void applyGuideStarMeasurement(const struct guideStarMeasurementStruct*, bool); // true updates the guide star position
         bool isPixelAtSaturation(void);
         QPixmap* getGuideStarPreview(void);
         double getArcSecsPerPix(short);
         void setFocalLengthOfGuidescope(int);
+        void setCentroidEstimator(short); // one of TSC_Centroid::centroidEstimator
+        float getStarParameter(short); // 0 is the SNR, 1 the FWHM and 2 the HFD in pixels of the last guide star
+        long initStarEnsemble(long); // takes up to this number of stars around the selected guide star as references; returns the number found
+        bool doStarEnsembleProcessing(void); // the position of the guide star from the offset of all stars in the current image
+        long getNumberOfEnsembleStars(bool); // true for the stars that were used in the last offset
+        bool guideStarWasFound(void); // in the last image
+        bool findGuideStar(float*, float*, float, float); // position in pixels of the camera image, radius of the search around it or 0 for the best star of the frame, FOV factor
+        QRect getGuideSubframe(const QRect&, float); // the subframe for the next images from the current one and the FOV factor; a null QRect is the full chip
 
     private:
         cv::Mat currentImageOCVMat;
@@ -45,6 +67,9 @@ Q_OBJECT
         QPixmap* prevPMap;
         QPoint* centroidOfGuideStar;
         QVector<QRgb> *myVec;
+        TSC_Centroid *centroidEngine;
+        TSC_StarEnsemble *starEnsemble;
+        TSC_StarFinder *starFinder;
         void convertQImgToMat(void);
         void convertMatToQImg(void);
         void storeMatToFile(void);
@@ -54,6 +79,8 @@ Q_OBJECT
         double arcsecPerPixX;
         double arcsecPerPixY;
         int maxGrayVal;
+        float starParameters[3];
+        bool starFound;
 
     signals:
         void guideImagePreviewAvailable(void);
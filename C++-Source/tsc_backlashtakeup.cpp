@@ -0,0 +1,80 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+#include "tsc_backlashtakeup.h"
+#include <stdlib.h>
+#include <math.h>
+
+TSC_BacklashTakeUp::TSC_BacklashTakeUp(void) {
+    this->takeUpIsRunning = false;
+    this->queuedSpeed = 0;
+    this->queuedSteps = 0;
+    this->timeoutInMS = 0;
+}
+
+//---------------------------------------------------
+TSC_BacklashTakeUp::~TSC_BacklashTakeUp(void) {
+}
+
+//---------------------------------------------------
+// the slack is travelled at eight times the sidereal speed
+long TSC_BacklashTakeUp::getTakeUpSpeed(double siderealSpeed) {
+    long speed;
+
+    speed = round(8*siderealSpeed);
+    if (speed < 1) {
+        speed = 1;
+    }
+    return speed;
+}
+
+//---------------------------------------------------
+void TSC_BacklashTakeUp::start(long steps, long speed, long followingSpeed, long followingSteps) {
+    this->timeoutInMS = 1000 + 2000*labs(steps)/speed;
+    this->queuedSpeed = followingSpeed;
+    this->queuedSteps = followingSteps;
+    this->takeUpTimer.start();
+    this->takeUpIsRunning = true;
+}
+
+//---------------------------------------------------
+void TSC_BacklashTakeUp::queueMotion(long followingSpeed, long followingSteps) {
+    this->queuedSpeed = followingSpeed;
+    this->queuedSteps = followingSteps;
+}
+
+//---------------------------------------------------
+bool TSC_BacklashTakeUp::isRunning(void) {
+    return this->takeUpIsRunning;
+}
+
+//---------------------------------------------------
+bool TSC_BacklashTakeUp::hasTimedOut(void) {
+    return (this->takeUpTimer.elapsed() >= this->timeoutInMS);
+}
+
+//---------------------------------------------------
+void TSC_BacklashTakeUp::cancel(void) {
+    this->takeUpIsRunning = false;
+}
+
+//---------------------------------------------------
+long TSC_BacklashTakeUp::getQueuedSpeed(void) {
+    return this->queuedSpeed;
+}
+
+//---------------------------------------------------
+long TSC_BacklashTakeUp::getQueuedSteps(void) {
+    return this->queuedSteps;
+}
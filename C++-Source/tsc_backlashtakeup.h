@@ -0,0 +1,47 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+// the state of a backlash take-up of QtContinuousStepper and QtKineticStepper. a continuous motion has no end
+// position that could be extended by the backlash, so the slack is travelled in a fast move of its own before
+// the motion starts. the drive does not wait for that move; the motion is queued here and started by the drive
+// once the AMIS report that the move has ended, or after a timeout if a reply is lost. speeds are in
+// microsteps/s, steps are signed and give the direction of the motor.
+
+#ifndef TSC_BACKLASHTAKEUP_H
+#define TSC_BACKLASHTAKEUP_H
+
+#include <QElapsedTimer>
+
+class TSC_BacklashTakeUp {
+public:
+    TSC_BacklashTakeUp(void);
+    ~TSC_BacklashTakeUp(void);
+    long getTakeUpSpeed(double); // microsteps/s of the drive at the sidereal speed -> speed of the take-up
+    void start(long, long, long, long); // steps and speed of the take-up, speed and steps of the motion that follows
+    void queueMotion(long, long); // replaces the motion that follows a running take-up
+    bool isRunning(void);
+    bool hasTimedOut(void);
+    void cancel(void); // the drive was stopped or got a new target
+    long getQueuedSpeed(void);
+    long getQueuedSteps(void);
+
+private:
+    bool takeUpIsRunning;
+    long queuedSpeed;
+    long queuedSteps;
+    qint64 timeoutInMS;
+    QElapsedTimer takeUpTimer;
+};
+
+#endif // TSC_BACKLASHTAKEUP_H
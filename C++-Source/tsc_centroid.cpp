@@ -0,0 +1,581 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+#include "tsc_centroid.h"
+#include <math.h>
+
+static const double fwhmPerSigma = 2.35482;
+
+TSC_Centroid::TSC_Centroid(void) {
+    this->image = 0;
+    this->stride = 0;
+    this->estimator = ceWindowed;
+    this->background = 0;
+    this->noise = 0;
+    this->centroid[0] = 0;
+    this->centroid[1] = 0;
+    this->aperture = 3;
+    this->secondMoment = 1;
+    this->snr = 0;
+    this->fwhm = 0;
+    this->hfd = 0;
+    this->peakValue = 0;
+    this->peakPos[0] = 0;
+    this->peakPos[1] = 0;
+}
+
+//---------------------------------------------------
+TSC_Centroid::~TSC_Centroid(void) {
+    this->borderPixels.clear();
+}
+
+//---------------------------------------------------
+void TSC_Centroid::setEstimator(short which) {
+    if ((which >= ceMoments) && (which <= ceQuadratic)) {
+        this->estimator = which;
+    }
+}
+
+//---------------------------------------------------
+short TSC_Centroid::getEstimator(void) {
+    return this->estimator;
+}
+
+//---------------------------------------------------
+double TSC_Centroid::getPixel(int x, int y) {
+    return this->image[y*this->stride + x];
+}
+
+//---------------------------------------------------
+// a mean of the two outermost rows and columns, clipped at three sigma so that stars on the border do not count
+void TSC_Centroid::estimateBackground(void) {
+    double mean = 0, sigma = 0, sum, sqSum, val;
+    int x, y, border, iter;
+    long cnt;
+    unsigned long idx;
+
+    this->borderPixels.clear();
+    border = 2;
+    for (y = this->roi[1]; y < this->roi[3]; y++) {
+        for (x = this->roi[0]; x < this->roi[2]; x++) {
+            if ((x < this->roi[0] + border) || (x >= this->roi[2] - border) || (y < this->roi[1] + border) ||
+                    (y >= this->roi[3] - border)) {
+                this->borderPixels.push_back(this->getPixel(x, y));
+            }
+        }
+    }
+    for (iter = 0; iter < 4; iter++) {
+        sum = 0;
+        sqSum = 0;
+        cnt = 0;
+        for (idx = 0; idx < this->borderPixels.size(); idx++) {
+            val = this->borderPixels[idx];
+            if ((iter == 0) || (fabs(val - mean) <= 3*sigma)) {
+                sum += val;
+                sqSum += val*val;
+                cnt++;
+            }
+        }
+        if (cnt == 0) {
+            break;
+        }
+        mean = sum/cnt;
+        sigma = sqrt(fmax(0, sqSum/cnt - mean*mean));
+    }
+    this->background = mean;
+    this->noise = fmax(sigma, 0.3); // the rounding to integer values alone is 0.29 ADU rms
+}
+
+//---------------------------------------------------
+// two passes; the second aperture is centred on the result of the first
+void TSC_Centroid::computeMoments(void) {
+    double cx, cy, sumW, sumX, sumY, sumSq, w, dx, dy, r2;
+    int x, y, pass;
+
+    cx = this->peakPos[0];
+    cy = this->peakPos[1];
+    r2 = this->aperture*this->aperture;
+    for (pass = 0; pass < 2; pass++) {
+        sumW = 0;
+        sumX = 0;
+        sumY = 0;
+        sumSq = 0;
+        for (y = (int)fmax(this->roi[1], floor(cy - this->aperture)); y <= (int)fmin(this->roi[3] - 1, ceil(cy + this->aperture)); y++) {
+            for (x = (int)fmax(this->roi[0], floor(cx - this->aperture)); x <= (int)fmin(this->roi[2] - 1, ceil(cx + this->aperture)); x++) {
+                dx = x - cx;
+                dy = y - cy;
+                if (dx*dx + dy*dy > r2) {
+                    continue;
+                }
+                w = this->getPixel(x, y) - this->background;
+                if (w <= 0) {
+                    continue;
+                }
+                sumW += w;
+                sumX += w*dx;
+                sumY += w*dy;
+                sumSq += w*(dx*dx + dy*dy);
+            }
+        }
+        if (sumW <= 0) {
+            break;
+        }
+        cx += sumX/sumW;
+        cy += sumY/sumW;
+        this->secondMoment = fmax(0.1, sumSq/sumW/2.0 - (sumX*sumX + sumY*sumY)/(sumW*sumW)/2.0);
+    }
+    this->centroid[0] = cx;
+    this->centroid[1] = cy;
+    this->fwhm = fwhmPerSigma*sqrt(this->secondMoment);
+}
+
+//---------------------------------------------------
+// the second moment of the pixels weighted with a gaussian window of the width of the star. for a gaussian star
+// of variance s and a window of variance w, the weighted variance is v = s*w/(s + w); the window is matched to
+// the star in a few iterations. this is much less affected by the noise far from the star than the moments
+void TSC_Centroid::computeWidth(void) {
+    double varStar, varWindow, sumW, sumSq, w, dx, dy, r2, radius, v;
+    int x, y, iter;
+
+    varStar = this->secondMoment;
+    for (iter = 0; iter < 5; iter++) {
+        varWindow = fmax(0.1, varStar);
+        radius = fmin(this->aperture, 4*sqrt(varWindow));
+        sumW = 0;
+        sumSq = 0;
+        for (y = (int)fmax(this->roi[1], floor(this->centroid[1] - radius)); y <= (int)fmin(this->roi[3] - 1, ceil(this->centroid[1] + radius)); y++) {
+            for (x = (int)fmax(this->roi[0], floor(this->centroid[0] - radius)); x <= (int)fmin(this->roi[2] - 1, ceil(this->centroid[0] + radius)); x++) {
+                dx = x - this->centroid[0];
+                dy = y - this->centroid[1];
+                r2 = dx*dx + dy*dy;
+                if (r2 > radius*radius) {
+                    continue;
+                }
+                w = exp(-r2/(2*varWindow))*(this->getPixel(x, y) - this->background);
+                sumW += w;
+                sumSq += w*r2;
+            }
+        }
+        if (sumW <= 0) {
+            return;
+        }
+        v = sumSq/sumW/2.0;
+        if (v <= 0) {
+            return;
+        }
+        if (v >= 0.95*varWindow) {
+            varStar = 20*varWindow; // the window is far too narrow
+        } else {
+            varStar = v*varWindow/(varWindow - v);
+        }
+    }
+    this->fwhm = fwhmPerSigma*sqrt(varStar);
+}
+
+//---------------------------------------------------
+// the window is a gaussian of the width of the star; the factor 2 in the update makes the iteration converge
+// to the centre of a gaussian star within a few steps
+bool TSC_Centroid::computeWindowed(void) {
+    double cx, cy, sigmaW, sumW, sumX, sumY, w, dx, dy, r2, radius, shiftX, shiftY;
+    int x, y, iter;
+
+    sigmaW = fmax(0.5, this->fwhm/fwhmPerSigma);
+    radius = fmin(this->aperture, 4*sigmaW);
+    cx = this->centroid[0];
+    cy = this->centroid[1];
+    for (iter = 0; iter < 20; iter++) {
+        sumW = 0;
+        sumX = 0;
+        sumY = 0;
+        for (y = (int)fmax(this->roi[1], floor(cy - radius)); y <= (int)fmin(this->roi[3] - 1, ceil(cy + radius)); y++) {
+            for (x = (int)fmax(this->roi[0], floor(cx - radius)); x <= (int)fmin(this->roi[2] - 1, ceil(cx + radius)); x++) {
+                dx = x - cx;
+                dy = y - cy;
+                r2 = dx*dx + dy*dy;
+                if (r2 > radius*radius) {
+                    continue;
+                }
+                w = exp(-r2/(2*sigmaW*sigmaW))*(this->getPixel(x, y) - this->background);
+                sumW += w;
+                sumX += w*dx;
+                sumY += w*dy;
+            }
+        }
+        if (sumW <= 0) {
+            return false;
+        }
+        shiftX = 2*sumX/sumW;
+        shiftY = 2*sumY/sumW;
+        cx += shiftX;
+        cy += shiftY;
+        if ((fabs(cx - this->centroid[0]) > this->aperture) || (fabs(cy - this->centroid[1]) > this->aperture)) {
+            return false;
+        }
+        if (shiftX*shiftX + shiftY*shiftY < 1e-8) {
+            break;
+        }
+    }
+    this->centroid[0] = cx;
+    this->centroid[1] = cy;
+    return true;
+}
+
+//---------------------------------------------------
+// the profiles and their derivatives; p holds x, y, amplitude, width (sigma or alpha), [beta,] background
+static double getProfile(const double *p, bool isMoffat, double x, double y, double *jac) {
+    double dx, dy, r2, g, u, uPow;
+
+    dx = x - p[0];
+    dy = y - p[1];
+    r2 = dx*dx + dy*dy;
+    if (isMoffat == false) {
+        g = exp(-r2/(2*p[3]*p[3]));
+        if (jac != 0) {
+            jac[0] = p[2]*g*dx/(p[3]*p[3]);
+            jac[1] = p[2]*g*dy/(p[3]*p[3]);
+            jac[2] = g;
+            jac[3] = p[2]*g*r2/(p[3]*p[3]*p[3]);
+            jac[4] = 1;
+        }
+        return p[4] + p[2]*g;
+    }
+    u = 1 + r2/(p[3]*p[3]);
+    uPow = pow(u, -p[4]);
+    if (jac != 0) {
+        jac[0] = p[2]*p[4]*uPow/u*2*dx/(p[3]*p[3]);
+        jac[1] = p[2]*p[4]*uPow/u*2*dy/(p[3]*p[3]);
+        jac[2] = uPow;
+        jac[3] = p[2]*p[4]*uPow/u*2*r2/(p[3]*p[3]*p[3]);
+        jac[4] = -p[2]*uPow*log(u);
+        jac[5] = 1;
+    }
+    return p[5] + p[2]*uPow;
+}
+
+//---------------------------------------------------
+// gaussian elimination with partial pivoting for the normal equations, n <= 6
+static bool solveNormalEquations(double a[6][7], int n, double *x) {
+    double factor;
+    int i, j, k, pivot;
+
+    for (i = 0; i < n; i++) {
+        pivot = i;
+        for (k = i + 1; k < n; k++) {
+            if (fabs(a[k][i]) > fabs(a[pivot][i])) {
+                pivot = k;
+            }
+        }
+        if (fabs(a[pivot][i]) < 1e-300) {
+            return false;
+        }
+        if (pivot != i) {
+            for (j = 0; j <= n; j++) {
+                factor = a[i][j];
+                a[i][j] = a[pivot][j];
+                a[pivot][j] = factor;
+            }
+        }
+        for (k = i + 1; k < n; k++) {
+            factor = a[k][i]/a[i][i];
+            for (j = i; j <= n; j++) {
+                a[k][j] -= factor*a[i][j];
+            }
+        }
+    }
+    for (i = n - 1; i >= 0; i--) {
+        x[i] = a[i][n];
+        for (j = i + 1; j < n; j++) {
+            x[i] -= a[i][j]*x[j];
+        }
+        x[i] /= a[i][i];
+    }
+    return true;
+}
+
+//---------------------------------------------------
+// levenberg-marquardt on the pixels in the aperture around the moments centroid
+bool TSC_Centroid::fitProfile(bool isMoffat) {
+    double p[6], trial[6], delta[6], jac[6], normal[6][7], chiSq, trialChiSq, lambda = 1e-3, res, dx, dy;
+    int np, x, y, xMin, xMax, yMin, yMax, iter, i, j;
+
+    np = (isMoffat == true) ? 6 : 5;
+    p[0] = this->centroid[0];
+    p[1] = this->centroid[1];
+    p[2] = fmax(1, this->getPixel(this->peakPos[0], this->peakPos[1]) - this->background);
+    if (isMoffat == false) {
+        p[3] = fmax(0.5, sqrt(this->secondMoment));
+        p[4] = this->background;
+    } else {
+        p[4] = 3.0;
+        p[3] = fmax(0.5, this->fwhm/(2*sqrt(pow(2.0, 1.0/p[4]) - 1)));
+        p[5] = this->background;
+    }
+    xMin = (int)fmax(this->roi[0], floor(p[0] - this->aperture));
+    xMax = (int)fmin(this->roi[2] - 1, ceil(p[0] + this->aperture));
+    yMin = (int)fmax(this->roi[1], floor(p[1] - this->aperture));
+    yMax = (int)fmin(this->roi[3] - 1, ceil(p[1] + this->aperture));
+    chiSq = 0;
+    for (y = yMin; y <= yMax; y++) {
+        for (x = xMin; x <= xMax; x++) {
+            res = this->getPixel(x, y) - getProfile(p, isMoffat, x, y, 0);
+            chiSq += res*res;
+        }
+    }
+    for (iter = 0; iter < 50; iter++) {
+        for (i = 0; i < np; i++) {
+            for (j = 0; j <= np; j++) {
+                normal[i][j] = 0;
+            }
+        }
+        for (y = yMin; y <= yMax; y++) {
+            for (x = xMin; x <= xMax; x++) {
+                res = this->getPixel(x, y) - getProfile(p, isMoffat, x, y, jac);
+                for (i = 0; i < np; i++) {
+                    for (j = 0; j < np; j++) {
+                        normal[i][j] += jac[i]*jac[j];
+                    }
+                    normal[i][np] += jac[i]*res;
+                }
+            }
+        }
+        for (i = 0; i < np; i++) {
+            normal[i][i] *= (1 + lambda);
+        }
+        if (solveNormalEquations(normal, np, delta) == false) {
+            return false;
+        }
+        for (i = 0; i < np; i++) {
+            trial[i] = p[i] + delta[i];
+        }
+        trial[3] = fmax(0.3, trial[3]);
+        if (isMoffat == true) {
+            trial[4] = fmin(20, fmax(1.01, trial[4]));
+        }
+        trialChiSq = 0;
+        for (y = yMin; y <= yMax; y++) {
+            for (x = xMin; x <= xMax; x++) {
+                res = this->getPixel(x, y) - getProfile(trial, isMoffat, x, y, 0);
+                trialChiSq += res*res;
+            }
+        }
+        if (trialChiSq < chiSq) {
+            for (i = 0; i < np; i++) {
+                p[i] = trial[i];
+            }
+            lambda *= 0.1;
+            if (chiSq - trialChiSq < 1e-8*chiSq) {
+                break;
+            }
+            chiSq = trialChiSq;
+        } else {
+            lambda *= 10;
+            if (lambda > 1e8) {
+                break;
+            }
+        }
+    }
+    dx = p[0] - this->centroid[0];
+    dy = p[1] - this->centroid[1];
+    if ((p[2] <= 0) || (dx*dx + dy*dy > this->aperture*this->aperture)) {
+        return false;
+    }
+    this->centroid[0] = p[0];
+    this->centroid[1] = p[1];
+    if (isMoffat == false) {
+        this->fwhm = fwhmPerSigma*p[3];
+    } else {
+        this->fwhm = 2*p[3]*sqrt(pow(2.0, 1.0/p[4]) - 1);
+    }
+    return true;
+}
+
+//---------------------------------------------------
+// sums over three rows or columns make the parabola less sensitive to the noise of single pixels
+void TSC_Centroid::computeQuadratic(void) {
+    double left = 0, centre = 0, right = 0, curvature, offset;
+    int pos[2], axis, k;
+
+    pos[0] = this->peakPos[0];
+    pos[1] = this->peakPos[1];
+    if ((pos[0] <= this->roi[0] + 1) || (pos[0] >= this->roi[2] - 2) || (pos[1] <= this->roi[1] + 1) || (pos[1] >= this->roi[3] - 2)) {
+        return; // the moments stay
+    }
+    for (axis = 0; axis < 2; axis++) {
+        left = 0;
+        centre = 0;
+        right = 0;
+        for (k = -1; k <= 1; k++) {
+            if (axis == 0) {
+                left += this->getPixel(pos[0] - 1, pos[1] + k);
+                centre += this->getPixel(pos[0], pos[1] + k);
+                right += this->getPixel(pos[0] + 1, pos[1] + k);
+            } else {
+                left += this->getPixel(pos[0] + k, pos[1] - 1);
+                centre += this->getPixel(pos[0] + k, pos[1]);
+                right += this->getPixel(pos[0] + k, pos[1] + 1);
+            }
+        }
+        curvature = left - 2*centre + right;
+        offset = 0;
+        if (curvature < 0) {
+            offset = fmax(-0.5, fmin(0.5, 0.5*(left - right)/curvature));
+        }
+        this->centroid[axis] = pos[axis] + offset;
+    }
+}
+
+//---------------------------------------------------
+// flux and half flux diameter in the aperture around the centroid. the diameter is twice the flux weighted
+// mean radius, which is what focusing aids commonly call the HFD
+void TSC_Centroid::computePhotometry(void) {
+    double flux = 0, weightedRadius = 0, val, dx, dy, r2;
+    int x, y;
+    long cnt = 0;
+
+    r2 = this->aperture*this->aperture;
+    for (y = (int)fmax(this->roi[1], floor(this->centroid[1] - this->aperture));
+         y <= (int)fmin(this->roi[3] - 1, ceil(this->centroid[1] + this->aperture)); y++) {
+        for (x = (int)fmax(this->roi[0], floor(this->centroid[0] - this->aperture));
+             x <= (int)fmin(this->roi[2] - 1, ceil(this->centroid[0] + this->aperture)); x++) {
+            dx = x - this->centroid[0];
+            dy = y - this->centroid[1];
+            if (dx*dx + dy*dy > r2) {
+                continue;
+            }
+            val = this->getPixel(x, y) - this->background;
+            flux += val;
+            weightedRadius += val*sqrt(dx*dx + dy*dy);
+            cnt++;
+        }
+    }
+    this->snr = 0;
+    if (flux > 0) {
+        this->snr = flux/sqrt(flux + cnt*this->noise*this->noise);
+    }
+    this->hfd = 0;
+    if (flux > 0) {
+        this->hfd = fmax(0, 2*weightedRadius/flux);
+    } // the noise is not clipped, it would add flux far from the star
+}
+
+//---------------------------------------------------
+bool TSC_Centroid::measure(const unsigned char *img, long bytesPerLine, int left, int top, int width, int height) {
+    const unsigned char *line;
+    double halfMax, fwhmGuess;
+    int x, y, val, boxMax = -1;
+    long cnt = 0;
+    bool success = true;
+
+    if ((img == 0) || (width < 8) || (height < 8)) {
+        return false;
+    }
+    this->image = img;
+    this->stride = bytesPerLine;
+    this->roi[0] = left;
+    this->roi[1] = top;
+    this->roi[2] = left + width;
+    this->roi[3] = top + height;
+    this->estimateBackground();
+    this->peakValue = 0;
+    for (y = this->roi[1] + 2; y < this->roi[3] - 2; y++) {
+        line = this->image + y*this->stride;
+        for (x = this->roi[0] + 2; x < this->roi[2] - 2; x++) {
+            if (line[x] > this->peakValue) {
+                this->peakValue = line[x];
+            }
+            val = line[x - 1] + line[x] + line[x + 1] + line[x - this->stride - 1] + line[x - this->stride] +
+                  line[x - this->stride + 1] + line[x + this->stride - 1] + line[x + this->stride] + line[x + this->stride + 1];
+            if (val > boxMax) {
+                boxMax = val;
+                this->peakPos[0] = x;
+                this->peakPos[1] = y;
+            }
+        }
+    } // the sums of 3 x 3 pixels find faint stars that single pixels of noise would outshine
+    if (boxMax - 9*this->background < 5*3*this->noise) {
+        return false;
+    }
+    halfMax = this->background + 0.5*(this->getPixel(this->peakPos[0], this->peakPos[1]) - this->background);
+    halfMax = fmax(halfMax, this->background + 3*this->noise); // else the noise makes the aperture of faint stars huge
+    for (y = (int)fmax(this->roi[1], this->peakPos[1] - 15); y <= (int)fmin(this->roi[3] - 1, this->peakPos[1] + 15); y++) {
+        for (x = (int)fmax(this->roi[0], this->peakPos[0] - 15); x <= (int)fmin(this->roi[2] - 1, this->peakPos[0] + 15); x++) {
+            if (this->getPixel(x, y) >= halfMax) {
+                cnt++;
+            }
+        }
+    }
+    fwhmGuess = 2*sqrt(cnt/M_PI);
+    this->aperture = fmin(fmax(3.0, 1.5*fwhmGuess + 1), 0.5*fmin(width, height) - 2);
+    this->computeMoments();
+    switch (this->estimator) {
+    case ceWindowed:
+        this->computeWidth();
+        success = this->computeWindowed();
+        break;
+    case ceGaussian:
+        success = this->fitProfile(false);
+        break;
+    case ceMoffat:
+        success = this->fitProfile(true);
+        break;
+    case ceQuadratic:
+        this->computeQuadratic();
+        break;
+    default:
+        break;
+    }
+    if (success == false) {
+        this->computeMoments();
+    } // the moments are the fallback if an estimator does not converge
+    if ((this->estimator != ceGaussian) && (this->estimator != ceMoffat)) {
+        this->computeWidth();
+    }
+    this->computePhotometry();
+    return true;
+}
+
+//---------------------------------------------------
+double TSC_Centroid::getCentroid(short axis) {
+    if ((axis < 0) || (axis > 1)) {
+        return 0;
+    }
+    return this->centroid[axis];
+}
+
+//---------------------------------------------------
+double TSC_Centroid::getSNR(void) {
+    return this->snr;
+}
+
+//---------------------------------------------------
+double TSC_Centroid::getFWHM(void) {
+    return this->fwhm;
+}
+
+//---------------------------------------------------
+double TSC_Centroid::getHFD(void) {
+    return this->hfd;
+}
+
+//---------------------------------------------------
+double TSC_Centroid::getBackground(void) {
+    return this->background;
+}
+
+//---------------------------------------------------
+int TSC_Centroid::getPeakValue(void) {
+    return this->peakValue;
+}
@@ -0,0 +1,74 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+// measures the position of a star in the region of interest of an 8 bit image with sub-pixel accuracy. the
+// pixels are read where they are, nothing is copied. the background and its noise come from the border of the
+// region, the star is the brightest spot of 3 x 3 pixels and the aperture around it scales with a first guess
+// of its width. the estimators are
+//   - intensity weighted moments of the background subtracted pixels in the aperture,
+//   - an iterative centroid with a gaussian window of the width of the star,
+//   - a least squares fit of a circular gaussian or moffat profile, and
+//   - a parabola through the brightest pixel and its neighbours in x and y.
+// all of them report the signal to noise ratio, the FWHM and the half flux diameter. pixel centres have
+// integer coordinates, as with the moments of opencv.
+
+#ifndef TSC_CENTROID_H
+#define TSC_CENTROID_H
+
+#include <vector>
+
+class TSC_Centroid {
+public:
+    enum centroidEstimator {ceMoments, ceWindowed, ceGaussian, ceMoffat, ceQuadratic};
+    TSC_Centroid(void);
+    ~TSC_Centroid(void);
+    void setEstimator(short); // one of centroidEstimator
+    short getEstimator(void);
+    bool measure(const unsigned char*, long, int, int, int, int); // image, bytes per line, left, top, width and height of the region; false if there is no star
+    double getCentroid(short); // 0 is x, 1 is y in pixels of the image
+    double getSNR(void); // signal to noise ratio of the star, for a gain of 1 electron per ADU
+    double getFWHM(void); // in pixels
+    double getHFD(void); // diameter that contains half of the flux, in pixels
+    double getBackground(void);
+    int getPeakValue(void); // brightest pixel in the region, for detecting saturation
+
+private:
+    const unsigned char *image;
+    long stride;
+    int roi[4]; // left, top, right and bottom, the last two exclusive
+    short estimator;
+    double background;
+    double noise; // rms of the background
+    double centroid[2];
+    double aperture; // radius in pixels
+    double secondMoment; // mean of the second moments in x and y, pixels^2
+    double snr;
+    double fwhm;
+    double hfd;
+    int peakValue;
+    int peakPos[2];
+    std::vector<double> borderPixels;
+    double getPixel(int, int);
+    void estimateBackground(void);
+    void computeMoments(void);
+    void computeWidth(void); // FWHM from a second moment with a gaussian window
+    bool computeWindowed(void);
+    bool fitProfile(bool); // true for a moffat profile
+    void computeQuadratic(void);
+    void computePhotometry(void);
+};
+
+#endif // TSC_CENTROID_H
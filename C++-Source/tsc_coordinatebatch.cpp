@@ -0,0 +1,158 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+//---------------------------------------------------
+#include "tsc_coordinatebatch.h"
+#include <math.h>
+
+// the loops below are only vectorised if sqrt need not set errno and comparisons need not trap; the flags
+// are set for this file only, as the rest of TSC relies on the strict math of the compiler
+#pragma GCC optimize ("tree-vectorize", "no-math-errno", "no-trapping-math")
+
+TSC_CoordinateBatch::TSC_CoordinateBatch(void) {
+    this->setLatitude(45.0);
+}
+
+//---------------------------------------------------
+TSC_CoordinateBatch::~TSC_CoordinateBatch(void) {
+    this->clear();
+}
+
+//---------------------------------------------------
+void TSC_CoordinateBatch::clear(void) {
+    this->ra.clear();
+    this->sinRA.clear();
+    this->cosRA.clear();
+    this->sinDecl.clear();
+    this->cosDecl.clear();
+    this->hourAngle.clear();
+    this->altitude.clear();
+    this->azimuth.clear();
+}
+
+//---------------------------------------------------
+void TSC_CoordinateBatch::addObject(float lra, float ldecl) {
+    this->ra.push_back(lra);
+    this->sinRA.push_back(sin(lra/180.0*M_PI));
+    this->cosRA.push_back(cos(lra/180.0*M_PI));
+    this->sinDecl.push_back(sin(ldecl/180.0*M_PI));
+    this->cosDecl.push_back(cos(ldecl/180.0*M_PI));
+    this->hourAngle.push_back(0);
+    this->altitude.push_back(0);
+    this->azimuth.push_back(0);
+}
+
+//---------------------------------------------------
+long TSC_CoordinateBatch::getNumberOfObjects(void) {
+    return this->ra.size();
+}
+
+//---------------------------------------------------
+void TSC_CoordinateBatch::setLatitude(double lat) {
+    this->sinLat = sin(lat/180.0*M_PI);
+    this->cosLat = cos(lat/180.0*M_PI);
+}
+
+//---------------------------------------------------
+// the loops are free functions so that the restrict qualifiers are on parameters; gcc ignores them on local
+// pointers and gives up on vectorising when it would need too many runtime checks for overlapping arrays
+static void computeHourAngles(long n, float lstInDeg, const float * __restrict__ pRA, float * __restrict__ pHA) {
+    float ha;
+    long idx;
+
+    for (idx = 0; idx < n; idx++) {
+        ha = lstInDeg - pRA[idx] + 540.0f; // positive, so truncation rounds down
+        pHA[idx] = ha - 360.0f*(int)(ha/360.0f) - 180.0f;
+    }
+}
+
+//---------------------------------------------------
+// sin(HA) and cos(HA) are taken from sin(LST - RA) and cos(LST - RA). the arcsine is the one from Abramowitz
+// and Stegun, 4.4.45; the arctangent is a minimax polynomial on [0,1], extended to all quadrants by symmetry
+static void computeAltAz(long n, float sinLST, float cosLST, float sLat, float cLat,
+                         const float * __restrict__ pSinRA, const float * __restrict__ pCosRA,
+                         const float * __restrict__ pSinDecl, const float * __restrict__ pCosDecl,
+                         float * __restrict__ pAlt, float * __restrict__ pAz) {
+    const float radToDeg = 180.0/M_PI;
+    float sinHA, cosHA, sinAlt, absSinAlt, asinAbs, y, x, absY, absX, t, t2, atanT, az;
+    long idx;
+
+    for (idx = 0; idx < n; idx++) {
+        sinHA = sinLST*pCosRA[idx] - cosLST*pSinRA[idx];
+        cosHA = cosLST*pCosRA[idx] + sinLST*pSinRA[idx];
+        sinAlt = sLat*pSinDecl[idx] + cLat*pCosDecl[idx]*cosHA;
+        absSinAlt = fabsf(sinAlt);
+        absSinAlt = (absSinAlt > 1.0f) ? 1.0f : absSinAlt; // rounding errors
+        asinAbs = 1.5707963f - sqrtf(1.0f - absSinAlt)*(1.5707963f + absSinAlt*(-0.2145988f + absSinAlt*(0.0889789f +
+                  absSinAlt*(-0.0501743f + absSinAlt*(0.0308918f + absSinAlt*(-0.0170881f + absSinAlt*(0.0066700f +
+                  absSinAlt*(-0.0012624f))))))));
+        pAlt[idx] = copysignf(asinAbs, sinAlt)*radToDeg;
+        y = -pCosDecl[idx]*sinHA;
+        x = pSinDecl[idx]*cLat - pCosDecl[idx]*cosHA*sLat;
+        absY = fabsf(y);
+        absX = fabsf(x);
+        t = (absX < absY) ? absX : absY;
+        t /= ((absX > absY) ? absX : absY) + 1e-30f;
+        t2 = t*t;
+        atanT = t*(0.99997726f + t2*(-0.33262347f + t2*(0.19354346f + t2*(-0.11643287f + t2*(0.05265332f + t2*(-0.01172120f))))));
+        az = (absY > absX) ? (1.5707963f - atanT) : atanT; // first octant to first quadrant
+        az = (x < 0) ? (3.1415927f - az) : az;
+        az = copysignf(az, y)*radToDeg;
+        pAz[idx] = (az < 0) ? (az + 360.0f) : az;
+    }
+}
+
+//---------------------------------------------------
+void TSC_CoordinateBatch::convert(double lst) {
+    float lstInDeg, sinLST, cosLST;
+    long n;
+
+    n = this->ra.size();
+    if (n == 0) {
+        return;
+    }
+    lstInDeg = fmod(lst*15.0, 360.0);
+    if (lstInDeg < 0) {
+        lstInDeg += 360.0f;
+    }
+    sinLST = sin(lstInDeg/180.0*M_PI);
+    cosLST = cos(lstInDeg/180.0*M_PI);
+    computeHourAngles(n, lstInDeg, this->ra.data(), this->hourAngle.data());
+    computeAltAz(n, sinLST, cosLST, this->sinLat, this->cosLat, this->sinRA.data(), this->cosRA.data(),
+                 this->sinDecl.data(), this->cosDecl.data(), this->altitude.data(), this->azimuth.data());
+}
+
+//---------------------------------------------------
+float TSC_CoordinateBatch::getHourAngle(long idx) {
+    if ((idx < 0) || (idx >= (long)this->hourAngle.size())) {
+        return 0;
+    }
+    return this->hourAngle[idx];
+}
+
+//---------------------------------------------------
+float TSC_CoordinateBatch::getAltitude(long idx) {
+    if ((idx < 0) || (idx >= (long)this->altitude.size())) {
+        return 0;
+    }
+    return this->altitude[idx];
+}
+
+//---------------------------------------------------
+float TSC_CoordinateBatch::getAzimuth(long idx) {
+    if ((idx < 0) || (idx >= (long)this->azimuth.size())) {
+        return 0;
+    }
+    return this->azimuth[idx];
+}
@@ -0,0 +1,55 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+//---------------------------------------------------
+// a class that converts a whole list of objects - typically a catalog - from right ascension and declination
+// to hour angle, altitude and azimuth for one sidereal time. the data are kept as separate arrays, and the
+// sine and cosine of both coordinates are computed once when the objects are added; the hour angle follows
+// from the addition theorems, so a conversion needs no sine or cosine per object. altitude and azimuth come
+// from polynomial approximations of arcsine and arctangent, good to 0.001 degrees. the loops have no branches
+// and are vectorised by the compiler. all angles in degrees; azimuth from north over east, hour angles from
+// -180 to 180, negative east of the meridian.
+
+#ifndef TSC_COORDINATEBATCH_H
+#define TSC_COORDINATEBATCH_H
+
+#include <vector>
+
+class TSC_CoordinateBatch {
+public:
+    TSC_CoordinateBatch(void);
+    ~TSC_CoordinateBatch(void);
+    void clear(void);
+    void addObject(float, float); // right ascension and declination
+    long getNumberOfObjects(void);
+    void setLatitude(double);
+    void convert(double); // local sidereal time in hours
+    float getHourAngle(long);
+    float getAltitude(long);
+    float getAzimuth(long);
+
+private:
+    std::vector<float> ra;
+    std::vector<float> sinRA;
+    std::vector<float> cosRA;
+    std::vector<float> sinDecl;
+    std::vector<float> cosDecl;
+    std::vector<float> hourAngle;
+    std::vector<float> altitude;
+    std::vector<float> azimuth;
+    float sinLat;
+    float cosLat;
+};
+
+#endif // TSC_COORDINATEBATCH_H
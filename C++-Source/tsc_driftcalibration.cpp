@@ -0,0 +1,294 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+#include "tsc_driftcalibration.h"
+#include <math.h>
+
+static const double siderealRate = 360.0/86164.0905; // degrees/s
+
+TSC_DriftCalibration::TSC_DriftCalibration(void) {
+    this->setModel(0, 0, 0);
+    this->minBaseline = 180;
+    this->residual = 0;
+}
+
+//---------------------------------------------------
+TSC_DriftCalibration::~TSC_DriftCalibration(void) {
+    this->clear();
+}
+
+//---------------------------------------------------
+void TSC_DriftCalibration::setModel(double rate, double up, double east) {
+    this->model[0] = rate;
+    this->model[1] = up/60.0/180.0*M_PI;
+    this->model[2] = east/60.0/180.0*M_PI;
+    this->prior[0] = this->model[0];
+    this->prior[1] = this->model[1];
+    this->prior[2] = this->model[2];
+}
+
+//---------------------------------------------------
+void TSC_DriftCalibration::setMinimumBaseline(double secs) {
+    if (secs > 0) {
+        this->minBaseline = secs;
+    }
+}
+
+//---------------------------------------------------
+void TSC_DriftCalibration::clear(void) {
+    this->fields.clear();
+    this->residual = 0;
+}
+
+//---------------------------------------------------
+void TSC_DriftCalibration::startField(bool isCorrected) {
+    struct fieldStruct field;
+    short idx;
+
+    if ((this->fields.empty() == false) && (this->fields.back().solutions.size() < 2)) {
+        this->fields.pop_back();
+    } // a single solution tells nothing about the drift
+    for (idx = 0; idx < 3; idx++) {
+        if (isCorrected == true) {
+            field.model[idx] = this->model[idx];
+        } else {
+            field.model[idx] = 0;
+        }
+    }
+    this->fields.push_back(field);
+}
+
+//---------------------------------------------------
+long TSC_DriftCalibration::addSolution(double time, double lst, double ra, double decl) {
+    struct solutionStruct sol;
+
+    if (this->fields.empty() == true) {
+        this->startField(false);
+    }
+    sol.time = time;
+    sol.decl = decl;
+    sol.ha = fmod(lst*15.0 - ra + 540.0, 360.0) - 180.0;
+    if (this->fields.back().solutions.empty() == false) {
+        while (ra - this->fields.back().solutions[0].ra > 180) {
+            ra -= 360;
+        }
+        while (ra - this->fields.back().solutions[0].ra < -180) {
+            ra += 360;
+        }
+        while (sol.ha - this->fields.back().solutions[0].ha > 180) {
+            sol.ha -= 360;
+        }
+        while (sol.ha - this->fields.back().solutions[0].ha < -180) {
+            sol.ha += 360;
+        }
+    } // the field may lie at RA 0h or at 12h from the meridian
+    sol.ra = ra;
+    this->fields.back().solutions.push_back(sol);
+    return this->fields.back().solutions.size();
+}
+
+//---------------------------------------------------
+// the drift is the slope of a straight line through the solutions; more than two solutions average the
+// errors of plate solving
+bool TSC_DriftCalibration::getFieldDrift(struct fieldStruct *field, double *raRate, double *declRate, double *ha,
+                                         double *decl, double *baseline) {
+    double meanT = 0, meanRA = 0, meanDecl = 0, meanHA = 0, sTT = 0, sTRA = 0, sTDecl = 0, dt, tMin, tMax;
+    unsigned long idx, n;
+
+    n = field->solutions.size();
+    if (n < 2) {
+        return false;
+    }
+    tMin = tMax = field->solutions[0].time;
+    for (idx = 0; idx < n; idx++) {
+        meanT += field->solutions[idx].time;
+        meanRA += field->solutions[idx].ra;
+        meanDecl += field->solutions[idx].decl;
+        meanHA += field->solutions[idx].ha;
+        tMin = fmin(tMin, field->solutions[idx].time);
+        tMax = fmax(tMax, field->solutions[idx].time);
+    }
+    meanT /= n;
+    meanRA /= n;
+    meanDecl /= n;
+    meanHA /= n;
+    if (tMax - tMin < this->minBaseline) {
+        return false;
+    }
+    for (idx = 0; idx < n; idx++) {
+        dt = field->solutions[idx].time - meanT;
+        sTT += dt*dt;
+        sTRA += dt*(field->solutions[idx].ra - meanRA);
+        sTDecl += dt*(field->solutions[idx].decl - meanDecl);
+    }
+    *raRate = sTRA/sTT;
+    *declRate = sTDecl/sTT;
+    *ha = meanHA;
+    *decl = meanDecl;
+    *baseline = tMax - tMin;
+    return true;
+}
+
+//---------------------------------------------------
+long TSC_DriftCalibration::getNumberOfFields(void) {
+    double raRate, declRate, ha, decl, baseline;
+    unsigned long idx;
+    long cnt = 0;
+
+    for (idx = 0; idx < this->fields.size(); idx++) {
+        if (this->getFieldDrift(&this->fields[idx], &raRate, &declRate, &ha, &decl, &baseline) == true) {
+            cnt++;
+        }
+    }
+    return cnt;
+}
+
+//---------------------------------------------------
+void TSC_DriftCalibration::predictDrift(const double *p, double ha, double decl, double *raRate, double *declRate) {
+    double sinHA, cosHA;
+
+    sinHA = sin(ha/180.0*M_PI);
+    cosHA = cos(ha/180.0*M_PI);
+    *declRate = siderealRate*(p[1]*sinHA + p[2]*cosHA);
+    *raRate = siderealRate*(p[0] + tan(decl/180.0*M_PI)*(p[1]*cosHA - p[2]*sinHA));
+}
+
+//---------------------------------------------------
+void TSC_DriftCalibration::getDriftRates(double ha, double decl, double *raRate, double *declRate) {
+    this->predictDrift(this->model, ha, decl, raRate, declRate);
+}
+
+//---------------------------------------------------
+// weighted least squares for the three parameters; the RA equation is multiplied by cos(decl) so that both
+// equations are in arc on the sky. the baseline weighs the fields as the error of the slope falls with it.
+// the tilt of the pole is pulled weakly towards the prior model, which only matters where the fields do not
+// determine it
+bool TSC_DriftCalibration::fitModel(void) {
+    double normal[3][4], rows[2][4], raRate, declRate, ha, decl, baseline, applied[2], weight, sinHA, cosHA,
+           sinDecl, cosDecl, lambda, factor, sqSum = 0, weightSum = 0, res, solution[3];
+    unsigned long idx;
+    short row, i, j, k, pivot;
+
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < 4; j++) {
+            normal[i][j] = 0;
+        }
+    }
+    for (idx = 0; idx < this->fields.size(); idx++) {
+        if (this->getFieldDrift(&this->fields[idx], &raRate, &declRate, &ha, &decl, &baseline) == false) {
+            continue;
+        }
+        this->predictDrift(this->fields[idx].model, ha, decl, &applied[0], &applied[1]);
+        raRate += applied[0];
+        declRate += applied[1]; // the drift without the correction that was applied while the field was tracked
+        weight = baseline*baseline/3600.0;
+        sinHA = sin(ha/180.0*M_PI);
+        cosHA = cos(ha/180.0*M_PI);
+        sinDecl = sin(decl/180.0*M_PI);
+        cosDecl = cos(decl/180.0*M_PI);
+        rows[0][0] = 0;
+        rows[0][1] = sinHA;
+        rows[0][2] = cosHA;
+        rows[0][3] = declRate/siderealRate;
+        rows[1][0] = cosDecl;
+        rows[1][1] = sinDecl*cosHA;
+        rows[1][2] = -sinDecl*sinHA;
+        rows[1][3] = cosDecl*raRate/siderealRate;
+        for (row = 0; row < 2; row++) {
+            for (i = 0; i < 3; i++) {
+                for (j = 0; j < 4; j++) {
+                    normal[i][j] += weight*rows[row][i]*rows[row][j];
+                }
+            }
+        }
+        weightSum += weight;
+    }
+    if (weightSum == 0) {
+        return false;
+    }
+    lambda = 1e-3*(normal[0][0] + normal[1][1] + normal[2][2])/3.0;
+    for (i = 1; i < 3; i++) {
+        normal[i][i] += lambda;
+        normal[i][3] += lambda*this->prior[i];
+    }
+    for (i = 0; i < 3; i++) {
+        pivot = i;
+        for (k = i + 1; k < 3; k++) {
+            if (fabs(normal[k][i]) > fabs(normal[pivot][i])) {
+                pivot = k;
+            }
+        }
+        if (fabs(normal[pivot][i]) < 1e-15) {
+            return false;
+        }
+        if (pivot != i) {
+            for (j = 0; j < 4; j++) {
+                factor = normal[i][j];
+                normal[i][j] = normal[pivot][j];
+                normal[pivot][j] = factor;
+            }
+        }
+        for (k = i + 1; k < 3; k++) {
+            factor = normal[k][i]/normal[i][i];
+            for (j = i; j < 4; j++) {
+                normal[k][j] -= factor*normal[i][j];
+            }
+        }
+    } // gaussian elimination ...
+    for (i = 2; i >= 0; i--) {
+        solution[i] = normal[i][3];
+        for (j = i + 1; j < 3; j++) {
+            solution[i] -= normal[i][j]*solution[j];
+        }
+        solution[i] /= normal[i][i];
+    } // ... and back substitution
+    for (idx = 0; idx < this->fields.size(); idx++) {
+        if (this->getFieldDrift(&this->fields[idx], &raRate, &declRate, &ha, &decl, &baseline) == false) {
+            continue;
+        }
+        this->predictDrift(this->fields[idx].model, ha, decl, &applied[0], &applied[1]);
+        raRate += applied[0];
+        declRate += applied[1];
+        this->predictDrift(solution, ha, decl, &applied[0], &applied[1]);
+        res = (raRate - applied[0])*cos(decl/180.0*M_PI);
+        sqSum += res*res;
+        res = declRate - applied[1];
+        sqSum += res*res;
+    }
+    this->residual = sqrt(sqSum/(2.0*this->getNumberOfFields()))*3600.0*60.0;
+    for (i = 0; i < 3; i++) {
+        this->model[i] = solution[i];
+    }
+    return true;
+}
+
+//---------------------------------------------------
+double TSC_DriftCalibration::getRateError(void) {
+    return this->model[0];
+}
+
+//---------------------------------------------------
+double TSC_DriftCalibration::getPoleOffset(short what) {
+    if ((what < 0) || (what > 1)) {
+        return 0;
+    }
+    return this->model[what + 1]*180.0/M_PI*60.0;
+}
+
+//---------------------------------------------------
+double TSC_DriftCalibration::getResidual(void) {
+    return this->residual;
+}
@@ -0,0 +1,68 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+//---------------------------------------------------
+// derives the error of the RA tracking rate and the misalignment of the polar axis from the drift of plate
+// solved positions while the mount tracks. a field is a series of solutions without any motion of the mount
+// other than tracking; its drift in RA and declination is fitted by a straight line. with the mount axis tilted
+// by a small angle from the celestial pole, declination drifts by w*(up*sin(HA) + east*cos(HA)) and RA by
+// w*(rate + tan(decl)*(up*cos(HA) - east*sin(HA))), where w is the sidereal rate, "up" the tilt of the pole
+// towards the zenith, "east" the tilt towards the east and "rate" the fraction by which the RA drive turns
+// too slowly. fields in the meridian show the azimuth error, fields in the east or west the altitude error;
+// as long as the fields do not tell them apart, the polar axis stays close to the model given with setModel.
+// in the southern hemisphere, a positive "east" tilt moves the visible pole to the west. angles are given in
+// degrees, the hour angle counts from the meridian to the west, times in seconds.
+
+#ifndef TSC_DRIFTCALIBRATION_H
+#define TSC_DRIFTCALIBRATION_H
+
+#include <vector>
+
+class TSC_DriftCalibration {
+public:
+    TSC_DriftCalibration(void);
+    ~TSC_DriftCalibration(void);
+    void setModel(double, double, double); // rate error as a fraction, tilt of the pole up and east in arcmin - the correction that is applied
+    void setMinimumBaseline(double); // shortest time in s between the first and the last solution of a usable field
+    void clear(void); // forget all fields
+    void startField(bool); // the mount has moved; the next solutions belong to a new field. true if the model corrects its tracking
+    long addSolution(double, double, double, double); // time, LST in hours, RA and decl of the solution; returns the number of solutions in the field
+    long getNumberOfFields(void); // fields with a sufficient baseline
+    bool fitModel(void); // false if there is no usable field
+    double getRateError(void); // fraction of the sidereal rate the RA drive turns too slowly
+    double getPoleOffset(short); // 0 is the tilt of the pole towards the zenith, 1 towards the east, in arcmin
+    double getResidual(void); // rms of the drift not explained by the model, in arcsec/min
+    void getDriftRates(double, double, double*, double*); // hour angle and decl -> drift in RA and decl in degrees/s while tracking
+
+private:
+    struct solutionStruct {
+        double time;
+        double ha;
+        double ra; // unwrapped relative to the first solution of the field
+        double decl;
+    };
+    struct fieldStruct {
+        std::vector<solutionStruct> solutions;
+        double model[3]; // the correction that was applied while the field was tracked
+    };
+    std::vector<fieldStruct> fields;
+    double model[3]; // rate error, tilt up and east in radians
+    double prior[3];
+    double residual;
+    double minBaseline;
+    bool getFieldDrift(struct fieldStruct*, double*, double*, double*, double*, double*); // RA and decl rate in degrees/s, mean hour angle, decl, baseline
+    void predictDrift(const double*, double, double, double*, double*);
+};
+
+#endif // TSC_DRIFTCALIBRATION_H
@@ -0,0 +1,241 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+//---------------------------------------------------
+#include "tsc_drivetuner.h"
+#include <math.h>
+
+TSC_DriveTuner::TSC_DriveTuner(void) {
+    this->limits.minAcc = 100;
+    this->setLimits(10000, 1.5, 1000);
+    this->setMargins(0.7, 0.8);
+    this->start(1000, 1.0, 100);
+    this->state.phase = 3;
+}
+
+//---------------------------------------------------
+TSC_DriveTuner::~TSC_DriveTuner(void) {
+}
+
+//---------------------------------------------------
+void TSC_DriveTuner::setLimits(double acc, double current, long speed) {
+    this->limits.maxAcc = fmax(acc, this->limits.minAcc);
+    this->limits.maxCurrent = current;
+    this->limits.maxSpeed = speed;
+    if (this->limits.maxSpeed < 1) {
+        this->limits.maxSpeed = 1;
+    }
+}
+
+//---------------------------------------------------
+void TSC_DriveTuner::setMargins(double accFraction, double speedFraction) {
+    if ((accFraction > 0) && (accFraction <= 1)) {
+        this->limits.accMargin = accFraction;
+    }
+    if ((speedFraction > 0) && (speedFraction <= 1)) {
+        this->limits.speedMargin = speedFraction;
+    }
+}
+
+//---------------------------------------------------
+void TSC_DriveTuner::start(double acc, double current, long speed) {
+    this->state.phase = 0;
+    this->state.trialAcc = fmin(fmax(acc, this->limits.minAcc), this->limits.maxAcc);
+    this->state.trialCurrent = fmin(current, this->limits.maxCurrent);
+    this->state.trialSpeed = speed;
+    if (this->state.trialSpeed > this->limits.maxSpeed) {
+        this->state.trialSpeed = this->limits.maxSpeed;
+    }
+    if (this->state.trialSpeed < 1) {
+        this->state.trialSpeed = 1;
+    }
+    this->state.goodAcc = this->state.trialAcc;
+    this->state.goodCurrent = this->state.trialCurrent;
+    this->state.goodSpeed = this->state.trialSpeed;
+    this->state.accStalled = false;
+    this->state.speedStalled = false;
+    this->state.failed = false;
+    this->state.tests = 0;
+    this->state.stalls = 0;
+}
+
+//---------------------------------------------------
+// the current is raised first; only if that does not help, the settings are changed
+void TSC_DriveTuner::reportTest(bool stalled) {
+    if (this->state.phase > 2) {
+        return;
+    }
+    this->state.tests++;
+    if (stalled == true) {
+        this->state.stalls++;
+    }
+    switch (this->state.phase) {
+    case 0: // the settings the drive runs with
+        if (stalled == false) {
+            this->state.goodAcc = this->state.trialAcc;
+            this->state.goodCurrent = this->state.trialCurrent;
+            this->state.phase = 1;
+            if (this->state.goodAcc >= this->limits.maxAcc) {
+                this->startSpeedPhase();
+            } else {
+                this->state.trialAcc = fmin(this->state.goodAcc*1.25, this->limits.maxAcc);
+            }
+        } else {
+            this->state.accStalled = true;
+            if (this->raiseCurrent() == false) {
+                this->state.trialAcc *= this->limits.accMargin;
+                if (this->state.trialAcc < this->limits.minAcc) {
+                    this->state.failed = true;
+                    this->state.phase = 3;
+                }
+            }
+        }
+        break;
+    case 1:
+        if (stalled == false) {
+            this->state.goodAcc = this->state.trialAcc;
+            this->state.goodCurrent = this->state.trialCurrent;
+            if (this->state.goodAcc >= this->limits.maxAcc) {
+                this->startSpeedPhase();
+            } else {
+                this->state.trialAcc = fmin(this->state.goodAcc*1.25, this->limits.maxAcc);
+            }
+        } else {
+            this->state.accStalled = true;
+            if (this->raiseCurrent() == false) {
+                this->startSpeedPhase();
+            }
+        }
+        break;
+    case 2:
+        if (stalled == false) {
+            this->state.goodSpeed = this->state.trialSpeed;
+            this->setNextSpeed();
+        } else {
+            this->state.speedStalled = true;
+            this->state.phase = 3;
+        }
+        break;
+    }
+}
+
+//---------------------------------------------------
+bool TSC_DriveTuner::raiseCurrent(void) {
+    if (this->state.trialCurrent + 0.25 > this->limits.maxCurrent + 1e-6) {
+        this->state.trialCurrent = this->state.goodCurrent;
+        return false;
+    }
+    this->state.trialCurrent += 0.25;
+    return true;
+}
+
+//---------------------------------------------------
+// the speed is tested with the acceleration that is finally used
+void TSC_DriveTuner::startSpeedPhase(void) {
+    this->state.phase = 2;
+    if (this->state.accStalled == true) {
+        this->state.goodAcc = fmax(this->limits.minAcc, this->state.goodAcc*this->limits.accMargin);
+    }
+    this->state.trialAcc = this->state.goodAcc;
+    this->state.trialCurrent = this->state.goodCurrent;
+    this->setNextSpeed();
+}
+
+//---------------------------------------------------
+void TSC_DriveTuner::setNextSpeed(void) {
+    if (this->state.goodSpeed >= this->limits.maxSpeed) {
+        this->state.phase = 3;
+        return;
+    }
+    this->state.trialSpeed = lround(this->state.goodSpeed*1.2);
+    if (this->state.trialSpeed <= this->state.goodSpeed) {
+        this->state.trialSpeed = this->state.goodSpeed + 1;
+    }
+    if (this->state.trialSpeed > this->limits.maxSpeed) {
+        this->state.trialSpeed = this->limits.maxSpeed;
+    }
+}
+
+//---------------------------------------------------
+short TSC_DriveTuner::getPhase(void) {
+    return this->state.phase;
+}
+
+//---------------------------------------------------
+bool TSC_DriveTuner::isFinished(void) {
+    return (this->state.phase > 2);
+}
+
+//---------------------------------------------------
+bool TSC_DriveTuner::hasFailed(void) {
+    return this->state.failed;
+}
+
+//---------------------------------------------------
+double TSC_DriveTuner::getTrialAcceleration(void) {
+    return this->state.trialAcc;
+}
+
+//---------------------------------------------------
+double TSC_DriveTuner::getTrialCurrent(void) {
+    return this->state.trialCurrent;
+}
+
+//---------------------------------------------------
+long TSC_DriveTuner::getTrialSpeed(void) {
+    return this->state.trialSpeed;
+}
+
+//---------------------------------------------------
+// long enough to reach the speed and to keep it for a second, but at least 2 and at most 30 degrees
+long TSC_DriveTuner::getTestTravel(double stepsPerDegree, double speed) {
+    double steps;
+
+    steps = speed*speed/this->state.trialAcc + speed;
+    steps = fmax(steps, 2.0*stepsPerDegree);
+    steps = fmin(steps, 30.0*stepsPerDegree);
+    return lround(steps);
+}
+
+//---------------------------------------------------
+double TSC_DriveTuner::getResult(short what) {
+    long speed;
+
+    switch (what) {
+    case 0:
+        return this->state.goodAcc;
+    case 1:
+        return this->state.goodCurrent;
+    case 2:
+        speed = this->state.goodSpeed;
+        if (this->state.speedStalled == true) {
+            speed = (long)floor(speed*this->limits.speedMargin);
+        }
+        if (speed < 1) {
+            speed = 1;
+        }
+        return speed;
+    }
+    return -1;
+}
+
+//---------------------------------------------------
+long TSC_DriveTuner::getNumberOfTests(void) {
+    return this->state.tests;
+}
+
+//---------------------------------------------------
+long TSC_DriveTuner::getNumberOfStalls(void) {
+    return this->state.stalls;
+}
@@ -0,0 +1,77 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+//---------------------------------------------------
+// the search for the largest acceleration and GoTo speed a drive can carry with the payload of the mount.
+// the drive is tested with short slews out and back; the caller carries them out and reports whether the
+// motor has stalled. starting from settings that are known to work, the acceleration is raised by 25% per
+// test. if the motor stalls, the current is raised in steps of 0.25 A and the test is repeated until the
+// maximum current is reached. with the acceleration found, the speed is raised by 20% per test until the
+// motor stalls or the limit is reached. if a stall was seen, the results keep a margin to the settings
+// where it happened. accelerations are given in microsteps/s^2, currents in A and speeds as multiples
+// of the sidereal rate, as in the GUI.
+
+#ifndef TSC_DRIVETUNER_H
+#define TSC_DRIVETUNER_H
+
+class TSC_DriveTuner {
+public:
+    TSC_DriveTuner(void);
+    ~TSC_DriveTuner(void);
+    void setLimits(double, double, long); // maximum acceleration, current and speed that may be tried
+    void setMargins(double, double); // fraction of the last acceleration and speed that worked, used if the motor stalled
+    void start(double, double, long); // acceleration, current and speed the drive runs with now
+    void reportTest(bool); // true if the motor stalled with the trial settings
+    short getPhase(void); // 0 checks the settings it started from, 1 raises the acceleration, 2 the speed, 3 is done
+    bool isFinished(void);
+    bool hasFailed(void); // true if the motor stalls even at the lowest acceleration
+    double getTrialAcceleration(void);
+    double getTrialCurrent(void);
+    long getTrialSpeed(void);
+    long getTestTravel(double, double); // microsteps per degree and trial speed in microsteps/s -> length of a test slew in microsteps
+    double getResult(short); // 0 acceleration, 1 current, 2 speed
+    long getNumberOfTests(void);
+    long getNumberOfStalls(void);
+
+private:
+    struct tunerLimitsStruct {
+        double minAcc;
+        double maxAcc;
+        double maxCurrent;
+        long maxSpeed;
+        double accMargin;
+        double speedMargin;
+    };
+    struct tunerStateStruct {
+        short phase;
+        double goodAcc; // the settings of the last test without a stall
+        double goodCurrent;
+        long goodSpeed;
+        double trialAcc;
+        double trialCurrent;
+        long trialSpeed;
+        bool accStalled; // a stall was seen while raising the acceleration
+        bool speedStalled;
+        bool failed;
+        long tests;
+        long stalls;
+    };
+    struct tunerLimitsStruct limits;
+    struct tunerStateStruct state;
+    bool raiseCurrent(void);
+    void startSpeedPhase(void);
+    void setNextSpeed(void);
+};
+
+#endif // TSC_DRIVETUNER_H
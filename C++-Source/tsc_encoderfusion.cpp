@@ -0,0 +1,203 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+#include "tsc_encoderfusion.h"
+#include <math.h>
+
+#define LOOP_TIME_CONSTANT 60.0 // slip in RA is made up within about a minute
+#define MAX_TRACKING_RATE 0.0004 // about 10% of the celestial speed in degrees/s
+
+TSC_EncoderFusion::TSC_EncoderFusion(void) {
+    short axis;
+
+    for (axis = 0; axis < 2; axis++) {
+        this->encoderAxis[axis].countsPerRevolution = 16777216; // a 24 bit encoder
+        this->encoderAxis[axis].direction = 1;
+    }
+    this->slipThresholdInArcsec = 30;
+    this->filterGain = 0.2;
+    this->closedLoopIsOn = false;
+    this->reset();
+}
+
+//---------------------------------------------------
+TSC_EncoderFusion::~TSC_EncoderFusion(void) {
+}
+
+//---------------------------------------------------
+void TSC_EncoderFusion::setEncoder(short axis, long counts, short dir) {
+    if ((axis < 0) || (axis > 1) || (counts <= 0)) {
+        return;
+    }
+    if ((this->encoderAxis[axis].countsPerRevolution != counts) || (this->encoderAxis[axis].direction != dir)) {
+        this->encoderAxis[axis].countsPerRevolution = counts;
+        if (dir < 0) {
+            this->encoderAxis[axis].direction = -1;
+        } else {
+            this->encoderAxis[axis].direction = 1;
+        }
+        this->encoderAxis[axis].hasReference = false;
+    }
+}
+
+//---------------------------------------------------
+void TSC_EncoderFusion::setSlipThreshold(double arcsec) {
+    if (arcsec > 0) {
+        this->slipThresholdInArcsec = arcsec;
+    }
+}
+
+//---------------------------------------------------
+void TSC_EncoderFusion::setFilterGain(double gain) {
+    if ((gain > 0) && (gain <= 1)) {
+        this->filterGain = gain;
+    }
+}
+
+//---------------------------------------------------
+void TSC_EncoderFusion::reset(void) {
+    short axis;
+
+    for (axis = 0; axis < 2; axis++) {
+        this->encoderAxis[axis].hasReference = false;
+        this->encoderAxis[axis].lastCounts = 0;
+        this->encoderAxis[axis].encoderTravel = 0;
+        this->encoderAxis[axis].stepTravel = 0;
+        this->encoderAxis[axis].appliedCorrection = 0;
+        this->encoderAxis[axis].slipped = false;
+    }
+    this->loopHasReference = false;
+    this->deviationAtLoopStart = 0;
+    this->loopTravel = 0;
+    this->trackingRate = 0;
+}
+
+//---------------------------------------------------
+// the travel between two readings is taken from the difference of the counts; an absolute encoder wraps
+// around after a revolution, so a difference of more than half a revolution is one across the zero mark.
+// while the axis slews, TSC estimates the travel from a mean speed, and a difference to the encoder is
+// no slip; the encoder is taken as it is once the axis has come to rest
+double TSC_EncoderFusion::update(short axis, double stepTravel, long counts, double dt, bool wasSlewing) {
+    struct encoderAxisStruct *enc;
+    double encoderStep, pending, correction, lag, loopError;
+    long deltaCounts;
+
+    if ((axis < 0) || (axis > 1)) {
+        return 0;
+    }
+    enc = &this->encoderAxis[axis];
+    if (enc->hasReference == false) {
+        enc->hasReference = true;
+        enc->lastCounts = counts;
+        enc->encoderTravel = 0;
+        enc->stepTravel = 0;
+        enc->appliedCorrection = 0;
+        enc->slipped = false;
+        return 0;
+    }
+    deltaCounts = this->getCountDifference(axis, counts, enc->lastCounts);
+    enc->lastCounts = counts;
+    encoderStep = enc->direction*deltaCounts*360.0/enc->countsPerRevolution;
+    enc->encoderTravel += encoderStep;
+    enc->stepTravel += stepTravel;
+    pending = enc->encoderTravel - enc->stepTravel - enc->appliedCorrection;
+    enc->slipped = false;
+    if (wasSlewing == true) {
+        correction = pending;
+    } else {
+        if (fabs(encoderStep - stepTravel)*3600.0 > this->slipThresholdInArcsec) {
+            enc->slipped = true;
+            correction = pending; // after a slip, the encoder is right
+        } else {
+            correction = this->filterGain*pending;
+        }
+    }
+    enc->appliedCorrection += correction;
+
+    if (axis == 0) {
+        if ((this->closedLoopIsOn == false) || (wasSlewing == true)) {
+            this->loopHasReference = false;
+            this->trackingRate = 0;
+        } else {
+            if (this->loopHasReference == false) {
+                this->loopHasReference = true;
+                this->deviationAtLoopStart = enc->encoderTravel - enc->stepTravel;
+                this->loopTravel = 0;
+                this->trackingRate = 0;
+            } else {
+                this->loopTravel += this->trackingRate*dt; // the extra travel shows in both encoder and step counting
+                lag = -((enc->encoderTravel - enc->stepTravel) - this->deviationAtLoopStart);
+                loopError = lag - this->loopTravel;
+                this->trackingRate = loopError/LOOP_TIME_CONSTANT;
+                if (this->trackingRate > MAX_TRACKING_RATE) {
+                    this->trackingRate = MAX_TRACKING_RATE;
+                }
+                if (this->trackingRate < -MAX_TRACKING_RATE) {
+                    this->trackingRate = -MAX_TRACKING_RATE;
+                }
+            }
+        }
+    }
+    return correction;
+}
+
+//---------------------------------------------------
+long TSC_EncoderFusion::getCountDifference(short axis, long counts, long earlierCounts) {
+    long deltaCounts, countsPerRevolution;
+
+    deltaCounts = counts - earlierCounts;
+    if ((axis < 0) || (axis > 1)) {
+        return deltaCounts;
+    }
+    countsPerRevolution = this->encoderAxis[axis].countsPerRevolution;
+    if (deltaCounts > countsPerRevolution/2) {
+        deltaCounts -= countsPerRevolution;
+    }
+    if (deltaCounts < -countsPerRevolution/2) {
+        deltaCounts += countsPerRevolution;
+    }
+    return deltaCounts;
+}
+
+//---------------------------------------------------
+bool TSC_EncoderFusion::hasSlipped(short axis) {
+    if ((axis < 0) || (axis > 1)) {
+        return false;
+    }
+    return this->encoderAxis[axis].slipped;
+}
+
+//---------------------------------------------------
+double TSC_EncoderFusion::getDeviation(short axis) {
+    if ((axis < 0) || (axis > 1)) {
+        return 0;
+    }
+    return (this->encoderAxis[axis].encoderTravel - this->encoderAxis[axis].stepTravel)*3600.0;
+}
+
+//---------------------------------------------------
+void TSC_EncoderFusion::setClosedLoop(bool isOn) {
+    this->closedLoopIsOn = isOn;
+    if (isOn == false) {
+        this->loopHasReference = false;
+        this->trackingRate = 0;
+    }
+}
+
+//---------------------------------------------------
+double TSC_EncoderFusion::getTrackingRate(void) {
+    return this->trackingRate;
+}
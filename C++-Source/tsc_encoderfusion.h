@@ -0,0 +1,65 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+// a class that fuses the position from step counting with readings of absolute encoders on the axes.
+// TSC counts the travel of the axes from the speed of the drives; encoders tell the true travel, but
+// their readings are noisy in the last counts. the position is therefore pulled towards the encoders
+// in small portions, and slippage of the gears shows up as a jump between both. in RA, the slip can be
+// made up by a tracking rate on top of the celestial speed. travel is given in degrees of the axis and
+// counted positive in the direction of the drive; axis 0 is RA, 1 is declination.
+
+#ifndef TSC_ENCODERFUSION_H
+#define TSC_ENCODERFUSION_H
+
+class TSC_EncoderFusion {
+public:
+    TSC_EncoderFusion(void);
+    ~TSC_EncoderFusion(void);
+    void setEncoder(short, long, short); // axis, counts per revolution of the axis and direction (+/-1) of counting
+    void setSlipThreshold(double); // difference between encoder and step counting in arcsec within one update that is taken as slip
+    void setFilterGain(double); // fraction of the difference that is corrected in one update, 0 < gain <= 1
+    void reset(void); // after a sync or a meridian flip; the next readings become the new reference
+    double update(short, double, long, double, bool); // axis, travel from step counting since the last update, encoder counts, time since the last update in s
+        // and a flag that tells whether the axis slewed in between; returns the correction of the position in degrees
+    bool hasSlipped(short); // true if the last update found a slip
+    long getCountDifference(short, long, long); // axis, counts and earlier counts -> counts in between, taking the wrap of the encoder
+        // at a full revolution into account; the axis is taken to have turned less than half a revolution
+    double getDeviation(short); // encoder minus step counting since the reference in arcsec
+    void setClosedLoop(bool); // RA tracking makes up for slip
+    double getTrackingRate(void); // additional RA rate in degrees/s
+
+private:
+    struct encoderAxisStruct {
+        long countsPerRevolution;
+        short direction;
+        bool hasReference;
+        long lastCounts;
+        double encoderTravel; // since the reference
+        double stepTravel;
+        double appliedCorrection;
+        bool slipped;
+    };
+    struct encoderAxisStruct encoderAxis[2];
+    double slipThresholdInArcsec;
+    double filterGain;
+    bool closedLoopIsOn;
+    bool loopHasReference;
+    double deviationAtLoopStart;
+    double loopTravel; // travel added by the tracking rate since the loop was started
+    double trackingRate;
+};
+
+#endif // TSC_ENCODERFUSION_H
@@ -0,0 +1,178 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+#include "tsc_fitsdecoder.h"
+#include <math.h>
+#include <string.h>
+
+static const long saturationValue = 64224; // 98% of 65535, as 250 is of 255 for an 8 bit camera
+
+TSC_FitsDecoder::TSC_FitsDecoder(void) {
+    this->clipping = 0.02;
+    this->clipLevel[0] = 0;
+    this->clipLevel[1] = 65535;
+    this->rawHistogram[0].resize(65536);
+    this->rawHistogram[1].resize(65536);
+    this->histogram.resize(65536);
+    this->lookupTable.resize(65536);
+}
+
+//---------------------------------------------------
+TSC_FitsDecoder::~TSC_FitsDecoder(void) {
+    this->rawHistogram[0].clear();
+    this->rawHistogram[1].clear();
+    this->histogram.clear();
+    this->lookupTable.clear();
+}
+
+//---------------------------------------------------
+void TSC_FitsDecoder::setClipping(double part) {
+    if ((part >= 0) && (part < 0.5)) {
+        this->clipping = part;
+    }
+}
+
+//---------------------------------------------------
+long TSC_FitsDecoder::getClipLevel(bool upper) {
+    if (upper == true) {
+        return this->clipLevel[1];
+    }
+    return this->clipLevel[0];
+}
+
+//---------------------------------------------------
+// the value in ADU of a word as it is in memory; the FITS word is big endian, whatever the machine is
+static long getValueOfRawWord(unsigned int raw, long bzero) {
+    unsigned short word;
+    unsigned char bytes[2];
+    short signedWord;
+    long value;
+
+    word = (unsigned short)raw;
+    memcpy(bytes, &word, 2);
+    signedWord = (short)((bytes[0] << 8) | bytes[1]);
+    value = signedWord + bzero;
+    if (value < 0) {
+        value = 0;
+    }
+    if (value > 65535) {
+        value = 65535;
+    }
+    return value;
+}
+
+//---------------------------------------------------
+// the loops are free functions so that the restrict qualifiers are on parameters, as in tsc_coordinatebatch
+static void countRawWords(long n, const unsigned char * __restrict__ data, unsigned int * __restrict__ hist0,
+                         unsigned int * __restrict__ hist1) {
+    unsigned short word0, word1;
+    long idx;
+
+    for (idx = 0; idx + 1 < n; idx += 2) {
+        memcpy(&word0, data + 2*idx, 2);
+        memcpy(&word1, data + 2*idx + 2, 2);
+        hist0[word0]++;
+        hist1[word1]++;
+    }
+    if (idx < n) {
+        memcpy(&word0, data + 2*idx, 2);
+        hist0[word0]++;
+    }
+}
+
+//---------------------------------------------------
+static void lookUpRawWords(long n, const unsigned char * __restrict__ data, const unsigned char * __restrict__ lut,
+                           unsigned char * __restrict__ out) {
+    unsigned short word;
+    long idx;
+
+    for (idx = 0; idx < n; idx++) {
+        memcpy(&word, data + 2*idx, 2);
+        out[idx] = lut[word];
+    }
+}
+
+//---------------------------------------------------
+// the lowest and the highest value where the clipped part of the pixels is reached, as in ccd_client before
+void TSC_FitsDecoder::computeClipLevels(long bzero, long numberOfPixels) {
+    double toBeClipped;
+    long count, value;
+
+    this->histogram.assign(65536, 0);
+    for (value = 0; value < 65536; value++) {
+        this->histogram[getValueOfRawWord(value, bzero)] += this->rawHistogram[0][value] + this->rawHistogram[1][value];
+    }
+    toBeClipped = numberOfPixels*this->clipping;
+    count = 0;
+    value = 0;
+    do {
+        count += this->histogram[value];
+        value++;
+    } while ((count < toBeClipped) && (value < 65536));
+    this->clipLevel[0] = value - 1;
+    count = 0;
+    value = 65535;
+    do {
+        count += this->histogram[value];
+        value--;
+    } while ((count < toBeClipped) && (value >= 0));
+    this->clipLevel[1] = value + 1;
+    if (this->clipLevel[1] <= this->clipLevel[0]) {
+        this->clipLevel[1] = this->clipLevel[0] + 1; // a flat image
+    }
+}
+
+//---------------------------------------------------
+void TSC_FitsDecoder::fillLookupTable(long bzero) {
+    double scale;
+    long raw, value;
+
+    scale = 250.0/(this->clipLevel[1] - this->clipLevel[0]);
+    for (raw = 0; raw < 65536; raw++) {
+        value = getValueOfRawWord(raw, bzero);
+        if (value >= saturationValue) {
+            this->lookupTable[raw] = 255;
+        } else if (value <= this->clipLevel[0]) {
+            this->lookupTable[raw] = 0;
+        } else if (value >= this->clipLevel[1]) {
+            this->lookupTable[raw] = 250;
+        } else {
+            this->lookupTable[raw] = (unsigned char)floor((value - this->clipLevel[0])*scale);
+        }
+    }
+}
+
+//---------------------------------------------------
+bool TSC_FitsDecoder::decode(const unsigned char *data, long width, long height, double bzero, unsigned char *image, long bytesPerLine) {
+    long row;
+
+    if ((data == 0) || (image == 0) || (width <= 0) || (height <= 0) || (bytesPerLine < width)) {
+        return false;
+    }
+    this->rawHistogram[0].assign(65536, 0);
+    this->rawHistogram[1].assign(65536, 0);
+    countRawWords(width*height, data, this->rawHistogram[0].data(), this->rawHistogram[1].data());
+    this->computeClipLevels(lround(bzero), width*height);
+    this->fillLookupTable(lround(bzero));
+    if (bytesPerLine == width) {
+        lookUpRawWords(width*height, data, this->lookupTable.data(), image);
+    } else {
+        for (row = 0; row < height; row++) {
+            lookUpRawWords(width, data + 2*row*width, this->lookupTable.data(), image + row*bytesPerLine);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+// converts the 16 bit pixels of a FITS image to an 8 bit image for display and guiding. the histogram is
+// stretched so that a part of the pixels is clipped at either end, and the rest is mapped linearly to 0..250.
+// FITS stores signed big endian words and BZERO; the byte order and BZERO are not applied to every pixel,
+// but taken into the tables instead: the histogram counts the words as they are in memory, and a lookup
+// table from these words to 8 bit is built once per image. so the image is read twice, once for the
+// histogram and once for the lookup, without any arithmetic per pixel. pixels at 98% of the 16 bit range
+// are saturated on the chip; they become 255, above the stretch, so that the 8 bit image still shows them
+// after the brightest pixels have been clipped to 250.
+
+#ifndef TSC_FITSDECODER_H
+#define TSC_FITSDECODER_H
+
+#include <vector>
+
+class TSC_FitsDecoder {
+public:
+    TSC_FitsDecoder(void);
+    ~TSC_FitsDecoder(void);
+    void setClipping(double); // part of the pixels clipped at either end of the histogram, 0.02 by default
+    bool decode(const unsigned char*, long, long, double, unsigned char*, long); // FITS data after the header, width, height, BZERO, 8 bit image and its bytes per line
+    long getClipLevel(bool); // ADU that is mapped to 0, or to 250 for true, in the last image
+
+private:
+    double clipping;
+    long clipLevel[2];
+    std::vector<unsigned int> rawHistogram[2]; // two, so that neighbouring pixels of equal value do not wait for each other
+    std::vector<unsigned int> histogram; // of the values in ADU
+    std::vector<unsigned char> lookupTable;
+    void computeClipLevels(long, long);
+    void fillLookupTable(long);
+};
+
+#endif // TSC_FITSDECODER_H
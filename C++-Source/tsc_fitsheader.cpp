@@ -0,0 +1,276 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+#include "tsc_fitsheader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+TSC_FitsHeader::TSC_FitsHeader(void) {
+    this->clear();
+}
+
+//---------------------------------------------------
+TSC_FitsHeader::~TSC_FitsHeader(void) {
+    this->cards.clear();
+}
+
+//---------------------------------------------------
+void TSC_FitsHeader::clear(void) {
+    this->cards.clear();
+    this->headerLength = 0;
+    this->bitpix = 0;
+    this->axisLength[0] = this->axisLength[1] = this->axisLength[2] = 0;
+    this->bzero = 0;
+    this->bscale = 1;
+}
+
+//---------------------------------------------------
+// a card is "KEYWORD = value / comment". numbers may have a "D" exponent, T and F are logical values
+// and are stored as 1 and 0; strings in quotes are not needed and are skipped
+bool TSC_FitsHeader::parseCard(const char *card, struct cardStruct *parsed) {
+    char valueField[72], *end;
+    int idx, len;
+
+    memcpy(parsed->keyword, card, 8);
+    parsed->keyword[8] = 0;
+    for (idx = 7; (idx >= 0) && (parsed->keyword[idx] == ' '); idx--) {
+        parsed->keyword[idx] = 0;
+    }
+    parsed->value = 0;
+    parsed->isNumeric = false;
+    if ((card[8] != '=') || (card[9] != ' ')) {
+        return false;
+    } // COMMENT, HISTORY and the like have no value
+    memcpy(valueField, card+10, 70);
+    valueField[70] = 0;
+    for (idx = 0; (idx < 70) && (valueField[idx] == ' '); idx++) {
+    }
+    if ((idx == 70) || (valueField[idx] == '\'')) {
+        return false;
+    }
+    if (((valueField[idx] == 'T') || (valueField[idx] == 'F')) &&
+        ((valueField[idx+1] == ' ') || (valueField[idx+1] == '/') || (valueField[idx+1] == 0))) {
+        parsed->value = (valueField[idx] == 'T') ? 1 : 0;
+        parsed->isNumeric = true;
+        return true;
+    }
+    len = idx;
+    while ((len < 70) && (valueField[len] != '/')) {
+        if ((valueField[len] == 'D') || (valueField[len] == 'd')) {
+            valueField[len] = 'E';
+        }
+        len++;
+    }
+    valueField[len] = 0;
+    parsed->value = strtod(valueField+idx, &end);
+    if (end == valueField+idx) {
+        return false;
+    }
+    parsed->isNumeric = true;
+    return true;
+}
+
+//---------------------------------------------------
+// the cards are read until END; the header ends with the block that holds the END card
+bool TSC_FitsHeader::parse(const unsigned char *data, long length) {
+    struct cardStruct parsed;
+    const char *card;
+    long offset;
+    double value;
+    bool endFound = false;
+
+    this->clear();
+    if ((data == NULL) || (length < 2880)) {
+        return false;
+    }
+    if ((memcmp(data, "SIMPLE  =", 9) != 0) && (memcmp(data, "XTENSION=", 9) != 0)) {
+        return false;
+    }
+    for (offset = 0; offset + 80 <= length; offset += 80) {
+        card = (const char*)data + offset;
+        if ((memcmp(card, "END", 3) == 0) && (card[3] == ' ')) {
+            endFound = true;
+            break;
+        }
+        if (this->parseCard(card, &parsed) == true) {
+            this->cards.push_back(parsed);
+        }
+    }
+    if (endFound == false) {
+        this->cards.clear();
+        return false;
+    }
+    this->headerLength = (offset/2880 + 1)*2880;
+    if (this->getValue("BITPIX", &value) == true) {
+        this->bitpix = (int)value;
+    }
+    if (this->getValue("NAXIS1", &value) == true) {
+        this->axisLength[1] = (long)value;
+    }
+    if (this->getValue("NAXIS2", &value) == true) {
+        this->axisLength[2] = (long)value;
+    }
+    if (this->getValue("NAXIS", &value) == true) {
+        this->axisLength[0] = (long)value;
+    }
+    if (this->getValue("BZERO", &value) == true) {
+        this->bzero = value;
+    }
+    if (this->getValue("BSCALE", &value) == true) {
+        this->bscale = value;
+    }
+    if ((this->bitpix == 0) || (this->axisLength[0] < 2) || (this->axisLength[1] <= 0) || (this->axisLength[2] <= 0)) {
+        return false;
+    }
+    return true;
+}
+
+//---------------------------------------------------
+// only the header blocks are read, a block at a time until the END card is there
+bool TSC_FitsHeader::readFile(const char *fileName) {
+    std::vector<unsigned char> header;
+    unsigned char block[2880];
+    FILE *fp;
+    long idx;
+    bool endFound = false;
+
+    this->clear();
+    fp = fopen(fileName, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    while ((endFound == false) && (fread(block, 1, 2880, fp) == 2880)) {
+        header.insert(header.end(), block, block+2880);
+        for (idx = 0; idx < 2880; idx += 80) {
+            if ((memcmp(block+idx, "END", 3) == 0) && (block[idx+3] == ' ')) {
+                endFound = true;
+            }
+        }
+    }
+    fclose(fp);
+    if (endFound == false) {
+        return false;
+    }
+    return this->parse(header.data(), header.size());
+}
+
+//---------------------------------------------------
+long TSC_FitsHeader::getHeaderLength(void) {
+    return this->headerLength;
+}
+
+//---------------------------------------------------
+int TSC_FitsHeader::getBitsPerPixel(void) {
+    return this->bitpix;
+}
+
+//---------------------------------------------------
+long TSC_FitsHeader::getAxisLength(short axis) {
+    if ((axis < 1) || (axis > 2)) {
+        return 0;
+    }
+    return this->axisLength[axis];
+}
+
+//---------------------------------------------------
+long TSC_FitsHeader::getDataLength(void) {
+    return this->axisLength[1]*this->axisLength[2]*(labs(this->bitpix)/8);
+}
+
+//---------------------------------------------------
+double TSC_FitsHeader::getBZero(void) {
+    return this->bzero;
+}
+
+//---------------------------------------------------
+double TSC_FitsHeader::getBScale(void) {
+    return this->bscale;
+}
+
+//---------------------------------------------------
+double TSC_FitsHeader::getExposureTime(void) {
+    double value;
+
+    if (this->getValue("EXPTIME", &value) == true) {
+        return value;
+    }
+    if (this->getValue("EXPOSURE", &value) == true) {
+        return value;
+    }
+    return 0;
+}
+
+//---------------------------------------------------
+int TSC_FitsHeader::getBinning(short axis) {
+    double value;
+
+    if ((axis == 0) && (this->getValue("XBINNING", &value) == true) && (value >= 1)) {
+        return (int)value;
+    }
+    if ((axis == 1) && (this->getValue("YBINNING", &value) == true) && (value >= 1)) {
+        return (int)value;
+    }
+    return 1;
+}
+
+//---------------------------------------------------
+bool TSC_FitsHeader::getValue(const char *keyword, double *value) {
+    unsigned long idx;
+
+    for (idx = 0; idx < this->cards.size(); idx++) {
+        if ((this->cards[idx].isNumeric == true) && (strcmp(this->cards[idx].keyword, keyword) == 0)) {
+            *value = this->cards[idx].value;
+            return true;
+        }
+    }
+    return false;
+}
+
+//---------------------------------------------------
+// astrometry.net writes a TAN projection with CRVAL at the reference pixel CRPIX and the CD matrix in
+// degrees per pixel. the center of the image is projected back to the sky; the SIP distortion terms are
+// left out, they are small near the reference pixel, which astrometry.net puts close to the center
+bool TSC_FitsHeader::getCenterCoordinates(double *ra, double *decl) {
+    double crval[2], crpix[2], cd[2][2], x, y, xi, eta, ra0, decl0, denom;
+
+    if ((this->getValue("CRVAL1", &crval[0]) == false) || (this->getValue("CRVAL2", &crval[1]) == false) ||
+        (this->getValue("CRPIX1", &crpix[0]) == false) || (this->getValue("CRPIX2", &crpix[1]) == false)) {
+        return false;
+    }
+    if ((this->getValue("CD1_1", &cd[0][0]) == false) || (this->getValue("CD1_2", &cd[0][1]) == false) ||
+        (this->getValue("CD2_1", &cd[1][0]) == false) || (this->getValue("CD2_2", &cd[1][1]) == false)) {
+        if ((this->getValue("CDELT1", &cd[0][0]) == false) || (this->getValue("CDELT2", &cd[1][1]) == false)) {
+            return false;
+        }
+        cd[0][1] = cd[1][0] = 0;
+    } // a header without rotation may only have CDELT
+    x = (this->axisLength[1]+1)/2.0-crpix[0];
+    y = (this->axisLength[2]+1)/2.0-crpix[1]; // FITS pixels start at 1
+    xi = (cd[0][0]*x+cd[0][1]*y)/180.0*M_PI;
+    eta = (cd[1][0]*x+cd[1][1]*y)/180.0*M_PI;
+    ra0 = crval[0]/180.0*M_PI;
+    decl0 = crval[1]/180.0*M_PI;
+    denom = cos(decl0)-eta*sin(decl0);
+    *ra = (ra0+atan2(xi, denom))*180.0/M_PI;
+    if (*ra < 0) {
+        *ra += 360;
+    }
+    if (*ra >= 360) {
+        *ra -= 360;
+    }
+    *decl = atan2(sin(decl0)+eta*cos(decl0), sqrt(xi*xi+denom*denom))*180.0/M_PI;
+    return true;
+}
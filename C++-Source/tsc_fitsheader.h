@@ -0,0 +1,61 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+// reads the header of a FITS image: the 80 character cards in blocks of 2880 bytes up to the END card.
+// the header is parsed where it is, in the BLOB of the INDI server or in the first blocks of a file, so
+// the image data are not copied. the size and the scaling of the image, the exposure and the binning are
+// taken from the header, and numerical values of other keywords can be looked up. the world coordinates
+// of astrometry.net are evaluated for the center of the image, which was the job of wcsinfo before.
+
+#ifndef TSC_FITSHEADER_H
+#define TSC_FITSHEADER_H
+
+#include <vector>
+
+class TSC_FitsHeader {
+public:
+    TSC_FitsHeader(void);
+    ~TSC_FitsHeader(void);
+    bool parse(const unsigned char*, long); // the FITS data and their length in bytes; false if there is no valid header
+    bool readFile(const char*); // reads and parses the header of a FITS file
+    long getHeaderLength(void); // in bytes; the image data start here
+    int getBitsPerPixel(void); // BITPIX; negative for floating point data
+    long getAxisLength(short); // NAXIS1 and NAXIS2 for 1 and 2
+    long getDataLength(void); // bytes of image data after the header
+    double getBZero(void);
+    double getBScale(void);
+    double getExposureTime(void); // EXPTIME or EXPOSURE in s; 0 if there is none
+    int getBinning(short); // XBINNING and YBINNING for 0 and 1; 1 if there is none
+    bool getValue(const char*, double*); // the value of a numerical or logical keyword
+    bool getCenterCoordinates(double*, double*); // RA and declination in degrees of the center of the image from a TAN projection; false without WCS
+
+private:
+    struct cardStruct {
+        char keyword[9];
+        double value;
+        bool isNumeric;
+    };
+    std::vector<struct cardStruct> cards;
+    long headerLength;
+    int bitpix;
+    long axisLength[3];
+    double bzero;
+    double bscale;
+    void clear(void);
+    bool parseCard(const char*, struct cardStruct*);
+};
+
+#endif // TSC_FITSHEADER_H
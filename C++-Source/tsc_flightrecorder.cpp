@@ -0,0 +1,266 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+#include "tsc_flightrecorder.h"
+#include <QDebug>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char flightRecorderMagic[8] = "TSCFLTR";
+static const uint32_t flightRecorderVersion = 1;
+static const int64_t flightRecorderSyncIntervalInUS = 5000000;
+static_assert(sizeof(struct TSC_FlightRecorder::flightRecordStruct) == 64, "the record layout of the flight recorder has changed");
+
+TSC_FlightRecorder::TSC_FlightRecorder(void) {
+    this->header = NULL;
+    this->records = NULL;
+    this->mapping = NULL;
+    this->mappingSize = 0;
+    this->fileDescriptor = -1;
+    this->isWritable = false;
+    this->lastSyncInUS = 0;
+    this->firstUnsyncedRecord = 0;
+}
+
+//---------------------------------------------------
+TSC_FlightRecorder::~TSC_FlightRecorder(void) {
+    this->close();
+}
+
+//---------------------------------------------------
+// the space for the whole ring is allocated when the file is created. writing to a mapped page that has no
+// space on the card behind it kills the program with SIGBUS, and the recorder must never take TSC down
+bool TSC_FlightRecorder::open(const char *fileName, uint32_t capacity) {
+    struct flightHeaderStruct fileHeader;
+    struct stat fileState;
+    uint64_t size;
+    bool isValid = false;
+
+    this->close();
+    if (capacity == 0) {
+        return false;
+    }
+    size = sizeof(struct flightHeaderStruct) + (uint64_t)capacity*sizeof(struct flightRecordStruct);
+    this->fileDescriptor = ::open(fileName, O_RDWR | O_CREAT, 0644);
+    if (this->fileDescriptor < 0) {
+        qDebug() << "Cannot open the flight recorder" << fileName;
+        return false;
+    }
+    if ((fstat(this->fileDescriptor, &fileState) == 0) && ((uint64_t)fileState.st_size == size) &&
+            (pread(this->fileDescriptor, &fileHeader, sizeof(fileHeader), 0) == (ssize_t)sizeof(fileHeader))) {
+        isValid = ((memcmp(fileHeader.magic, flightRecorderMagic, 8) == 0) && (fileHeader.version == flightRecorderVersion) &&
+            (fileHeader.recordSize == sizeof(struct flightRecordStruct)) && (fileHeader.capacity == capacity));
+    }
+    if (isValid == false) {
+        if ((ftruncate(this->fileDescriptor, 0) != 0) || (posix_fallocate(this->fileDescriptor, 0, size) != 0)) {
+            qDebug() << "No space for the flight recorder";
+            ::close(this->fileDescriptor);
+            this->fileDescriptor = -1;
+            return false;
+        }
+    } // a recording with another layout or size is discarded
+    this->mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->fileDescriptor, 0);
+    if (this->mapping == MAP_FAILED) {
+        qDebug() << "Cannot map the flight recorder";
+        this->mapping = NULL;
+        ::close(this->fileDescriptor);
+        this->fileDescriptor = -1;
+        return false;
+    }
+    this->mappingSize = size;
+    this->isWritable = true;
+    this->header = (struct flightHeaderStruct*)this->mapping;
+    this->records = (struct flightRecordStruct*)((char*)this->mapping + sizeof(struct flightHeaderStruct));
+    if (isValid == false) {
+        memset(this->header, 0, sizeof(struct flightHeaderStruct));
+        memcpy(this->header->magic, flightRecorderMagic, 8);
+        this->header->version = flightRecorderVersion;
+        this->header->recordSize = sizeof(struct flightRecordStruct);
+        this->header->capacity = capacity;
+        this->header->numberOfRecords = 0;
+    }
+    while (this->records[this->header->numberOfRecords%capacity].sequence == (uint32_t)(this->header->numberOfRecords + 1)) {
+        this->header->numberOfRecords++;
+    } // after a power cut, the pages of the records may have reached the card, but not the header
+    this->firstUnsyncedRecord = this->header->numberOfRecords;
+    this->lastSyncInUS = getTimeInUS();
+    return true;
+}
+
+//---------------------------------------------------
+bool TSC_FlightRecorder::openForReading(const char *fileName) {
+    struct stat fileState;
+    uint64_t size;
+
+    this->close();
+    this->fileDescriptor = ::open(fileName, O_RDONLY);
+    if (this->fileDescriptor < 0) {
+        return false;
+    }
+    if ((fstat(this->fileDescriptor, &fileState) != 0) || ((uint64_t)fileState.st_size < sizeof(struct flightHeaderStruct))) {
+        this->close();
+        return false;
+    }
+    this->mapping = mmap(NULL, fileState.st_size, PROT_READ, MAP_SHARED, this->fileDescriptor, 0);
+    if (this->mapping == MAP_FAILED) {
+        this->mapping = NULL;
+        this->close();
+        return false;
+    }
+    this->mappingSize = fileState.st_size;
+    this->header = (struct flightHeaderStruct*)this->mapping;
+    this->records = (struct flightRecordStruct*)((char*)this->mapping + sizeof(struct flightHeaderStruct));
+    size = sizeof(struct flightHeaderStruct) + this->header->capacity*sizeof(struct flightRecordStruct);
+    if ((memcmp(this->header->magic, flightRecorderMagic, 8) != 0) || (this->header->version != flightRecorderVersion) ||
+            (this->header->recordSize != sizeof(struct flightRecordStruct)) || (this->header->capacity == 0) ||
+            (size != this->mappingSize)) {
+        qDebug() << "Not a flight recording of this version:" << fileName;
+        this->close();
+        return false;
+    }
+    return true;
+}
+
+//---------------------------------------------------
+void TSC_FlightRecorder::close(void) {
+    if (this->mapping != NULL) {
+        if (this->isWritable == true) {
+            this->syncPages();
+        }
+        munmap(this->mapping, this->mappingSize);
+    }
+    if (this->fileDescriptor >= 0) {
+        ::close(this->fileDescriptor);
+    }
+    this->header = NULL;
+    this->records = NULL;
+    this->mapping = NULL;
+    this->mappingSize = 0;
+    this->fileDescriptor = -1;
+    this->isWritable = false;
+}
+
+//---------------------------------------------------
+bool TSC_FlightRecorder::isOpen(void) {
+    return (this->mapping != NULL);
+}
+
+//---------------------------------------------------
+// the sequence number is written last; a record that was torn by a crash does not carry the number of its slot
+void TSC_FlightRecorder::record(struct flightRecordStruct *rec) {
+    struct flightRecordStruct *slot;
+    uint64_t count;
+
+    if (this->isWritable == false) {
+        return;
+    }
+    count = this->header->numberOfRecords;
+    slot = &this->records[count%this->header->capacity];
+    rec->timeInUS = getTimeInUS();
+    rec->reserved = 0;
+    slot->sequence = 0;
+    __sync_synchronize();
+    memcpy((char*)slot + sizeof(uint32_t), (char*)rec + sizeof(uint32_t), sizeof(struct flightRecordStruct) - sizeof(uint32_t));
+    __sync_synchronize();
+    slot->sequence = (uint32_t)(count + 1);
+    rec->sequence = slot->sequence;
+    this->header->numberOfRecords = count + 1;
+    if (rec->timeInUS - this->lastSyncInUS > flightRecorderSyncIntervalInUS) {
+        this->syncPages();
+    }
+}
+
+//---------------------------------------------------
+// only the header and the pages of the records written since the last call go to the card. at 10 records
+// per second, that is a page or two every few seconds instead of a walk over the whole ring
+void TSC_FlightRecorder::syncPages(void) {
+    uint64_t count, capacity, first, last;
+
+    count = this->header->numberOfRecords;
+    capacity = this->header->capacity;
+    this->syncRange(this->header, sizeof(struct flightHeaderStruct));
+    if (count - this->firstUnsyncedRecord >= capacity) {
+        this->syncRange(this->records, capacity*sizeof(struct flightRecordStruct));
+    } else if (count > this->firstUnsyncedRecord) {
+        first = this->firstUnsyncedRecord%capacity;
+        last = count%capacity;
+        if (first < last) {
+            this->syncRange(&this->records[first], (last - first)*sizeof(struct flightRecordStruct));
+        } else {
+            this->syncRange(&this->records[first], (capacity - first)*sizeof(struct flightRecordStruct));
+            this->syncRange(this->records, last*sizeof(struct flightRecordStruct));
+        } // the records wrapped around the end of the ring
+    }
+    this->firstUnsyncedRecord = count;
+    this->lastSyncInUS = getTimeInUS();
+}
+
+//---------------------------------------------------
+// msync takes an address at the start of a page; the mapping itself starts at one
+void TSC_FlightRecorder::syncRange(void *start, uint64_t length) {
+    uint64_t pageSize, offset, pageOffset;
+
+    if (length == 0) {
+        return;
+    }
+    pageSize = (uint64_t)sysconf(_SC_PAGESIZE);
+    offset = (uint64_t)((char*)start - (char*)this->mapping);
+    pageOffset = offset - offset%pageSize;
+    msync((char*)this->mapping + pageOffset, offset + length - pageOffset, MS_SYNC);
+}
+
+//---------------------------------------------------
+uint64_t TSC_FlightRecorder::getNumberOfRecords(void) {
+    if (this->header == NULL) {
+        return 0;
+    }
+    if (this->header->numberOfRecords < this->header->capacity) {
+        return this->header->numberOfRecords;
+    }
+    return this->header->capacity;
+}
+
+//---------------------------------------------------
+uint64_t TSC_FlightRecorder::getTotalRecords(void) {
+    if (this->header == NULL) {
+        return 0;
+    }
+    return this->header->numberOfRecords;
+}
+
+//---------------------------------------------------
+bool TSC_FlightRecorder::getRecord(uint64_t idx, struct flightRecordStruct *rec) {
+    uint64_t number;
+
+    if (idx >= this->getNumberOfRecords()) {
+        return false;
+    }
+    number = this->header->numberOfRecords - this->getNumberOfRecords() + idx;
+    memcpy(rec, &this->records[number%this->header->capacity], sizeof(struct flightRecordStruct));
+    return (rec->sequence == (uint32_t)(number + 1));
+}
+
+//---------------------------------------------------
+int64_t TSC_FlightRecorder::getTimeInUS(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (int64_t)now.tv_sec*1000000 + now.tv_nsec/1000;
+}
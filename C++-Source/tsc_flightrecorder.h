@@ -0,0 +1,83 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+//---------------------------------------------------
+// a flight recorder for the mount. fixed-size binary records go to a ring buffer in a file that is mapped
+// into memory, so writing a record is just a copy. the kernel writes the pages to the card in the background,
+// and they survive a crash of TSC; against a power cut, the pages written are synchronised every few seconds.
+// an existing recording is continued, so the history before a crash is still there after a restart. the same
+// class reads recordings for TSC_FlightDump. the layout of the file must not change without changing the
+// version in the header.
+
+#ifndef TSC_FLIGHTRECORDER_H
+#define TSC_FLIGHTRECORDER_H
+
+#include <stdint.h>
+
+class TSC_FlightRecorder {
+public:
+    enum flightEvent {frPeriodic, frSessionStart, frGuidePulseRA, frGuidePulseDecl, frGoToStart, frSync, frEmergencyStop};
+    enum flightFlag {ffTracking = 1, ffGoToRA = 2, ffGoToDecl = 4, ffRAMoving = 8, ffDeclMoving = 16, ffGuiding = 32,
+                     ffEast = 64, ffParked = 128, ffDriverError = 256};
+    struct flightRecordStruct { // 64 bytes, no padding
+        uint32_t sequence; // number of the record since the file was created, starting at 1; 0 is an empty slot
+        uint16_t event; // flightEvent
+        uint16_t flags; // flightFlag bits
+        int64_t timeInUS; // UTC in microseconds since 1970
+        int64_t stepsRA; // position of the axes as counted by the drives, in microsteps at the ratio for tracking
+        int64_t stepsDecl;
+        float rateRA; // commanded motion of the axes in arcsec/s
+        float rateDecl;
+        float guidePulseRA; // duration of a guide pulse in ms, signed by direction; 0 if none
+        float guidePulseDecl;
+        float usbLatencyRA; // round trip of the last command to the AMIS in ms
+        float usbLatencyDecl;
+        int16_t flipStep; // state of the meridian flip and of the sequencer
+        int16_t sequencerStep;
+        uint32_t reserved;
+    };
+    TSC_FlightRecorder(void);
+    ~TSC_FlightRecorder(void);
+    bool open(const char*, uint32_t); // file and number of records in the ring; creates the file if it does not fit
+    bool openForReading(const char*);
+    void close(void);
+    bool isOpen(void);
+    void record(struct flightRecordStruct*); // sequence and time are filled in
+    uint64_t getNumberOfRecords(void); // records available, at most the size of the ring
+    uint64_t getTotalRecords(void); // records written since the file was created
+    bool getRecord(uint64_t, struct flightRecordStruct*); // 0 is the oldest record available; false if the slot was not written completely
+    static int64_t getTimeInUS(void);
+
+private:
+    struct flightHeaderStruct { // 64 bytes at the start of the file
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t capacity;
+        uint64_t numberOfRecords;
+        char reserved[32];
+    };
+    struct flightHeaderStruct *header;
+    struct flightRecordStruct *records;
+    void *mapping;
+    uint64_t mappingSize;
+    int fileDescriptor;
+    bool isWritable;
+    int64_t lastSyncInUS;
+    uint64_t firstUnsyncedRecord; // number of the first record written since the last synchronisation
+    void syncPages(void);
+    void syncRange(void*, uint64_t); // the pages holding the range of the mapping
+};
+
+#endif // TSC_FLIGHTRECORDER_H
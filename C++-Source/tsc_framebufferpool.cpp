@@ -0,0 +1,218 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+#include "tsc_framebufferpool.h"
+#include <QMutex>
+
+// the references are counted on the threads of the pipeline and on the GUI thread. the mutex is not a
+// member of the pool, as a buffer may be released after its pool was deleted
+static QMutex bufferMutex;
+
+//---------------------------------------------------
+// called by Qt when the last QImage on a buffer is deleted
+static void releaseImageBuffer(void *info) {
+    TSC_FrameBufferPool::release(static_cast<struct frameBufferStruct*>(info));
+}
+
+//---------------------------------------------------
+TSC_FrameBuffer::TSC_FrameBuffer(void) {
+    this->buffer = NULL;
+}
+
+//---------------------------------------------------
+TSC_FrameBuffer::TSC_FrameBuffer(const TSC_FrameBuffer &other) {
+    this->buffer = other.buffer;
+    TSC_FrameBufferPool::retain(this->buffer);
+}
+
+//---------------------------------------------------
+TSC_FrameBuffer& TSC_FrameBuffer::operator=(const TSC_FrameBuffer &other) {
+    if (this->buffer != other.buffer) {
+        TSC_FrameBufferPool::retain(other.buffer);
+        TSC_FrameBufferPool::release(this->buffer);
+        this->buffer = other.buffer;
+    }
+    return *this;
+}
+
+//---------------------------------------------------
+TSC_FrameBuffer::~TSC_FrameBuffer(void) {
+    TSC_FrameBufferPool::release(this->buffer);
+}
+
+//---------------------------------------------------
+bool TSC_FrameBuffer::isNull(void) const {
+    if (this->buffer == NULL) {
+        return true;
+    }
+    return false;
+}
+
+//---------------------------------------------------
+unsigned char* TSC_FrameBuffer::data(void) {
+    if (this->buffer == NULL) {
+        return NULL;
+    }
+    return this->buffer->data;
+}
+
+//---------------------------------------------------
+const unsigned char* TSC_FrameBuffer::constData(void) const {
+    if (this->buffer == NULL) {
+        return NULL;
+    }
+    return this->buffer->data;
+}
+
+//---------------------------------------------------
+long TSC_FrameBuffer::size(void) const {
+    if (this->buffer == NULL) {
+        return 0;
+    }
+    return this->buffer->size;
+}
+
+//---------------------------------------------------
+// the QImage holds a reference of its own, which is given back by "releaseImageBuffer". the colortable
+// is set while the image is not shared yet, so the QImage does not detach from the buffer
+QImage TSC_FrameBuffer::getImageView(long offset, int width, int height, int bytesPerLine, const QVector<QRgb> &colors) const {
+    QImage view;
+
+    if ((this->buffer == NULL) || (offset < 0) || (width <= 0) || (height <= 0) || (bytesPerLine < width) ||
+        (offset+(long)bytesPerLine*(height-1)+width > this->buffer->size)) {
+        return QImage();
+    }
+    TSC_FrameBufferPool::retain(this->buffer);
+    view = QImage(this->buffer->data+offset, width, height, bytesPerLine, QImage::Format_Indexed8,
+        releaseImageBuffer, this->buffer);
+    view.setColorTable(colors);
+    return view;
+}
+
+//---------------------------------------------------
+void TSC_FrameBuffer::clear(void) {
+    TSC_FrameBufferPool::release(this->buffer);
+    this->buffer = NULL;
+}
+
+//---------------------------------------------------
+TSC_FrameBufferPool::TSC_FrameBufferPool(void) {
+    this->allocations = 0;
+}
+
+//---------------------------------------------------
+// buffers that are still referenced, for instance by the camera image in g_AllData, are left to
+// their last reference
+TSC_FrameBufferPool::~TSC_FrameBufferPool(void) {
+    QMutexLocker locker(&bufferMutex);
+    unsigned long idx;
+
+    for (idx = 0; idx < this->buffers.size(); idx++) {
+        if (this->buffers[idx]->references == 0) {
+            delete[] this->buffers[idx]->data;
+            delete this->buffers[idx];
+        } else {
+            this->buffers[idx]->pool = NULL;
+        }
+    }
+    this->buffers.clear();
+}
+
+//---------------------------------------------------
+// the smallest free buffer that is large enough is taken. if there is none, a free buffer is enlarged,
+// and only if all are in use, a new one is added
+TSC_FrameBuffer TSC_FrameBufferPool::getBuffer(long bytes) {
+    QMutexLocker locker(&bufferMutex);
+    TSC_FrameBuffer handle;
+    struct frameBufferStruct *chosen = NULL, *candidate;
+    unsigned long idx;
+
+    if (bytes <= 0) {
+        return handle;
+    }
+    for (idx = 0; idx < this->buffers.size(); idx++) {
+        candidate = this->buffers[idx];
+        if (candidate->references == 0) {
+            if (candidate->capacity >= bytes) {
+                if ((chosen == NULL) || (chosen->capacity < bytes) || (candidate->capacity < chosen->capacity)) {
+                    chosen = candidate;
+                }
+            } else if (chosen == NULL) {
+                chosen = candidate;
+            }
+        }
+    }
+    if (chosen == NULL) {
+        chosen = new struct frameBufferStruct;
+        chosen->pool = this;
+        chosen->data = NULL;
+        chosen->capacity = 0;
+        this->buffers.push_back(chosen);
+    }
+    if (chosen->capacity < bytes) {
+        delete[] chosen->data;
+        chosen->data = new unsigned char[bytes];
+        chosen->capacity = bytes;
+        this->allocations++;
+    }
+    chosen->size = bytes;
+    chosen->references = 1;
+    handle.buffer = chosen;
+    return handle;
+}
+
+//---------------------------------------------------
+long TSC_FrameBufferPool::getAllocations(void) {
+    QMutexLocker locker(&bufferMutex);
+
+    return this->allocations;
+}
+
+//---------------------------------------------------
+long TSC_FrameBufferPool::getBuffersInUse(void) {
+    QMutexLocker locker(&bufferMutex);
+    unsigned long idx;
+    long inUse = 0;
+
+    for (idx = 0; idx < this->buffers.size(); idx++) {
+        if (this->buffers[idx]->references > 0) {
+            inUse++;
+        }
+    }
+    return inUse;
+}
+
+//---------------------------------------------------
+void TSC_FrameBufferPool::retain(struct frameBufferStruct *buf) {
+    QMutexLocker locker(&bufferMutex);
+
+    if (buf != NULL) {
+        buf->references++;
+    }
+}
+
+//---------------------------------------------------
+// a buffer without references is free for the next frame, or deleted if its pool is gone
+void TSC_FrameBufferPool::release(struct frameBufferStruct *buf) {
+    QMutexLocker locker(&bufferMutex);
+
+    if (buf == NULL) {
+        return;
+    }
+    buf->references--;
+    if ((buf->references == 0) && (buf->pool == NULL)) {
+        delete[] buf->data;
+        delete buf;
+    }
+}
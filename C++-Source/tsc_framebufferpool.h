@@ -0,0 +1,76 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+// a pool of buffers for camera frames. the pipeline of the ccd_client copies each BLOB into a buffer of the
+// pool and decodes it into another one; after a few frames, all buffers are there and a frame needs no
+// allocation anymore. a TSC_FrameBuffer is a counted reference to a buffer, and QImages made with
+// "getImageView" share its pixels with the implicit sharing of Qt, so the camera image can be handed
+// to the guiding, the display and the storage without copying it. a buffer goes back to the pool when
+// the last reference and the last QImage on it are gone. the views must not be written to.
+
+#ifndef TSC_FRAMEBUFFERPOOL_H
+#define TSC_FRAMEBUFFERPOOL_H
+
+#include <QImage>
+#include <QVector>
+#include <vector>
+
+class TSC_FrameBufferPool;
+
+struct frameBufferStruct {
+    TSC_FrameBufferPool *pool; // NULL once the pool is deleted; the buffer is freed with its last reference
+    unsigned char *data;
+    long capacity;
+    long size;
+    int references;
+};
+
+//---------------------------------------------------
+class TSC_FrameBuffer {
+public:
+    TSC_FrameBuffer(void);
+    TSC_FrameBuffer(const TSC_FrameBuffer&);
+    TSC_FrameBuffer& operator=(const TSC_FrameBuffer&);
+    ~TSC_FrameBuffer(void);
+    bool isNull(void) const;
+    unsigned char* data(void); // only for filling the buffer before it is shared
+    const unsigned char* constData(void) const;
+    long size(void) const;
+    QImage getImageView(long, int, int, int, const QVector<QRgb>&) const; // an 8 bit image at an offset in bytes with width, height and bytes per line, and its colortable
+    void clear(void);
+
+private:
+    friend class TSC_FrameBufferPool;
+    struct frameBufferStruct *buffer;
+};
+
+//---------------------------------------------------
+class TSC_FrameBufferPool {
+public:
+    TSC_FrameBufferPool(void);
+    ~TSC_FrameBufferPool(void);
+    TSC_FrameBuffer getBuffer(long); // a free buffer of at least this size in bytes
+    long getAllocations(void); // buffers that were allocated or enlarged so far
+    long getBuffersInUse(void);
+    static void retain(struct frameBufferStruct*);
+    static void release(struct frameBufferStruct*);
+
+private:
+    std::vector<struct frameBufferStruct*> buffers;
+    long allocations;
+};
+
+#endif // TSC_FRAMEBUFFERPOOL_H
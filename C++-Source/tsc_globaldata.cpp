@@ -13,9 +13,12 @@
 
 //---------------------------------------------------
 #include "tsc_globaldata.h"
-#include "mainwindow.h"
 #include <QDebug>
 #include <QFile>
+#include <math.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 TSC_GlobalData::TSC_GlobalData() {
 
@@ -66,6 +69,38 @@ TSC_GlobalData::TSC_GlobalData() {
     this->psParams.searchRadiusInDeg = 3.0;
     this->psParams.pathToImages = new QString("/home/pi/TwoStepperControl-master/build-TwoStepperControl-Desktop-Release/TSC_Images/");
     this->psParams.pathToFITSToBeSolved = new QString();
+    this->refractionState.correctionIsOn = false;
+    this->refractionState.pressureInHPa = 1010.0;
+    this->meridianFlipState.autoFlipIsOn = false;
+    this->meridianFlipState.flipLimitInMin = 10;
+    for (short axis = 0; axis < 2; axis++) {
+        this->slewTimeModel.accFactor[axis] = 1.0;
+        this->slewTimeModel.latency[axis] = 0.1f;
+        this->slewTimeModel.rmsError[axis] = 0;
+        this->slewTimeModel.noOfSlews[axis] = 0;
+        this->backlash.microsteps[axis] = 0;
+        this->positionSource.countsPerRevolution[axis] = 16777216;
+        this->positionSource.direction[axis] = 1;
+    }
+    this->backlash.compensationIsOn = true;
+    this->positionSource.source = 0;
+    this->positionSource.slipThresholdInArcsec = 30;
+    this->homePosition.isKnown = false;
+    this->homePosition.hourAngle = 0;
+    this->homePosition.declination = 0;
+    this->homePosition.declSign = 1;
+    this->homePosition.scopeIsEast = false;
+    this->homePosition.searchDirection[0] = 1;
+    this->homePosition.searchDirection[1] = 1;
+    this->homePosition.speed = 100;
+    this->trackingCalibration.correctionIsOn = false;
+    this->trackingCalibration.rateError = 0;
+    this->trackingCalibration.poleOffset[0] = 0;
+    this->trackingCalibration.poleOffset[1] = 0;
+    this->centroidEstimator = 1; // the windowed centroid
+    this->numberOfGuideStars = 1;
+    this->guideAlgorithm[0] = 0; // the running average that TSC has always used
+    this->guideAlgorithm[1] = 0;
 
     if (this->loadGlobalData() == false) {
         this->gearData.planetaryRatioRA=9;
@@ -152,6 +187,28 @@ double TSC_GlobalData::getPSSearchRad(void) {
     return this->psParams.searchRadiusInDeg;
 }
 
+//-------------------------------------------------
+// switch refraction correction for GoTo and tracking on and off
+void TSC_GlobalData::setRefractionCorrection(bool isOn) {
+    this->refractionState.correctionIsOn = isOn;
+}
+
+//-------------------------------------------------
+bool TSC_GlobalData::getRefractionCorrection(void) {
+    return this->refractionState.correctionIsOn;
+}
+
+//-------------------------------------------------
+// there is no barometer on the HAT, so the pressure is entered on the main tab and kept in the preferences file
+void TSC_GlobalData::setAtmosphericPressure(float press) {
+    this->refractionState.pressureInHPa = press;
+}
+
+//-------------------------------------------------
+float TSC_GlobalData::getAtmosphericPressure(void) {
+    return this->refractionState.pressureInHPa;
+}
+
 //-----------------------------------------------
 QString TSC_GlobalData::getPathToImageToBeSolved(void) {
     return this->psParams.pathToFITSToBeSolved->toLatin1();
@@ -249,6 +306,59 @@ short TSC_GlobalData::getMaxDeclForNoFlip(void) {
     return this->meridianFlipState.maxDeclForNoFlip;
 }
 
+//-----------------------------------------------
+// store and retrieve whether the flip is carried out automatically in an exposure series
+void TSC_GlobalData::setAutoMFlip(bool isOn) {
+    this->meridianFlipState.autoFlipIsOn = isOn;
+}
+
+//-----------------------------------------------
+bool TSC_GlobalData::getAutoMFlip(void) {
+    return this->meridianFlipState.autoFlipIsOn;
+}
+
+//-----------------------------------------------
+// the limit is given in minutes of hour angle past the meridian
+void TSC_GlobalData::setMFlipLimit(short minutes) {
+    if ((minutes > 0) && (minutes <= 60)) {
+        this->meridianFlipState.flipLimitInMin = minutes;
+    }
+}
+
+//-----------------------------------------------
+short TSC_GlobalData::getMFlipLimit(void) {
+    return this->meridianFlipState.flipLimitInMin;
+}
+
+//-----------------------------------------------
+void TSC_GlobalData::setSlewTimeModel(short axis, short what, double val) {
+    if ((axis < 0) || (axis > 1)) {
+        return;
+    }
+    switch (what) {
+        case 0: this->slewTimeModel.accFactor[axis] = val; break;
+        case 1: this->slewTimeModel.latency[axis] = val; break;
+        case 2: this->slewTimeModel.rmsError[axis] = val; break;
+        case 3: this->slewTimeModel.noOfSlews[axis] = (long)val; break;
+    }
+}
+
+//-----------------------------------------------
+double TSC_GlobalData::getSlewTimeModel(short axis, short what) {
+    double retval = 0;
+
+    if ((axis < 0) || (axis > 1)) {
+        return 0;
+    }
+    switch (what) {
+        case 0: retval = this->slewTimeModel.accFactor[axis]; break;
+        case 1: retval = this->slewTimeModel.latency[axis]; break;
+        case 2: retval = this->slewTimeModel.rmsError[axis]; break;
+        case 3: retval = this->slewTimeModel.noOfSlews[axis]; break;
+    }
+    return retval;
+}
+
 //-----------------------------------------------
 // set a flag that initializes serial LX200 upon startup
 void TSC_GlobalData::setLX200SerialFlag(bool val) {
@@ -493,6 +603,399 @@ QString TSC_GlobalData::getSiteName(void) {
     return this->siteParams.siteName;
 }
 
+//-----------------------------------------------
+void TSC_GlobalData::setMountLimits(float minAlt, float haEast, float haWest) {
+    if ((minAlt >= -10) && (minAlt <= 60)) {
+        this->siteParams.minAltitude = minAlt;
+    }
+    if ((haEast >= 0) && (haEast <= 12)) {
+        this->siteParams.haLimitEast = haEast;
+    }
+    if ((haWest >= 0) && (haWest <= 12)) {
+        this->siteParams.haLimitWest = haWest;
+    }
+}
+
+//-----------------------------------------------
+float TSC_GlobalData::getMountLimits(short what) {
+    float retval = 0;
+
+    switch (what) {
+        case 0: retval = this->siteParams.minAltitude; break;
+        case 1: retval = this->siteParams.haLimitEast; break;
+        case 2: retval = this->siteParams.haLimitWest; break;
+    }
+    return retval;
+}
+
+//-----------------------------------------------
+void TSC_GlobalData::setBacklash(short axis, long steps) {
+    if ((axis < 0) || (axis > 1) || (steps < 0)) {
+        return;
+    }
+    this->backlash.microsteps[axis] = steps;
+}
+
+//-----------------------------------------------
+long TSC_GlobalData::getBacklash(short axis) {
+    if ((axis < 0) || (axis > 1)) {
+        return 0;
+    }
+    return this->backlash.microsteps[axis];
+}
+
+//-----------------------------------------------
+void TSC_GlobalData::setBacklashCompensation(bool isOn) {
+    this->backlash.compensationIsOn = isOn;
+}
+
+//-----------------------------------------------
+bool TSC_GlobalData::getBacklashCompensation(void) {
+    return this->backlash.compensationIsOn;
+}
+
+//-----------------------------------------------
+void TSC_GlobalData::setPositionSource(short src) {
+    if ((src >= 0) && (src <= 2)) {
+        this->positionSource.source = src;
+    }
+}
+
+//-----------------------------------------------
+short TSC_GlobalData::getPositionSource(void) {
+    return this->positionSource.source;
+}
+
+//-----------------------------------------------
+void TSC_GlobalData::setEncoderParams(short axis, long counts, short dir) {
+    if ((axis < 0) || (axis > 1) || (counts <= 0)) {
+        return;
+    }
+    this->positionSource.countsPerRevolution[axis] = counts;
+    if (dir < 0) {
+        this->positionSource.direction[axis] = -1;
+    } else {
+        this->positionSource.direction[axis] = 1;
+    }
+}
+
+//-----------------------------------------------
+long TSC_GlobalData::getEncoderParams(short axis, short what) {
+    if ((axis < 0) || (axis > 1)) {
+        return 0;
+    }
+    if (what == 0) {
+        return this->positionSource.countsPerRevolution[axis];
+    }
+    return this->positionSource.direction[axis];
+}
+
+//-----------------------------------------------
+void TSC_GlobalData::setEncoderSlipThreshold(float arcsec) {
+    if (arcsec > 0) {
+        this->positionSource.slipThresholdInArcsec = arcsec;
+    }
+}
+
+//-----------------------------------------------
+float TSC_GlobalData::getEncoderSlipThreshold(void) {
+    return this->positionSource.slipThresholdInArcsec;
+}
+
+//-----------------------------------------------
+void TSC_GlobalData::setHomePosition(float ha, float decl, short sign, bool isEast) {
+    this->homePosition.hourAngle = ha;
+    this->homePosition.declination = decl;
+    if (sign < 0) {
+        this->homePosition.declSign = -1;
+    } else {
+        this->homePosition.declSign = 1;
+    }
+    this->homePosition.scopeIsEast = isEast;
+    this->homePosition.isKnown = true;
+}
+
+//-----------------------------------------------
+float TSC_GlobalData::getHomePosition(short what) {
+    switch (what) {
+    case 0: return this->homePosition.hourAngle;
+    case 1: return this->homePosition.declination;
+    case 2: return this->homePosition.declSign;
+    case 3: return (this->homePosition.scopeIsEast == true) ? 1 : 0;
+    }
+    return 0;
+}
+
+//-----------------------------------------------
+bool TSC_GlobalData::isHomePositionKnown(void) {
+    return this->homePosition.isKnown;
+}
+
+//-----------------------------------------------
+void TSC_GlobalData::setHomeSearchDirection(short axis, short dir) {
+    if ((axis < 0) || (axis > 1)) {
+        return;
+    }
+    if (dir < 0) {
+        this->homePosition.searchDirection[axis] = -1;
+    } else {
+        this->homePosition.searchDirection[axis] = 1;
+    }
+}
+
+//-----------------------------------------------
+short TSC_GlobalData::getHomeSearchDirection(short axis) {
+    if ((axis < 0) || (axis > 1)) {
+        return 1;
+    }
+    return this->homePosition.searchDirection[axis];
+}
+
+//-----------------------------------------------
+void TSC_GlobalData::setHomingSpeed(float speed) {
+    if (speed >= 1) {
+        this->homePosition.speed = speed;
+    }
+}
+
+//-----------------------------------------------
+float TSC_GlobalData::getHomingSpeed(void) {
+    return this->homePosition.speed;
+}
+
+//-----------------------------------------------
+void TSC_GlobalData::setTrackingCalibration(float rate, float up, float east) {
+    this->trackingCalibration.rateError = rate;
+    this->trackingCalibration.poleOffset[0] = up;
+    this->trackingCalibration.poleOffset[1] = east;
+}
+
+//-----------------------------------------------
+float TSC_GlobalData::getTrackingCalibration(short what) {
+    switch (what) {
+    case 0: return this->trackingCalibration.rateError;
+    case 1: return this->trackingCalibration.poleOffset[0];
+    case 2: return this->trackingCalibration.poleOffset[1];
+    }
+    return 0;
+}
+
+//-----------------------------------------------
+void TSC_GlobalData::setTrackingCalibrationCorrection(bool isOn) {
+    this->trackingCalibration.correctionIsOn = isOn;
+}
+
+//-----------------------------------------------
+bool TSC_GlobalData::getTrackingCalibrationCorrection(void) {
+    return this->trackingCalibration.correctionIsOn;
+}
+
+//-----------------------------------------------
+double TSC_GlobalData::getMicrostepsPerDegree(short axis) {
+    if (axis == 0) {
+        return this->getGearData(0)*this->getGearData(1)*this->getGearData(2)/this->getGearData(3)*this->getMicroSteppingRatio(0);
+    }
+    return this->getGearData(4)*this->getGearData(5)*this->getGearData(6)/this->getGearData(7)*this->getMicroSteppingRatio(0);
+}
+
+//-----------------------------------------------
+// at a sync, the counters are stored together with the mechanical position the sync defines; the position of a
+// parked mount then follows from the steps the drives carried out since, not from the model of TSC
+void TSC_GlobalData::setAxisSteps(long long stepsRA, long long stepsDecl, bool isSync) {
+    double ha;
+
+    this->axisSteps.steps[0] = stepsRA;
+    this->axisSteps.steps[1] = stepsDecl;
+    if (isSync == true) {
+        ha = this->getLocalSTime()*15 - this->syncPosition.rightAscension;
+        while (ha < 0) {
+            ha += 360;
+        }
+        while (ha >= 360) {
+            ha -= 360;
+        }
+        this->axisSteps.stepsAtSync[0] = stepsRA;
+        this->axisSteps.stepsAtSync[1] = stepsDecl;
+        this->axisSteps.hourAngleAtSync = ha;
+        this->axisSteps.declinationAtSync = this->syncPosition.declination;
+    }
+}
+
+//-----------------------------------------------
+long long TSC_GlobalData::getAxisSteps(short axis) {
+    if ((axis < 0) || (axis > 1)) {
+        return 0;
+    }
+    return this->axisSteps.steps[axis];
+}
+
+//-----------------------------------------------
+// the step counters of the drives are stored with the counters and the position at the last sync, together with
+// the microsteps per revolution - if the gears or the microstepping were changed, the counts are useless. the file
+// is written under a temporary name and then renamed, so a power cut leaves either the old or the new state, never
+// a partial one
+bool TSC_GlobalData::storeMountState(bool isParked) {
+    std::string ostr;
+    long perRevolution[2];
+    short axis, boolFlag;
+    int fd;
+
+    std::ofstream outfile(".TSCMountState.tsl.tmp");
+    if (!outfile.is_open()) {
+        qDebug() << "Cannot write the mount state";
+        return false;
+    }
+    outfile << "2// Version of the mount state file.\n";
+    if (isParked == true) {
+        boolFlag = 1;
+    } else {
+        boolFlag = 0;
+    }
+    ostr.append(std::to_string(boolFlag));
+    ostr.append("// 1 if the mount is parked and the position below is valid.\n");
+    for (axis = 0; axis < 2; axis++) {
+        perRevolution[axis] = lround(360.0*this->getMicrostepsPerDegree(axis));
+        ostr.append(std::to_string(this->axisSteps.steps[axis]) + " " + std::to_string(perRevolution[axis]) + " " +
+                    std::to_string(this->axisSteps.stepsAtSync[axis]) + " ");
+        if (axis == 0) {
+            ostr.append(std::to_string(this->axisSteps.hourAngleAtSync));
+            ostr.append("// RA axis - step counter, microsteps per revolution, step counter and hour angle at the last sync.\n");
+        } else {
+            ostr.append(std::to_string(this->axisSteps.declinationAtSync));
+            ostr.append("// Decl axis - step counter, microsteps per revolution, step counter and declination at the last sync.\n");
+        }
+    }
+    if (this->meridianFlipState.scopeIsEast == true) {
+        boolFlag = 1;
+    } else {
+        boolFlag = 0;
+    }
+    ostr.append(std::to_string(this->meridianFlipState.declSign) + " " + std::to_string(boolFlag));
+    ostr.append("// Declination sign and flag whether the scope is east of the pier.\n");
+    outfile << ostr.data();
+    outfile.close();
+    if (outfile.fail() == true) {
+        qDebug() << "Cannot write the mount state";
+        return false;
+    }
+    fd = open(".TSCMountState.tsl.tmp", O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        ::close(fd);
+    } // the data have to be on the card before the old state is replaced
+    if (rename(".TSCMountState.tsl.tmp", ".TSCMountState.tsl") != 0) {
+        qDebug() << "Cannot replace the mount state";
+        return false;
+    }
+    return true;
+}
+
+//-----------------------------------------------
+// the step counters are kept, so that TSC can set the drives to them before the mount is synced to the position
+bool TSC_GlobalData::restoreMountState(double *ha, double *decl) {
+    std::string line;
+    long long counts[2], countsAtSync[2];
+    long perRevolution[2];
+    double positionAtSync[2], position[2];
+    short version = 0, isParked = 0, sign = 0, isEast = 0, axis;
+    char delimiter('/');
+
+    std::ifstream infile(".TSCMountState.tsl");
+    if (!infile.is_open()) {
+        return false;
+    }
+    std::getline(infile, line, delimiter);
+    std::istringstream isVersion(line);
+    isVersion >> version;
+    std::getline(infile, line, '\n');
+    std::getline(infile, line, delimiter);
+    std::istringstream isParkedFlag(line);
+    isParkedFlag >> isParked;
+    std::getline(infile, line, '\n');
+    for (axis = 0; axis < 2; axis++) {
+        std::getline(infile, line, delimiter);
+        std::istringstream isCounts(line);
+        if (!(isCounts >> counts[axis] >> perRevolution[axis] >> countsAtSync[axis] >> positionAtSync[axis])) {
+            infile.close();
+            return false;
+        }
+        std::getline(infile, line, '\n');
+    }
+    std::getline(infile, line, delimiter);
+    std::istringstream isSide(line);
+    isSide >> sign >> isEast;
+    infile.close();
+    if ((version != 2) || (isParked != 1) || ((sign != 1) && (sign != -1))) {
+        return false;
+    } // version 1 held the position of the model, which is not restored
+    for (axis = 0; axis < 2; axis++) {
+        if (perRevolution[axis] != lround(360.0*this->getMicrostepsPerDegree(axis))) {
+            qDebug() << "Gears or microstepping were changed - the parked position is not restored";
+            return false;
+        }
+        position[axis] = positionAtSync[axis] + (counts[axis] - countsAtSync[axis])/this->getMicrostepsPerDegree(axis);
+    }
+    if (fabs(position[1]) > 90) {
+        qDebug() << "The declination axis passed the pole after the last sync - the parked position is not restored";
+        return false;
+    }
+    while (position[0] < 0) {
+        position[0] += 360;
+    }
+    while (position[0] >= 360) {
+        position[0] -= 360;
+    }
+    *ha = position[0];
+    *decl = position[1];
+    this->axisSteps.steps[0] = counts[0];
+    this->axisSteps.steps[1] = counts[1];
+    this->meridianFlipState.declSign = sign;
+    if (isEast == 1) {
+        this->meridianFlipState.scopeIsEast = true;
+    } else {
+        this->meridianFlipState.scopeIsEast = false;
+    }
+    return true;
+}
+
+//-----------------------------------------------
+void TSC_GlobalData::clearHorizonProfile(void) {
+    this->siteParams.horizonAz.clear();
+    this->siteParams.horizonAlt.clear();
+}
+
+//-----------------------------------------------
+void TSC_GlobalData::addHorizonPoint(float az, float alt) {
+    this->siteParams.horizonAz.push_back(az);
+    this->siteParams.horizonAlt.push_back(alt);
+}
+
+//-----------------------------------------------
+long TSC_GlobalData::getNumberOfHorizonPoints(void) {
+    return this->siteParams.horizonAz.size();
+}
+
+//-----------------------------------------------
+float TSC_GlobalData::getHorizonPoint(long idx, short what) {
+    if ((idx < 0) || (idx >= (long)this->siteParams.horizonAz.size())) {
+        return 0;
+    }
+    if (what == 0) {
+        return this->siteParams.horizonAz[idx];
+    }
+    return this->siteParams.horizonAlt[idx];
+}
+
+//-----------------------------------------------
+void TSC_GlobalData::setHideUnreachableObjects(bool hide) {
+    this->siteParams.hideUnreachable = hide;
+}
+
+//-----------------------------------------------
+bool TSC_GlobalData::getHideUnreachableObjects(void) {
+    return this->siteParams.hideUnreachable;
+}
+
 //-----------------------------------------------
 bool TSC_GlobalData::getTrackingMode(void) {
     return this->isInTrackingMode;
@@ -524,9 +1027,45 @@ int TSC_GlobalData::getGuideScopeFocalLength(void) {
 }
 
 //-----------------------------------------------
+void TSC_GlobalData::setCentroidEstimator(short est) {
+    if ((est >= 0) && (est <= 4)) {
+        this->centroidEstimator = est;
+    }
+}
+
+//-----------------------------------------------
+short TSC_GlobalData::getCentroidEstimator(void) {
+    return this->centroidEstimator;
+}
+
+//-----------------------------------------------
+void TSC_GlobalData::setNumberOfGuideStars(short n) {
+    if ((n >= 1) && (n <= 16)) {
+        this->numberOfGuideStars = n;
+    }
+}
+
+//-----------------------------------------------
+short TSC_GlobalData::getNumberOfGuideStars(void) {
+    return this->numberOfGuideStars;
+}
+
+//-----------------------------------------------
+void TSC_GlobalData::setGuideAlgorithm(short axis, short method) {
+    if ((axis >= 0) && (axis <= 1) && (method >= 0) && (method <= 4)) {
+        this->guideAlgorithm[axis] = method;
+    }
+}
+
+//-----------------------------------------------
+short TSC_GlobalData::getGuideAlgorithm(short axis) {
+    return this->guideAlgorithm[axis];
+}
+
+//-----------------------------------------------
+// the QImage shares the pixels of the camera image, which are not copied
 void TSC_GlobalData::storeCameraImage(QImage inImg) {
-    delete currentCameraImage;
-    currentCameraImage=new QImage(inImg);
+    *currentCameraImage=inImg;
 }
 
 //-----------------------------------------------
@@ -906,7 +1445,9 @@ int TSC_GlobalData::getDriveID(short what) {
 
 void TSC_GlobalData::storeGlobalData(void) {
     std::ofstream outfile("TSC_Preferences.tsp");
-    short boolFlag = 0;
+    short boolFlag = 0, axis;
+    std::string axisName;
+    size_t idx;
 
     std::string ostr = std::to_string(this->gearData.planetaryRatioRA);
     ostr.append("// Gear ratio for planetary connected to RA-stepper.\n");
@@ -1107,6 +1648,167 @@ void TSC_GlobalData::storeGlobalData(void) {
     ostr.append("// Flag whether to allow for getting a time via LX200 ...\n");
     outfile << ostr.data();
     ostr.clear();
+    if (this->refractionState.correctionIsOn == true) {
+        boolFlag = 1;
+    } else {
+        boolFlag = 0;
+    }
+    ostr.append(std::to_string(boolFlag));
+    ostr.append("// Flag whether GoTo and tracking are corrected for atmospheric refraction.\n");
+    outfile << ostr.data();
+    ostr.clear();
+    ostr.append(std::to_string(this->refractionState.pressureInHPa));
+    ostr.append("// Atmospheric pressure at the site in hPa.\n");
+    outfile << ostr.data();
+    ostr.clear();
+    if (this->meridianFlipState.autoFlipIsOn == true) {
+        boolFlag = 1;
+    } else {
+        boolFlag = 0;
+    }
+    ostr.append(std::to_string(boolFlag));
+    ostr.append("// Flag whether the meridian flip is carried out automatically.\n");
+    outfile << ostr.data();
+    ostr.clear();
+    ostr.append(std::to_string(this->meridianFlipState.flipLimitInMin));
+    ostr.append("// Minutes past the meridian before the flip has to be carried out.\n");
+    outfile << ostr.data();
+    ostr.clear();
+    for (axis = 0; axis < 2; axis++) {
+        if (axis == 0) {
+            axisName = "RA";
+        } else {
+            axisName = "Decl";
+        }
+        ostr.append(std::to_string(this->slewTimeModel.accFactor[axis]));
+        ostr.append("// Effective acceleration of the " + axisName + " drive during GoTo relative to the controller setting.\n");
+        outfile << ostr.data();
+        ostr.clear();
+        ostr.append(std::to_string(this->slewTimeModel.latency[axis]));
+        ostr.append("// Latency of a GoTo in " + axisName + " in s.\n");
+        outfile << ostr.data();
+        ostr.clear();
+        ostr.append(std::to_string(this->slewTimeModel.rmsError[axis]));
+        ostr.append("// RMS error of the predicted GoTo duration in " + axisName + " in s.\n");
+        outfile << ostr.data();
+        ostr.clear();
+        ostr.append(std::to_string(this->slewTimeModel.noOfSlews[axis]));
+        ostr.append("// Number of GoTos measured in " + axisName + ".\n");
+        outfile << ostr.data();
+        ostr.clear();
+    }
+    ostr.append(std::to_string(this->siteParams.minAltitude));
+    ostr.append("// Minimum altitude the telescope may point to in degrees.\n");
+    outfile << ostr.data();
+    ostr.clear();
+    ostr.append(std::to_string(this->siteParams.haLimitEast));
+    ostr.append("// Hour angle limit east of the meridian in hours.\n");
+    outfile << ostr.data();
+    ostr.clear();
+    ostr.append(std::to_string(this->siteParams.haLimitWest));
+    ostr.append("// Hour angle limit west of the meridian in hours.\n");
+    outfile << ostr.data();
+    ostr.clear();
+    if (this->siteParams.hideUnreachable == true) {
+        boolFlag = 1;
+    } else {
+        boolFlag = 0;
+    }
+    ostr.append(std::to_string(boolFlag));
+    ostr.append("// Flag whether unreachable objects are hidden in the catalogs.\n");
+    outfile << ostr.data();
+    ostr.clear();
+    ostr.append(std::to_string(this->siteParams.horizonAz.size()));
+    ostr.append("// Number of points in the horizon profile.\n");
+    outfile << ostr.data();
+    ostr.clear();
+    for (idx = 0; idx < this->siteParams.horizonAz.size(); idx++) {
+        ostr.append(std::to_string(this->siteParams.horizonAz[idx]));
+        ostr.append(" ");
+        ostr.append(std::to_string(this->siteParams.horizonAlt[idx]));
+        ostr.append("// Horizon profile - azimuth and lowest free altitude in degrees.\n");
+        outfile << ostr.data();
+        ostr.clear();
+    }
+    for (axis = 0; axis < 2; axis++) {
+        if (axis == 0) {
+            axisName = "RA";
+        } else {
+            axisName = "Decl";
+        }
+        ostr.append(std::to_string(this->backlash.microsteps[axis]));
+        ostr.append("// Backlash in " + axisName + " in microsteps for guiding.\n");
+        outfile << ostr.data();
+        ostr.clear();
+    }
+    if (this->backlash.compensationIsOn == true) {
+        boolFlag = 1;
+    } else {
+        boolFlag = 0;
+    }
+    ostr.append(std::to_string(boolFlag));
+    ostr.append("// Flag whether the drives compensate backlash.\n");
+    outfile << ostr.data();
+    ostr.clear();
+    ostr.append(std::to_string(this->positionSource.source));
+    ostr.append("// Position source - 0 is step counting, 1 encoders via AMIS, 2 encoders via SPI.\n");
+    outfile << ostr.data();
+    ostr.clear();
+    for (axis = 0; axis < 2; axis++) {
+        if (axis == 0) {
+            axisName = "RA";
+        } else {
+            axisName = "Decl";
+        }
+        ostr.append(std::to_string(this->positionSource.countsPerRevolution[axis]));
+        ostr.append(" ");
+        ostr.append(std::to_string(this->positionSource.direction[axis]));
+        ostr.append("// Encoder counts per revolution and counting direction in " + axisName + ".\n");
+        outfile << ostr.data();
+        ostr.clear();
+    }
+    ostr.append(std::to_string(this->positionSource.slipThresholdInArcsec));
+    ostr.append("// Difference between encoders and step counting in arcsec that is taken as slip.\n");
+    outfile << ostr.data();
+    ostr.clear();
+    if (this->homePosition.isKnown == true) {
+        boolFlag = 1;
+    } else {
+        boolFlag = 0;
+    }
+    ostr.append(std::to_string(boolFlag) + " " + std::to_string(this->homePosition.hourAngle) + " " +
+                std::to_string(this->homePosition.declination) + " " + std::to_string(this->homePosition.declSign) + " " +
+                std::to_string((this->homePosition.scopeIsEast == true) ? 1 : 0));
+    ostr.append("// Home position known, its hour angle, declination, declination sign and east flag.\n");
+    outfile << ostr.data();
+    ostr.clear();
+    ostr.append(std::to_string(this->homePosition.searchDirection[0]) + " " + std::to_string(this->homePosition.searchDirection[1]) + " " +
+                std::to_string(this->homePosition.speed));
+    ostr.append("// Direction (+/-1) of the search for the home switches in RA and Decl and speed of the search.\n");
+    outfile << ostr.data();
+    ostr.clear();
+    if (this->trackingCalibration.correctionIsOn == true) {
+        boolFlag = 1;
+    } else {
+        boolFlag = 0;
+    }
+    ostr.append(std::to_string(boolFlag) + " " + std::to_string(this->trackingCalibration.rateError) + " " +
+                std::to_string(this->trackingCalibration.poleOffset[0]) + " " + std::to_string(this->trackingCalibration.poleOffset[1]));
+    ostr.append("// Tracking correction on, rate error of RA drive, tilt of polar axis up and east in arcmin.\n");
+    outfile << ostr.data();
+    ostr.clear();
+    ostr.append(std::to_string(this->centroidEstimator));
+    ostr.append("// Centroid of the guide star: 0 moments, 1 windowed, 2 gaussian fit, 3 moffat fit, 4 peak interpolation.\n");
+    outfile << ostr.data();
+    ostr.clear();
+    ostr.append(std::to_string(this->numberOfGuideStars));
+    ostr.append("// Number of stars used for guiding.\n");
+    outfile << ostr.data();
+    ostr.clear();
+    ostr.append(std::to_string(this->guideAlgorithm[0]) + " " + std::to_string(this->guideAlgorithm[1]));
+    ostr.append("// Guide algorithm in RA and Decl: 0 hysteresis, 1 low pass, 2 resist switch, 3 PID, 4 predictive.\n");
+    outfile << ostr.data();
+    ostr.clear();
     outfile.close();
 }
 
@@ -1114,7 +1816,9 @@ void TSC_GlobalData::storeGlobalData(void) {
 
 bool TSC_GlobalData::loadGlobalData(void) {
     std::string line;   // define a line that is read until \n is encountered
-    short boolFlag;
+    short boolFlag, sval, axis;
+    float fval, fval2, fval3;
+    long lval, idx;
 
     char delimiter('/');    // data are separated from comments by c++ - style comments
     std::ifstream infile("TSC_Preferences.tsp");  // read that preferences file ...
@@ -1319,6 +2023,190 @@ bool TSC_GlobalData::loadGlobalData(void) {
         this->useTimeFromLX200 = true;
     }
     std::getline(infile, line, '\n');
+    std::getline(infile, line, delimiter);
+    std::istringstream isRefraction(line);
+    if (isRefraction >> boolFlag) { // preference files written by older versions end here - keep the defaults then
+        if (boolFlag == 0) {
+            this->refractionState.correctionIsOn = false;
+        } else {
+            this->refractionState.correctionIsOn = true;
+        }
+    }
+    std::getline(infile, line, '\n');
+    std::getline(infile, line, delimiter);
+    std::istringstream isPressure(line);
+    if (isPressure >> fval) {
+        this->refractionState.pressureInHPa = fval;
+    }
+    std::getline(infile, line, '\n');
+    std::getline(infile, line, delimiter);
+    std::istringstream isAutoFlip(line);
+    if (isAutoFlip >> boolFlag) {
+        if (boolFlag == 0) {
+            this->meridianFlipState.autoFlipIsOn = false;
+        } else {
+            this->meridianFlipState.autoFlipIsOn = true;
+        }
+    }
+    std::getline(infile, line, '\n');
+    std::getline(infile, line, delimiter);
+    std::istringstream isFlipLimit(line);
+    if (isFlipLimit >> sval) {
+        if ((sval > 0) && (sval <= 60)) {
+            this->meridianFlipState.flipLimitInMin = sval;
+        }
+    }
+    std::getline(infile, line, '\n');
+    for (axis = 0; axis < 2; axis++) {
+        std::getline(infile, line, delimiter);
+        std::istringstream isAccFactor(line);
+        if ((isAccFactor >> fval) && (fval > 0)) {
+            this->slewTimeModel.accFactor[axis] = fval;
+        }
+        std::getline(infile, line, '\n');
+        std::getline(infile, line, delimiter);
+        std::istringstream isLatency(line);
+        if ((isLatency >> fval) && (fval >= 0)) {
+            this->slewTimeModel.latency[axis] = fval;
+        }
+        std::getline(infile, line, '\n');
+        std::getline(infile, line, delimiter);
+        std::istringstream isRMSError(line);
+        if ((isRMSError >> fval) && (fval >= 0)) {
+            this->slewTimeModel.rmsError[axis] = fval;
+        }
+        std::getline(infile, line, '\n');
+        std::getline(infile, line, delimiter);
+        std::istringstream isNoOfSlews(line);
+        if ((isNoOfSlews >> lval) && (lval >= 0)) {
+            this->slewTimeModel.noOfSlews[axis] = lval;
+        }
+        std::getline(infile, line, '\n');
+    }
+    std::getline(infile, line, delimiter);
+    std::istringstream isMinAlt(line);
+    if (isMinAlt >> fval) {
+        this->setMountLimits(fval, this->siteParams.haLimitEast, this->siteParams.haLimitWest);
+    }
+    std::getline(infile, line, '\n');
+    std::getline(infile, line, delimiter);
+    std::istringstream isHALimitEast(line);
+    if (isHALimitEast >> fval) {
+        this->setMountLimits(this->siteParams.minAltitude, fval, this->siteParams.haLimitWest);
+    }
+    std::getline(infile, line, '\n');
+    std::getline(infile, line, delimiter);
+    std::istringstream isHALimitWest(line);
+    if (isHALimitWest >> fval) {
+        this->setMountLimits(this->siteParams.minAltitude, this->siteParams.haLimitEast, fval);
+    }
+    std::getline(infile, line, '\n');
+    std::getline(infile, line, delimiter);
+    std::istringstream isHideUnreachable(line);
+    if (isHideUnreachable >> boolFlag) {
+        if (boolFlag == 0) {
+            this->siteParams.hideUnreachable = false;
+        } else {
+            this->siteParams.hideUnreachable = true;
+        }
+    }
+    std::getline(infile, line, '\n');
+    std::getline(infile, line, delimiter);
+    std::istringstream isNoOfHorizonPoints(line);
+    if ((isNoOfHorizonPoints >> lval) && (lval > 0)) {
+        std::getline(infile, line, '\n');
+        this->clearHorizonProfile();
+        for (idx = 0; idx < lval; idx++) {
+            std::getline(infile, line, delimiter);
+            std::istringstream isHorizonPoint(line);
+            if (isHorizonPoint >> fval >> fval2) {
+                this->addHorizonPoint(fval, fval2);
+            }
+            std::getline(infile, line, '\n');
+        }
+    } else {
+        std::getline(infile, line, '\n');
+    }
+    for (axis = 0; axis < 2; axis++) {
+        std::getline(infile, line, delimiter);
+        std::istringstream isBacklash(line);
+        if ((isBacklash >> lval) && (lval >= 0)) {
+            this->backlash.microsteps[axis] = lval;
+        }
+        std::getline(infile, line, '\n');
+    }
+    std::getline(infile, line, delimiter);
+    std::istringstream isBacklashComp(line);
+    if (isBacklashComp >> boolFlag) {
+        if (boolFlag == 0) {
+            this->backlash.compensationIsOn = false;
+        } else {
+            this->backlash.compensationIsOn = true;
+        }
+    }
+    std::getline(infile, line, '\n');
+    std::getline(infile, line, delimiter);
+    std::istringstream isPositionSource(line);
+    if (isPositionSource >> sval) {
+        this->setPositionSource(sval);
+    }
+    std::getline(infile, line, '\n');
+    for (axis = 0; axis < 2; axis++) {
+        std::getline(infile, line, delimiter);
+        std::istringstream isEncoder(line);
+        if (isEncoder >> lval >> sval) {
+            this->setEncoderParams(axis, lval, sval);
+        }
+        std::getline(infile, line, '\n');
+    }
+    std::getline(infile, line, delimiter);
+    std::istringstream isSlipThreshold(line);
+    if (isSlipThreshold >> fval) {
+        this->setEncoderSlipThreshold(fval);
+    }
+    std::getline(infile, line, '\n');
+    std::getline(infile, line, delimiter);
+    std::istringstream isHomePosition(line);
+    if ((isHomePosition >> boolFlag >> fval >> fval2 >> sval >> lval) && (boolFlag == 1)) {
+        this->setHomePosition(fval, fval2, sval, (lval == 1));
+    }
+    std::getline(infile, line, '\n');
+    std::getline(infile, line, delimiter);
+    std::istringstream isHomeSearch(line);
+    if (isHomeSearch >> sval >> lval) {
+        this->setHomeSearchDirection(0, sval);
+        this->setHomeSearchDirection(1, (short)lval);
+        if (isHomeSearch >> fval) {
+            this->setHomingSpeed(fval);
+        } // preferences written before the speed was added have the directions only
+    }
+    std::getline(infile, line, '\n');
+    std::getline(infile, line, delimiter);
+    std::istringstream isTrackingCalibration(line);
+    if (isTrackingCalibration >> boolFlag >> fval >> fval2 >> fval3) {
+        this->setTrackingCalibration(fval, fval2, fval3);
+        this->setTrackingCalibrationCorrection(boolFlag == 1);
+    }
+    std::getline(infile, line, '\n');
+    std::getline(infile, line, delimiter);
+    std::istringstream isCentroidEstimator(line);
+    if (isCentroidEstimator >> sval) {
+        this->setCentroidEstimator(sval);
+    }
+    std::getline(infile, line, '\n');
+    std::getline(infile, line, delimiter);
+    std::istringstream isGuideStars(line);
+    if (isGuideStars >> sval) {
+        this->setNumberOfGuideStars(sval);
+    }
+    std::getline(infile, line, '\n');
+    std::getline(infile, line, delimiter);
+    std::istringstream isGuideAlgorithm(line);
+    if (isGuideAlgorithm >> sval >> lval) {
+        this->setGuideAlgorithm(0, sval);
+        this->setGuideAlgorithm(1, (short)lval);
+    }
+    std::getline(infile, line, '\n');
     infile.close(); // close the reading file for preferences
     return true;
 }
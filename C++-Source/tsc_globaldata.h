@@ -24,6 +24,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sstream>
+#include <vector>
 
 class TSC_GlobalData {
 public:
@@ -60,6 +61,12 @@ public:
     void storeCameraImage(QImage);
     void setGuideScopeFocalLength(int); // FL of guidescope in mm
     int getGuideScopeFocalLength(void);
+    void setCentroidEstimator(short); // how the guide star is measured, one of TSC_Centroid::centroidEstimator
+    short getCentroidEstimator(void);
+    void setNumberOfGuideStars(short); // 1 guides on the selected star alone, more use an ensemble of stars
+    short getNumberOfGuideStars(void);
+    void setGuideAlgorithm(short, short); // 0 for RA, 1 for decl and one of TSC_GuideAlgorithm::guideMethod
+    short getGuideAlgorithm(short);
     bool getGuidingState(void); // check if system is in autoguiding state
     void setGuidingState(bool);
     bool getTrackingMode(void); // a global variable checking if the mount is tracking or slewing
@@ -68,6 +75,14 @@ public:
     void setSiteParams(QString); // set the name of the site
     double getSiteCoords(short); // get coordinates of site
     QString getSiteName(void); // get name of site
+    void setMountLimits(float, float, float); // minimum altitude in degrees, how far the tube may cross the meridian to the east and to the west on the equator, in hours
+    float getMountLimits(short); // 0 is the minimum altitude, 1 the limit east, 2 the limit west
+    void clearHorizonProfile(void);
+    void addHorizonPoint(float, float); // azimuth and lowest free altitude in degrees
+    long getNumberOfHorizonPoints(void);
+    float getHorizonPoint(long, short); // 0 is azimuth, 1 is altitude
+    void setHideUnreachableObjects(bool); // catalog objects that cannot be reached are not listed
+    bool getHideUnreachableObjects(void);
     QImage* getCameraImage(void); // retrieve the topical image from the guiding camera
     QString* getBTMACAddress(void); // get the MAC address of the BT-adapter
     void setLX200IPAddress(QString); // store the IP address for LX200
@@ -108,6 +123,38 @@ public:
     int getMicroSteppingRatio(short); // 0 for guiding/tracking, 1 for moving, 2 for slewing
     void setMaxDeclForNoFlip(short);
     short getMaxDeclForNoFlip(void);
+    void setAutoMFlip(bool); // carry out the meridian flip during an exposure series without operator action
+    bool getAutoMFlip(void);
+    void setMFlipLimit(short); // time in minutes the mount may track past the meridian before it has to flip
+    short getMFlipLimit(void);
+    void setSlewTimeModel(short, short, double); // axis 0 is RA, 1 is decl; 0 is the acceleration factor, 1 the latency in s, 2 the rms error of the ETA in s, 3 the number of measured slews
+    double getSlewTimeModel(short, short);
+    void setBacklash(short, long); // axis 0 is RA, 1 is decl; backlash in microsteps at the microstepping ratio for guiding
+    long getBacklash(short);
+    void setBacklashCompensation(bool); // the drives take up the backlash whenever they reverse
+    bool getBacklashCompensation(void);
+    void setPositionSource(short); // 0 is step counting, 1 encoders read via the AMIS boards, 2 encoders read via SPI
+    short getPositionSource(void);
+    void setEncoderParams(short, long, short); // axis 0 is RA, 1 is decl; counts per revolution of the axis and direction of counting (+/-1)
+    long getEncoderParams(short, short); // axis; 0 is the counts per revolution, 1 the direction
+    void setEncoderSlipThreshold(float); // in arcsec
+    float getEncoderSlipThreshold(void);
+    void setHomePosition(float, float, short, bool); // mechanical hour angle and declination where the home switches close, declination sign and side of the pier there
+    float getHomePosition(short); // 0 is the hour angle, 1 the declination, 2 the declination sign, 3 is 1 if the scope is east
+    bool isHomePositionKnown(void);
+    void setHomeSearchDirection(short, short); // axis and direction (+/-1) in which the drive runs to its home switch
+    short getHomeSearchDirection(short);
+    void setHomingSpeed(float); // multiple of the sidereal speed at which the drives run to the home switches
+    float getHomingSpeed(void);
+    void setTrackingCalibration(float, float, float); // rate error of the RA drive as a fraction, tilt of the polar axis up and east in arcmin
+    float getTrackingCalibration(short); // 0 is the rate error, 1 and 2 the tilt up and east
+    void setTrackingCalibrationCorrection(bool); // the tracking rates are corrected for the calibrated errors
+    bool getTrackingCalibrationCorrection(void);
+    void setAxisSteps(long long, long long, bool); // step counters of the RA and decl drives, signed so that they count up with hour angle and declination; true at a sync
+    long long getAxisSteps(short); // as set or restored from the mount state
+    double getMicrostepsPerDegree(short); // axis 0 is RA, 1 is decl; at the microstepping ratio for tracking
+    bool storeMountState(bool); // writes the step counters of the drives to ".TSCMountState.tsl"; true if the mount is parked
+    bool restoreMountState(double*, double*); // mechanical hour angle and declination of a parked mount; false if there is no valid state
     void setTimeFromLX200Flag(bool);
     bool getTimeFromLX200Flag(void);
     bool getDriverAvailability(void);
@@ -122,6 +169,10 @@ public:
     bool getBooleanPSParams(short); // see above
     void setPSSearchRad(double);
     double getPSSearchRad(void);
+    void setRefractionCorrection(bool); // switch correction of GoTo targets and tracking rates for atmospheric refraction
+    bool getRefractionCorrection(void);
+    void setAtmosphericPressure(float); // ambient pressure in hPa for the refraction model
+    float getAtmosphericPressure(void);
 
 private:
     QElapsedTimer *monotonicGlobalTimer;
@@ -132,6 +183,9 @@ private:
     bool isInTrackingMode;
     QImage *currentCameraImage;
     int guideScopeFocalLength;
+    short centroidEstimator;
+    short numberOfGuideStars;
+    short guideAlgorithm[2]; // RA and decl
     float dslrPixelDiagSize;
     int mainScopeFocalLength;
     int ditherRangeMin;
@@ -208,6 +262,12 @@ private:
         double latitude;
         QString siteName;
         double UTCOffset;
+        float minAltitude = 0; // the limits of the mount
+        float haLimitEast = 12; // in hours from the meridian
+        float haLimitWest = 12;
+        bool hideUnreachable = false;
+        std::vector<float> horizonAz; // the horizon profile of the site
+        std::vector<float> horizonAlt;
     };
 
     struct auxDriveStruct {
@@ -227,6 +287,8 @@ private:
         short declSign = 1;
         bool declSwitchChangePending = false;
         short maxDeclForNoFlip;
+        bool autoFlipIsOn = false;
+        short flipLimitInMin = 10;
     };
 
     struct plateSolvingParams {
@@ -238,6 +300,53 @@ private:
         QString *pathToFITSToBeSolved = nullptr;
     };
 
+    struct refractionParams {
+        bool correctionIsOn = false;
+        float pressureInHPa = 1010;
+    };
+
+    struct slewTimeModelParams { // calibration of the GoTo ETA from measured slews; index 0 is RA, 1 is decl
+        float accFactor[2] = {1.0, 1.0}; // effective acceleration of the drive relative to the one set in the controller
+        float latency[2] = {0.1f, 0.1f}; // time in s from the travel command until the stop is detected
+        float rmsError[2] = {0, 0}; // rms error of the predicted slew duration in s
+        long noOfSlews[2] = {0, 0};
+    };
+
+    struct backlashParams {
+        long microsteps[2] = {0, 0}; // backlash of RA and decl in microsteps at the microstepping ratio for guiding
+        bool compensationIsOn = true;
+    };
+
+    struct positionSourceParams {
+        short source = 0; // 0 is step counting, 1 encoders via the AMIS boards, 2 encoders via SPI
+        long countsPerRevolution[2] = {16777216, 16777216};
+        short direction[2] = {1, 1};
+        float slipThresholdInArcsec = 30;
+    };
+
+    struct homePositionParams {
+        bool isKnown = false; // the position of the home switches is learned when homing a synced mount
+        float hourAngle = 0;
+        float declination = 0;
+        short declSign = 1;
+        bool scopeIsEast = false;
+        short searchDirection[2] = {1, 1};
+        float speed = 100; // multiple of the sidereal speed
+    };
+
+    struct axisStepsParams { // the position of the axes as the drives counted it, for the mount state
+        long long steps[2] = {0, 0};
+        long long stepsAtSync[2] = {0, 0};
+        double hourAngleAtSync = 0; // mechanical hour angle and declination at the last sync
+        double declinationAtSync = 0;
+    };
+
+    struct trackingCalibrationParams { // from the drift of plate solved positions while tracking
+        bool correctionIsOn = false;
+        float rateError = 0; // fraction of the sidereal rate the RA drive turns too slowly
+        float poleOffset[2] = {0, 0}; // tilt of the polar axis towards the zenith and towards the east in arcmin
+    };
+
     struct initialStarPosStruct initialStarPos;
     struct cameraDisplaySizeStruct cameraDisplaySize;
     struct cameraDisplaySizeStruct mainCameraDisplaySize;
@@ -251,6 +360,13 @@ private:
     struct auxDriveStruct auxDriveParams;
     struct mflipParams meridianFlipState;
     struct plateSolvingParams psParams;
+    struct refractionParams refractionState;
+    struct slewTimeModelParams slewTimeModel;
+    struct backlashParams backlash;
+    struct positionSourceParams positionSource;
+    struct homePositionParams homePosition;
+    struct axisStepsParams axisSteps;
+    struct trackingCalibrationParams trackingCalibration;
 };
 
 #endif // TSC_GLOBALDATA_H
@@ -0,0 +1,468 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+
+//---------------------------------------------------
+#include "tsc_guidealgorithm.h"
+#include <math.h>
+
+static const long maxFrames = 1024; // about an hour with 3 s per frame
+static const long lowPassFrames = 10;
+static const long switchFrames = 3; // deviations in the new direction before resist switch reverses
+static const long driftFrames = 32; // for the drift of gaPredictive as long as there is no period
+static const long refitFrames = 8;
+static const double shortestPeriod = 60.0;
+static const double longestPeriod = 1800.0;
+
+TSC_GuideAlgorithm::TSC_GuideAlgorithm(void) {
+    this->method = gaHysteresis;
+    this->minMove = 0.3;
+    this->aggressiveness = 1.0;
+    this->hysteresisWeight = 0.9;
+    this->maxCorrection = 1.0e6;
+    this->gain[0] = 0.7;
+    this->gain[1] = 0.05;
+    this->gain[2] = 0.0;
+    this->reset();
+}
+
+//---------------------------------------------------
+TSC_GuideAlgorithm::~TSC_GuideAlgorithm(void) {
+    this->frames.clear();
+}
+
+//---------------------------------------------------
+void TSC_GuideAlgorithm::setMethod(short meth) {
+    if ((meth >= gaHysteresis) && (meth <= gaPredictive)) {
+        this->method = meth;
+    }
+    this->reset();
+}
+
+//---------------------------------------------------
+short TSC_GuideAlgorithm::getMethod(void) {
+    return this->method;
+}
+
+//---------------------------------------------------
+void TSC_GuideAlgorithm::setParameters(double minPix, double aggr, double weight) {
+    if (minPix >= 0) {
+        this->minMove = minPix;
+    }
+    if (aggr > 0) {
+        this->aggressiveness = aggr;
+    }
+    if ((weight >= 0) && (weight <= 1)) {
+        this->hysteresisWeight = weight;
+    }
+}
+
+//---------------------------------------------------
+void TSC_GuideAlgorithm::setMaximumCorrection(double pix) {
+    if (pix > 0) {
+        this->maxCorrection = pix;
+    }
+}
+
+//---------------------------------------------------
+void TSC_GuideAlgorithm::setPIDGains(double kp, double ki, double kd) {
+    if (kp >= 0) {
+        this->gain[0] = kp;
+    }
+    if (ki >= 0) {
+        this->gain[1] = ki;
+    }
+    if (kd >= 0) {
+        this->gain[2] = kd;
+    }
+}
+
+//---------------------------------------------------
+void TSC_GuideAlgorithm::reset(void) {
+    short idx;
+
+    this->frames.clear();
+    this->correctionSum = 0;
+    this->lastCorrection = 0;
+    this->lastWasClipped = false;
+    this->integral = 0;
+    this->direction = 0;
+    this->period = 0;
+    for (idx = 0; idx < 6; idx++) {
+        this->model[idx] = 0;
+    }
+    this->modelOrigin = 0;
+    this->modelIsValid = false;
+    this->framesSinceFit = 0;
+}
+
+//---------------------------------------------------
+double TSC_GuideAlgorithm::computeCorrection(double deviation, double time) {
+    struct frameStruct frame;
+    double correction;
+
+    frame.time = time;
+    frame.deviation = deviation;
+    frame.track = deviation + this->correctionSum;
+    this->frames.push_back(frame);
+    if ((long)this->frames.size() > maxFrames) {
+        this->frames.erase(this->frames.begin());
+    }
+    switch (this->method) {
+    case gaLowPass:
+        correction = this->computeLowPass();
+        break;
+    case gaResistSwitch:
+        correction = this->computeResistSwitch();
+        break;
+    case gaPID:
+        correction = this->computePID();
+        break;
+    case gaPredictive:
+        correction = this->computePredictive();
+        break;
+    default:
+        correction = this->computeHysteresis();
+    }
+    correction *= this->aggressiveness;
+    this->lastWasClipped = false;
+    if (fabs(correction) > this->maxCorrection) {
+        correction = copysign(this->maxCorrection, correction);
+        this->lastWasClipped = true;
+    }
+    this->lastCorrection = correction;
+    this->correctionSum += correction;
+    return correction;
+}
+
+//---------------------------------------------------
+double TSC_GuideAlgorithm::getPeriod(void) {
+    return this->period;
+}
+
+//---------------------------------------------------
+double TSC_GuideAlgorithm::getPeriodicAmplitude(void) {
+    if (this->period > 0) {
+        return sqrt(this->model[2]*this->model[2] + this->model[3]*this->model[3]);
+    }
+    return 0;
+}
+
+//---------------------------------------------------
+// the errors before the first frames are taken as 0, as in MainWindow before
+double TSC_GuideAlgorithm::computeHysteresis(void) {
+    double errs[3] = {0, 0, 0}, prevWeights;
+    long n, idx;
+
+    n = (long)this->frames.size();
+    for (idx = 0; (idx < 3) && (idx < n); idx++) {
+        errs[2-idx] = this->frames[n-1-idx].deviation;
+    }
+    if (fabs(errs[2]) <= this->minMove) {
+        return 0;
+    }
+    prevWeights = (1.0 - this->hysteresisWeight)/2.0;
+    return prevWeights*errs[0] + prevWeights*errs[1] + this->hysteresisWeight*errs[2];
+}
+
+//---------------------------------------------------
+// the end of the line through the track, minus what was corrected so far, is the deviation without the noise
+double TSC_GuideAlgorithm::computeLowPass(void) {
+    double estimate, track, drift;
+
+    if (this->fitLine(lowPassFrames, &track, &drift) == true) {
+        estimate = track - (this->frames.back().track - this->frames.back().deviation);
+    } else {
+        estimate = this->frames.back().deviation;
+    }
+    if (fabs(estimate) <= this->minMove) {
+        return 0;
+    }
+    return estimate;
+}
+
+//---------------------------------------------------
+double TSC_GuideAlgorithm::computeResistSwitch(void) {
+    double deviation;
+    short sign;
+    long n, idx;
+
+    n = (long)this->frames.size();
+    deviation = this->frames.back().deviation;
+    if (fabs(deviation) <= this->minMove) {
+        return 0;
+    }
+    sign = (deviation > 0) ? 1 : -1;
+    if ((this->direction != 0) && (sign != this->direction)) {
+        if (n < switchFrames) {
+            return 0;
+        }
+        for (idx = n - switchFrames; idx < n; idx++) {
+            if (this->frames[idx].deviation*sign <= this->minMove) {
+                return 0;
+            }
+        }
+    } // a single deviation the other way is taken as seeing; the drive would take up the backlash for nothing
+    this->direction = sign;
+    return deviation;
+}
+
+//---------------------------------------------------
+// the integral does not grow while the correction is clipped in the direction of the deviation
+double TSC_GuideAlgorithm::computePID(void) {
+    double deviation, dt = 0, derivative = 0, correction, limit;
+    long n;
+
+    n = (long)this->frames.size();
+    deviation = this->frames.back().deviation;
+    if (n > 1) {
+        dt = this->frames[n-1].time - this->frames[n-2].time;
+        if (dt > 0) {
+            derivative = (deviation - this->frames[n-2].deviation)/dt;
+        }
+    }
+    if ((this->lastWasClipped == false) || (deviation*this->lastCorrection <= 0)) {
+        this->integral += deviation*dt;
+    }
+    if (this->gain[1] > 0) {
+        limit = this->maxCorrection/this->gain[1];
+        if (fabs(this->integral) > limit) {
+            this->integral = copysign(limit, this->integral);
+        }
+    }
+    correction = this->gain[1]*this->integral + this->gain[2]*derivative;
+    if (fabs(deviation) > this->minMove) {
+        correction += this->gain[0]*deviation;
+    }
+    return correction;
+}
+
+//---------------------------------------------------
+// the model is fitted again every few frames; until there are enough frames, only the deviation is corrected
+double TSC_GuideAlgorithm::computePredictive(void) {
+    double deviation, correction = 0, step, now;
+    long n;
+
+    n = (long)this->frames.size();
+    deviation = this->frames.back().deviation;
+    if (fabs(deviation) > this->minMove) {
+        correction = this->gain[0]*deviation;
+    }
+    if (n < driftFrames) {
+        return correction;
+    }
+    this->framesSinceFit++;
+    if ((this->modelIsValid == false) || (this->framesSinceFit >= refitFrames)) {
+        this->framesSinceFit = 0;
+        this->searchPeriod();
+        this->modelIsValid = this->fitPeriodicModel();
+    }
+    if (this->modelIsValid == true) {
+        now = this->frames.back().time;
+        step = (now - this->frames[n-refitFrames].time)/(refitFrames - 1); // the time to the next frame
+        correction += this->evaluateModel(now + step) - this->evaluateModel(now);
+    }
+    return correction;
+}
+
+//---------------------------------------------------
+bool TSC_GuideAlgorithm::fitLine(long count, double *track, double *drift) {
+    double sumT = 0, sumY = 0, sumTT = 0, sumTY = 0, t, det;
+    long n, idx, first;
+
+    n = (long)this->frames.size();
+    first = n - count;
+    if (first < 0) {
+        first = 0;
+    }
+    if (n - first < 3) {
+        return false;
+    }
+    for (idx = first; idx < n; idx++) {
+        t = this->frames[idx].time - this->frames.back().time;
+        sumT += t;
+        sumY += this->frames[idx].track;
+        sumTT += t*t;
+        sumTY += t*this->frames[idx].track;
+    }
+    det = (n - first)*sumTT - sumT*sumT;
+    if (det <= 0) {
+        return false;
+    }
+    *drift = ((n - first)*sumTY - sumT*sumY)/det;
+    *track = (sumY - *drift*sumT)/(n - first);
+    return true;
+}
+
+//---------------------------------------------------
+// the periodogram of the track without its drift; a peak well above the mean is taken as the period. the
+// frequencies are four times closer than the resolution of the track, the peak is refined with a parabola
+void TSC_GuideAlgorithm::searchPeriod(void) {
+    std::vector<double> residual, power;
+    double track, drift, t0, span, longest, shortest, freq, freqStep, c, s, arg, meanPower = 0, delta, denom;
+    long n, idx, k, peak = 0;
+
+    this->period = 0;
+    n = (long)this->frames.size();
+    t0 = this->frames.front().time;
+    span = this->frames.back().time - t0;
+    if ((span <= 0) || (this->fitLine(n, &track, &drift) == false)) {
+        return;
+    }
+    longest = fmin(longestPeriod, span/1.5);
+    shortest = fmax(shortestPeriod, 4*span/(n - 1));
+    if (longest <= shortest) {
+        return;
+    }
+    residual.resize(n);
+    for (idx = 0; idx < n; idx++) {
+        residual[idx] = this->frames[idx].track - (track + drift*(this->frames[idx].time - this->frames.back().time));
+    }
+    freqStep = 1.0/(4*span);
+    for (freq = 1.0/longest; freq <= 1.0/shortest; freq += freqStep) {
+        c = 0;
+        s = 0;
+        for (idx = 0; idx < n; idx++) {
+            arg = 2*M_PI*freq*(this->frames[idx].time - t0);
+            c += residual[idx]*cos(arg);
+            s += residual[idx]*sin(arg);
+        }
+        power.push_back(c*c + s*s);
+        meanPower += c*c + s*s;
+    }
+    if (power.size() < 3) {
+        return;
+    }
+    meanPower /= power.size();
+    for (k = 1; k < (long)power.size(); k++) {
+        if (power[k] > power[peak]) {
+            peak = k;
+        }
+    }
+    if (power[peak] < 8*meanPower) {
+        return;
+    } // noise alone hardly reaches this
+    delta = 0;
+    if ((peak > 0) && (peak < (long)power.size() - 1)) {
+        denom = power[peak-1] - 2*power[peak] + power[peak+1];
+        if (denom < 0) {
+            delta = 0.5*(power[peak-1] - power[peak+1])/denom;
+        }
+    }
+    this->period = 1.0/(1.0/longest + (peak + delta)*freqStep);
+}
+
+//---------------------------------------------------
+// gaussian elimination with partial pivoting; false if the system is singular
+static bool solveLinearSystem(double a[6][6], double *b, short n) {
+    double factor, swap;
+    short row, col, pivot, idx;
+
+    for (col = 0; col < n; col++) {
+        pivot = col;
+        for (row = col + 1; row < n; row++) {
+            if (fabs(a[row][col]) > fabs(a[pivot][col])) {
+                pivot = row;
+            }
+        }
+        if (fabs(a[pivot][col]) < 1.0e-12) {
+            return false;
+        }
+        for (idx = 0; idx < n; idx++) {
+            swap = a[col][idx];
+            a[col][idx] = a[pivot][idx];
+            a[pivot][idx] = swap;
+        }
+        swap = b[col];
+        b[col] = b[pivot];
+        b[pivot] = swap;
+        for (row = col + 1; row < n; row++) {
+            factor = a[row][col]/a[col][col];
+            for (idx = col; idx < n; idx++) {
+                a[row][idx] -= factor*a[col][idx];
+            }
+            b[row] -= factor*b[col];
+        }
+    }
+    for (row = n - 1; row >= 0; row--) {
+        for (idx = row + 1; idx < n; idx++) {
+            b[row] -= a[row][idx]*b[idx];
+        }
+        b[row] /= a[row][row];
+    }
+    return true;
+}
+
+//---------------------------------------------------
+// without a period, the model is the drift of the last frames; with a period, offset, drift and two harmonics
+// are fitted to all frames by least squares. the time counts from the last frame
+bool TSC_GuideAlgorithm::fitPeriodicModel(void) {
+    double normal[6][6], rhs[6], basis[6], t, omega;
+    long n, idx;
+    short row, col;
+
+    for (row = 0; row < 6; row++) {
+        this->model[row] = 0;
+    }
+    this->modelOrigin = this->frames.back().time;
+    if (this->period <= 0) {
+        return this->fitLine(driftFrames, &this->model[0], &this->model[1]);
+    }
+    for (row = 0; row < 6; row++) {
+        rhs[row] = 0;
+        for (col = 0; col < 6; col++) {
+            normal[row][col] = 0;
+        }
+    }
+    omega = 2*M_PI/this->period;
+    n = (long)this->frames.size();
+    for (idx = 0; idx < n; idx++) {
+        t = this->frames[idx].time - this->modelOrigin;
+        basis[0] = 1;
+        basis[1] = t;
+        basis[2] = cos(omega*t);
+        basis[3] = sin(omega*t);
+        basis[4] = cos(2*omega*t);
+        basis[5] = sin(2*omega*t);
+        for (row = 0; row < 6; row++) {
+            rhs[row] += basis[row]*this->frames[idx].track;
+            for (col = 0; col < 6; col++) {
+                normal[row][col] += basis[row]*basis[col];
+            }
+        }
+    }
+    if (solveLinearSystem(normal, rhs, 6) == false) {
+        this->period = 0;
+        return this->fitLine(driftFrames, &this->model[0], &this->model[1]);
+    }
+    for (row = 0; row < 6; row++) {
+        this->model[row] = rhs[row];
+    }
+    return true;
+}
+
+//---------------------------------------------------
+double TSC_GuideAlgorithm::evaluateModel(double time) {
+    double t, omega, value;
+
+    t = time - this->modelOrigin;
+    value = this->model[0] + this->model[1]*t;
+    if (this->period > 0) {
+        omega = 2*M_PI/this->period;
+        value += this->model[2]*cos(omega*t) + this->model[3]*sin(omega*t) + this->model[4]*cos(2*omega*t) +
+            this->model[5]*sin(2*omega*t);
+    }
+    return value;
+}
@@ -0,0 +1,87 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+// turns the deviation of the guide star along one axis into the correction of the next guide pulse. deviation
+// and correction are in pixels of the guide camera; a positive correction moves the star back against a positive
+// deviation. the track of the star is the deviation plus all corrections sent before the frame, which is where the
+// star would be without guiding. the methods are
+//   - the running average of MainWindow::correctGuideStarPosition: the last error has the hysteresis weight,
+//     the two errors before share the rest,
+//   - a low pass that fits a straight line to the track of the last ten frames and corrects the end of the line,
+//   - resist switch, which reverses the direction of the corrections only after three deviations beyond the
+//     minimum move in the new direction; meant for declination with its backlash,
+//   - a PID controller whose integral stops growing while the correction is clipped, and
+//   - a predictive controller that learns the periodic error of the worm from the track. the period is the peak
+//     of a periodogram, the model is a drift and two harmonics of that period. the motion the model predicts up
+//     to the next frame is added to a proportional correction of the deviation.
+// deviations below the minimum move are not corrected, but the predicted motion is. the correction is scaled by
+// the aggressiveness and clipped to the maximum correction. times are in seconds.
+
+#ifndef TSC_GUIDEALGORITHM_H
+#define TSC_GUIDEALGORITHM_H
+
+#include <vector>
+
+class TSC_GuideAlgorithm {
+public:
+    enum guideMethod {gaHysteresis, gaLowPass, gaResistSwitch, gaPID, gaPredictive};
+    TSC_GuideAlgorithm(void);
+    ~TSC_GuideAlgorithm(void);
+    void setMethod(short); // one of guideMethod; forgets the past frames
+    short getMethod(void);
+    void setParameters(double, double, double); // minimum move in pixels, aggressiveness, weight of the last error for gaHysteresis
+    void setMaximumCorrection(double); // in pixels
+    void setPIDGains(double, double, double); // proportional, integral in 1/s and derivative in s; the first is also the feedback of gaPredictive
+    void reset(void); // forget the past frames, for a new guide star
+    double computeCorrection(double, double); // deviation in pixels and time of the frame -> correction in pixels
+    double getPeriod(void); // period of the periodic error found by gaPredictive, 0 if there is none
+    double getPeriodicAmplitude(void); // amplitude of its first harmonic in pixels
+
+private:
+    struct frameStruct {
+        double time;
+        double deviation;
+        double track; // deviation plus the corrections sent before
+    };
+    std::vector<frameStruct> frames;
+    short method;
+    double minMove;
+    double aggressiveness;
+    double hysteresisWeight;
+    double maxCorrection;
+    double gain[3];
+    double correctionSum; // all corrections since the last reset
+    double lastCorrection;
+    bool lastWasClipped;
+    double integral; // of the deviation for gaPID, pixels*s
+    short direction; // sign of the corrections for gaResistSwitch, 0 before the first one
+    double period;
+    double model[6]; // offset, drift and two harmonics of the track for gaPredictive
+    double modelOrigin; // time where the model has the offset
+    bool modelIsValid;
+    long framesSinceFit;
+    double computeHysteresis(void);
+    double computeLowPass(void);
+    double computeResistSwitch(void);
+    double computePID(void);
+    double computePredictive(void);
+    bool fitLine(long, double*, double*); // over the last frames; track at the last frame and drift per second
+    void searchPeriod(void);
+    bool fitPeriodicModel(void);
+    double evaluateModel(double);
+};
+
+#endif // TSC_GUIDEALGORITHM_H
@@ -0,0 +1,244 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+
+//---------------------------------------------------
+#include "tsc_guidelog.h"
+#include <QDebug>
+#include <stdlib.h>
+#include <string.h>
+
+static const char guideLogSignature[] = "# TSC guide log";
+static const int guideLogVersion = 1;
+static const char guideLogColumns[] = "time,centroid_x,centroid_y,snr,dev_ra,dev_decl,pulse_ra,pulse_decl,decl_direction,stars";
+
+TSC_GuideLog::TSC_GuideLog(void) {
+    this->logFile = NULL;
+}
+
+//---------------------------------------------------
+TSC_GuideLog::~TSC_GuideLog(void) {
+    this->close();
+    this->segments.clear();
+}
+
+//---------------------------------------------------
+bool TSC_GuideLog::open(const char *fileName) {
+    this->close();
+    this->logFile = fopen(fileName, "a");
+    if (this->logFile == NULL) {
+        qDebug() << "Cannot open the guide log" << fileName;
+        return false;
+    }
+    return true;
+}
+
+//---------------------------------------------------
+void TSC_GuideLog::close(void) {
+    if (this->logFile != NULL) {
+        fclose(this->logFile);
+        this->logFile = NULL;
+    }
+}
+
+//---------------------------------------------------
+bool TSC_GuideLog::isOpen(void) {
+    return (this->logFile != NULL);
+}
+
+//---------------------------------------------------
+void TSC_GuideLog::startSegment(struct guideSegmentStruct *segment) {
+    double values[4];
+
+    if (this->logFile == NULL) {
+        return;
+    }
+    fprintf(this->logFile, "%s %d\n", guideLogSignature, guideLogVersion);
+    this->writeParameter("travel_ms_per_px", segment->travelTime, 2);
+    values[0] = segment->rotation[0][0];
+    values[1] = segment->rotation[0][1];
+    values[2] = segment->rotation[1][0];
+    values[3] = segment->rotation[1][1];
+    this->writeParameter("rotation", values, 4);
+    this->writeParameter("arcsec_per_px", segment->arcsecPerPixel, 2);
+    this->writeParameter("reference", segment->reference, 2);
+    values[0] = segment->declBacklash;
+    values[1] = (segment->backlashCompensated == true);
+    this->writeParameter("decl_backlash", values, 2);
+    values[0] = segment->method[0];
+    values[1] = segment->method[1];
+    this->writeParameter("guide_algorithms", values, 2);
+    fprintf(this->logFile, "%s\n", guideLogColumns);
+    fflush(this->logFile);
+}
+
+//---------------------------------------------------
+void TSC_GuideLog::writeParameter(const char *name, const double *values, short numberOfValues) {
+    short idx;
+
+    if (this->logFile == NULL) {
+        return;
+    }
+    fprintf(this->logFile, "# %s", name);
+    for (idx = 0; idx < numberOfValues; idx++) {
+        fprintf(this->logFile, ",%.6g", values[idx]);
+    }
+    fprintf(this->logFile, "\n");
+    fflush(this->logFile);
+}
+
+//---------------------------------------------------
+void TSC_GuideLog::writeFrame(struct guideFrameStruct *frame) {
+    if (this->logFile == NULL) {
+        return;
+    }
+    fprintf(this->logFile, "%.3f,%.3f,%.3f,%.1f,%.4f,%.4f,%.0f,%.0f,%d,%d\n", frame->time, frame->centroid[0], frame->centroid[1],
+            frame->snr, frame->deviation[0], frame->deviation[1], frame->pulse[0], frame->pulse[1], frame->declDirection, frame->stars);
+    fflush(this->logFile);
+}
+
+//---------------------------------------------------
+// unknown names are skipped, so that parameters can be added without breaking older readers
+void TSC_GuideLog::setParameter(struct guideSegmentStruct *segment, const char *name, const double *values, short numberOfValues) {
+    if ((strcmp(name, "travel_ms_per_px") == 0) && (numberOfValues == 2)) {
+        segment->travelTime[0] = values[0];
+        segment->travelTime[1] = values[1];
+    } else if ((strcmp(name, "rotation") == 0) && (numberOfValues == 4)) {
+        segment->rotation[0][0] = values[0];
+        segment->rotation[0][1] = values[1];
+        segment->rotation[1][0] = values[2];
+        segment->rotation[1][1] = values[3];
+    } else if ((strcmp(name, "arcsec_per_px") == 0) && (numberOfValues == 2)) {
+        segment->arcsecPerPixel[0] = values[0];
+        segment->arcsecPerPixel[1] = values[1];
+    } else if ((strcmp(name, "reference") == 0) && (numberOfValues == 2)) {
+        segment->reference[0] = values[0];
+        segment->reference[1] = values[1];
+    } else if ((strcmp(name, "decl_backlash") == 0) && (numberOfValues == 2)) {
+        segment->declBacklash = (long)values[0];
+        segment->backlashCompensated = (values[1] != 0);
+    } else if ((strcmp(name, "guide_algorithms") == 0) && (numberOfValues == 2)) {
+        segment->method[0] = (short)values[0];
+        segment->method[1] = (short)values[1];
+    }
+}
+
+//---------------------------------------------------
+// a row that does not have all columns, as the last one after a crash, is skipped
+bool TSC_GuideLog::read(const char *fileName) {
+    struct guideSegmentStruct segment;
+    struct guideFrameStruct frame;
+    FILE *infile;
+    char line[512], name[64], *pos, *end;
+    double values[10];
+    short numberOfValues;
+    size_t nameLength;
+    long idx;
+
+    this->segments.clear();
+    infile = fopen(fileName, "r");
+    if (infile == NULL) {
+        qDebug() << "Cannot read the guide log" << fileName;
+        return false;
+    }
+    while (fgets(line, sizeof(line), infile) != NULL) {
+        if (strncmp(line, guideLogSignature, strlen(guideLogSignature)) == 0) {
+            memset(&segment.travelTime, 0, sizeof(segment.travelTime));
+            memset(&segment.rotation, 0, sizeof(segment.rotation));
+            segment.rotation[0][0] = segment.rotation[1][1] = 1;
+            segment.arcsecPerPixel[0] = segment.arcsecPerPixel[1] = 0;
+            segment.reference[0] = segment.reference[1] = 0;
+            segment.declBacklash = 0;
+            segment.backlashCompensated = false;
+            segment.method[0] = segment.method[1] = 0;
+            this->segments.push_back(segment);
+            continue;
+        }
+        if (this->segments.empty() == true) {
+            continue;
+        } // not a guide log, or a row before the first segment
+        numberOfValues = 0;
+        if (line[0] == '#') {
+            pos = line + 1;
+            while (*pos == ' ') {
+                pos++;
+            }
+            nameLength = strcspn(pos, ",\r\n");
+            if ((nameLength == 0) || (nameLength >= sizeof(name))) {
+                continue;
+            }
+            memcpy(name, pos, nameLength);
+            name[nameLength] = 0;
+            pos += nameLength;
+            while ((*pos == ',') && (numberOfValues < 10)) {
+                values[numberOfValues] = strtod(pos + 1, &end);
+                if (end == pos + 1) {
+                    break;
+                }
+                numberOfValues++;
+                pos = end;
+            }
+            this->setParameter(&this->segments.back(), name, values, numberOfValues);
+            continue;
+        }
+        pos = line;
+        while (numberOfValues < 10) {
+            values[numberOfValues] = strtod(pos, &end);
+            if (end == pos) {
+                break;
+            }
+            numberOfValues++;
+            pos = end;
+            if (*pos != ',') {
+                break;
+            }
+            pos++;
+        }
+        if (numberOfValues < 10) {
+            continue;
+        } // the column names, or a torn row
+        frame.time = values[0];
+        frame.centroid[0] = values[1];
+        frame.centroid[1] = values[2];
+        frame.snr = values[3];
+        frame.deviation[0] = values[4];
+        frame.deviation[1] = values[5];
+        frame.pulse[0] = values[6];
+        frame.pulse[1] = values[7];
+        frame.declDirection = (short)values[8];
+        frame.stars = (short)values[9];
+        this->segments.back().frames.push_back(frame);
+    }
+    fclose(infile);
+    for (idx = (long)this->segments.size() - 1; idx >= 0; idx--) {
+        if (this->segments[idx].frames.empty() == true) {
+            this->segments.erase(this->segments.begin() + idx);
+        }
+    } // guiding that was stopped before the first correction
+    return (this->segments.empty() == false);
+}
+
+//---------------------------------------------------
+long TSC_GuideLog::getNumberOfSegments(void) {
+    return (long)this->segments.size();
+}
+
+//---------------------------------------------------
+struct TSC_GuideLog::guideSegmentStruct* TSC_GuideLog::getSegment(long idx) {
+    if ((idx < 0) || (idx >= (long)this->segments.size())) {
+        return NULL;
+    }
+    return &this->segments[idx];
+}
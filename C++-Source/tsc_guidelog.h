@@ -0,0 +1,69 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+// the guiding log of TSC. every start of guiding opens a segment with the calibration and the settings as
+// comment lines, followed by one CSV row per guide frame: the time since the start in s, the centroid of the
+// guide star in pixels of the camera image, its SNR, the deviation in RA and decl in pixels, the guide pulses
+// in ms - positive if the pulse moves the star back against a positive deviation - the direction of the decl
+// drive after the pulse and the number of stars in the offset. the rows are written as they come, so a crash
+// loses at most the last frame. the same class reads a log with all its segments for TSC_GuideReplay.
+
+#ifndef TSC_GUIDELOG_H
+#define TSC_GUIDELOG_H
+
+#include <stdio.h>
+#include <vector>
+
+class TSC_GuideLog {
+public:
+    struct guideFrameStruct {
+        double time; // s since the start of the segment
+        float centroid[2];
+        float snr;
+        float deviation[2]; // RA and decl in pixels
+        float pulse[2]; // ms, signed as above; 0 if none was sent
+        short declDirection; // +1 or -1
+        short stars; // 1 if the guide star alone was used
+    };
+    struct guideSegmentStruct {
+        double travelTime[2]; // ms per pixel in RA and decl from the calibration; 0 if unknown
+        double rotation[2][2]; // camera x and y to RA and decl
+        double arcsecPerPixel[2];
+        double reference[2]; // centroid of the guide star at the start
+        long declBacklash; // in microsteps
+        bool backlashCompensated; // the decl drive takes up the backlash itself
+        short method[2]; // TSC_GuideAlgorithm::guideMethod in RA and decl
+        std::vector<struct guideFrameStruct> frames;
+    };
+    TSC_GuideLog(void);
+    ~TSC_GuideLog(void);
+    bool open(const char*); // appends to an existing log
+    void close(void);
+    bool isOpen(void);
+    void startSegment(struct guideSegmentStruct*); // the frames of the struct are ignored
+    void writeParameter(const char*, const double*, short); // name, values and their number, for anything else worth keeping
+    void writeFrame(struct guideFrameStruct*);
+    bool read(const char*); // false if the file cannot be read or has no frames
+    long getNumberOfSegments(void);
+    struct guideSegmentStruct* getSegment(long);
+
+private:
+    FILE *logFile;
+    std::vector<struct guideSegmentStruct> segments;
+    void setParameter(struct guideSegmentStruct*, const char*, const double*, short); // a comment line that was read
+};
+
+#endif // TSC_GUIDELOG_H
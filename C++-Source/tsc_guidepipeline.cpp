@@ -0,0 +1,408 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+#include "tsc_guidepipeline.h"
+#include <QDebug>
+#include <QString>
+#include <math.h>
+#include <string.h>
+
+//---------------------------------------------------
+TSC_PipelineStage::TSC_PipelineStage(TSC_GuidePipeline *pipe, short stageNo) {
+    this->pipeline = pipe;
+    this->stage = stageNo;
+}
+
+//---------------------------------------------------
+void TSC_PipelineStage::run(void) {
+    this->pipeline->runStage(this->stage);
+}
+
+//---------------------------------------------------
+TSC_GuidePipeline::TSC_GuidePipeline(void) {
+    short idx;
+
+    for (idx = 0; idx < 256; idx++) {
+        this->grayTable.append(qRgb(idx,idx,idx));
+    } // colortable for grayscale QImages
+    for (idx = 0; idx < 3; idx++) {
+        this->stages[idx] = new TSC_PipelineStage(this, idx);
+        this->stageTimeSum[idx] = 0;
+        this->stageFrames[idx] = 0;
+    }
+    this->queueLength = 2;
+    this->isRunning = false;
+    this->frameCounter = 0;
+    this->droppedFrames = 0;
+    this->displaySize[0] = 550;
+    this->displaySize[1] = 400;
+    this->storeImages = false;
+    this->imageCounter = 1;
+    this->starSearch.isActive = false;
+    this->starSearch.position[0] = this->starSearch.position[1] = 0;
+    this->starSearch.threshold = 50;
+    this->starSearch.medianOn = false;
+    this->starSearch.lpOn = false;
+    this->starSearch.contrast = 1.0;
+    this->starSearch.brightness = 0;
+    this->starSearch.FOVFactor = 1.0;
+    this->starSearch.estimator = TSC_Centroid::ceWindowed;
+    this->centroidEngine = new TSC_Centroid();
+    this->fitsDecoder = new TSC_FitsDecoder();
+    this->fitsHeader = new TSC_FitsHeader();
+    this->bufferPool = new TSC_FrameBufferPool();
+    this->clock.start();
+}
+
+//---------------------------------------------------
+TSC_GuidePipeline::~TSC_GuidePipeline(void) {
+    short idx;
+
+    this->stop();
+    for (idx = 0; idx < 3; idx++) {
+        delete this->stages[idx];
+    }
+    delete this->centroidEngine;
+    delete this->fitsDecoder;
+    delete this->fitsHeader;
+    delete this->bufferPool;
+}
+
+//---------------------------------------------------
+void TSC_GuidePipeline::start(void) {
+    short idx;
+
+    this->queueMutex.lock();
+    if (this->isRunning == true) {
+        this->queueMutex.unlock();
+        return;
+    }
+    this->isRunning = true;
+    this->queueMutex.unlock();
+    for (idx = 0; idx < 3; idx++) {
+        this->stages[idx]->start();
+    }
+}
+
+//---------------------------------------------------
+void TSC_GuidePipeline::stop(void) {
+    short idx;
+
+    this->queueMutex.lock();
+    this->isRunning = false;
+    this->frameQueued.wakeAll();
+    this->queueMutex.unlock();
+    for (idx = 0; idx < 3; idx++) {
+        this->stages[idx]->wait();
+    }
+    this->queueMutex.lock();
+    for (idx = 0; idx < 4; idx++) {
+        this->queues[idx].clear();
+    }
+    this->queueMutex.unlock();
+}
+
+//---------------------------------------------------
+// the BLOB belongs to the INDI client and is overwritten by the next one, so the data are copied. this
+// is the only copy of the frame
+bool TSC_GuidePipeline::submitFrame(const char *fitsData, long length, int width, int height, QRect subframe) {
+    struct guideFrameStruct frame;
+
+    if ((fitsData == NULL) || (length < 2880) || (width <= 0) || (height <= 0)) {
+        qDebug() << "Guide camera image without data ...";
+        return false;
+    }
+    if ((subframe.isEmpty() == true) || (QRect(0, 0, width, height).contains(subframe) == false)) {
+        qDebug() << "Guide camera subframe is not on the chip ...";
+        return false;
+    }
+    frame.fitsData = this->bufferPool->getBuffer(length);
+    memcpy(frame.fitsData.data(), fitsData, length);
+    frame.width = width;
+    frame.height = height;
+    frame.bitsPerPixel = 0;
+    frame.subframe = subframe;
+    frame.scalingFactor = 1;
+    frame.starMeasured = false;
+    frame.measurement.starFound = false;
+    frame.arrivalTime = this->clock.nsecsElapsed()/1.0e6;
+    frame.latency = 0;
+    this->queueMutex.lock();
+    if (this->isRunning == false) {
+        this->queueMutex.unlock();
+        return false;
+    }
+    this->frameCounter++;
+    frame.number = this->frameCounter;
+    this->queueMutex.unlock();
+    this->enqueue(psDecode, frame);
+    return true;
+}
+
+//---------------------------------------------------
+bool TSC_GuidePipeline::getFrame(struct guideFrameStruct *frame) {
+    QMutexLocker locker(&this->queueMutex);
+
+    if (this->queues[3].isEmpty() == true) {
+        return false;
+    }
+    *frame = this->queues[3].dequeue();
+    return true;
+}
+
+//---------------------------------------------------
+void TSC_GuidePipeline::setDisplaySize(int w, int h) {
+    QMutexLocker locker(&this->queueMutex);
+
+    if ((w > 0) && (h > 0)) {
+        this->displaySize[0] = w;
+        this->displaySize[1] = h;
+    }
+}
+
+//---------------------------------------------------
+void TSC_GuidePipeline::setStoreImages(bool what) {
+    QMutexLocker locker(&this->queueMutex);
+
+    this->storeImages = what;
+}
+
+//---------------------------------------------------
+void TSC_GuidePipeline::setStarSearch(float ccdX, float ccdY, int gsThreshold, bool medianOn, bool lpOn,
+                                      float cntrst, int briteness, float FOVfact) {
+    QMutexLocker locker(&this->queueMutex);
+
+    this->starSearch.isActive = true;
+    this->starSearch.position[0] = ccdX;
+    this->starSearch.position[1] = ccdY;
+    this->starSearch.threshold = gsThreshold;
+    this->starSearch.medianOn = medianOn;
+    this->starSearch.lpOn = lpOn;
+    this->starSearch.contrast = cntrst;
+    this->starSearch.brightness = briteness;
+    this->starSearch.FOVFactor = FOVfact;
+}
+
+//---------------------------------------------------
+void TSC_GuidePipeline::stopStarSearch(void) {
+    QMutexLocker locker(&this->queueMutex);
+
+    this->starSearch.isActive = false;
+}
+
+//---------------------------------------------------
+void TSC_GuidePipeline::setCentroidEstimator(short est) {
+    QMutexLocker locker(&this->queueMutex);
+
+    this->starSearch.estimator = est;
+}
+
+//---------------------------------------------------
+long TSC_GuidePipeline::getDroppedFrames(void) {
+    QMutexLocker locker(&this->queueMutex);
+
+    return this->droppedFrames;
+}
+
+//---------------------------------------------------
+long TSC_GuidePipeline::getBufferAllocations(void) {
+    return this->bufferPool->getAllocations();
+}
+
+//---------------------------------------------------
+double TSC_GuidePipeline::getStageTime(short stage) {
+    QMutexLocker locker(&this->queueMutex);
+
+    if ((stage < 0) || (stage > 2) || (this->stageFrames[stage] == 0)) {
+        return 0;
+    }
+    return this->stageTimeSum[stage]/this->stageFrames[stage];
+}
+
+//---------------------------------------------------
+// a full queue drops its oldest frame
+void TSC_GuidePipeline::enqueue(short queue, const struct guideFrameStruct &frame) {
+    QMutexLocker locker(&this->queueMutex);
+
+    if (this->isRunning == false) {
+        return;
+    }
+    while (this->queues[queue].size() >= this->queueLength) {
+        this->queues[queue].dequeue();
+        this->droppedFrames++;
+    }
+    this->queues[queue].enqueue(frame);
+    this->frameQueued.wakeAll();
+}
+
+//---------------------------------------------------
+bool TSC_GuidePipeline::dequeue(short queue, struct guideFrameStruct *frame) {
+    QMutexLocker locker(&this->queueMutex);
+
+    while ((this->isRunning == true) && (this->queues[queue].isEmpty() == true)) {
+        this->frameQueued.wait(&this->queueMutex);
+    }
+    if (this->isRunning == false) {
+        return false;
+    }
+    *frame = this->queues[queue].dequeue();
+    return true;
+}
+
+//---------------------------------------------------
+void TSC_GuidePipeline::runStage(short stage) {
+    struct guideFrameStruct frame;
+    QElapsedTimer stageTimer;
+    double ms;
+
+    while (this->dequeue(stage, &frame) == true) {
+        stageTimer.start();
+        if (stage == psDecode) {
+            if (this->decodeFrame(&frame) == false) {
+                continue;
+            }
+        } else if (stage == psDetect) {
+            this->detectStar(&frame);
+        } else {
+            this->prepareDisplay(&frame);
+        }
+        ms = stageTimer.nsecsElapsed()/1.0e6;
+        this->queueMutex.lock();
+        this->stageTimeSum[stage] += ms;
+        this->stageFrames[stage]++;
+        this->queueMutex.unlock();
+        if (stage == psDisplay) {
+            frame.latency = this->clock.nsecsElapsed()/1.0e6 - frame.arrivalTime;
+        }
+        this->enqueue(stage+1, frame);
+        if (stage == psDisplay) {
+            emit this->frameAvailable();
+        }
+    }
+}
+
+//---------------------------------------------------
+// the size, the depth and BZERO of the image are taken from the FITS header. if the image is as large as
+// the subframe that was requested, it is put to its place in an image of the chip, and the rest of the
+// image is black; so the guide star keeps its position. a camera may also ignore the subframe and send
+// the full chip, or bin the pixels; then the image is taken as it is. 8 bit images of the full chip are
+// a view on the BLOB itself. 16 bit data are stretched to 8 bit by the TSC_FitsDecoder so that 2% of the
+// pixels are clipped at either end of the histogram; BSCALE does not change this stretch. the lines are
+// 32 bit aligned, as in a QImage of its own
+bool TSC_GuidePipeline::decodeFrame(struct guideFrameStruct *frame) {
+    TSC_FrameBuffer imageBuffer;
+    const unsigned char *fitsdata;
+    unsigned char *pixels;
+    long imgwidth, imgheight, subwidth, subheight, bytesPerLine, row, headerLength;
+    bool isFullFrame;
+
+    if (this->fitsHeader->parse(frame->fitsData.constData(), frame->fitsData.size()) == false) {
+        qDebug() << "Guide camera image has no valid FITS header ...";
+        return false;
+    }
+    frame->bitsPerPixel = this->fitsHeader->getBitsPerPixel();
+    if ((frame->bitsPerPixel != 8) && (frame->bitsPerPixel != 16)) {
+        qDebug() << "Guide camera images with" << frame->bitsPerPixel << "bits per pixel are not supported ...";
+        return false;
+    }
+    headerLength = this->fitsHeader->getHeaderLength();
+    subwidth = this->fitsHeader->getAxisLength(1);
+    subheight = this->fitsHeader->getAxisLength(2);
+    if (frame->fitsData.size()-headerLength < this->fitsHeader->getDataLength()) {
+        qDebug() << "Guide camera image is shorter than its header says ...";
+        return false;
+    }
+    if ((subwidth != frame->subframe.width()) || (subheight != frame->subframe.height())) {
+        frame->width = subwidth;
+        frame->height = subheight;
+        frame->subframe = QRect(0, 0, subwidth, subheight);
+    }
+    imgwidth = frame->width;
+    imgheight = frame->height;
+    fitsdata = frame->fitsData.constData()+headerLength;
+    isFullFrame = (frame->subframe == QRect(0, 0, imgwidth, imgheight));
+    if ((frame->bitsPerPixel == 8) && (isFullFrame == true)) {
+        frame->image = frame->fitsData.getImageView(headerLength, imgwidth, imgheight, imgwidth, this->grayTable);
+    } else {
+        bytesPerLine = (imgwidth+3)/4*4;
+        imageBuffer = this->bufferPool->getBuffer(bytesPerLine*imgheight);
+        if (isFullFrame == false) {
+            memset(imageBuffer.data(), 0, bytesPerLine*imgheight);
+        }
+        pixels = imageBuffer.data()+frame->subframe.y()*bytesPerLine+frame->subframe.x();
+        if (frame->bitsPerPixel == 8) {
+            for (row = 0; row < subheight; row++) {
+                memcpy(pixels+row*bytesPerLine, fitsdata+row*subwidth, subwidth);
+            }
+        } else if (this->fitsDecoder->decode(fitsdata, subwidth, subheight, this->fitsHeader->getBZero(), pixels, bytesPerLine) == false) {
+            return false;
+        }
+        frame->image = imageBuffer.getImageView(0, imgwidth, imgheight, bytesPerLine, this->grayTable);
+    }
+    frame->fitsData.clear();
+    return true;
+}
+
+//---------------------------------------------------
+// the guide star is searched where the GUI found it in one of the last frames; the result is taken
+// over by ocv_guiding::applyGuideStarMeasurement on the GUI thread
+void TSC_GuidePipeline::detectStar(struct guideFrameStruct *frame) {
+    struct starSearchStruct search;
+
+    this->queueMutex.lock();
+    search = this->starSearch;
+    this->queueMutex.unlock();
+    frame->starMeasured = false;
+    if (search.isActive == false) {
+        return;
+    }
+    this->centroidEngine->setEstimator(search.estimator);
+    frame->starMeasured = ocv_guiding::measureGuideStar(frame->image, search.position[0], search.position[1], search.threshold,
+        search.medianOn, search.lpOn, search.contrast, search.brightness, search.FOVFactor, this->centroidEngine, &frame->measurement);
+}
+
+//---------------------------------------------------
+void TSC_GuidePipeline::prepareDisplay(struct guideFrameStruct *frame) {
+    int widgetWidth, widgetHeight;
+    float sfw, sfh;
+    bool storeImg;
+    long imgNo;
+    QString efilename;
+
+    this->queueMutex.lock();
+    widgetWidth = this->displaySize[0];
+    widgetHeight = this->displaySize[1];
+    storeImg = this->storeImages;
+    imgNo = this->imageCounter;
+    if (storeImg == true) {
+        this->imageCounter++;
+    }
+    this->queueMutex.unlock();
+    if (storeImg == true) {
+        efilename = QString("GuideCameraImage");
+        efilename.append(QString::number(imgNo));
+        efilename.append(".jpg");
+        frame->image.save(efilename,0,-1);
+    }
+    sfw = widgetWidth/(float)frame->width;
+    sfh = widgetHeight/(float)frame->height;
+    if (sfw < sfh) {
+        frame->scalingFactor = sfw;
+    } else {
+        frame->scalingFactor = sfh;
+    } // the scaling factor from the QImage to the QPixmap
+    frame->displayImage = frame->image.scaled(widgetWidth,widgetHeight,Qt::KeepAspectRatio,Qt::FastTransformation);
+}
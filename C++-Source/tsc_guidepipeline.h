@@ -0,0 +1,138 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+// takes the guide camera images from the INDI client through three stages, each of them on a thread of its
+// own: decoding of the FITS data to an 8 bit image, the measurement of the guide star and the preparation
+// of the image for the camera view. the stages are connected by short queues; if a stage cannot keep up,
+// the oldest frame in its queue is dropped, as the guiding loop needs the latest image and not every image.
+// "submitFrame" returns at once, so the next exposure can be started as soon as a BLOB has arrived. the
+// finished frames are picked up with "getFrame" after "frameAvailable" was emitted. QPixmaps may only be
+// made on the GUI thread, so the display stage delivers a scaled QImage. the BLOB is copied once into a buffer
+// of a TSC_FrameBufferPool, and the camera image is a view on a buffer of the pool.
+
+#ifndef TSC_GUIDEPIPELINE_H
+#define TSC_GUIDEPIPELINE_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QQueue>
+#include <QVector>
+#include <QRect>
+#include "ocv_guiding.h"
+#include "tsc_centroid.h"
+#include "tsc_fitsdecoder.h"
+#include "tsc_fitsheader.h"
+#include "tsc_framebufferpool.h"
+
+class TSC_GuidePipeline;
+
+//---------------------------------------------------
+// a thread that runs one stage of the pipeline
+class TSC_PipelineStage : public QThread {
+public:
+    TSC_PipelineStage(TSC_GuidePipeline*, short);
+
+protected:
+    void run(void);
+
+private:
+    TSC_GuidePipeline *pipeline;
+    short stage;
+};
+
+//---------------------------------------------------
+class TSC_GuidePipeline : public QObject {
+    Q_OBJECT
+public:
+    enum pipelineStage {psDecode, psDetect, psDisplay};
+    struct guideFrameStruct {
+        long number;
+        TSC_FrameBuffer fitsData; // the BLOB; released after decoding
+        int width; // of the chip, or of the image if the camera has binned it
+        int height;
+        int bitsPerPixel; // BITPIX of the FITS header
+        QRect subframe; // the part of the chip in the FITS data
+        QImage image; // the 8 bit camera image, a view on a buffer of the pool
+        QImage displayImage; // scaled to the camera view
+        float scalingFactor; // from the camera image to the camera view
+        bool starMeasured;
+        struct ocv_guiding::guideStarMeasurementStruct measurement;
+        double arrivalTime; // ms on the clock of the pipeline
+        double latency; // ms from the arrival of the BLOB to the end of the last stage
+    };
+    TSC_GuidePipeline(void);
+    ~TSC_GuidePipeline(void);
+    void start(void);
+    void stop(void); // waits for the threads; frames in the queues are dropped
+    bool submitFrame(const char*, long, int, int, QRect); // FITS data, length in bytes, chip width, height and the subframe that was requested; called by the INDI thread
+    bool getFrame(struct guideFrameStruct*); // the oldest finished frame; false if there is none
+    void setDisplaySize(int, int);
+    void setStoreImages(bool); // the display stage saves the camera images as jpeg
+    void setStarSearch(float, float, int, bool, bool, float, int, float); // guide star position in pixels of the camera image and the parameters of ocv_guiding::doGuideStarImgProcessing
+    void stopStarSearch(void);
+    void setCentroidEstimator(short); // one of TSC_Centroid::centroidEstimator
+    long getDroppedFrames(void);
+    long getBufferAllocations(void); // full frame buffers allocated so far; stays constant once the pool is filled
+    double getStageTime(short); // mean ms for one frame in a stage
+    void runStage(short); // the loop of a TSC_PipelineStage
+
+private:
+    struct starSearchStruct {
+        bool isActive;
+        float position[2];
+        int threshold;
+        bool medianOn;
+        bool lpOn;
+        float contrast;
+        int brightness;
+        float FOVFactor;
+        short estimator;
+    };
+    TSC_PipelineStage *stages[3];
+    QQueue<struct guideFrameStruct> queues[4]; // the input of each stage and the finished frames
+    int queueLength;
+    QMutex queueMutex; // guards the queues and all the settings
+    QWaitCondition frameQueued;
+    bool isRunning;
+    long frameCounter;
+    long droppedFrames;
+    double stageTimeSum[3];
+    long stageFrames[3];
+    QElapsedTimer clock;
+    int displaySize[2];
+    bool storeImages;
+    long imageCounter;
+    struct starSearchStruct starSearch;
+    TSC_Centroid *centroidEngine; // used by the detection stage only
+    TSC_FitsDecoder *fitsDecoder; // used by the decoding stage only
+    TSC_FitsHeader *fitsHeader; // read by the decoding stage
+    TSC_FrameBufferPool *bufferPool;
+    QVector<QRgb> grayTable;
+    void enqueue(short, const struct guideFrameStruct&);
+    bool dequeue(short, struct guideFrameStruct*); // blocks until a frame is there; false when the pipeline stops
+    bool decodeFrame(struct guideFrameStruct*);
+    void detectStar(struct guideFrameStruct*);
+    void prepareDisplay(struct guideFrameStruct*);
+
+signals:
+    void frameAvailable(void); // a frame has passed all stages
+};
+
+#endif // TSC_GUIDEPIPELINE_H
@@ -0,0 +1,256 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+//---------------------------------------------------
+#include "tsc_horizonmask.h"
+#include "tsc_globaldata.h"
+#include <QDebug>
+#include <math.h>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+extern TSC_GlobalData *g_AllData;
+
+TSC_HorizonMask::TSC_HorizonMask(void) {
+    this->minAltitude = 0;
+    this->haLimitEast = 180;
+    this->haLimitWest = 180;
+    this->setLatitude(45.0);
+    this->buildTable();
+}
+
+//---------------------------------------------------
+TSC_HorizonMask::~TSC_HorizonMask(void) {
+    this->profile.clear();
+}
+
+//---------------------------------------------------
+void TSC_HorizonMask::setLatitude(double lat) {
+    this->latitude = lat;
+}
+
+//---------------------------------------------------
+void TSC_HorizonMask::setMountLimits(double minAlt, double haEast, double haWest) {
+    this->minAltitude = minAlt;
+    this->haLimitEast = fmin(180.0, fabs(haEast));
+    this->haLimitWest = fmin(180.0, fabs(haWest));
+    this->buildTable();
+}
+
+//---------------------------------------------------
+void TSC_HorizonMask::clearHorizon(void) {
+    this->profile.clear();
+    this->buildTable();
+}
+
+//---------------------------------------------------
+void TSC_HorizonMask::addHorizonPoint(double az, double alt) {
+    struct horizonPoint point;
+
+    while (az < 0) {
+        az += 360;
+    }
+    while (az >= 360) {
+        az -= 360;
+    }
+    point.az = az;
+    point.alt = alt;
+    this->profile.push_back(point);
+    std::sort(this->profile.begin(), this->profile.end(),
+              [](const horizonPoint &a, const horizonPoint &b) { return a.az < b.az; });
+    this->buildTable();
+}
+
+//---------------------------------------------------
+// reading a .tsh file with the same layout as a sequence file
+// number of points
+// Azimuth[deg],Altitude[deg]
+bool TSC_HorizonMask::loadHorizon(QString filename) {
+    std::string line;
+    double az, alt;
+    long counter, numberOfPoints = 0;
+    char delimiter(',');
+    QByteArray ba = filename.toLatin1();
+    const char *cfilename = ba.data();
+    std::vector<horizonPoint> points;
+    struct horizonPoint point;
+
+    std::ifstream infile(cfilename);
+    if (!infile.is_open()) {
+        qDebug() << "Horizon file" << filename << "could not be opened";
+        return false;
+    }
+    std::getline(infile, line);
+    std::istringstream isNumber(line);
+    isNumber >> numberOfPoints;
+    for (counter = 0; counter < numberOfPoints; counter++) {
+        if (!std::getline(infile, line, delimiter)) {
+            break;
+        }
+        std::istringstream isAz(line);
+        std::getline(infile, line);
+        std::istringstream isAlt(line);
+        if ((isAz >> az) && (isAlt >> alt)) {
+            point.az = fmod(fmod(az, 360.0) + 360.0, 360.0);
+            point.alt = alt;
+            points.push_back(point);
+        }
+    }
+    infile.close();
+    if (points.empty() == true) {
+        return false;
+    }
+    std::sort(points.begin(), points.end(), [](const horizonPoint &a, const horizonPoint &b) { return a.az < b.az; });
+    this->profile = points;
+    this->buildTable();
+    return true;
+}
+
+//---------------------------------------------------
+long TSC_HorizonMask::getNumberOfHorizonPoints(void) {
+    return this->profile.size();
+}
+
+//---------------------------------------------------
+double TSC_HorizonMask::getHorizonPoint(long idx, short what) {
+    if ((idx < 0) || (idx >= (long)this->profile.size())) {
+        return 0;
+    }
+    if (what == 0) {
+        return this->profile[idx].az;
+    }
+    return this->profile[idx].alt;
+}
+
+//---------------------------------------------------
+// linear interpolation between the points of the profile; the profile is closed across north
+void TSC_HorizonMask::buildTable(void) {
+    long entry, next;
+    size_t idx = 0, n;
+    double az, az0, az1, alt;
+
+    n = this->profile.size();
+    for (entry = 0; entry < 3600; entry++) {
+        az = entry*0.1;
+        if (n == 0) {
+            alt = -90;
+        } else if (n == 1) {
+            alt = this->profile[0].alt;
+        } else {
+            while ((idx < n) && (this->profile[idx].az <= az)) {
+                idx++;
+            } // idx is the first point east of the azimuth
+            if ((idx == 0) || (idx == n)) {
+                az0 = this->profile[n-1].az;
+                az1 = this->profile[0].az + 360;
+                if (az < az0) {
+                    az += 360;
+                }
+                next = 0;
+                alt = this->profile[n-1].alt;
+            } else {
+                az0 = this->profile[idx-1].az;
+                az1 = this->profile[idx].az;
+                next = idx;
+                alt = this->profile[idx-1].alt;
+            }
+            if (az1 - az0 > 1e-6) {
+                alt += (this->profile[next].alt - alt)*(az - az0)/(az1 - az0);
+            }
+        }
+        this->altitudeTable[entry] = fmax(alt, this->minAltitude);
+    }
+}
+
+//---------------------------------------------------
+double TSC_HorizonMask::getMinimumAltitude(double az) {
+    long entry;
+
+    entry = lround(az*10.0) % 3600;
+    if (entry < 0) {
+        entry += 3600;
+    }
+    return this->altitudeTable[entry];
+}
+
+//---------------------------------------------------
+// a GEM flips so that the tube is on the east side of the pier for objects west of the meridian, as in
+// MainWindow::checkForFlip; other mounts stay as they are
+bool TSC_HorizonMask::isEastAfterGoTo(double ha) {
+    if (g_AllData->getMFlipParams(0) == false) {
+        return g_AllData->getMFlipParams(1);
+    }
+    return ((ha >= 0) && (ha < 180));
+}
+
+//---------------------------------------------------
+// the hour angle has to be in [-180, 180]. the distance of the tube from the meridian plane is the sine of the
+// hour angle past the meridian times the cosine of the declination; on the equator, it reaches the limit at
+// the hour angle of the limit. limits of 6 hours and more are taken as plain hour angles
+bool TSC_HorizonMask::clearsPier(double ha, double decl, bool isEast) {
+    double pastMeridian, limit;
+
+    if (isEast == true) {
+        pastMeridian = -ha;
+        limit = this->haLimitEast;
+    } else {
+        pastMeridian = ha;
+        limit = this->haLimitWest;
+    } // the tube on the east side of the pier points to the west; it must not track too far to the east
+    if (pastMeridian <= limit) {
+        return true;
+    }
+    if (limit >= 90) {
+        return false;
+    }
+    return (cos(decl/180.0*M_PI)*sin(pastMeridian/180.0*M_PI) <= sin(limit/180.0*M_PI));
+}
+
+//---------------------------------------------------
+bool TSC_HorizonMask::isReachable(double ha, double decl) {
+    while (ha > 180) {
+        ha -= 360;
+    }
+    while (ha < -180) {
+        ha += 360;
+    } // negative hour angles are east of the meridian
+    return this->isReachableOnSide(ha, decl, this->isEastAfterGoTo(ha));
+}
+
+//---------------------------------------------------
+bool TSC_HorizonMask::isReachableOnSide(double ha, double decl, bool isEast) {
+    double alt, az;
+
+    while (ha > 180) {
+        ha -= 360;
+    }
+    while (ha < -180) {
+        ha += 360;
+    }
+    if (this->clearsPier(ha, decl, isEast) == false) {
+        return false;
+    }
+    TSC_Refraction::convertHADeclToAltAz(ha, decl, this->latitude, &alt, &az);
+    return (alt >= this->getMinimumAltitude(az));
+}
+
+//---------------------------------------------------
+// for positions that were converted in a batch; the hour angle has to be in [-180, 180]
+bool TSC_HorizonMask::isReachableAltAz(double ha, double decl, double alt, double az) {
+    if (this->clearsPier(ha, decl, this->isEastAfterGoTo(ha)) == false) {
+        return false;
+    }
+    return (alt >= this->getMinimumAltitude(az));
+}
@@ -0,0 +1,65 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+//---------------------------------------------------
+// a class that tells whether a position can be reached by the telescope. the horizon profile of the site gives
+// the lowest free altitude for a number of azimuths (trees, buildings); in addition, the mount has a minimum
+// altitude, and the tube hits the pier if it tracks too far past the meridian. the limits east and west give
+// how far the tube may cross the meridian on the celestial equator, with the tube on the east and on the west
+// side of the pier. closer to the pole, the tube stays closer to the polar axis and clears the pier at larger
+// hour angles; the distance of the tube from the meridian plane is what counts. without a side, a position is
+// checked for the side the mount is on after a GoTo. the profile is interpolated into a table with one entry
+// per 0.1 degrees of azimuth, so a query does not depend on the number of points. azimuth is counted from
+// north over east, hour angles from the meridian to the west; all angles in degrees.
+
+#ifndef TSC_HORIZONMASK_H
+#define TSC_HORIZONMASK_H
+
+#include <QString>
+#include <vector>
+#include "tsc_refraction.h"
+
+class TSC_HorizonMask {
+public:
+    TSC_HorizonMask(void);
+    ~TSC_HorizonMask(void);
+    void setLatitude(double);
+    void setMountLimits(double, double, double); // minimum altitude, hour angles past the meridian to the east and to the west
+    void clearHorizon(void);
+    void addHorizonPoint(double, double); // azimuth and lowest free altitude
+    bool loadHorizon(QString); // replaces the profile by the one in a horizon file; false if nothing could be read
+    long getNumberOfHorizonPoints(void);
+    double getHorizonPoint(long, short); // 0 is azimuth, 1 is altitude
+    double getMinimumAltitude(double); // lowest altitude that can be reached at an azimuth
+    bool isReachable(double, double); // hour angle and decl
+    bool isReachableOnSide(double, double, bool); // hour angle, decl and true if the tube is on the east side of the pier
+    bool isReachableAltAz(double, double, double, double); // hour angle, decl, and the altitude and azimuth that are already known
+
+private:
+    struct horizonPoint {
+        double az;
+        double alt;
+    };
+    std::vector<horizonPoint> profile; // sorted by azimuth
+    float altitudeTable[3600]; // the profile and the minimum altitude combined
+    double latitude;
+    double minAltitude;
+    double haLimitEast;
+    double haLimitWest;
+    void buildTable(void);
+    bool isEastAfterGoTo(double); // hour angle
+    bool clearsPier(double, double, bool); // hour angle, decl, tube on the east side
+};
+
+#endif // TSC_HORIZONMASK_H
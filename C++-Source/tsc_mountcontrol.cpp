@@ -0,0 +1,224 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+#include "tsc_mountcontrol.h"
+#include "tsc_globaldata.h"
+#include <math.h>
+
+extern TSC_GlobalData *g_AllData;
+
+TSC_MountControl::TSC_MountControl(QtContinuousStepper *raDrive, QtKineticStepper *declDrive, TSC_SlewPlanner *planner,
+                                   TSC_SlewTimeModel *timeModel) {
+    this->StepperDriveRA = raDrive;
+    this->StepperDriveDecl = declDrive;
+    this->slewPlanner = planner;
+    this->slewTimeModel = timeModel;
+    this->horizonMask = NULL;
+    this->guideAlgorithm[0] = NULL;
+    this->guideAlgorithm[1] = NULL;
+    this->rotMatrixGuidingXToRA[0][0] = 1;
+    this->rotMatrixGuidingXToRA[0][1] = 0;
+    this->rotMatrixGuidingXToRA[1][0] = 0;
+    this->rotMatrixGuidingXToRA[1][1] = 1;
+    this->travelTimeInMSForOnePix[0] = 0;
+    this->travelTimeInMSForOnePix[1] = 0;
+    this->declIsSwitched = false;
+}
+
+//---------------------------------------------------
+TSC_MountControl::~TSC_MountControl(void) {
+}
+
+//---------------------------------------------------
+void TSC_MountControl::setHorizonMask(TSC_HorizonMask *mask) {
+    this->horizonMask = mask;
+}
+
+//---------------------------------------------------
+double TSC_MountControl::getMicrostepsPerDegree(short axis) {
+    if (axis == 0) {
+        return (1.0/g_AllData->getGearData(3)*g_AllData->getMicroSteppingRatio(2)*
+                g_AllData->getGearData(0)*g_AllData->getGearData(1)*g_AllData->getGearData(2));
+    }
+    return (1.0/g_AllData->getGearData(7)*g_AllData->getMicroSteppingRatio(2)*
+            g_AllData->getGearData(4)*g_AllData->getGearData(5)*g_AllData->getGearData(6));
+}
+
+//---------------------------------------------------
+// the scope keeps its RA while it tracks; the RA it had at the last sync is carried on by the motion of the sky
+double TSC_MountControl::getShortestRATravel(double scopeRA, double targetRA) {
+    double travelRA, absShortRATravel;
+
+    travelRA = scopeRA - targetRA;
+    if (fabs(travelRA) > 180) {
+        absShortRATravel = 360.0 - fabs(travelRA);
+        if (travelRA > 0) {
+            travelRA = -absShortRATravel;
+        } else {
+            travelRA = absShortRATravel;
+        }
+    } // determine the shorter travel path
+    return travelRA;
+}
+
+//---------------------------------------------------
+// the speed and acceleration of the controllers are the upper limits for the planner, which lowers them for the
+// axis that has less to travel. the straight line between two reachable positions may still dip below the horizon;
+// then one axis moves first
+bool TSC_MountControl::planGoTo(double ha, double decl, double travelRA, double travelDecl, double goToSpeed, bool checkPath) {
+    double convertDegreesToMicrostepsRA, convertDegreesToMicrostepsDecl, speedRA, speedDecl;
+
+    convertDegreesToMicrostepsRA = this->getMicrostepsPerDegree(0);
+    convertDegreesToMicrostepsDecl = this->getMicrostepsPerDegree(1);
+    speedRA = round(round(goToSpeed)*g_AllData->getCelestialSpeed()*convertDegreesToMicrostepsRA);
+    speedDecl = round(round(goToSpeed)*g_AllData->getCelestialSpeed()*convertDegreesToMicrostepsDecl); // the speed the drives will be set to in travelForNSteps
+    this->slewPlanner->setAxis(0, convertDegreesToMicrostepsRA, speedRA, this->StepperDriveRA->getKineticsFromController(2));
+    this->slewPlanner->setAxis(1, convertDegreesToMicrostepsDecl, speedDecl, this->StepperDriveDecl->getKineticsFromController(2));
+    this->slewPlanner->setTimeModel(0, this->slewTimeModel->getParameter(0,0), this->slewTimeModel->getParameter(0,1));
+    this->slewPlanner->setTimeModel(1, this->slewTimeModel->getParameter(1,0), this->slewTimeModel->getParameter(1,1));
+    this->slewPlanner->setSkyRate(0, g_AllData->getCelestialSpeed()); // the earth moves on during the slew in RA
+    this->slewPlanner->clearWaypoints();
+    if ((checkPath == true) && (this->horizonMask != NULL) && (this->isSlewPathReachable(ha, decl, travelRA, travelDecl) == false)) {
+        if ((this->isSlewPathReachable(ha, decl, travelRA, 0) == true) &&
+            (this->isSlewPathReachable(ha + travelRA, decl, 0, travelDecl) == true)) {
+            this->slewPlanner->addWaypoint(travelRA, 0);
+        } else if ((this->isSlewPathReachable(ha, decl, 0, travelDecl) == true) &&
+                   (this->isSlewPathReachable(ha, decl + travelDecl, travelRA, 0) == true)) {
+            this->slewPlanner->addWaypoint(0, travelDecl);
+        } else {
+            return false;
+        }
+    }
+    this->slewPlanner->planSlew(travelRA, travelDecl); // the compensation of the earth motion is computed for every segment
+    return true;
+}
+
+//---------------------------------------------------
+// samples the straight path of a slew in hour angle and declination; true if it stays within the horizon and the mount
+// limits. the path is only checked for GoTos without a meridian flip, so the tube stays on its side of the pier
+bool TSC_MountControl::isSlewPathReachable(double ha, double ldecl, double travelHA, double travelDecl) {
+    const short samples = 20;
+    short cnt;
+
+    this->horizonMask->setLatitude(g_AllData->getSiteCoords(0));
+    for (cnt = 1; cnt < samples; cnt++) {
+        if (this->horizonMask->isReachableOnSide(ha + travelHA*cnt/samples, ldecl + travelDecl*cnt/samples,
+                                                 g_AllData->getMFlipParams(1)) == false) {
+            return false;
+        }
+    } // start and end were checked before
+    return true;
+}
+
+//---------------------------------------------------
+// an axis that does not move in a segment keeps tracking, or stands still in declination. a GoTo to the position
+// where the mount is moves both axes by zero steps and ends in the next tick of the event queue
+bool TSC_MountControl::movesInSegment(long segment, short axis) {
+    return ((this->slewPlanner->getSegmentSteps(segment, axis) > 0) || (this->slewPlanner->getSegmentSteps(segment, 1 - axis) == 0));
+}
+
+//---------------------------------------------------
+// the axis is set to the speed and acceleration of the plan so that both axes arrive together
+void TSC_MountControl::startSegment(long segment, short axis) {
+    long steps;
+    double speed, acc;
+
+    steps = this->slewPlanner->getSegmentSteps(segment, axis);
+    speed = this->slewPlanner->getSegmentSpeed(segment, axis);
+    acc = round(this->slewPlanner->getSegmentAcceleration(segment, axis));
+    this->slewTimeModel->startSlew(axis, steps, speed, acc); // the measured durations are used to refine the ETA
+    if (axis == 0) {
+        this->StepperDriveRA->changeMicroSteps(g_AllData->getMicroSteppingRatio(2));
+        this->StepperDriveRA->setStepperParams(acc, 1);
+        this->StepperDriveRA->travelForNSteps(steps, this->slewPlanner->getSegmentDirection(segment, 0),
+                                              speed/(g_AllData->getCelestialSpeed()*this->getMicrostepsPerDegree(0)), false);
+    } else {
+        this->StepperDriveDecl->changeMicroSteps(g_AllData->getMicroSteppingRatio(2));
+        this->StepperDriveDecl->setStepperParams(acc, 1);
+        this->StepperDriveDecl->travelForNSteps(steps, this->slewPlanner->getSegmentDirection(segment, 1),
+                                                speed/(g_AllData->getCelestialSpeed()*this->getMicrostepsPerDegree(1)), 0);
+    }
+}
+
+//---------------------------------------------------
+// the planner may have lowered the acceleration, and the declination drive goes back to the microstep ratio for guiding
+void TSC_MountControl::finishGoTo(double accRA, double accDecl, double currentDecl) {
+    this->slewTimeModel->cancelSlews(); // a slew that was stopped does not tell anything about the duration of a GoTo
+    this->StepperDriveDecl->changeMicroSteps(g_AllData->getMicroSteppingRatio(0));
+    this->StepperDriveRA->setStepperParams(accRA, 1);
+    this->StepperDriveDecl->setStepperParams(accDecl, 1);
+    this->StepperDriveDecl->setInitialParamsAndComputeBaseSpeed(accDecl, currentDecl);
+}
+
+//---------------------------------------------------
+void TSC_MountControl::setGuideAlgorithms(TSC_GuideAlgorithm *raAlgorithm, TSC_GuideAlgorithm *declAlgorithm) {
+    this->guideAlgorithm[0] = raAlgorithm;
+    this->guideAlgorithm[1] = declAlgorithm;
+}
+
+//---------------------------------------------------
+void TSC_MountControl::setGuideCalibration(double rotMatrix[2][2], double travelTimeRA, double travelTimeDecl) {
+    this->rotMatrixGuidingXToRA[0][0] = rotMatrix[0][0];
+    this->rotMatrixGuidingXToRA[0][1] = rotMatrix[0][1];
+    this->rotMatrixGuidingXToRA[1][0] = rotMatrix[1][0];
+    this->rotMatrixGuidingXToRA[1][1] = rotMatrix[1][1];
+    this->travelTimeInMSForOnePix[0] = travelTimeRA;
+    this->travelTimeInMSForOnePix[1] = travelTimeDecl;
+}
+
+//---------------------------------------------------
+// the longest pulse is 2 s; the algorithms limit their corrections accordingly
+void TSC_MountControl::setGuideParameters(double minMove, double aggressiveness, double hysteresisWeight, bool switchDecl) {
+    short axis;
+
+    for (axis = 0; axis < 2; axis++) {
+        this->guideAlgorithm[axis]->setParameters(minMove, aggressiveness, hysteresisWeight);
+        if (this->travelTimeInMSForOnePix[axis] > 0) {
+            this->guideAlgorithm[axis]->setMaximumCorrection(2000.0/this->travelTimeInMSForOnePix[axis]);
+        }
+    }
+    this->declIsSwitched = switchDecl;
+}
+
+//---------------------------------------------------
+void TSC_MountControl::resetGuiding(void) {
+    this->guideAlgorithm[0]->reset(); // a new reference; the algorithms forget the past frames
+    this->guideAlgorithm[1]->reset();
+}
+
+//---------------------------------------------------
+// the deviation vector is rotated to the ra/decl coordinate system; the mount has to move in the other direction
+void TSC_MountControl::computeGuideStep(double devX, double devY, double frameTime, struct guideStepStruct *step) {
+    short axis;
+
+    step->deviation[0] = this->rotMatrixGuidingXToRA[0][0]*devX + this->rotMatrixGuidingXToRA[0][1]*devY;
+    step->deviation[1] = this->rotMatrixGuidingXToRA[1][0]*devX + this->rotMatrixGuidingXToRA[1][1]*devY;
+    for (axis = 0; axis < 2; axis++) {
+        step->correction[axis] = this->guideAlgorithm[axis]->computeCorrection(step->deviation[axis], frameTime);
+        step->pulseDuration[axis] = round(this->travelTimeInMSForOnePix[axis]*fabs(step->correction[axis]));
+        if (step->pulseDuration[axis] > 2000) {
+            step->pulseDuration[axis] = 2000;
+        }
+    }
+    if (step->correction[0] > 0) {
+        step->pulseDirection[0] = -1;
+    } else {
+        step->pulseDirection[0] = 1;
+    }
+    if ((step->correction[1] < 0) != this->declIsSwitched) {
+        step->pulseDirection[1] = -1;
+    } else {
+        step->pulseDirection[1] = 1;
+    }
+}
@@ -0,0 +1,70 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+// the parts of a GoTo and of a guide step that command the drives and do not depend on the GUI. MainWindow and
+// the night benchmark of the simulator both call them, so that the benchmark measures the code that runs on the
+// mount. the callers keep the rest: MainWindow the GUI, the position readings and the event queue that detects
+// the end of a slew, the benchmark the virtual clock. a GoTo is planned with planGoTo and carried out segment by
+// segment with startSegment; finishGoTo restores the drives. a guide step turns the deviation of the guide star
+// on the chip into pulses for both axes, which the caller carries out. angles are given in decimal degrees.
+
+#ifndef TSC_MOUNTCONTROL_H
+#define TSC_MOUNTCONTROL_H
+
+#include "QtContinuousStepper.h"
+#include "QtKineticStepper.h"
+#include "tsc_slewplanner.h"
+#include "tsc_slewtimemodel.h"
+#include "tsc_horizonmask.h"
+#include "tsc_guidealgorithm.h"
+
+class TSC_MountControl {
+public:
+    TSC_MountControl(QtContinuousStepper*, QtKineticStepper*, TSC_SlewPlanner*, TSC_SlewTimeModel*); // none of them is owned
+    ~TSC_MountControl(void);
+    void setHorizonMask(TSC_HorizonMask*); // NULL plans without checking the path; it is not owned
+    double getShortestRATravel(double, double); // RA the scope points to and target RA -> travel in RA of less than 180 degrees
+    bool planGoTo(double, double, double, double, double, bool); // HA and decl at the start, travel in RA and decl, GoTo speed in
+                                                                 // multiples of the sidereal speed, check the path -> false if there is no clear path
+    bool movesInSegment(long, short); // segment, axis 0 is RA, 1 is decl
+    void startSegment(long, short); // starts the drive of an axis that moves in the segment
+    void finishGoTo(double, double, double); // acceleration of RA and decl and current of decl that were set in the controllers before
+    void setGuideAlgorithms(TSC_GuideAlgorithm*, TSC_GuideAlgorithm*); // RA and decl; they are not owned
+    void setGuideCalibration(double[2][2], double, double); // rotation from the chip to RA and decl, ms for a correction of one pixel in RA and decl
+    void setGuideParameters(double, double, double, bool); // minimum move in pixels, aggressiveness, hysteresis weight, decl pulses switched
+    void resetGuiding(void); // a new reference star
+    struct guideStepStruct {
+        double deviation[2]; // the deviation of the star in RA and decl in pixels
+        double correction[2]; // from the guide algorithms in pixels; 0 leaves the axis alone
+        long pulseDuration[2]; // in ms
+        short pulseDirection[2]; // for the pulse guide routines of RA and decl
+    };
+    void computeGuideStep(double, double, double, struct guideStepStruct*); // deviation from the reference on the chip in pixels,
+                                                                            // time since the reference in s
+
+private:
+    QtContinuousStepper *StepperDriveRA;
+    QtKineticStepper *StepperDriveDecl;
+    TSC_SlewPlanner *slewPlanner;
+    TSC_SlewTimeModel *slewTimeModel;
+    TSC_HorizonMask *horizonMask;
+    TSC_GuideAlgorithm *guideAlgorithm[2];
+    double rotMatrixGuidingXToRA[2][2];
+    double travelTimeInMSForOnePix[2];
+    bool declIsSwitched; // the "Switch Decl" checkbox of MainWindow
+    double getMicrostepsPerDegree(short); // at the GoTo microstep ratio
+    bool isSlewPathReachable(double, double, double, double);
+};
+
+#endif // TSC_MOUNTCONTROL_H
@@ -0,0 +1,162 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+#include "tsc_refraction.h"
+#include <math.h>
+
+TSC_Refraction::TSC_Refraction(void) {
+    this->temperature = 10.0;
+    this->pressure = 1010.0; // standard atmosphere as used in the formulae by saemundsson and bennett
+}
+
+//---------------------------------------------------
+TSC_Refraction::~TSC_Refraction(void) {
+}
+
+//---------------------------------------------------
+// the temperature comes from the sensor on the HAT, the pressure is entered on the main tab
+void TSC_Refraction::setAtmosphericConditions(float temp, float press) {
+    if ((temp > -40) && (temp < 80)) {
+        this->temperature = temp;
+    }
+    if ((press > 300) && (press <= 1100)) {
+        this->pressure = press;
+    }
+}
+
+//---------------------------------------------------
+// refraction for a true altitude after saemundsson, J. Meeus, 2. ed, p.106; scaled for
+// temperature and pressure. returns the value in degrees
+double TSC_Refraction::getRefraction(double trueAlt) {
+    double refrInArcMin, hDeg;
+
+    if (trueAlt < -1.0) {
+        return 0.0; // the object is below the horizon - nothing to compensate
+    }
+    hDeg = trueAlt + 10.3/(trueAlt + 5.11);
+    refrInArcMin = 1.02/tan(hDeg/180.0*M_PI);
+    refrInArcMin *= (this->pressure/1010.0)*(283.0/(273.0 + this->temperature));
+    return (refrInArcMin/60.0);
+}
+
+//---------------------------------------------------
+// altitude of an object given by hour angle and declination for a given latitude
+double TSC_Refraction::getAltitude(double ha, double decl, double lat) {
+    double alt, az;
+
+    this->convertHADeclToAltAz(ha, decl, lat, &alt, &az);
+    return alt;
+}
+
+//---------------------------------------------------
+// convert catalog coordinates to the position where the object is actually seen
+void TSC_Refraction::getApparentPosition(double ra, double decl, double lst, double lat, double *appRA, double *appDecl) {
+    this->shiftPosition(ra, decl, lst, lat, true, appRA, appDecl);
+}
+
+//---------------------------------------------------
+// convert an apparent position, for instance the position of the mount, back to catalog coordinates
+void TSC_Refraction::getTruePosition(double appRA, double appDecl, double lst, double lat, double *ra, double *decl) {
+    this->shiftPosition(appRA, appDecl, lst, lat, false, ra, decl);
+}
+
+//---------------------------------------------------
+// the change of refraction with time causes an additional motion of the object on top of earth rotation.
+// it is determined by comparing the apparent position now and one minute later.
+void TSC_Refraction::getRefractionRates(double ra, double decl, double lst, double lat, double *haRate, double *declRate) {
+    const double deltaT = 60.0; // time in seconds for the finite difference
+    double appRANow, appDeclNow, appRALater, appDeclLater, lstLater, deltaRA;
+
+    lstLater = lst + deltaT*1.00273791/3600.0;
+    this->getApparentPosition(ra, decl, lst, lat, &appRANow, &appDeclNow);
+    this->getApparentPosition(ra, decl, lstLater, lat, &appRALater, &appDeclLater);
+    deltaRA = appRANow - appRALater;
+    if (deltaRA > 180) {
+        deltaRA -= 360;
+    }
+    if (deltaRA < -180) {
+        deltaRA += 360;
+    } // an increasing apparent hour angle is a decreasing apparent right ascension
+    *haRate = deltaRA/deltaT;
+    *declRate = (appDeclLater - appDeclNow)/deltaT;
+}
+
+//---------------------------------------------------
+// azimuth is counted from north to east, from -180 to 180; the horizon mask uses the same conversion
+void TSC_Refraction::convertHADeclToAltAz(double ha, double decl, double lat, double *alt, double *az) {
+    double haRad, declRad, latRad, sinAlt;
+
+    haRad = ha/180.0*M_PI;
+    declRad = decl/180.0*M_PI;
+    latRad = lat/180.0*M_PI;
+    sinAlt = sin(latRad)*sin(declRad) + cos(latRad)*cos(declRad)*cos(haRad);
+    if (sinAlt > 1) {
+        sinAlt = 1;
+    }
+    if (sinAlt < -1) {
+        sinAlt = -1;
+    }
+    *alt = asin(sinAlt)/M_PI*180.0;
+    *az = atan2(-cos(declRad)*sin(haRad), sin(declRad)*cos(latRad) - cos(declRad)*cos(haRad)*sin(latRad))/M_PI*180.0;
+}
+
+//---------------------------------------------------
+// the inverse transform has the same structure as the forward transform
+void TSC_Refraction::convertAltAzToHADecl(double alt, double az, double lat, double *ha, double *decl) {
+    double altRad, azRad, latRad, sinDecl;
+
+    altRad = alt/180.0*M_PI;
+    azRad = az/180.0*M_PI;
+    latRad = lat/180.0*M_PI;
+    sinDecl = sin(latRad)*sin(altRad) + cos(latRad)*cos(altRad)*cos(azRad);
+    if (sinDecl > 1) {
+        sinDecl = 1;
+    }
+    if (sinDecl < -1) {
+        sinDecl = -1;
+    }
+    *decl = asin(sinDecl)/M_PI*180.0;
+    *ha = atan2(-cos(altRad)*sin(azRad), sin(altRad)*cos(latRad) - cos(altRad)*cos(azRad)*sin(latRad))/M_PI*180.0;
+}
+
+//---------------------------------------------------
+// lifts (or lowers) an object along its vertical circle by the amount of refraction. for the inverse,
+// bennett's formula for the apparent altitude is used, J. Meeus, 2. ed, p.106
+void TSC_Refraction::shiftPosition(double ra, double decl, double lst, double lat, bool toApparent,
+                                   double *newRA, double *newDecl) {
+    double ha, alt, az, newHA, hDeg, refr;
+
+    ha = lst*15.0 - ra;
+    this->convertHADeclToAltAz(ha, decl, lat, &alt, &az);
+    if (toApparent == true) {
+        alt += this->getRefraction(alt);
+    } else {
+        if (alt > -1.0) {
+            hDeg = alt + 7.31/(alt + 4.4);
+            refr = (1.0/tan(hDeg/180.0*M_PI))*(this->pressure/1010.0)*(283.0/(273.0 + this->temperature));
+            alt -= refr/60.0;
+        }
+    }
+    if (alt > 90) {
+        alt = 90;
+    }
+    this->convertAltAzToHADecl(alt, az, lat, &newHA, newDecl);
+    *newRA = lst*15.0 - newHA;
+    while (*newRA < 0) {
+        *newRA += 360;
+    }
+    while (*newRA >= 360) {
+        *newRA -= 360;
+    }
+}
@@ -0,0 +1,41 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+// a class that models atmospheric refraction; it converts true (catalog) positions to apparent positions
+// and computes the additional rates in hour angle and declination caused by the change of refraction
+// while an object is tracked. all angles are given in decimal degrees.
+
+#ifndef TSC_REFRACTION_H
+#define TSC_REFRACTION_H
+
+class TSC_Refraction {
+public:
+    TSC_Refraction(void);
+    ~TSC_Refraction(void);
+    void setAtmosphericConditions(float, float); // temperature in degrees centigrade and pressure in hPa
+    double getRefraction(double); // refraction in degrees for a true altitude in degrees
+    double getAltitude(double, double, double); // altitude for hour angle, declination and latitude
+    void getApparentPosition(double, double, double, double, double*, double*); // RA, decl, LST in hours, latitude -> apparent RA and decl
+    void getTruePosition(double, double, double, double, double*, double*); // inverse of the above
+    void getRefractionRates(double, double, double, double, double*, double*); // RA, decl, LST in hours, latitude -> additional rate in HA and decl in degrees/s
+    static void convertHADeclToAltAz(double, double, double, double*, double*); // hour angle, decl, latitude -> altitude and azimuth
+
+private:
+    double temperature; // ambient temperature in degrees centigrade
+    double pressure; // ambient pressure in hPa
+    void convertAltAzToHADecl(double, double, double, double*, double*);
+    void shiftPosition(double, double, double, double, bool, double*, double*);
+};
+
+#endif // TSC_REFRACTION_H
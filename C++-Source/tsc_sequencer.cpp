@@ -0,0 +1,328 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+#include "tsc_sequencer.h"
+#include <QDebug>
+#include <math.h>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+TSC_Sequencer::TSC_Sequencer(void) {
+    this->raSpeed = 1.0;
+    this->raAcc = 1.0;
+    this->declSpeed = 1.0;
+    this->declAcc = 1.0;
+    this->latitude = 45.0;
+    this->flipIsEnabled = false;
+    this->mountIsEast = true;
+    this->horizonMask = NULL;
+    this->slewTimeModel = NULL;
+}
+
+//---------------------------------------------------
+TSC_Sequencer::~TSC_Sequencer(void) {
+    this->targets.clear();
+}
+
+//---------------------------------------------------
+void TSC_Sequencer::addTarget(std::string name, float ra, float decl, short exposures, float expTime) {
+    struct sequenceEntry entry;
+
+    entry.oname = name;
+    entry.oRADec = ra;
+    entry.oDeclDec = decl;
+    entry.noOfExposures = exposures;
+    entry.expTime = expTime;
+    this->targets.push_back(entry);
+}
+
+//---------------------------------------------------
+// reading a .csv file with the special format
+// number of targets
+// ObjectName,RA[deg],Decl[deg],NumberOfExposures,ExposureTime[s]
+bool TSC_Sequencer::loadTargets(QString filename) {
+    std::string name, line;
+    float radec, decldec, expTime;
+    short exposures;
+    long counter, numberOfTargets = 0, targetsRead = 0;
+    char delimiter(',');
+    QByteArray ba = filename.toLatin1();
+    const char *cfilename = ba.data();
+
+    std::ifstream infile(cfilename);
+    std::getline(infile, line);
+    std::istringstream iss(line);
+    iss >> numberOfTargets;
+    for (counter = 0; counter < numberOfTargets; counter++) {
+        std::getline(infile, name, delimiter);  // object name
+        std::getline(infile, line, delimiter);  // right ascension
+        std::istringstream issra(line);
+        std::getline(infile, line, delimiter);  // declination
+        std::istringstream issdecl(line);
+        std::getline(infile, line, delimiter);  // number of exposures
+        std::istringstream issexp(line);
+        std::getline(infile, line);             // exposure time
+        std::istringstream isstime(line);
+        if (!(issra >> radec) || !(issdecl >> decldec) || !(issexp >> exposures) || !(isstime >> expTime)) {
+            qDebug() << "Sequence file ends prematurely at target" << counter;
+            break;
+        }
+        this->addTarget(name, radec, decldec, exposures, expTime);
+        targetsRead++;
+    }
+    infile.close();
+    return (targetsRead > 0);
+}
+
+//---------------------------------------------------
+void TSC_Sequencer::removeTarget(long index) {
+    if ((index >= 0) && (index < this->getNumberOfTargets())) {
+        this->targets.erase(this->targets.begin()+index);
+    }
+}
+
+//---------------------------------------------------
+void TSC_Sequencer::clearTargets(void) {
+    this->targets.clear();
+}
+
+//---------------------------------------------------
+long TSC_Sequencer::getNumberOfTargets(void) {
+    return (long)this->targets.size();
+}
+
+//---------------------------------------------------
+std::string TSC_Sequencer::getTargetName(long index) {
+    return this->targets[index].oname;
+}
+
+//---------------------------------------------------
+float TSC_Sequencer::getTargetCoordinates(long index, short what) {
+    if (what == 0) {
+        return this->targets[index].oRADec;
+    }
+    return this->targets[index].oDeclDec;
+}
+
+//---------------------------------------------------
+short TSC_Sequencer::getNumberOfExposures(long index) {
+    return this->targets[index].noOfExposures;
+}
+
+//---------------------------------------------------
+float TSC_Sequencer::getExposureTime(long index) {
+    return this->targets[index].expTime;
+}
+
+//---------------------------------------------------
+// MainWindow::takeNextExposureInSeries pauses for five seconds between exposures, and the
+// shutter release adds another half second
+double TSC_Sequencer::getPlanDuration(long index) {
+    return (this->targets[index].noOfExposures*(this->targets[index].expTime + 5.5));
+}
+
+//---------------------------------------------------
+void TSC_Sequencer::setSlewParameters(double vRA, double aRA, double vDecl, double aDecl) {
+    if ((vRA > 0) && (aRA > 0)) {
+        this->raSpeed = vRA;
+        this->raAcc = aRA;
+    }
+    if ((vDecl > 0) && (aDecl > 0)) {
+        this->declSpeed = vDecl;
+        this->declAcc = aDecl;
+    }
+}
+
+//---------------------------------------------------
+void TSC_Sequencer::setHorizonMask(TSC_HorizonMask *mask) {
+    this->horizonMask = mask;
+}
+
+//---------------------------------------------------
+void TSC_Sequencer::setSlewTimeModel(TSC_SlewTimeModel *model) {
+    this->slewTimeModel = model;
+}
+
+//---------------------------------------------------
+void TSC_Sequencer::setMountParameters(double lat, bool doesFlip, bool isEast) {
+    this->latitude = lat;
+    this->flipIsEnabled = doesFlip;
+    this->mountIsEast = isEast;
+}
+
+//---------------------------------------------------
+// the ETA of MainWindow including the fitted acceleration and latency. the trapezoid does not depend on the
+// units as long as travel, speed and acceleration are all given in degrees
+double TSC_Sequencer::estimateAxisTime(short axis, double travel) {
+    if (this->slewTimeModel == NULL) {
+        return 0; // no estimate without the model; the order is then only sorted for flips and the horizon
+    }
+    if (axis == 0) {
+        return this->slewTimeModel->predictDuration(0, fabs(travel), this->raSpeed, this->raAcc);
+    }
+    return this->slewTimeModel->predictDuration(1, fabs(travel), this->declSpeed, this->declAcc);
+}
+
+//---------------------------------------------------
+// both axes move at the same time, so the longer travel determines the duration. a meridian flip turns the
+// mount by 180 degrees in hour angle and moves the declination axis across the pole
+double TSC_Sequencer::estimateSlewTime(double ha, double decl, double gha, double gdecl, bool flip) {
+    double travelHA, travelDecl, tRA, tDecl;
+
+    travelHA = fabs(gha - ha);
+    if (travelHA > 180) {
+        travelHA = 360 - travelHA;
+    }
+    travelDecl = fabs(gdecl - decl);
+    if (flip == true) {
+        travelHA = 180 - travelHA;
+        if (this->latitude >= 0) {
+            travelDecl = (90 - decl) + (90 - gdecl);
+        } else {
+            travelDecl = (90 + decl) + (90 + gdecl);
+        }
+    }
+    tRA = this->estimateAxisTime(0, travelHA);
+    tDecl = this->estimateAxisTime(1, travelDecl);
+    if (tRA > tDecl) {
+        return tRA;
+    }
+    return tDecl;
+}
+
+//---------------------------------------------------
+// hour angle between 0 and 360 degrees for a given LST in hours and a time offset in seconds
+double TSC_Sequencer::getHourAngle(double lst, double ra, double dt) {
+    double ha;
+
+    ha = (lst + dt*1.00273791/3600.0)*15.0 - ra;
+    while (ha < 0) {
+        ha += 360;
+    }
+    while (ha >= 360) {
+        ha -= 360;
+    }
+    return ha;
+}
+
+//---------------------------------------------------
+// a GEM that is "east" reaches hour angles between 0 and 180 degrees, as in MainWindow::checkForFlip
+bool TSC_Sequencer::needsEastSide(double ha) {
+    return ((ha >= 0) && (ha < 180));
+}
+
+//---------------------------------------------------
+// simulates the session for a given order and returns its duration. exposure plans that run across the meridian
+// need a flip in the middle of an exposure, which costs the flip and the exposure. targets below the horizon
+// or outside the mount limits are penalized for sorting, but not for the estimate of the duration
+double TSC_Sequencer::evaluateOrder(std::vector<long> *order, double lst, double ra, double decl, double overhead, bool withPenalty) {
+    const double belowHorizonPenalty = 86400.0;
+    double t = 0, ha, decl0, gha, gdecl, sinAlt, latRad, declRad, plan, haAtEnd;
+    bool isEast, flip, isReachable;
+    unsigned long i;
+    long idx;
+
+    isEast = this->mountIsEast;
+    ha = this->getHourAngle(lst, ra, 0);
+    decl0 = decl;
+    latRad = this->latitude/180.0*M_PI;
+    for (i = 0; i < order->size(); i++) {
+        idx = (*order)[i];
+        gdecl = this->targets[idx].oDeclDec;
+        gha = this->getHourAngle(lst, this->targets[idx].oRADec, t);
+        flip = false;
+        if ((this->flipIsEnabled == true) && (this->needsEastSide(gha) != isEast)) {
+            flip = true;
+            isEast = !isEast;
+        }
+        t += this->estimateSlewTime(ha, decl0, gha, gdecl, flip) + overhead;
+        gha = this->getHourAngle(lst, this->targets[idx].oRADec, t);
+        if (this->horizonMask != NULL) {
+            isReachable = this->horizonMask->isReachableOnSide(gha, gdecl, isEast);
+        } else {
+            declRad = gdecl/180.0*M_PI;
+            sinAlt = sin(latRad)*sin(declRad) + cos(latRad)*cos(declRad)*cos(gha/180.0*M_PI);
+            isReachable = (sinAlt >= 0);
+        }
+        if ((isReachable == false) && (withPenalty == true)) {
+            t += belowHorizonPenalty;
+        }
+        plan = this->getPlanDuration(idx);
+        haAtEnd = this->getHourAngle(lst, this->targets[idx].oRADec, t + plan);
+        if ((this->flipIsEnabled == true) && (this->needsEastSide(haAtEnd) != isEast)) {
+            t += this->estimateSlewTime(haAtEnd, gdecl, haAtEnd, gdecl, true) + this->targets[idx].expTime;
+            isEast = !isEast;
+        }
+        t += plan;
+        ha = haAtEnd;
+        decl0 = gdecl;
+    }
+    return t;
+}
+
+//---------------------------------------------------
+// nearest neighbour in terms of slew time first, then the order is improved by reversing sections of it
+// as long as the total duration decreases (2-opt). the list is small, so the cubic effort does not matter
+double TSC_Sequencer::optimizeOrder(double lst, double ra, double decl, double overhead) {
+    std::vector<long> order, candidate, remaining;
+    std::vector<sequenceEntry> sortedTargets;
+    double bestDuration, duration, shortest;
+    unsigned long i, j, best, pass;
+    bool improved;
+
+    for (i = 0; i < this->targets.size(); i++) {
+        remaining.push_back(i);
+    }
+    while (remaining.empty() == false) {
+        best = 0;
+        shortest = -1;
+        for (i = 0; i < remaining.size(); i++) {
+            candidate = order;
+            candidate.push_back(remaining[i]);
+            duration = this->evaluateOrder(&candidate, lst, ra, decl, overhead, true);
+            if ((shortest < 0) || (duration < shortest)) {
+                shortest = duration;
+                best = i;
+            }
+        }
+        order.push_back(remaining[best]);
+        remaining.erase(remaining.begin()+best);
+    }
+    bestDuration = this->evaluateOrder(&order, lst, ra, decl, overhead, true);
+    improved = true;
+    for (pass = 0; (pass < 20) && (improved == true); pass++) {
+        improved = false;
+        for (i = 0; i+1 < order.size(); i++) {
+            for (j = i+1; j < order.size(); j++) {
+                candidate = order;
+                std::reverse(candidate.begin()+i, candidate.begin()+j+1);
+                duration = this->evaluateOrder(&candidate, lst, ra, decl, overhead, true);
+                if (duration < bestDuration - 1.0) {
+                    bestDuration = duration;
+                    order = candidate;
+                    improved = true;
+                }
+            }
+        }
+    }
+    for (i = 0; i < order.size(); i++) {
+        sortedTargets.push_back(this->targets[order[i]]);
+        order[i] = i;
+    } // the sorted list is carried out from its first entry on
+    this->targets = sortedTargets;
+    return this->evaluateOrder(&order, lst, ra, decl, overhead, false);
+}
+
+//---------------------------------------------------
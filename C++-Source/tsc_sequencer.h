@@ -0,0 +1,74 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//---------------------------------------------------
+// a class that holds a list of targets with exposure plans for an unattended observing session. it estimates
+// the time needed for slews between the targets with the calibrated TSC_SlewTimeModel and sorts the
+// list so that slews are short and meridian flips are rare. the session itself is carried out by MainWindow.
+// all angles are given in decimal degrees, times in seconds.
+
+#ifndef TSC_SEQUENCER_H
+#define TSC_SEQUENCER_H
+
+#include <QString>
+#include <string>
+#include <vector>
+#include "tsc_horizonmask.h"
+#include "tsc_slewtimemodel.h"
+
+class TSC_Sequencer {
+public:
+    TSC_Sequencer(void);
+    ~TSC_Sequencer(void);
+    void addTarget(std::string, float, float, short, float); // name, RA, decl, number of exposures and exposure time
+    bool loadTargets(QString); // appends the targets from a sequence file; false if nothing could be read
+    void removeTarget(long);
+    void clearTargets(void);
+    long getNumberOfTargets(void);
+    std::string getTargetName(long);
+    float getTargetCoordinates(long, short); // 0 is RA, 1 is decl
+    short getNumberOfExposures(long);
+    float getExposureTime(long);
+    double getPlanDuration(long); // time for all exposures of a target including the pauses
+    void setSlewParameters(double, double, double, double); // speed and acceleration in RA and decl in degrees/s and degrees/s^2
+    void setSlewTimeModel(TSC_SlewTimeModel*); // the calibrated ETA of the GoTos; it is not owned by the sequencer
+    void setMountParameters(double, bool, bool); // latitude, mount is a GEM that flips, mount is east
+    void setHorizonMask(TSC_HorizonMask*); // horizon and mount limits of the site; it is not owned by the sequencer
+    double estimateSlewTime(double, double, double, double, bool); // HA and decl of start and target, flip -> duration of the slew
+    double optimizeOrder(double, double, double, double); // LST in hours, current RA and decl, overhead per target -> total duration
+
+private:
+    struct sequenceEntry {
+        std::string oname;
+        float oRADec;
+        float oDeclDec;
+        short noOfExposures;
+        float expTime;
+    };
+    std::vector<sequenceEntry> targets;
+    double raSpeed; // maximum speed of the drives during GoTo in degrees/s
+    double raAcc;
+    double declSpeed;
+    double declAcc;
+    double latitude;
+    bool flipIsEnabled;
+    bool mountIsEast;
+    TSC_HorizonMask *horizonMask;
+    TSC_SlewTimeModel *slewTimeModel;
+    double estimateAxisTime(short, double); // axis and travel in degrees
+    double evaluateOrder(std::vector<long>*, double, double, double, double, bool);
+    double getHourAngle(double, double, double);
+    bool needsEastSide(double);
+};
+
+#endif // TSC_SEQUENCER_H
@@ -0,0 +1,267 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+#include "tsc_slewplanner.h"
+#include "tsc_slewtimemodel.h"
+#include <math.h>
+
+TSC_SlewPlanner::TSC_SlewPlanner(void) {
+    short ax;
+
+    for (ax = 0; ax < 2; ax++) {
+        this->axis[ax].stepsPerDegree = 1;
+        this->axis[ax].maxSpeed = 1;
+        this->axis[ax].maxAcc = 1;
+        this->axis[ax].accFactor = 1;
+        this->axis[ax].latency = 0;
+        this->axis[ax].skyRate = 0;
+    }
+    this->minAcc = 100; // the lowest acceleration in the GUI
+    this->straightLineTolerance = 0.02;
+}
+
+//---------------------------------------------------
+TSC_SlewPlanner::~TSC_SlewPlanner(void) {
+    this->waypoints.clear();
+    this->segments.clear();
+}
+
+//---------------------------------------------------
+void TSC_SlewPlanner::setAxis(short ax, double stepsPerDegree, double speed, double acc) {
+    if ((ax < 0) || (ax > 1) || (stepsPerDegree <= 0) || (speed <= 0) || (acc <= 0)) {
+        return;
+    }
+    this->axis[ax].stepsPerDegree = stepsPerDegree;
+    this->axis[ax].maxSpeed = speed;
+    this->axis[ax].maxAcc = acc;
+}
+
+//---------------------------------------------------
+void TSC_SlewPlanner::setTimeModel(short ax, double accFactor, double latency) {
+    if ((ax < 0) || (ax > 1)) {
+        return;
+    }
+    if (accFactor > 0) {
+        this->axis[ax].accFactor = accFactor;
+    }
+    if (latency >= 0) {
+        this->axis[ax].latency = latency;
+    }
+}
+
+//---------------------------------------------------
+void TSC_SlewPlanner::setSkyRate(short ax, double rate) {
+    if ((ax < 0) || (ax > 1)) {
+        return;
+    }
+    this->axis[ax].skyRate = rate;
+}
+
+//---------------------------------------------------
+void TSC_SlewPlanner::setMinimumAcceleration(double acc) {
+    if (acc > 0) {
+        this->minAcc = acc;
+    }
+}
+
+//---------------------------------------------------
+void TSC_SlewPlanner::setStraightLineTolerance(double tol) {
+    if (tol >= 0) {
+        this->straightLineTolerance = tol;
+    }
+}
+
+//---------------------------------------------------
+void TSC_SlewPlanner::clearWaypoints(void) {
+    this->waypoints.clear();
+}
+
+//---------------------------------------------------
+void TSC_SlewPlanner::addWaypoint(double ra, double decl) {
+    struct waypointStruct wp;
+
+    wp.pos[0] = ra;
+    wp.pos[1] = decl;
+    this->waypoints.push_back(wp);
+}
+
+//---------------------------------------------------
+long TSC_SlewPlanner::getNumberOfWaypoints(void) {
+    return this->waypoints.size();
+}
+
+//---------------------------------------------------
+long TSC_SlewPlanner::planSlew(double travelRA, double travelDecl) {
+    struct segmentStruct seg;
+    double from[2] = {0, 0};
+    unsigned long idx;
+
+    this->segments.clear();
+    for (idx = 0; idx < this->waypoints.size(); idx++) {
+        this->planSegment(this->waypoints[idx].pos[0] - from[0], this->waypoints[idx].pos[1] - from[1], &seg);
+        this->segments.push_back(seg);
+        from[0] = this->waypoints[idx].pos[0];
+        from[1] = this->waypoints[idx].pos[1];
+    }
+    this->planSegment(travelRA - from[0], travelDecl - from[1], &seg);
+    this->segments.push_back(seg);
+    return this->segments.size();
+}
+
+//---------------------------------------------------
+// the sky moves on while the axis slews, and the duration depends on the travel; as in startGoToObject,
+// a few iterations are enough. an axis that does not move in a segment tracks and needs no compensation
+void TSC_SlewPlanner::planSegment(double travelRA, double travelDecl, struct segmentStruct *seg) {
+    const double leg[2] = {travelRA, travelDecl};
+    short ax, iteration;
+
+    seg->travel[0] = travelRA;
+    seg->travel[1] = travelDecl;
+    for (iteration = 0; iteration < 4; iteration++) {
+        for (ax = 0; ax < 2; ax++) {
+            seg->steps[ax] = lround(fabs(seg->travel[ax])*this->axis[ax].stepsPerDegree);
+        }
+        this->computeProfiles(seg);
+        for (ax = 0; ax < 2; ax++) {
+            if (leg[ax] != 0) {
+                seg->travel[ax] = leg[ax] + this->axis[ax].skyRate*seg->duration;
+            }
+        }
+    }
+    for (ax = 0; ax < 2; ax++) {
+        seg->steps[ax] = lround(fabs(seg->travel[ax])*this->axis[ax].stepsPerDegree);
+    }
+    this->computeProfiles(seg);
+}
+
+//---------------------------------------------------
+// the progress along the path is s in [0,1]; axis i travels s*D_i, so the common profile of s may neither
+// exceed v_i/D_i nor a_i/D_i of any axis. the accelerations are the effective ones of the time model
+void TSC_SlewPlanner::computeProfiles(struct segmentStruct *seg) {
+    double timeAlone[2], effAcc, speedOfS = 1e30, accOfS = 1e30, timeTogether, disc, lat = 0;
+    short ax, slow;
+
+    for (ax = 0; ax < 2; ax++) {
+        effAcc = this->axis[ax].maxAcc*this->axis[ax].accFactor;
+        timeAlone[ax] = TSC_SlewTimeModel::getProfileDuration(seg->steps[ax], this->axis[ax].maxSpeed, effAcc);
+        seg->speed[ax] = this->axis[ax].maxSpeed;
+        seg->acc[ax] = this->axis[ax].maxAcc;
+        if (seg->steps[ax] > 0) {
+            speedOfS = fmin(speedOfS, this->axis[ax].maxSpeed/seg->steps[ax]);
+            accOfS = fmin(accOfS, effAcc/seg->steps[ax]);
+            lat = fmax(lat, this->axis[ax].latency);
+        }
+    }
+    slow = (timeAlone[0] >= timeAlone[1]) ? 0 : 1;
+    seg->independentDuration = fmax(timeAlone[0], timeAlone[1]) + lat;
+    seg->duration = seg->independentDuration;
+    seg->isStraight = true;
+    if ((seg->steps[0] == 0) || (seg->steps[1] == 0)) {
+        return;
+    } // a motion in one axis only is straight anyway
+    timeTogether = TSC_SlewTimeModel::getProfileDuration(1.0, speedOfS, accOfS);
+    if (timeTogether <= timeAlone[slow]*(1.0 + this->straightLineTolerance)) {
+        for (ax = 0; ax < 2; ax++) {
+            seg->speed[ax] = fmax(1.0, speedOfS*seg->steps[ax]);
+            seg->acc[ax] = accOfS*seg->steps[ax]/this->axis[ax].accFactor;
+            if (seg->acc[ax] < this->minAcc) {
+                seg->acc[ax] = this->minAcc;
+                seg->isStraight = false;
+            } // a short travel in one axis ends a little early
+        }
+        seg->duration = timeTogether + lat;
+        return;
+    }
+    ax = 1 - slow;
+    effAcc = this->axis[ax].maxAcc*this->axis[ax].accFactor;
+    disc = effAcc*effAcc*timeAlone[slow]*timeAlone[slow] - 4.0*effAcc*seg->steps[ax];
+    if (disc > 0) {
+        seg->speed[ax] = fmax(1.0, fmin(this->axis[ax].maxSpeed, 0.5*(effAcc*timeAlone[slow] - sqrt(disc))));
+    } // the speed where a trapezoid of the full acceleration takes as long as the slow axis
+    seg->isStraight = false;
+}
+
+//---------------------------------------------------
+long TSC_SlewPlanner::getNumberOfSegments(void) {
+    return this->segments.size();
+}
+
+//---------------------------------------------------
+long TSC_SlewPlanner::getSegmentSteps(long seg, short ax) {
+    if ((seg < 0) || (seg >= (long)this->segments.size()) || (ax < 0) || (ax > 1)) {
+        return 0;
+    }
+    return this->segments[seg].steps[ax];
+}
+
+//---------------------------------------------------
+short TSC_SlewPlanner::getSegmentDirection(long seg, short ax) {
+    if ((seg < 0) || (seg >= (long)this->segments.size()) || (ax < 0) || (ax > 1)) {
+        return 1;
+    }
+    return (this->segments[seg].travel[ax] < 0) ? -1 : 1;
+}
+
+//---------------------------------------------------
+double TSC_SlewPlanner::getSegmentSpeed(long seg, short ax) {
+    if ((seg < 0) || (seg >= (long)this->segments.size()) || (ax < 0) || (ax > 1)) {
+        return 0;
+    }
+    return this->segments[seg].speed[ax];
+}
+
+//---------------------------------------------------
+double TSC_SlewPlanner::getSegmentAcceleration(long seg, short ax) {
+    if ((seg < 0) || (seg >= (long)this->segments.size()) || (ax < 0) || (ax > 1)) {
+        return 0;
+    }
+    return this->segments[seg].acc[ax];
+}
+
+//---------------------------------------------------
+double TSC_SlewPlanner::getSegmentDuration(long seg) {
+    if ((seg < 0) || (seg >= (long)this->segments.size())) {
+        return 0;
+    }
+    return this->segments[seg].duration;
+}
+
+//---------------------------------------------------
+double TSC_SlewPlanner::getIndependentDuration(long seg) {
+    if ((seg < 0) || (seg >= (long)this->segments.size())) {
+        return 0;
+    }
+    return this->segments[seg].independentDuration;
+}
+
+//---------------------------------------------------
+bool TSC_SlewPlanner::isSegmentStraight(long seg) {
+    if ((seg < 0) || (seg >= (long)this->segments.size())) {
+        return false;
+    }
+    return this->segments[seg].isStraight;
+}
+
+//---------------------------------------------------
+double TSC_SlewPlanner::getTotalDuration(void) {
+    std::vector<segmentStruct>::iterator it;
+    double sum = 0;
+
+    for (it = this->segments.begin(); it != this->segments.end(); it++) {
+        sum += it->duration;
+    }
+    return sum;
+}
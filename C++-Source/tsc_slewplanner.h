@@ -0,0 +1,85 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+//---------------------------------------------------
+// plans GoTos where both axes move together. each axis follows a trapezoidal speed profile; if the profiles
+// are scaled copies of each other, the mount moves on a straight line in hour angle and declination and both
+// axes arrive at the same time. the common profile is limited by the axis that needs the most time for its
+// part of the travel. if one axis limits the speed and the other one the acceleration, the straight line
+// takes longer than the slower axis alone; up to the straight line tolerance, 2% by default, this is accepted.
+// otherwise the other axis is merely slowed down to arrive together with the slow one, and the slew takes as
+// long as the slower axis alone. waypoints split the slew into segments that end with a stop, for
+// instance to go around the pier. travel is given in degrees, counted like the travel in
+// MainWindow::startGoToObject; speeds in microsteps/s, accelerations in microsteps/s^2 and times in s.
+// axis 0 is RA, 1 is declination.
+
+#ifndef TSC_SLEWPLANNER_H
+#define TSC_SLEWPLANNER_H
+
+#include <vector>
+
+class TSC_SlewPlanner {
+public:
+    TSC_SlewPlanner(void);
+    ~TSC_SlewPlanner(void);
+    void setAxis(short, double, double, double); // axis, microsteps per degree, speed and acceleration set in the controller
+    void setTimeModel(short, double, double); // axis, factor from set to effective acceleration and latency, as in TSC_SlewTimeModel
+    void setSkyRate(short, double); // degrees/s added to the travel of an axis while it slews; the sky moves on in RA
+    void setMinimumAcceleration(double); // the controllers do not take less
+    void setStraightLineTolerance(double); // fraction of additional time that is accepted for a straight line
+    void clearWaypoints(void);
+    void addWaypoint(double, double); // position in RA and decl relative to the start, in degrees
+    long getNumberOfWaypoints(void);
+    long planSlew(double, double); // travel to the target in RA and decl in degrees; returns the number of segments
+    long getNumberOfSegments(void);
+    long getSegmentSteps(long, short); // segment, axis
+    short getSegmentDirection(long, short); // +/-1
+    double getSegmentSpeed(long, short);
+    double getSegmentAcceleration(long, short); // to be set in the controller
+    double getSegmentDuration(long); // predicted time until both axes have stopped
+    double getIndependentDuration(long); // the same segment with both axes at full speed and acceleration
+    bool isSegmentStraight(long);
+    double getTotalDuration(void);
+
+private:
+    struct axisStruct {
+        double stepsPerDegree;
+        double maxSpeed;
+        double maxAcc;
+        double accFactor;
+        double latency;
+        double skyRate;
+    };
+    struct waypointStruct {
+        double pos[2];
+    };
+    struct segmentStruct {
+        double travel[2]; // degrees, including the motion of the sky
+        long steps[2];
+        double speed[2];
+        double acc[2];
+        double duration;
+        double independentDuration;
+        bool isStraight;
+    };
+    struct axisStruct axis[2];
+    double minAcc;
+    double straightLineTolerance;
+    std::vector<waypointStruct> waypoints;
+    std::vector<segmentStruct> segments;
+    void planSegment(double, double, struct segmentStruct*);
+    void computeProfiles(struct segmentStruct*);
+};
+
+#endif // TSC_SLEWPLANNER_H
@@ -0,0 +1,228 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+//---------------------------------------------------
+#include "tsc_slewtimemodel.h"
+#include <math.h>
+
+#define MAX_SAMPLES_PER_AXIS 32 // older slews are dropped; changes of the mechanics are followed this way
+#define MIN_SAMPLES_FOR_FIT 3
+
+TSC_SlewTimeModel::TSC_SlewTimeModel(void) {
+    short axis;
+
+    for (axis = 0; axis < 2; axis++) {
+        this->axisModel[axis].accFactor = 1.0;
+        this->axisModel[axis].latency = 0.1; // the polling interval of the event queue in MainWindow
+        this->axisModel[axis].rmsError = 0;
+        this->axisModel[axis].noOfSlews = 0;
+        this->axisModel[axis].priorAccFactor = 1.0;
+        this->axisModel[axis].priorLatency = 0.1;
+        this->axisModel[axis].priorWeight = 0;
+        this->axisModel[axis].slewIsPending = false;
+    }
+}
+
+//---------------------------------------------------
+TSC_SlewTimeModel::~TSC_SlewTimeModel(void) {
+    this->axisModel[0].samples.clear();
+    this->axisModel[1].samples.clear();
+}
+
+//---------------------------------------------------
+void TSC_SlewTimeModel::setParameters(short axis, double accFactor, double latency, double rms, long slews) {
+    if ((axis < 0) || (axis > 1)) {
+        return;
+    }
+    if (accFactor > 0) {
+        this->axisModel[axis].accFactor = accFactor;
+    }
+    if (latency >= 0) {
+        this->axisModel[axis].latency = latency;
+    }
+    this->axisModel[axis].rmsError = fabs(rms);
+    this->axisModel[axis].noOfSlews = slews;
+    this->axisModel[axis].priorAccFactor = this->axisModel[axis].accFactor;
+    this->axisModel[axis].priorLatency = this->axisModel[axis].latency;
+    this->axisModel[axis].priorWeight = slews;
+    if (this->axisModel[axis].priorWeight > MAX_SAMPLES_PER_AXIS) {
+        this->axisModel[axis].priorWeight = MAX_SAMPLES_PER_AXIS;
+    } // the fit never used more slews than the window holds
+    this->axisModel[axis].samples.clear();
+}
+
+//---------------------------------------------------
+double TSC_SlewTimeModel::getParameter(short axis, short what) {
+    double retval = 0;
+
+    if ((axis < 0) || (axis > 1)) {
+        return 0;
+    }
+    switch (what) {
+        case 0: retval = this->axisModel[axis].accFactor; break;
+        case 1: retval = this->axisModel[axis].latency; break;
+        case 2: retval = this->axisModel[axis].rmsError; break;
+        case 3: retval = this->axisModel[axis].noOfSlews; break;
+    }
+    return retval;
+}
+
+//---------------------------------------------------
+// the drive accelerates to full speed, travels and brakes again. if the travel is too short, the drive
+// brakes before full speed is reached and the profile is a triangle
+double TSC_SlewTimeModel::getProfileDuration(double travel, double speed, double acc) {
+    travel = fabs(travel);
+    if ((travel <= 0) || (speed <= 0) || (acc <= 0)) {
+        return 0;
+    }
+    if (travel < speed*speed/acc) {
+        return 2.0*sqrt(travel/acc);
+    }
+    return travel/speed + speed/acc;
+}
+
+//---------------------------------------------------
+double TSC_SlewTimeModel::predictDuration(short axis, double travel, double speed, double acc) {
+    if ((axis < 0) || (axis > 1)) {
+        return 0;
+    }
+    return this->getProfileDuration(travel, speed, acc*this->axisModel[axis].accFactor) + this->axisModel[axis].latency;
+}
+
+//---------------------------------------------------
+void TSC_SlewTimeModel::startSlew(short axis, double travel, double speed, double acc) {
+    if ((axis < 0) || (axis > 1)) {
+        return;
+    }
+    this->axisModel[axis].pendingSlew.travel = fabs(travel);
+    this->axisModel[axis].pendingSlew.speed = speed;
+    this->axisModel[axis].pendingSlew.acc = acc;
+    this->axisModel[axis].pendingSlew.duration = this->predictDuration(axis, travel, speed, acc); // kept until the slew is finished
+    this->axisModel[axis].slewIsPending = true;
+}
+
+//---------------------------------------------------
+// the rms error is taken from the predictions made before each slew, so it tells how good the ETA
+// really was and not only how well the model fits the slews it was fitted to
+bool TSC_SlewTimeModel::finishSlew(short axis, double measuredDuration) {
+    struct slewSample sample;
+    std::vector<slewSample>::iterator it;
+    double sqSum = 0;
+
+    if ((axis < 0) || (axis > 1) || (this->axisModel[axis].slewIsPending == false)) {
+        return false;
+    }
+    this->axisModel[axis].slewIsPending = false;
+    sample = this->axisModel[axis].pendingSlew;
+    if ((sample.speed <= 0) || (sample.acc <= 0) || (measuredDuration < 0)) {
+        return false;
+    }
+    sample.predictionError = measuredDuration - sample.duration;
+    sample.duration = measuredDuration;
+    this->axisModel[axis].samples.push_back(sample);
+    if (this->axisModel[axis].samples.size() > MAX_SAMPLES_PER_AXIS) {
+        this->axisModel[axis].samples.erase(this->axisModel[axis].samples.begin());
+    }
+    this->axisModel[axis].noOfSlews++;
+    for (it = this->axisModel[axis].samples.begin(); it != this->axisModel[axis].samples.end(); it++) {
+        sqSum += it->predictionError*it->predictionError;
+    }
+    this->axisModel[axis].rmsError = sqrt(sqSum/this->axisModel[axis].samples.size());
+    if (this->axisModel[axis].samples.size() >= MIN_SAMPLES_FOR_FIT) {
+        this->fitParameters(axis);
+    }
+    return true;
+}
+
+//---------------------------------------------------
+void TSC_SlewTimeModel::cancelSlews(void) {
+    this->axisModel[0].slewIsPending = false;
+    this->axisModel[1].slewIsPending = false;
+}
+
+//---------------------------------------------------
+// for a given acceleration factor, the best latency is the mean difference between measured and modelled
+// duration; it may not become negative
+double TSC_SlewTimeModel::getResidualSum(short axis, double accFactor, double *latency) {
+    std::vector<slewSample>::iterator it;
+    double sum = 0, sqSum = 0, res;
+    long n;
+
+    n = this->axisModel[axis].samples.size();
+    for (it = this->axisModel[axis].samples.begin(); it != this->axisModel[axis].samples.end(); it++) {
+        sum += it->duration - this->getProfileDuration(it->travel, it->speed, it->acc*accFactor);
+    }
+    *latency = sum/n;
+    if (*latency < 0) {
+        *latency = 0;
+    }
+    for (it = this->axisModel[axis].samples.begin(); it != this->axisModel[axis].samples.end(); it++) {
+        res = it->duration - this->getProfileDuration(it->travel, it->speed, it->acc*accFactor) - *latency;
+        sqSum += res*res;
+    }
+    return sqSum;
+}
+
+//---------------------------------------------------
+// least squares fit of acceleration factor and latency; a coarse logarithmic scan of the acceleration
+// factor between 0.2 and 5 is followed by a golden section search around the best value. the fit is averaged
+// with the parameters that were set before, which stand for the slews of the window that are not measured yet
+void TSC_SlewTimeModel::fitParameters(short axis) {
+    double logK, bestLogK = 0, lo, hi, x1, x2, f1, f2, f, bestF = 1e30, lat, n, prior;
+    const double gr = 0.6180339887;
+    short cnt;
+
+    for (cnt = 0; cnt <= 40; cnt++) {
+        logK = log(0.2) + cnt*(log(5.0) - log(0.2))/40.0;
+        f = this->getResidualSum(axis, exp(logK), &lat);
+        if (f < bestF) {
+            bestF = f;
+            bestLogK = logK;
+        }
+    }
+    lo = bestLogK - (log(5.0) - log(0.2))/40.0;
+    hi = bestLogK + (log(5.0) - log(0.2))/40.0;
+    x1 = hi - gr*(hi - lo);
+    x2 = lo + gr*(hi - lo);
+    f1 = this->getResidualSum(axis, exp(x1), &lat);
+    f2 = this->getResidualSum(axis, exp(x2), &lat);
+    for (cnt = 0; cnt < 30; cnt++) {
+        if (f1 < f2) {
+            hi = x2;
+            x2 = x1;
+            f2 = f1;
+            x1 = hi - gr*(hi - lo);
+            f1 = this->getResidualSum(axis, exp(x1), &lat);
+        } else {
+            lo = x1;
+            x1 = x2;
+            f1 = f2;
+            x2 = lo + gr*(hi - lo);
+            f2 = this->getResidualSum(axis, exp(x2), &lat);
+        }
+    }
+    logK = 0.5*(lo + hi);
+    if (this->getResidualSum(axis, exp(logK), &lat) > bestF) {
+        logK = bestLogK;
+    }
+    this->getResidualSum(axis, exp(logK), &lat);
+    n = this->axisModel[axis].samples.size();
+    prior = this->axisModel[axis].priorWeight - n;
+    if (prior > 0) {
+        logK = (prior*log(this->axisModel[axis].priorAccFactor) + n*logK)/(prior + n);
+        lat = (prior*this->axisModel[axis].priorLatency + n*lat)/(prior + n);
+    }
+    this->axisModel[axis].accFactor = exp(logK);
+    this->axisModel[axis].latency = lat;
+}
@@ -0,0 +1,65 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+//---------------------------------------------------
+// a class that predicts the duration of a GoTo for each axis. the drives follow a trapezoidal speed profile;
+// the effective acceleration and the latency from the travel command until the end of the slew is detected
+// in the event queue are fitted to the slews measured on the mount. the parameters that were set, usually the
+// ones stored in the preferences, count for the slews they were fitted to until as many new slews have been
+// measured; only the parameters are stored, not the slews. distances are given in microsteps, speeds
+// in microsteps/s, accelerations in microsteps/s^2 and times in seconds. axis 0 is RA, 1 is declination.
+
+#ifndef TSC_SLEWTIMEMODEL_H
+#define TSC_SLEWTIMEMODEL_H
+
+#include <vector>
+
+class TSC_SlewTimeModel {
+public:
+    TSC_SlewTimeModel(void);
+    ~TSC_SlewTimeModel(void);
+    void setParameters(short, double, double, double, long); // axis, acceleration factor, latency, rms error, number of measured slews
+    double getParameter(short, short); // axis; 0 is the acceleration factor, 1 the latency, 2 the rms error, 3 the number of measured slews
+    double predictDuration(short, double, double, double); // axis, travel, speed and acceleration set in the controller
+    void startSlew(short, double, double, double); // remembers a slew that was just commanded
+    bool finishSlew(short, double); // the measured duration of the slew; true if the slew was used for the model
+    void cancelSlews(void); // slews that were stopped are not used
+    static double getProfileDuration(double, double, double); // travel, speed, acceleration -> duration without latency
+
+private:
+    struct slewSample {
+        double travel;
+        double speed;
+        double acc;
+        double duration; // measured
+        double predictionError; // measured duration minus the duration predicted when the slew was started
+    };
+    struct axisModelStruct {
+        double accFactor;
+        double latency;
+        double rmsError;
+        long noOfSlews;
+        double priorAccFactor; // the parameters that were set, and the number of slews they stand for
+        double priorLatency;
+        long priorWeight;
+        bool slewIsPending;
+        struct slewSample pendingSlew;
+        std::vector<slewSample> samples; // the most recent slews
+    };
+    struct axisModelStruct axisModel[2];
+    double getResidualSum(short, double, double*); // axis, acceleration factor -> sum of squared residuals and optimal latency
+    void fitParameters(short);
+};
+
+#endif // TSC_SLEWTIMEMODEL_H
@@ -0,0 +1,468 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+#include "tsc_starensemble.h"
+#include <math.h>
+#include <algorithm>
+
+static const double fwhmPerSigma = 2.35482;
+
+TSC_StarEnsemble::TSC_StarEnsemble(void) {
+    this->centroid = new TSC_Centroid();
+    this->boxSize = 32;
+    this->clipSigma = 3.0;
+    this->fitRotation = true;
+    this->clear();
+}
+
+//---------------------------------------------------
+TSC_StarEnsemble::~TSC_StarEnsemble(void) {
+    this->stars.clear();
+    delete this->centroid;
+}
+
+//---------------------------------------------------
+void TSC_StarEnsemble::setEstimator(short est) {
+    this->centroid->setEstimator(est);
+}
+
+//---------------------------------------------------
+void TSC_StarEnsemble::setBoxSize(int size) {
+    if (size >= 12) {
+        this->boxSize = size;
+    } // the centroid needs a border for the background
+}
+
+//---------------------------------------------------
+int TSC_StarEnsemble::getBoxSize(void) {
+    return this->boxSize;
+}
+
+//---------------------------------------------------
+void TSC_StarEnsemble::setClipping(double sigmas) {
+    if (sigmas > 1.0) {
+        this->clipSigma = sigmas;
+    }
+}
+
+//---------------------------------------------------
+void TSC_StarEnsemble::setRotationFit(bool isOn) {
+    this->fitRotation = isOn;
+}
+
+//---------------------------------------------------
+void TSC_StarEnsemble::clear(void) {
+    this->stars.clear();
+    this->commonVariance = 0;
+    this->offset[0] = 0;
+    this->offset[1] = 0;
+    this->offsetError = 0;
+    this->rotation = 0;
+    this->centre[0] = 0;
+    this->centre[1] = 0;
+    this->starsUsed = 0;
+}
+
+//---------------------------------------------------
+// the box is kept on the image; the variance per axis of a centroid is about (sigma of the star/SNR)^2
+bool TSC_StarEnsemble::measureStar(const unsigned char *image, long bytesPerLine, int width, int height,
+                                   double x, double y, double *pos, double *variance) {
+    int left, top;
+
+    if ((width < this->boxSize) || (height < this->boxSize)) {
+        return false;
+    }
+    left = (int)round(x) - this->boxSize/2;
+    top = (int)round(y) - this->boxSize/2;
+    left = std::min(std::max(left, 0), width - this->boxSize);
+    top = std::min(std::max(top, 0), height - this->boxSize);
+    if (this->centroid->measure(image, bytesPerLine, left, top, this->boxSize, this->boxSize) == false) {
+        return false;
+    }
+    if ((this->centroid->getSNR() <= 0) || (this->centroid->getFWHM() <= 0)) {
+        return false;
+    }
+    pos[0] = this->centroid->getCentroid(0);
+    pos[1] = this->centroid->getCentroid(1);
+    *variance = pow(this->centroid->getFWHM()/fwhmPerSigma/this->centroid->getSNR(), 2);
+    return true;
+}
+
+//---------------------------------------------------
+struct starCandidate {
+    int x;
+    int y;
+    int sum;
+};
+
+static bool isBrighterCandidate(const starCandidate &a, const starCandidate &b) {
+    return (a.sum > b.sum);
+}
+
+//---------------------------------------------------
+// the background and its noise are the median and the median absolute deviation of every fourth pixel. a
+// candidate is a local maximum whose 3 x 3 sum is 5 sigma above the background; the brightest candidates
+// are taken if no brighter one is within the box and none of their pixels is saturated
+long TSC_StarEnsemble::findStars(const unsigned char *image, long bytesPerLine, int width, int height,
+                                 double guideX, double guideY, long maxStars) {
+    std::vector<starCandidate> candidates;
+    struct ensembleStar newStar;
+    struct starCandidate cand;
+    const unsigned char *line;
+    long histogram[256], cnt = 0, sum;
+    double pos[2], variance, noise;
+    int x, y, dx, dy, median, mad, threshold, minVal, margin, val;
+    size_t i, j;
+    bool isLocalMax, isIsolated;
+
+    this->clear();
+    if (image == 0) {
+        return 0;
+    }
+    if (this->measureStar(image, bytesPerLine, width, height, guideX, guideY, pos, &variance) == false) {
+        return 0;
+    }
+    newStar.refPos[0] = pos[0];
+    newStar.refPos[1] = pos[1];
+    newStar.shift[0] = newStar.shift[1] = 0;
+    newStar.variance = variance;
+    newStar.found = true;
+    newStar.used = true;
+    this->stars.push_back(newStar); // the guide star is always the first one
+    if (maxStars <= 1) {
+        return 1;
+    }
+
+    for (x = 0; x < 256; x++) {
+        histogram[x] = 0;
+    }
+    for (y = 0; y < height; y += 2) {
+        line = image + y*bytesPerLine;
+        for (x = 0; x < width; x += 2) {
+            histogram[line[x]]++;
+            cnt++;
+        }
+    }
+    sum = 0;
+    for (median = 0; median < 255; median++) {
+        sum += histogram[median];
+        if (2*sum >= cnt) {
+            break;
+        }
+    }
+    sum = histogram[median];
+    for (mad = 1; mad < 256; mad++) {
+        if (2*sum >= cnt) {
+            break;
+        }
+        if (median - mad >= 0) {
+            sum += histogram[median - mad];
+        }
+        if (median + mad < 256) {
+            sum += histogram[median + mad];
+        }
+    }
+    noise = fmax(1.4826*(mad - 0.5), 0.5); // the deviations are integers
+    threshold = (int)ceil(9*median + 15*noise);
+    minVal = (int)ceil(median + 2*noise); // a quick test before the sum is taken
+
+    margin = this->boxSize/2 + 2;
+    for (y = margin; y < height - margin; y++) {
+        line = image + y*bytesPerLine;
+        for (x = margin; x < width - margin; x++) {
+            val = line[x];
+            if (val < minVal) {
+                continue;
+            }
+            isLocalMax = true;
+            for (dy = -2; (dy <= 2) && (isLocalMax == true); dy++) {
+                for (dx = -2; dx <= 2; dx++) {
+                    if ((dy < 0) || ((dy == 0) && (dx < 0))) {
+                        if (line[x + dy*bytesPerLine + dx] >= val) {
+                            isLocalMax = false;
+                            break;
+                        }
+                    } else if (line[x + dy*bytesPerLine + dx] > val) {
+                        isLocalMax = false;
+                        break;
+                    }
+                }
+            } // ties go to the first pixel in the order of the scan
+            if (isLocalMax == false) {
+                continue;
+            }
+            cand.sum = 0;
+            for (dy = -1; dy <= 1; dy++) {
+                for (dx = -1; dx <= 1; dx++) {
+                    if (line[x + dy*bytesPerLine + dx] > 250) {
+                        cand.sum = -1;
+                    }
+                    if (cand.sum >= 0) {
+                        cand.sum += line[x + dy*bytesPerLine + dx];
+                    }
+                }
+            }
+            if (cand.sum >= threshold) {
+                cand.x = x;
+                cand.y = y;
+                candidates.push_back(cand);
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), isBrighterCandidate);
+
+    for (i = 0; (i < candidates.size()) && ((long)this->stars.size() < maxStars); i++) {
+        isIsolated = ((fabs(candidates[i].x - this->stars[0].refPos[0]) >= this->boxSize) ||
+                      (fabs(candidates[i].y - this->stars[0].refPos[1]) >= this->boxSize));
+        for (j = 0; (j < i) && (isIsolated == true); j++) {
+            if ((abs(candidates[j].x - candidates[i].x) < this->boxSize) && (abs(candidates[j].y - candidates[i].y) < this->boxSize)) {
+                isIsolated = false;
+            }
+        } // a brighter star in the box would pull the centroid
+        if (isIsolated == false) {
+            continue;
+        }
+        if (this->measureStar(image, bytesPerLine, width, height, candidates[i].x, candidates[i].y, pos, &variance) == false) {
+            continue;
+        }
+        if ((fabs(pos[0] - candidates[i].x) > 2) || (fabs(pos[1] - candidates[i].y) > 2)) {
+            continue;
+        }
+        newStar.refPos[0] = pos[0];
+        newStar.refPos[1] = pos[1];
+        newStar.variance = variance;
+        this->stars.push_back(newStar);
+    }
+    candidates.clear();
+    return this->stars.size();
+}
+
+//---------------------------------------------------
+// the stars are searched where the predicted offset and the last rotation put them
+bool TSC_StarEnsemble::measureOffset(const unsigned char *image, long bytesPerLine, int width, int height,
+                                     double predictedX, double predictedY) {
+    std::vector<ensembleStar>::iterator star;
+    double pos[2], variance, rx, ry, cosRot, sinRot;
+
+    this->starsUsed = 0;
+    if ((image == 0) || (this->stars.empty() == true)) {
+        return false;
+    }
+    cosRot = cos(this->rotation);
+    sinRot = sin(this->rotation);
+    for (star = this->stars.begin(); star != this->stars.end(); star++) {
+        rx = star->refPos[0] - this->stars[0].refPos[0];
+        ry = star->refPos[1] - this->stars[0].refPos[1];
+        star->found = this->measureStar(image, bytesPerLine, width, height,
+                                        this->stars[0].refPos[0] + predictedX + cosRot*rx - sinRot*ry,
+                                        this->stars[0].refPos[1] + predictedY + sinRot*rx + cosRot*ry, pos, &variance);
+        if (star->found == true) {
+            star->shift[0] = pos[0] - star->refPos[0];
+            star->shift[1] = pos[1] - star->refPos[1];
+            star->variance = variance;
+        }
+    }
+    this->fitShifts();
+    return (this->starsUsed > 0);
+}
+
+//---------------------------------------------------
+// weighted least squares for the shift at the weighted centre of the stars and a small rotation about it;
+// the rotation term has a weighted mean of zero there, so both can be computed separately. the first pass
+// starts from the median of the shifts, so a single star that is far off cannot pull the first estimate.
+// a star is rejected if its residual exceeds the clipping limit, where the errors of the centroids are
+// scaled up if the median residual says they are too small
+void TSC_StarEnsemble::fitShifts(void) {
+    std::vector<ensembleStar>::iterator star;
+    std::vector<double> values;
+    double sumW, w, t[2], rx, ry, num, den, res[2], chi2, scale2, excess, theta;
+    long nFound, nUsed, nChanged;
+    int iter;
+    short axis;
+    bool keep;
+
+    nFound = 0;
+    for (star = this->stars.begin(); star != this->stars.end(); star++) {
+        star->used = star->found;
+        if (star->found == true) {
+            nFound++;
+        }
+    }
+    if (nFound == 0) {
+        return;
+    }
+    theta = 0;
+    for (iter = 0; iter < 10; iter++) {
+        nUsed = 0;
+        sumW = t[0] = t[1] = this->centre[0] = this->centre[1] = 0;
+        for (star = this->stars.begin(); star != this->stars.end(); star++) {
+            if (star->used == true) {
+                w = 1.0/(star->variance + this->commonVariance);
+                sumW += w;
+                t[0] += w*star->shift[0];
+                t[1] += w*star->shift[1];
+                this->centre[0] += w*star->refPos[0];
+                this->centre[1] += w*star->refPos[1];
+                nUsed++;
+            }
+        }
+        t[0] /= sumW;
+        t[1] /= sumW;
+        this->centre[0] /= sumW;
+        this->centre[1] /= sumW;
+        if ((iter == 0) && (nFound >= 3)) {
+            for (axis = 0; axis < 2; axis++) {
+                values.clear();
+                for (star = this->stars.begin(); star != this->stars.end(); star++) {
+                    if (star->used == true) {
+                        values.push_back(star->shift[axis]);
+                    }
+                }
+                std::nth_element(values.begin(), values.begin() + values.size()/2, values.end());
+                t[axis] = values[values.size()/2];
+            }
+        } // the centre stays the weighted one
+        theta = 0;
+        if ((this->fitRotation == true) && (nUsed >= 3) && (iter > 0)) {
+            num = den = 0;
+            for (star = this->stars.begin(); star != this->stars.end(); star++) {
+                if (star->used == true) {
+                    w = 1.0/(star->variance + this->commonVariance);
+                    rx = star->refPos[0] - this->centre[0];
+                    ry = star->refPos[1] - this->centre[1];
+                    num += w*(rx*(star->shift[1] - t[1]) - ry*(star->shift[0] - t[0]));
+                    den += w*(rx*rx + ry*ry);
+                }
+            }
+            if (den > 0) {
+                theta = num/den;
+            }
+        }
+        this->offset[0] = t[0];
+        this->offset[1] = t[1];
+        this->rotation = theta;
+        this->offsetError = sqrt(1.0/sumW);
+        this->starsUsed = nUsed;
+        if (nFound < 3) {
+            break;
+        } // nothing to compare with
+
+        values.clear();
+        for (star = this->stars.begin(); star != this->stars.end(); star++) {
+            if (star->used == true) {
+                rx = star->refPos[0] - this->centre[0];
+                ry = star->refPos[1] - this->centre[1];
+                res[0] = star->shift[0] - t[0] + theta*ry;
+                res[1] = star->shift[1] - t[1] - theta*rx;
+                values.push_back((res[0]*res[0] + res[1]*res[1])/(star->variance + this->commonVariance));
+            }
+        }
+        std::nth_element(values.begin(), values.begin() + values.size()/2, values.end());
+        scale2 = fmax(1.0, values[values.size()/2]/1.386); // the median of chi^2 with two degrees of freedom
+        nChanged = 0;
+        nUsed = 0;
+        for (star = this->stars.begin(); star != this->stars.end(); star++) {
+            if (star->found == true) {
+                rx = star->refPos[0] - this->centre[0];
+                ry = star->refPos[1] - this->centre[1];
+                res[0] = star->shift[0] - t[0] + theta*ry;
+                res[1] = star->shift[1] - t[1] - theta*rx;
+                chi2 = (res[0]*res[0] + res[1]*res[1])/(star->variance + this->commonVariance);
+                keep = (chi2 <= this->clipSigma*this->clipSigma*scale2);
+                if (keep != star->used) {
+                    nChanged++;
+                }
+                star->used = keep;
+                if (keep == true) {
+                    nUsed++;
+                }
+            }
+        }
+        if (nUsed == 0) {
+            for (star = this->stars.begin(); star != this->stars.end(); star++) {
+                star->used = star->found;
+            }
+            break;
+        }
+        if ((nChanged == 0) && (iter > 0)) {
+            break;
+        }
+    }
+
+    rx = this->stars[0].refPos[0] - this->centre[0];
+    ry = this->stars[0].refPos[1] - this->centre[1];
+    this->offset[0] -= this->rotation*ry;
+    this->offset[1] += this->rotation*rx; // from the centre of the stars to the guide star
+
+    if (this->starsUsed >= 3) {
+        excess = 0;
+        for (star = this->stars.begin(); star != this->stars.end(); star++) {
+            if (star->used == true) {
+                rx = star->refPos[0] - this->centre[0];
+                ry = star->refPos[1] - this->centre[1];
+                res[0] = star->shift[0] - t[0] + this->rotation*ry;
+                res[1] = star->shift[1] - t[1] - this->rotation*rx;
+                excess += (res[0]*res[0] + res[1]*res[1])/2.0 - star->variance;
+            }
+        }
+        excess /= this->starsUsed - ((this->fitRotation == true) ? 1.5 : 1.0); // the fit takes up degrees of freedom
+        this->commonVariance = 0.8*this->commonVariance + 0.2*fmax(0, excess);
+    } // the part of the scatter that the centroid errors do not explain is learned over the frames
+}
+
+//---------------------------------------------------
+long TSC_StarEnsemble::getNumberOfStars(void) {
+    return this->stars.size();
+}
+
+//---------------------------------------------------
+long TSC_StarEnsemble::getNumberOfStarsUsed(void) {
+    return this->starsUsed;
+}
+
+//---------------------------------------------------
+double TSC_StarEnsemble::getOffset(short axis) {
+    if ((axis < 0) || (axis > 1)) {
+        return 0;
+    }
+    return this->offset[axis];
+}
+
+//---------------------------------------------------
+double TSC_StarEnsemble::getOffsetError(void) {
+    return this->offsetError;
+}
+
+//---------------------------------------------------
+double TSC_StarEnsemble::getRotation(void) {
+    return this->rotation*180.0/M_PI;
+}
+
+//---------------------------------------------------
+double TSC_StarEnsemble::getReferencePosition(long idx, short axis) {
+    if ((idx < 0) || (idx >= (long)this->stars.size()) || (axis < 0) || (axis > 1)) {
+        return 0;
+    }
+    return this->stars[idx].refPos[axis];
+}
+
+//---------------------------------------------------
+bool TSC_StarEnsemble::isStarUsed(long idx) {
+    if ((idx < 0) || (idx >= (long)this->stars.size())) {
+        return false;
+    }
+    return this->stars[idx].used;
+}
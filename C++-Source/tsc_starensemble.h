@@ -0,0 +1,75 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+//---------------------------------------------------
+// guides on several stars at once. when guiding starts, the brightest isolated and unsaturated stars of the
+// frame are taken as references, together with the selected guide star. in every following frame, each star
+// is measured by TSC_Centroid in a small box around its predicted position, and the offset of the frame is
+// the weighted mean of the shifts of the stars. the weights are the inverse variances of the centroids,
+// estimated from their SNR and FWHM plus the variance that all stars share, like differential seeing.
+// stars that deviate by more than a few sigma, for instance from a hot pixel or a star that fades in a cloud,
+// are rejected iteratively. with three stars or more, a rotation of the field around the stars can be fitted
+// as well; the offset is then taken at the position of the guide star. positions are in pixels of the image.
+
+#ifndef TSC_STARENSEMBLE_H
+#define TSC_STARENSEMBLE_H
+
+#include <vector>
+#include "tsc_centroid.h"
+
+class TSC_StarEnsemble {
+public:
+    TSC_StarEnsemble(void);
+    ~TSC_StarEnsemble(void);
+    void setEstimator(short); // one of TSC_Centroid::centroidEstimator
+    void setBoxSize(int); // width of the region around every star in pixels
+    int getBoxSize(void);
+    void setClipping(double); // stars farther off than this number of sigma are rejected
+    void setRotationFit(bool);
+    void clear(void);
+    long findStars(const unsigned char*, long, int, int, double, double, long); // image, bytes per line, width, height, position of the guide star, maximum number of stars; returns the number of stars
+    bool measureOffset(const unsigned char*, long, int, int, double, double); // image, bytes per line, width, height and the predicted offset in x and y
+    long getNumberOfStars(void);
+    long getNumberOfStarsUsed(void); // in the last offset
+    double getOffset(short); // 0 is x, 1 is y at the guide star, relative to the reference frame
+    double getOffsetError(void); // one sigma, in pixels per axis
+    double getRotation(void); // in degrees
+    double getReferencePosition(long, short); // star, axis; star 0 is the guide star
+    bool isStarUsed(long);
+
+private:
+    struct ensembleStar {
+        double refPos[2];
+        double shift[2]; // measured in the last frame
+        double variance; // of the centroid per axis from the SNR, pixels^2
+        bool found;
+        bool used;
+    };
+    std::vector<ensembleStar> stars;
+    TSC_Centroid *centroid;
+    int boxSize;
+    double clipSigma;
+    bool fitRotation;
+    double commonVariance; // variance of the shifts that is not explained by the centroid errors, pixels^2
+    double offset[2];
+    double offsetError;
+    double rotation; // radians
+    double centre[2]; // weighted mean of the reference positions, the rotation is about this point
+    long starsUsed;
+    bool measureStar(const unsigned char*, long, int, int, double, double, double*, double*); // centroid and variance in a box around a position
+    void fitShifts(void); // offset and rotation from the stars that are used
+};
+
+#endif // TSC_STARENSEMBLE_H
@@ -0,0 +1,368 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+//---------------------------------------------------
+#include "tsc_starfinder.h"
+#include <math.h>
+#include <algorithm>
+
+static const int tileSize = 32;
+static const int starBoxSize = 24; // region of TSC_Centroid around a detection
+static const int saturationLevel = 251; // above the stretch of TSC_FitsDecoder, as in ocv_guiding::isPixelAtSaturation
+static const double minimumFWHM = 1.0; // narrower spots are hot pixels or cosmics
+static const double filterGain = 64; // sum of the weights of binning and kernel
+static const double filterNoiseGain = 12; // noise of the filtered image in sigma of a pixel, 2 from the binning times the norm 6 of the kernel
+
+TSC_StarFinder::TSC_StarFinder(void) {
+    this->centroid = new TSC_Centroid();
+    this->detectionLimit = 5.0;
+    this->searchWindow = 90;
+    this->tilesX = 0;
+    this->tilesY = 0;
+    this->background = 0;
+    this->noise = 0;
+}
+
+//---------------------------------------------------
+TSC_StarFinder::~TSC_StarFinder(void) {
+    this->tileBackground.clear();
+    this->binnedImage.clear();
+    this->rowFilteredImage.clear();
+    this->filteredImage.clear();
+    this->detections.clear();
+    this->candidates.clear();
+    delete this->centroid;
+}
+
+//---------------------------------------------------
+void TSC_StarFinder::setEstimator(short est) {
+    this->centroid->setEstimator(est);
+}
+
+//---------------------------------------------------
+void TSC_StarFinder::setDetectionLimit(double sigmas) {
+    if (sigmas > 2.0) {
+        this->detectionLimit = sigmas;
+    }
+}
+
+//---------------------------------------------------
+void TSC_StarFinder::setSearchWindow(int halfWidth) {
+    if (halfWidth >= starBoxSize) {
+        this->searchWindow = halfWidth;
+    }
+}
+
+//---------------------------------------------------
+static double getMedian(std::vector<float> values) {
+    size_t half;
+
+    if (values.empty() == true) {
+        return 0;
+    }
+    half = values.size()/2;
+    std::nth_element(values.begin(), values.begin() + half, values.end());
+    return values[half];
+}
+
+//---------------------------------------------------
+// every fourth pixel of a tile is counted, as in TSC_StarEnsemble::findStars
+void TSC_StarFinder::estimateBackground(const unsigned char *image, long bytesPerLine, int width, int height) {
+    std::vector<float> rawBackground, tileNoise, neighbours;
+    const unsigned char *line;
+    long histogram[256], cnt, sum;
+    int tx, ty, x, y, dx, dy, median, mad;
+
+    this->tilesX = (width + tileSize - 1)/tileSize;
+    this->tilesY = (height + tileSize - 1)/tileSize;
+    rawBackground.resize(this->tilesX*this->tilesY);
+    tileNoise.resize(this->tilesX*this->tilesY);
+    for (ty = 0; ty < this->tilesY; ty++) {
+        for (tx = 0; tx < this->tilesX; tx++) {
+            for (x = 0; x < 256; x++) {
+                histogram[x] = 0;
+            }
+            cnt = 0;
+            for (y = ty*tileSize; y < std::min((ty + 1)*tileSize, height); y += 2) {
+                line = image + y*bytesPerLine;
+                for (x = tx*tileSize; x < std::min((tx + 1)*tileSize, width); x += 2) {
+                    histogram[line[x]]++;
+                    cnt++;
+                }
+            }
+            sum = 0;
+            for (median = 0; median < 255; median++) {
+                sum += histogram[median];
+                if (2*sum >= cnt) {
+                    break;
+                }
+            }
+            sum = histogram[median];
+            for (mad = 1; mad < 256; mad++) {
+                if (2*sum >= cnt) {
+                    break;
+                }
+                if (median - mad >= 0) {
+                    sum += histogram[median - mad];
+                }
+                if (median + mad < 256) {
+                    sum += histogram[median + mad];
+                }
+            }
+            rawBackground[ty*this->tilesX + tx] = median;
+            tileNoise[ty*this->tilesX + tx] = fmax(1.4826*(mad - 0.5), 0.5); // the deviations are integers
+        }
+    }
+    this->tileBackground.resize(this->tilesX*this->tilesY);
+    for (ty = 0; ty < this->tilesY; ty++) {
+        for (tx = 0; tx < this->tilesX; tx++) {
+            neighbours.clear();
+            for (dy = std::max(ty - 1, 0); dy <= std::min(ty + 1, this->tilesY - 1); dy++) {
+                for (dx = std::max(tx - 1, 0); dx <= std::min(tx + 1, this->tilesX - 1); dx++) {
+                    neighbours.push_back(rawBackground[dy*this->tilesX + dx]);
+                }
+            }
+            this->tileBackground[ty*this->tilesX + tx] = getMedian(neighbours);
+        }
+    } // a bright star or a hot spot fills a tile, but hardly the majority of its neighbours
+    this->background = getMedian(this->tileBackground);
+    this->noise = getMedian(tileNoise);
+}
+
+//---------------------------------------------------
+double TSC_StarFinder::getBackgroundAt(double x, double y) {
+    double tx, ty, fx, fy;
+    int x0, y0, x1, y1;
+
+    tx = std::min(std::max((x - 0.5*tileSize)/tileSize, 0.0), this->tilesX - 1.0);
+    ty = std::min(std::max((y - 0.5*tileSize)/tileSize, 0.0), this->tilesY - 1.0);
+    x0 = (int)tx;
+    y0 = (int)ty;
+    x1 = std::min(x0 + 1, this->tilesX - 1);
+    y1 = std::min(y0 + 1, this->tilesY - 1);
+    fx = tx - x0;
+    fy = ty - y0;
+    return (1 - fy)*((1 - fx)*this->tileBackground[y0*this->tilesX + x0] + fx*this->tileBackground[y0*this->tilesX + x1]) +
+        fy*((1 - fx)*this->tileBackground[y1*this->tilesX + x0] + fx*this->tileBackground[y1*this->tilesX + x1]);
+}
+
+//---------------------------------------------------
+// the loops are free functions so that the restrict qualifiers are on parameters, as in tsc_fitsdecoder
+static void binRows(int binnedWidth, const unsigned char * __restrict__ row0, const unsigned char * __restrict__ row1,
+                    unsigned short * __restrict__ out) {
+    int x;
+
+    for (x = 0; x < binnedWidth; x++) {
+        out[x] = row0[2*x] + row0[2*x + 1] + row1[2*x] + row1[2*x + 1];
+    }
+}
+
+//---------------------------------------------------
+static void filterRow(int width, const unsigned short * __restrict__ in, unsigned short * __restrict__ out) {
+    int x;
+
+    out[0] = 0;
+    out[width - 1] = 0;
+    for (x = 1; x < width - 1; x++) {
+        out[x] = in[x - 1] + 2*in[x] + in[x + 1];
+    }
+}
+
+//---------------------------------------------------
+static void filterColumns(int width, const unsigned short * __restrict__ row0, const unsigned short * __restrict__ row1,
+                          const unsigned short * __restrict__ row2, unsigned short * __restrict__ out) {
+    int x;
+
+    for (x = 0; x < width; x++) {
+        out[x] = row0[x] + 2*row1[x] + row2[x];
+    }
+}
+
+//---------------------------------------------------
+// at most 4 x 255 after the binning and 16 times that after the kernel, so the values fit into 16 bits
+void TSC_StarFinder::filterImage(const unsigned char *image, long bytesPerLine, int width, int height) {
+    int binnedWidth, binnedHeight, y;
+
+    binnedWidth = width/2;
+    binnedHeight = height/2;
+    this->binnedImage.resize(binnedWidth*binnedHeight);
+    this->rowFilteredImage.resize(binnedWidth*binnedHeight);
+    this->filteredImage.assign(binnedWidth*binnedHeight, 0);
+    for (y = 0; y < binnedHeight; y++) {
+        binRows(binnedWidth, image + 2*y*bytesPerLine, image + (2*y + 1)*bytesPerLine, this->binnedImage.data() + y*binnedWidth);
+        filterRow(binnedWidth, this->binnedImage.data() + y*binnedWidth, this->rowFilteredImage.data() + y*binnedWidth);
+    }
+    for (y = 1; y < binnedHeight - 1; y++) {
+        filterColumns(binnedWidth, this->rowFilteredImage.data() + (y - 1)*binnedWidth, this->rowFilteredImage.data() + y*binnedWidth,
+                      this->rowFilteredImage.data() + (y + 1)*binnedWidth, this->filteredImage.data() + y*binnedWidth);
+    }
+}
+
+//---------------------------------------------------
+// a quick test against the lowest background comes first, so that the background is only interpolated for
+// the few pixels that may be a star. ties of the maximum go to the first pixel in the order of the scan
+void TSC_StarFinder::detectStars(int width, int height) {
+    struct detectionStruct det;
+    const unsigned short *line;
+    double limit, quickLimit;
+    int binnedWidth, binnedHeight, x, y, val;
+    bool isLocalMax;
+
+    binnedWidth = width/2;
+    binnedHeight = height/2;
+    limit = this->detectionLimit*filterNoiseGain*this->noise;
+    quickLimit = filterGain*(*std::min_element(this->tileBackground.begin(), this->tileBackground.end())) + limit;
+    for (y = 1; y < binnedHeight - 1; y++) {
+        line = this->filteredImage.data() + y*binnedWidth;
+        for (x = 1; x < binnedWidth - 1; x++) {
+            val = line[x];
+            if (val <= quickLimit) {
+                continue;
+            }
+            isLocalMax = ((line[x - binnedWidth - 1] < val) && (line[x - binnedWidth] < val) && (line[x - binnedWidth + 1] < val) &&
+                (line[x - 1] < val) && (line[x + 1] <= val) && (line[x + binnedWidth - 1] <= val) && (line[x + binnedWidth] <= val) &&
+                (line[x + binnedWidth + 1] <= val));
+            if (isLocalMax == false) {
+                continue;
+            }
+            det.x = 2*x + 0.5;
+            det.y = 2*y + 0.5;
+            det.response = val - filterGain*this->getBackgroundAt(det.x, det.y);
+            if (det.response > limit) {
+                this->detections.push_back(det);
+            }
+        }
+    }
+}
+
+//---------------------------------------------------
+bool TSC_StarFinder::measureCandidate(const unsigned char *image, long bytesPerLine, int width, int height,
+                                      const struct detectionStruct *det, struct guideStarCandidateStruct *cand) {
+    int left, top;
+
+    left = std::min(std::max((int)round(det->x) - starBoxSize/2, 0), width - starBoxSize);
+    top = std::min(std::max((int)round(det->y) - starBoxSize/2, 0), height - starBoxSize);
+    if (this->centroid->measure(image, bytesPerLine, left, top, starBoxSize, starBoxSize) == false) {
+        return false;
+    }
+    cand->position[0] = this->centroid->getCentroid(0);
+    cand->position[1] = this->centroid->getCentroid(1);
+    cand->snr = this->centroid->getSNR();
+    cand->fwhm = this->centroid->getFWHM();
+    cand->peak = this->centroid->getPeakValue();
+    if ((cand->snr <= 0) || (cand->fwhm < minimumFWHM) || (cand->peak >= saturationLevel)) {
+        return false;
+    }
+    if ((fabs(cand->position[0] - det->x) > 3) || (fabs(cand->position[1] - det->y) > 3)) {
+        return false;
+    } // another star in the box
+    return true;
+}
+
+//---------------------------------------------------
+// the detections are taken in the order of their brightness, and only the brightest are measured, so that a
+// crowded field does not take long. the SNR part of the score is half at an SNR of 10
+long TSC_StarFinder::findStars(const unsigned char *image, long bytesPerLine, int width, int height, long maxStars) {
+    struct guideStarCandidateStruct cand;
+    double dist;
+    size_t i, j, maxDetections, maxMeasured;
+    bool hasBrighterNeighbour;
+
+    this->detections.clear();
+    this->candidates.clear();
+    if ((image == 0) || (width < 2*tileSize) || (height < 2*tileSize) || (maxStars <= 0)) {
+        return 0;
+    }
+    this->estimateBackground(image, bytesPerLine, width, height);
+    this->filterImage(image, bytesPerLine, width, height);
+    this->detectStars(width, height);
+    std::sort(this->detections.begin(), this->detections.end(),
+              [](const struct detectionStruct &a, const struct detectionStruct &b) { return (a.response > b.response); });
+    maxDetections = std::min(this->detections.size(), (size_t)500);
+    maxMeasured = 4*maxStars;
+    for (i = 0; (i < maxDetections) && (this->candidates.size() < maxMeasured); i++) {
+        hasBrighterNeighbour = false;
+        for (j = 0; (j < i) && (hasBrighterNeighbour == false); j++) {
+            hasBrighterNeighbour = ((fabs(this->detections[j].x - this->detections[i].x) < this->searchWindow) &&
+                (fabs(this->detections[j].y - this->detections[i].y) < this->searchWindow));
+        }
+        if (hasBrighterNeighbour == true) {
+            continue;
+        }
+        if (this->measureCandidate(image, bytesPerLine, width, height, &this->detections[i], &cand) == false) {
+            continue;
+        }
+        cand.isolation = 1e6;
+        for (j = 0; j < this->detections.size(); j++) {
+            if (j != i) {
+                dist = sqrt(pow(this->detections[j].x - cand.position[0], 2) + pow(this->detections[j].y - cand.position[1], 2));
+                cand.isolation = fmin(cand.isolation, dist);
+            }
+        }
+        cand.edgeDistance = fmin(fmin(cand.position[0], width - 1 - cand.position[0]), fmin(cand.position[1], height - 1 - cand.position[1]));
+        cand.score = cand.snr/(cand.snr + 10)*fmin(cand.isolation/(this->searchWindow/3.0), 1.0)*
+            fmax(fmin(cand.edgeDistance/this->searchWindow, 1.0), 0.0);
+        this->candidates.push_back(cand);
+    }
+    std::sort(this->candidates.begin(), this->candidates.end(),
+              [](const struct guideStarCandidateStruct &a, const struct guideStarCandidateStruct &b) { return (a.score > b.score); });
+    if ((long)this->candidates.size() > maxStars) {
+        this->candidates.resize(maxStars);
+    }
+    return this->candidates.size();
+}
+
+//---------------------------------------------------
+long TSC_StarFinder::getNumberOfStars(void) {
+    return (long)this->candidates.size();
+}
+
+//---------------------------------------------------
+long TSC_StarFinder::getNumberOfDetections(void) {
+    return (long)this->detections.size();
+}
+
+//---------------------------------------------------
+struct TSC_StarFinder::guideStarCandidateStruct* TSC_StarFinder::getStar(long idx) {
+    if ((idx < 0) || (idx >= (long)this->candidates.size())) {
+        return NULL;
+    }
+    return &this->candidates[idx];
+}
+
+//---------------------------------------------------
+long TSC_StarFinder::getNearestStar(double x, double y, double radius) {
+    double dist, bestDist;
+    long idx, best = -1;
+
+    bestDist = radius;
+    for (idx = 0; idx < (long)this->candidates.size(); idx++) {
+        dist = sqrt(pow(this->candidates[idx].position[0] - x, 2) + pow(this->candidates[idx].position[1] - y, 2));
+        if (dist < bestDist) {
+            bestDist = dist;
+            best = idx;
+        }
+    }
+    return best;
+}
+
+//---------------------------------------------------
+double TSC_StarFinder::getBackground(void) {
+    return this->background;
+}
+
+//---------------------------------------------------
+double TSC_StarFinder::getNoise(void) {
+    return this->noise;
+}
@@ -0,0 +1,85 @@
+// this code is part of "TSC", a free control software for astronomical telescopes
+// Copyright (C)  2016-18, wolfgang birkfellner
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+//---------------------------------------------------
+// finds guide stars in the full frame of the guiding camera, so that no star has to be clicked and a star can
+// be found again after a dither or a meridian flip. the background and its noise are the median and the median
+// absolute deviation in tiles of 32 x 32 pixels, smoothed by a median over the neighbouring tiles so that
+// stars and gradients do not pull it. the image is filtered with a gaussian of about 3.5 pixels FWHM, which is
+// matched to the stars of a guide scope; it is made of a 2 x 2 binning and a binomial 3 x 3 kernel on the binned
+// image, all in integers, so a frame of a megapixel takes a few ms. local maxima of the filtered image above
+// the detection limit are the detections; the brightest ones are measured by TSC_Centroid. a candidate is
+// rejected if it is saturated as in ocv_guiding::isPixelAtSaturation - for 16 bit images, the raw value decides,
+// not the top of the stretch, see TSC_FitsDecoder - if it is a hot pixel narrower than a star,
+// or if a brighter star is within the window the guiding searches around it - the guiding would jump to that
+// one. the others are ranked by a score of their SNR, their distance to the next star and to the edge of the
+// frame. positions are in pixels of the image.
+
+#ifndef TSC_STARFINDER_H
+#define TSC_STARFINDER_H
+
+#include <vector>
+#include "tsc_centroid.h"
+
+class TSC_StarFinder {
+public:
+    struct guideStarCandidateStruct {
+        double position[2];
+        double snr;
+        double fwhm;
+        int peak; // brightest pixel around the star
+        double isolation; // distance to the next star found
+        double edgeDistance;
+        double score; // between 0 and 1, the product of the parts for SNR, isolation and edge distance
+    };
+    TSC_StarFinder(void);
+    ~TSC_StarFinder(void);
+    void setEstimator(short); // one of TSC_Centroid::centroidEstimator
+    void setDetectionLimit(double); // in sigma of the filtered image
+    void setSearchWindow(int); // half the width of the region the guiding searches around the star, 90 times the FOV factor in ocv_guiding
+    long findStars(const unsigned char*, long, int, int, long); // image, bytes per line, width, height, maximum number of candidates; returns the number found
+    long getNumberOfStars(void);
+    long getNumberOfDetections(void); // local maxima above the limit, including the ones that were rejected
+    struct guideStarCandidateStruct* getStar(long); // 0 is the best guide star
+    long getNearestStar(double, double, double); // position and radius in pixels; the nearest candidate or -1 if there is none within the radius
+    double getBackground(void); // median of the tiles, in ADU
+    double getNoise(void); // per pixel, in ADU
+
+private:
+    struct detectionStruct {
+        double x; // centre of the binned pixel in pixels of the image
+        double y;
+        double response; // filtered value above the background
+    };
+    TSC_Centroid *centroid;
+    double detectionLimit;
+    int searchWindow;
+    int tilesX;
+    int tilesY;
+    std::vector<float> tileBackground;
+    double background;
+    double noise;
+    std::vector<unsigned short> binnedImage;
+    std::vector<unsigned short> rowFilteredImage;
+    std::vector<unsigned short> filteredImage;
+    std::vector<struct detectionStruct> detections;
+    std::vector<struct guideStarCandidateStruct> candidates;
+    void estimateBackground(const unsigned char*, long, int, int);
+    double getBackgroundAt(double, double); // interpolated between the centres of the tiles
+    void filterImage(const unsigned char*, long, int, int);
+    void detectStars(int, int);
+    bool measureCandidate(const unsigned char*, long, int, int, const struct detectionStruct*, struct guideStarCandidateStruct*);
+};
+
+#endif // TSC_STARFINDER_H
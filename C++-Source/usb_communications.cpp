@@ -187,6 +187,7 @@ bool usbCommunications::sendCommand(QString theCmd, bool isRA) {
     int cmdLen, cntr, noOfBytesWritten;
     int retVal;
     short idx;
+    QElapsedTimer roundTripTimer;
 
     this->deleteResponse(isRA);
     if (isRA == true) {
@@ -200,6 +201,7 @@ bool usbCommunications::sendCommand(QString theCmd, bool isRA) {
     } // converted the QString to unsigned char ...
 
     if (g_AllData->getDriverAvailability() == true) {
+        roundTripTimer.start();
         retVal = libusb_bulk_transfer(this->deviceHandles[idx], (0x03 | LIBUSB_ENDPOINT_OUT), this->commandData[idx], cmdLen, &noOfBytesWritten, 1000); // finding out endpoints is done by running lsusb -v -d VID:PID
         if(retVal == 0 && noOfBytesWritten == cmdLen) {
             this->writeError = false;
@@ -209,6 +211,7 @@ bool usbCommunications::sendCommand(QString theCmd, bool isRA) {
             qDebug() << "Write error!";
         }
         this->receiveReply(isRA);
+        this->roundTripInMS[idx] = roundTripTimer.nsecsElapsed()/1000000.0;
         this->commandData[idx][0] ='\0';
         return this->writeErr;
     } else {
@@ -308,3 +311,11 @@ void usbCommunications::deleteResponse(bool isRA) {
     }
     this->dataReceived[idx]->clear();
 }
+
+//------------------------------------------------------------------------------------------------------------
+double usbCommunications::getRoundTripTime(bool isRA) {
+    if (isRA == true) {
+        return this->roundTripInMS[this->indexForRA];
+    }
+    return this->roundTripInMS[this->indexForDecl];
+}
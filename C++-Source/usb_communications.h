@@ -11,6 +11,7 @@ public:
     bool receiveReply(bool);
     QString getReply(bool);
     void deleteResponse(bool);
+    double getRoundTripTime(bool); // time in ms from sending the last command until the reply came in
 
 private:
     libusb_device **deviceList; //pointer to pointer of device, used to retrieve a list of devices
@@ -32,4 +33,5 @@ private:
     bool readError = false;
     QString* dataReceived[2];
     QString* startupResponse;
+    double roundTripInMS[2] = {0, 0};
 };